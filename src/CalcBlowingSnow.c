@@ -22,6 +22,9 @@
  *   2004-Oct-04 Merged with Laura Bowling's updated lake model code.		TJB
  *   2007-Apr-03 Module returns an ERROR value that can be trapped in main      GCT
  *   2011-Nov-04 Updated mtclim functions to MTCLIM 4.3.			TJB
+ *   2015-Feb-02 Made the running sum in trapzd() thread-local.		GT
+ *   2015-Feb-02 polint() keeps its work arrays on the stack; it is only
+ *		 called with n = K.						GT
  */
 
 #include <stdarg.h>
@@ -362,14 +365,11 @@ void polint(double xa[], double ya[], int n, double x, double *y, double *dy)
 {
   int i, m, ns;
   double den, dif, dift, ho, hp, w;
-  double *c,*d;
+  double c[K+1],d[K+1];
 
+  if (n > K) nrerror("Too many points in routine polint");
   ns=1;
   dif=fabs(x-xa[1]);
-  c=(double *)malloc((size_t) ((n+1)*sizeof(double)));
-  if(!c) nrerror("allocation failure in vector()");
-  d=(double *)malloc((size_t) ((n+1)*sizeof(double)));
-  if(!d) nrerror("allocation failure in vector()");
 
   for (i=1; i<=n; i++) {
     if ( (dift=fabs(x-xa[i])) < dif) {
@@ -392,8 +392,6 @@ void polint(double xa[], double ya[], int n, double x, double *y, double *dy)
     }
     *y += (*dy=(2*ns < (n-m) ? c[ns+1] : d[ns--]));
   }
-  free(d);
-  free(c);
 }
 
 
@@ -403,7 +401,7 @@ double trapzd(double (*funcd)(), double es, double Wind, double AirDens, double
 	      double Zrh, double a, double b, int n)
 {
   double x, tnm, sum, del;
-  static double s;
+  static THREAD_LOCAL double s;
   int it, j;
 
   if (n==1) {
@@ -29,6 +29,10 @@
   2013-Jul-25 Added advect_carbon_storage().				TJB
   2013-Dec-26 Removed EXCESS_ICE option.				TJB
   2014-Mar-28 Removed DIST_PRCP option.					TJB
+  2015-Feb-02 IceEnergyBalance() and ErrorPrintIcePackEnergyBalance() now
+	      take an ice_energy_bal_struct instead of a va_list.
+	      Removed CalcIcePackEnergyBalance() and
+	      ErrorIcePackEnergyBalance().				GT
 ******************************************************************************/
 
 //#ifndef LAKE_SET
@@ -79,20 +83,18 @@ void advect_snow_storage(double, double, double, snow_data_struct *);
 void alblake(double, double, double *, double *, float *, float *, double, double, 
 	     int, int *, double, double, char *, int, double);
 double calc_density(double);
-double CalcIcePackEnergyBalance(double Tsurf, ...);
 void colavg (double *, double *, double *, float, double *, int, double, double);
 float dragcoeff(float, double, double);
 void eddy (int, double, double * , double *, double *, double, int, double, double);
 void energycalc(double *, double *, int, double, double,double *, double *, double *);
-double ErrorIcePackEnergyBalance(double Tsurf, ...);
-double ErrorPrintIcePackEnergyBalance(double, va_list);
+double ErrorPrintIcePackEnergyBalance(double, ice_energy_bal_struct *, char *);
 int get_depth(lake_con_struct, double, double *);
 int get_sarea(lake_con_struct, double, double *);
 int get_volume(lake_con_struct, double, double *);
 void iceform (double *,double *,double ,double,double *,int, int, double, double, double *, double *, double *, double *, double *, double);
 void icerad(double,double ,double,double *, double *,double *);
 int ice_melt(double, double, double *, double, snow_data_struct *, lake_var_struct *, int, double, double, double, double, double, double, double, double, double, double, double, double, double, double, double *, double *, double *, double *, double *, double *, double *, double *, double *, double);
-double IceEnergyBalance(double, va_list);
+double IceEnergyBalance(double, void *);
 int initialize_lake(lake_var_struct *, lake_con_struct, soil_con_struct *, cell_data_struct *, double, int);
 int lakeice(double *, double, double, double, double, int, 
 	    double, double, double *, double, double, int, dmy_struct, double *, double *, double, double);
@@ -35,67 +35,90 @@ void alloc_atmos(int nrecs, atmos_data_struct **atmos)
   2010-Sep-24 Renamed runoff_in to channel_in.				TJB
   2011-Nov-04 Added tskc.						TJB
   2013-Jul-25 Added Catm, coszen, fdir, and par.			TJB
+  2015-Feb-02 Each field is now one contiguous block of nrecs*(NR+1)
+	      values, allocated with a single calloc(); atmos[rec].field
+	      points to the record's NR+1 values within the block.	GT
 
 *******************************************************************/
 {
-  extern param_set_struct param_set;
+  extern THREAD_LOCAL param_set_struct param_set;
 
   int i;
 
   *atmos = (atmos_data_struct *) calloc(nrecs, sizeof(atmos_data_struct)); 
   if (*atmos == NULL)
     vicerror("Memory allocation error in alloc_atmos().");
+  if (nrecs < 1)
+    return;
 
-  for (i = 0; i < nrecs; i++) {
-    (*atmos)[i].air_temp = (double *) calloc(NR+1, sizeof(double));
-    if ((*atmos)[i].air_temp == NULL)
-      vicerror("Memory allocation error in alloc_atmos().");
-    (*atmos)[i].Catm = (double *) calloc(NR+1, sizeof(double));
-    if ((*atmos)[i].Catm == NULL)
-      vicerror("Memory allocation error in alloc_atmos().");
-    (*atmos)[i].channel_in = (double *) calloc(NR+1, sizeof(double));	
-    if ((*atmos)[i].channel_in == NULL)
-      vicerror("Memory allocation error in alloc_atmos().");
-    (*atmos)[i].coszen = (double *) calloc(NR+1, sizeof(double));
-    if ((*atmos)[i].coszen == NULL)
-      vicerror("Memory allocation error in alloc_atmos().");
-    (*atmos)[i].density = (double *) calloc(NR+1, sizeof(double));	
-    if ((*atmos)[i].density == NULL)
-      vicerror("Memory allocation error in alloc_atmos().");
-    (*atmos)[i].fdir = (double *) calloc(NR+1, sizeof(double));
-    if ((*atmos)[i].fdir == NULL)
-      vicerror("Memory allocation error in alloc_atmos().");
-    (*atmos)[i].longwave = (double *) calloc(NR+1, sizeof(double));	
-    if ((*atmos)[i].longwave == NULL)
-      vicerror("Memory allocation error in alloc_atmos().");
-    (*atmos)[i].par = (double *) calloc(NR+1, sizeof(double));
-    if ((*atmos)[i].par == NULL)
-      vicerror("Memory allocation error in alloc_atmos().");
-    (*atmos)[i].prec = (double *) calloc(NR+1, sizeof(double));
-    if ((*atmos)[i].prec == NULL)
-      vicerror("Memory allocation error in alloc_atmos().");      
-    (*atmos)[i].pressure = (double *) calloc(NR+1, sizeof(double));
-    if ((*atmos)[i].pressure == NULL)
-      vicerror("Memory allocation error in alloc_atmos().");
-    (*atmos)[i].shortwave = (double *) calloc(NR+1, sizeof(double));	
-    if ((*atmos)[i].shortwave == NULL)
-      vicerror("Memory allocation error in alloc_atmos().");
-    (*atmos)[i].snowflag = (char *) calloc(NR+1, sizeof(char));	
-    if ((*atmos)[i].snowflag == NULL)
-      vicerror("Memory allocation error in alloc_atmos().");
-    (*atmos)[i].tskc = (double *) calloc(NR+1, sizeof(double));	
-    if ((*atmos)[i].tskc == NULL)
-      vicerror("Memory allocation error in alloc_atmos().");
-    (*atmos)[i].vp = (double *) calloc(NR+1, sizeof(double));	
-    if ((*atmos)[i].vp == NULL)
-      vicerror("Memory allocation error in alloc_atmos().");
-    (*atmos)[i].vpd = (double *) calloc(NR+1, sizeof(double));
-    if ((*atmos)[i].vpd == NULL)
-      vicerror("Memory allocation error in alloc_atmos().");
-    (*atmos)[i].wind = (double *) calloc(NR+1, sizeof(double));
-    if ((*atmos)[i].wind == NULL)
-      vicerror("Memory allocation error in alloc_atmos().");
-  }    			
+  /* One block per field; record i's array starts at element i*(NR+1) */
+  (*atmos)[0].air_temp = (double *) calloc((size_t)nrecs*(NR+1), sizeof(double));
+  if ((*atmos)[0].air_temp == NULL)
+    vicerror("Memory allocation error in alloc_atmos().");
+  (*atmos)[0].Catm = (double *) calloc((size_t)nrecs*(NR+1), sizeof(double));
+  if ((*atmos)[0].Catm == NULL)
+    vicerror("Memory allocation error in alloc_atmos().");
+  (*atmos)[0].channel_in = (double *) calloc((size_t)nrecs*(NR+1), sizeof(double));
+  if ((*atmos)[0].channel_in == NULL)
+    vicerror("Memory allocation error in alloc_atmos().");
+  (*atmos)[0].coszen = (double *) calloc((size_t)nrecs*(NR+1), sizeof(double));
+  if ((*atmos)[0].coszen == NULL)
+    vicerror("Memory allocation error in alloc_atmos().");
+  (*atmos)[0].density = (double *) calloc((size_t)nrecs*(NR+1), sizeof(double));
+  if ((*atmos)[0].density == NULL)
+    vicerror("Memory allocation error in alloc_atmos().");
+  (*atmos)[0].fdir = (double *) calloc((size_t)nrecs*(NR+1), sizeof(double));
+  if ((*atmos)[0].fdir == NULL)
+    vicerror("Memory allocation error in alloc_atmos().");
+  (*atmos)[0].longwave = (double *) calloc((size_t)nrecs*(NR+1), sizeof(double));
+  if ((*atmos)[0].longwave == NULL)
+    vicerror("Memory allocation error in alloc_atmos().");
+  (*atmos)[0].par = (double *) calloc((size_t)nrecs*(NR+1), sizeof(double));
+  if ((*atmos)[0].par == NULL)
+    vicerror("Memory allocation error in alloc_atmos().");
+  (*atmos)[0].prec = (double *) calloc((size_t)nrecs*(NR+1), sizeof(double));
+  if ((*atmos)[0].prec == NULL)
+    vicerror("Memory allocation error in alloc_atmos().");
+  (*atmos)[0].pressure = (double *) calloc((size_t)nrecs*(NR+1), sizeof(double));
+  if ((*atmos)[0].pressure == NULL)
+    vicerror("Memory allocation error in alloc_atmos().");
+  (*atmos)[0].shortwave = (double *) calloc((size_t)nrecs*(NR+1), sizeof(double));
+  if ((*atmos)[0].shortwave == NULL)
+    vicerror("Memory allocation error in alloc_atmos().");
+  (*atmos)[0].snowflag = (char *) calloc((size_t)nrecs*(NR+1), sizeof(char));
+  if ((*atmos)[0].snowflag == NULL)
+    vicerror("Memory allocation error in alloc_atmos().");
+  (*atmos)[0].tskc = (double *) calloc((size_t)nrecs*(NR+1), sizeof(double));
+  if ((*atmos)[0].tskc == NULL)
+    vicerror("Memory allocation error in alloc_atmos().");
+  (*atmos)[0].vp = (double *) calloc((size_t)nrecs*(NR+1), sizeof(double));
+  if ((*atmos)[0].vp == NULL)
+    vicerror("Memory allocation error in alloc_atmos().");
+  (*atmos)[0].vpd = (double *) calloc((size_t)nrecs*(NR+1), sizeof(double));
+  if ((*atmos)[0].vpd == NULL)
+    vicerror("Memory allocation error in alloc_atmos().");
+  (*atmos)[0].wind = (double *) calloc((size_t)nrecs*(NR+1), sizeof(double));
+  if ((*atmos)[0].wind == NULL)
+    vicerror("Memory allocation error in alloc_atmos().");
+
+  for (i = 1; i < nrecs; i++) {
+    (*atmos)[i].air_temp   = (*atmos)[0].air_temp   + i*(NR+1);
+    (*atmos)[i].Catm       = (*atmos)[0].Catm       + i*(NR+1);
+    (*atmos)[i].channel_in = (*atmos)[0].channel_in + i*(NR+1);
+    (*atmos)[i].coszen     = (*atmos)[0].coszen     + i*(NR+1);
+    (*atmos)[i].density    = (*atmos)[0].density    + i*(NR+1);
+    (*atmos)[i].fdir       = (*atmos)[0].fdir       + i*(NR+1);
+    (*atmos)[i].longwave   = (*atmos)[0].longwave   + i*(NR+1);
+    (*atmos)[i].par        = (*atmos)[0].par        + i*(NR+1);
+    (*atmos)[i].prec       = (*atmos)[0].prec       + i*(NR+1);
+    (*atmos)[i].pressure   = (*atmos)[0].pressure   + i*(NR+1);
+    (*atmos)[i].shortwave  = (*atmos)[0].shortwave  + i*(NR+1);
+    (*atmos)[i].snowflag   = (*atmos)[0].snowflag   + i*(NR+1);
+    (*atmos)[i].tskc       = (*atmos)[0].tskc       + i*(NR+1);
+    (*atmos)[i].vp         = (*atmos)[0].vp         + i*(NR+1);
+    (*atmos)[i].vpd        = (*atmos)[0].vpd        + i*(NR+1);
+    (*atmos)[i].wind       = (*atmos)[0].wind       + i*(NR+1);
+  }
 
 }
 
@@ -116,30 +139,30 @@ void free_atmos(int nrecs, atmos_data_struct **atmos)
   2010-Sep-24 Renamed runoff_in to channel_in.				TJB
   2011-Nov-04 Added tskc.						TJB
   2013-Jul-25 Added Catm, coszen, fdir, and par.			TJB
+  2015-Feb-02 Frees the contiguous field blocks allocated by
+	      alloc_atmos().						GT
 ***************************************************************************/
 {
-  int i;
-
   if (*atmos == NULL)
     return;
 
-  for (i = 0; i < nrecs; i++) {
-    free((*atmos)[i].air_temp);
-    free((*atmos)[i].Catm);
-    free((*atmos)[i].channel_in);
-    free((*atmos)[i].coszen);
-    free((*atmos)[i].density);
-    free((*atmos)[i].fdir);
-    free((*atmos)[i].longwave);
-    free((*atmos)[i].par);
-    free((*atmos)[i].prec);
-    free((*atmos)[i].pressure);
-    free((*atmos)[i].shortwave);
-    free((*atmos)[i].snowflag);
-    free((*atmos)[i].tskc);
-    free((*atmos)[i].vp);
-    free((*atmos)[i].vpd);
-    free((*atmos)[i].wind);
+  if (nrecs > 0) {
+    free((*atmos)[0].air_temp);
+    free((*atmos)[0].Catm);
+    free((*atmos)[0].channel_in);
+    free((*atmos)[0].coszen);
+    free((*atmos)[0].density);
+    free((*atmos)[0].fdir);
+    free((*atmos)[0].longwave);
+    free((*atmos)[0].par);
+    free((*atmos)[0].prec);
+    free((*atmos)[0].pressure);
+    free((*atmos)[0].shortwave);
+    free((*atmos)[0].snowflag);
+    free((*atmos)[0].tskc);
+    free((*atmos)[0].vp);
+    free((*atmos)[0].vpd);
+    free((*atmos)[0].wind);
   }
 
   free(*atmos);
@@ -26,28 +26,43 @@ void alloc_veg_hist(int nrecs, int nveg, veg_hist_struct ***veg_hist)
 
   Modifications:
   2014-Apr-25 Added veg cover fraction.					TJB
+  2015-Feb-02 The structs of all records, and each field, are now
+	      single contiguous blocks, allocated with one calloc()
+	      each; veg_hist[rec][veg].field points into the block.	GT
 *******************************************************************/
 {
   int i,j;
+  veg_hist_struct *vh;
 
   (*veg_hist) = (veg_hist_struct **) calloc(nrecs, sizeof(veg_hist_struct *)); 
   if ((*veg_hist) == NULL)
     vicerror("Memory allocation error in alloc_veg_hist().");
+  if (nrecs < 1 || nveg < 1)
+    return;
+
+  /* One block of structs for all records, and one block per field;
+     veg tile j of record i is element i*nveg+j of the struct block,
+     and its arrays start at element (i*nveg+j)*(NR+1) of the field
+     blocks */
+  vh = (veg_hist_struct *) calloc((size_t)nrecs*nveg, sizeof(veg_hist_struct));
+  if (vh == NULL)
+    vicerror("Memory allocation error in alloc_veg_hist().");
+  vh[0].albedo = (double *) calloc((size_t)nrecs*nveg*(NR+1), sizeof(double));
+  if (vh[0].albedo == NULL)
+    vicerror("Memory allocation error in alloc_veg_hist().");
+  vh[0].LAI = (double *) calloc((size_t)nrecs*nveg*(NR+1), sizeof(double));
+  if (vh[0].LAI == NULL)
+    vicerror("Memory allocation error in alloc_veg_hist().");
+  vh[0].vegcover = (double *) calloc((size_t)nrecs*nveg*(NR+1), sizeof(double));
+  if (vh[0].vegcover == NULL)
+    vicerror("Memory allocation error in alloc_veg_hist().");
 
   for (i = 0; i < nrecs; i++) {
-    (*veg_hist)[i] = (veg_hist_struct *) calloc(nveg, sizeof(veg_hist_struct));
-    if ((*veg_hist)[i] == NULL)
-      vicerror("Memory allocation error in alloc_veg_hist().");
+    (*veg_hist)[i] = &vh[i*nveg];
     for (j = 0; j < nveg; j++) {
-      (*veg_hist)[i][j].albedo = (double *) calloc(NR+1, sizeof(double));
-      if ((*veg_hist)[i][j].albedo == NULL)
-        vicerror("Memory allocation error in alloc_veg_hist().");
-      (*veg_hist)[i][j].LAI = (double *) calloc(NR+1, sizeof(double));
-      if ((*veg_hist)[i][j].LAI == NULL)
-        vicerror("Memory allocation error in alloc_veg_hist().");
-      (*veg_hist)[i][j].vegcover = (double *) calloc(NR+1, sizeof(double));
-      if ((*veg_hist)[i][j].vegcover == NULL)
-        vicerror("Memory allocation error in alloc_veg_hist().");
+      (*veg_hist)[i][j].albedo   = vh[0].albedo   + (i*nveg+j)*(NR+1);
+      (*veg_hist)[i][j].LAI      = vh[0].LAI      + (i*nveg+j)*(NR+1);
+      (*veg_hist)[i][j].vegcover = vh[0].vegcover + (i*nveg+j)*(NR+1);
     }
   }
 
@@ -60,21 +75,20 @@ void free_veg_hist(int nrecs, int nveg, veg_hist_struct ***veg_hist)
 /***************************************************************************
   Modifications:
   2014-Apr-25 Added veg cover fraction.					TJB
+  2015-Feb-02 Frees the contiguous blocks allocated by alloc_veg_hist(),
+	      and sets *veg_hist to NULL.				GT
 ***************************************************************************/
 {
-  int i,j;
-
   if (*veg_hist == NULL)
     return;
 
-  for (i = 0; i < nrecs; i++) {
-    for (j = 0; j < nveg; j++) {
-      free((*veg_hist)[i][j].albedo);
-      free((*veg_hist)[i][j].LAI);
-      free((*veg_hist)[i][j].vegcover);
-    }
-    free((*veg_hist)[i]);
+  if (nrecs > 0 && nveg > 0) {
+    free((*veg_hist)[0][0].albedo);
+    free((*veg_hist)[0][0].LAI);
+    free((*veg_hist)[0][0].vegcover);
+    free((*veg_hist)[0]);
   }
 
   free(*veg_hist);
+  *veg_hist = NULL;
 }
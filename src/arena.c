@@ -0,0 +1,121 @@
+/*
+ * Purpose: arena allocator for structures that live as long as one
+ *          grid cell
+ * Usage  : Part of VIC
+ * Created: 2015-Feb-02
+ * Notes  : Every cell allocates the same set of structures (its model
+ *          state, vegetation tile parameters and snow band arrays) and
+ *          frees them when it is done.  Instead, these are carved from
+ *          one block per arena, and are all released at once by
+ *          reset_arena() when the cell is done.  Allocations that do
+ *          not fit in the block (i.e. during the first cell, or for a
+ *          cell with more tiles than any before it) are taken from the
+ *          heap; the next reset_arena() grows the block to hold all of
+ *          them, so that once the largest cell has been seen, cells are
+ *          processed without calls to malloc() or free().
+ */
+
+/****************************************************************************/
+/*			  PREPROCESSOR DIRECTIVES                           */
+/****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vicNl.h>
+
+static char vcid[] = "$Id$";
+
+/* Allocations are aligned to ARENA_ALIGN bytes */
+#define ARENA_ALIGN 16
+
+/* Header of an allocation that did not fit in the block */
+typedef union arena_chunk {
+  union arena_chunk *next;
+  char               pad[ARENA_ALIGN];
+} arena_chunk;
+
+/****************************************************************************/
+/*				arena_calloc()                              */
+/****************************************************************************/
+void *arena_calloc(arena_struct *arena,
+                   size_t        nmemb,
+                   size_t        size)
+/*******************************************************************
+  arena_calloc
+
+  Returns a zeroed array of nmemb elements of the given size, which
+  remains valid until the next reset_arena() or free_arena().
+*******************************************************************/
+{
+  size_t       n;
+  void        *p;
+  arena_chunk *chunk;
+
+  n = (nmemb*size + ARENA_ALIGN-1) / ARENA_ALIGN * ARENA_ALIGN;
+  arena->need += n;
+
+  if (arena->used + n <= arena->size) {
+    p = arena->base + arena->used;
+    arena->used += n;
+    memset(p, 0, n);
+    return(p);
+  }
+
+  chunk = (arena_chunk *)calloc(1, sizeof(arena_chunk) + n);
+  if (chunk == NULL)
+    nrerror("Memory allocation failure in arena_calloc()");
+  chunk->next = (arena_chunk *)arena->overflow;
+  arena->overflow = chunk;
+
+  return((void *)(chunk+1));
+}
+
+/****************************************************************************/
+/*				reset_arena()                               */
+/****************************************************************************/
+void reset_arena(arena_struct *arena)
+/*******************************************************************
+  reset_arena
+
+  Releases everything allocated from the arena.  If the allocations
+  since the last reset did not fit in the block, the block is
+  replaced by one that is large enough to hold them.
+*******************************************************************/
+{
+  arena_chunk *chunk;
+
+  while (arena->overflow != NULL) {
+    chunk = (arena_chunk *)arena->overflow;
+    arena->overflow = chunk->next;
+    free(chunk);
+  }
+
+  if (arena->need > arena->size) {
+    free(arena->base);
+    arena->base = (char *)malloc(arena->need);
+    if (arena->base == NULL)
+      nrerror("Memory allocation failure in reset_arena()");
+    arena->size = arena->need;
+  }
+
+  arena->used = 0;
+  arena->need = 0;
+}
+
+/****************************************************************************/
+/*				free_arena()                                */
+/****************************************************************************/
+void free_arena(arena_struct *arena)
+/*******************************************************************
+  free_arena
+
+  Releases everything allocated from the arena, and the block.
+*******************************************************************/
+{
+  arena->need = 0;
+  reset_arena(arena);
+  free(arena->base);
+  arena->base = NULL;
+  arena->size = 0;
+}
@@ -65,6 +65,11 @@ double calc_atmos_energy_bal(double  InOverSensible,
 	      of root_brent, error_print_atmos_energy_bal and
 	      solve_atmos_energy_bal.					TJB
   2013-Dec-26 Moved CLOSE_ENERGY from compile-time to run-time options.	TJB
+  2015-Feb-02 The arguments of func_atmos_energy_bal() are now stored
+	      in an atmos_energy_bal_struct that is passed to
+	      root_brent(), func_atmos_energy_bal() and
+	      error_print_atmos_energy_bal(), replacing the va_list
+	      argument lists.						GT
 ************************************************************************/
 
   extern option_struct options;
@@ -81,6 +86,7 @@ double calc_atmos_energy_bal(double  InOverSensible,
   double VP_upper;
   double gamma;
   char ErrorString[MAXSTRING];
+  atmos_energy_bal_struct atmos_args;
   
   F = 1;
 
@@ -102,6 +108,15 @@ double calc_atmos_energy_bal(double  InOverSensible,
 
   InLatent = (*LatentHeat) + (*LatentHeatSub);
 
+  // store the arguments of the canopy air energy balance
+  atmos_args.LatentHeat    = (*LatentHeat) + (*LatentHeatSub);
+  atmos_args.NetRadiation  = NetRadiation;
+  atmos_args.Ra            = Ra;
+  atmos_args.Tair          = Tair;
+  atmos_args.atmos_density = atmos_density;
+  atmos_args.InSensible    = InSensible;
+  atmos_args.SensibleHeat  = SensibleHeat;
+
   /******************************
     Find Canopy Air Temperature
   ******************************/
@@ -116,10 +131,8 @@ double calc_atmos_energy_bal(double  InOverSensible,
     T_upper = (Tair) + CANOPY_DT;
 
     // iterate for canopy air temperature
-    Tcanopy = root_brent(T_lower, T_upper, ErrorString, func_atmos_energy_bal, 
-		         (*LatentHeat) + (*LatentHeatSub), 
-		         NetRadiation, Ra, Tair, atmos_density, InSensible, 
-		         SensibleHeat);
+    Tcanopy = root_brent(T_lower, T_upper, ErrorString, func_atmos_energy_bal,
+		         &atmos_args);
 
     if ( Tcanopy <= -998 ) {
       if (options.TFALLBACK) {
@@ -129,11 +142,8 @@ double calc_atmos_energy_bal(double  InOverSensible,
       }
       else {
         // handle error flag from root brent
-        (*Error) = error_calc_atmos_energy_bal(Tcanopy, (*LatentHeat) 
-					       + (*LatentHeatSub), 
-					       NetRadiation, Ra, Tair, 
-					       atmos_density, InSensible, 
-					       SensibleHeat, ErrorString);
+        (*Error) = error_print_atmos_energy_bal(Tcanopy, &atmos_args,
+						ErrorString);
         return ( ERROR );
       }
     }
@@ -144,9 +154,7 @@ double calc_atmos_energy_bal(double  InOverSensible,
   }
 
   // compute variables based on final temperature
-  (*Error) = solve_atmos_energy_bal(Tcanopy, (*LatentHeat) + (*LatentHeatSub), 
-				    NetRadiation, Ra, Tair, atmos_density, 
-				    InSensible, SensibleHeat);
+  (*Error) = func_atmos_energy_bal(Tcanopy, &atmos_args);
 
   /*****************************
     Find Canopy Vapor Pressure
@@ -185,35 +193,9 @@ double calc_atmos_energy_bal(double  InOverSensible,
 
 }
 
-double solve_atmos_energy_bal(double Tcanopy, ...) {
-
-  va_list ap;
-
-  double error;
-
-  va_start(ap, Tcanopy);
-  error = func_atmos_energy_bal(Tcanopy, ap);
-  va_end(ap);
-
-  return error;
-
-}
-
-double error_calc_atmos_energy_bal(double Tcanopy, ...) {
-
-  va_list ap;
-
-  double error;
-
-  va_start(ap, Tcanopy);
-  error = error_print_atmos_energy_bal(Tcanopy, ap);
-  va_end(ap);
-
-  return error;
-
-}
-
-double error_print_atmos_energy_bal(double Tcanopy, va_list ap) {
+double error_print_atmos_energy_bal(double Tcanopy,
+				    atmos_energy_bal_struct *args,
+				    char *ErrorString) {
 
   double  LatentHeat;
   double  NetRadiation;
@@ -223,18 +205,16 @@ double error_print_atmos_energy_bal(double Tcanopy, va_list ap) {
   double  InSensible;
 
   double *SensibleHeat;
-  char *ErrorString;
  
-  // extract variables from va_arg
-  LatentHeat    = (double)  va_arg(ap, double);
-  NetRadiation  = (double)  va_arg(ap, double);
-  Ra            = (double)  va_arg(ap, double);
-  Tair          = (double)  va_arg(ap, double);
-  atmos_density = (double)  va_arg(ap, double);
-  InSensible    = (double)  va_arg(ap, double);
-
-  SensibleHeat  = (double *)va_arg(ap, double *);
-  ErrorString   = (char *)va_arg(ap, char *);
+  // extract variables from argument struct
+  LatentHeat    = args->LatentHeat;
+  NetRadiation  = args->NetRadiation;
+  Ra            = args->Ra;
+  Tair          = args->Tair;
+  atmos_density = args->atmos_density;
+  InSensible    = args->InSensible;
+
+  SensibleHeat  = args->SensibleHeat;
 
   // print variable values
   fprintf(stderr, "%s", ErrorString);
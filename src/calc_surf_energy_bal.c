@@ -172,9 +172,17 @@ double calc_surf_energy_bal(double             Le,
   2014-Mar-28 Removed DIST_PRCP option.					TJB
   2014-Apr-25 Added non-climatological LAI.				TJB
   2014-May-05 Added non-climatological vegcover fraction.		TJB
+  2015-Feb-02 The arguments of func_surf_energy_bal() are now stored
+	      once in a surf_energy_bal_struct, which is passed to
+	      root_brent(), func_surf_energy_bal() and
+	      error_print_surf_energy_bal(), replacing the va_list
+	      argument lists and the solve_surf_energy_bal() and
+	      error_calc_surf_energy_bal() wrappers.			GT
+  2015-Feb-02 The surface temperature is found by root_solve(), with
+	      the previous surface temperature as first guess.		GT
 ***************************************************************/
 {
-  extern veg_lib_struct *veg_lib;
+  extern THREAD_LOCAL veg_lib_struct *veg_lib;
   extern option_struct   options;
 
   int      FIRST_SOLN[2];
@@ -238,6 +246,7 @@ double calc_surf_energy_bal(double             Le,
   double   TmpNetShortSnow;
   double   old_swq, old_depth;
   char ErrorString[MAXSTRING];
+  surf_energy_bal_struct surf_args;
 
   /**************************************************
     Set All Variables For Use
@@ -327,6 +336,111 @@ double calc_surf_energy_bal(double             Le,
   Zsum_node      = soil_con->Zsum_node;   
   ice_node       = energy->ice;
 
+  /**************************************************
+    Store Arguments of the Surface Energy Balance
+  **************************************************/
+  surf_args.rec             = rec;
+  surf_args.nrecs           = nrecs;
+  surf_args.dmy             = dmy;
+  surf_args.VEG             = VEG;
+  surf_args.veg_class       = veg_class;
+  surf_args.iveg            = iveg;
+  surf_args.delta_t         = delta_t;
+  surf_args.Cs1             = Cs1;
+  surf_args.Cs2             = Cs2;
+  surf_args.D1              = D1;
+  surf_args.D2              = D2;
+  surf_args.T1_old          = T1_old;
+  surf_args.T2              = T2;
+  surf_args.Ts_old          = Ts_old;
+  surf_args.Told_node       = energy->T;
+  surf_args.bubble          = bubble;
+  surf_args.dp              = dp;
+  surf_args.expt            = expt;
+  surf_args.ice0            = ice0;
+  surf_args.kappa1          = kappa1;
+  surf_args.kappa2          = kappa2;
+  surf_args.max_moist       = max_moist;
+  surf_args.moist           = moist;
+  surf_args.root            = root;
+  surf_args.CanopLayerBnd   = CanopLayerBnd;
+  surf_args.UnderStory      = UnderStory;
+  surf_args.overstory       = overstory;
+  surf_args.NetShortBare    = NetShortBare;
+  surf_args.NetShortGrnd    = NetShortGrnd;
+  surf_args.NetShortSnow    = TmpNetShortSnow;
+  surf_args.Tair            = Tair;
+  surf_args.atmos_density   = atmos_density;
+  surf_args.atmos_pressure  = atmos_pressure;
+  surf_args.emissivity      = emissivity;
+  surf_args.LongBareIn      = LongBareIn;
+  surf_args.LongSnowIn      = LongSnowIn;
+  surf_args.surf_atten      = surf_atten;
+  surf_args.vp              = VPcanopy;
+  surf_args.vpd             = VPDcanopy;
+  surf_args.shortwave       = atmos_shortwave;
+  surf_args.Catm            = atmos_Catm;
+  surf_args.dryFrac         = dryFrac;
+  surf_args.Wdew            = &Wdew;
+  surf_args.displacement    = displacement;
+  surf_args.ra              = aero_resist;
+  surf_args.Ra_used         = aero_resist_used;
+  surf_args.rainfall        = rainfall;
+  surf_args.ref_height      = ref_height;
+  surf_args.roughness       = roughness;
+  surf_args.wind            = wind;
+  surf_args.Le              = Le;
+  surf_args.Advection       = energy->advection;
+  surf_args.OldTSurf        = OldTSurf;
+  surf_args.TPack           = snow->pack_temp;
+  surf_args.Tsnow_surf      = Tsnow_surf;
+  surf_args.kappa_snow      = kappa_snow;
+  surf_args.melt_energy     = melt_energy;
+  surf_args.snow_coverage   = snow_coverage;
+  surf_args.snow_density    = snow->density;
+  surf_args.snow_swq        = snow->swq;
+  surf_args.snow_water      = snow->surf_water;
+  surf_args.deltaCC         = &energy->deltaCC;
+  surf_args.refreeze_energy = &energy->refreeze_energy;
+  surf_args.vapor_flux      = &snow->vapor_flux;
+  surf_args.blowing_flux    = &snow->blowing_flux;
+  surf_args.surface_flux    = &snow->surface_flux;
+  surf_args.Nnodes          = Nnodes;
+  surf_args.Cs_node         = Cs_node;
+  surf_args.T_node          = T_node;
+  surf_args.Tnew_node       = Tnew_node;
+  surf_args.Tnew_fbflag     = Tnew_fbflag;
+  surf_args.Tnew_fbcount    = Tnew_fbcount;
+  surf_args.alpha           = alpha;
+  surf_args.beta            = beta;
+  surf_args.bubble_node     = bubble_node;
+  surf_args.Zsum_node       = Zsum_node;
+  surf_args.expt_node       = expt_node;
+  surf_args.gamma           = gamma;
+  surf_args.ice_node        = ice_node;
+  surf_args.kappa_node      = kappa_node;
+  surf_args.max_moist_node  = max_moist_node;
+  surf_args.moist_node      = moist_node;
+  surf_args.soil_con        = soil_con;
+  surf_args.layer           = layer;
+  surf_args.veg_var         = veg_var;
+  surf_args.INCLUDE_SNOW    = INCLUDE_SNOW;
+  surf_args.NOFLUX          = options.NOFLUX;
+  surf_args.EXP_TRANS       = options.EXP_TRANS;
+  surf_args.SNOWING         = snow->snow;
+  surf_args.FIRST_SOLN      = FIRST_SOLN;
+  surf_args.NetLongBare     = &NetLongBare;
+  surf_args.NetLongSnow     = &TmpNetLongSnow;
+  surf_args.T1              = &T1;
+  surf_args.deltaH          = &energy->deltaH;
+  surf_args.fusion          = &energy->fusion;
+  surf_args.grnd_flux       = &energy->grnd_flux;
+  surf_args.latent_heat     = &energy->latent;
+  surf_args.latent_heat_sub = &energy->latent_sub;
+  surf_args.sensible_heat   = &energy->sensible;
+  surf_args.snow_flux       = &energy->snow_flux;
+  surf_args.store_error     = &energy->error;
+
   /**************************************************
     Find Surface Temperature Using Root Brent Method
   **************************************************/
@@ -357,35 +471,9 @@ double calc_surf_energy_bal(double             Le,
       tmpNnodes = Nnodes;
     }
 
-    Tsurf = root_brent(T_lower, T_upper, ErrorString, func_surf_energy_bal,
-		       rec, nrecs, dmy->month, VEG, veg_class, iveg, delta_t,
-		       Cs1, Cs2, D1, D2,
-		       T1_old, T2, Ts_old, energy->T, bubble, dp, 
-		       expt, ice0, kappa1, kappa2, 
-		       max_moist, moist, root, CanopLayerBnd,
-		       UnderStory, overstory, NetShortBare, NetShortGrnd, 
-		       TmpNetShortSnow, Tair, atmos_density, 
-		       atmos_pressure,
-		       emissivity, LongBareIn, LongSnowIn, surf_atten, 
-		       VPcanopy, VPDcanopy, 
-		       atmos_shortwave, atmos_Catm, dryFrac,
-		       &Wdew, displacement, aero_resist, aero_resist_used, 
-		       rainfall, ref_height, roughness, wind, Le, 
-		       energy->advection, OldTSurf, snow->pack_temp, 
-		       Tsnow_surf, kappa_snow, melt_energy, 
-		       snow_coverage, 
-		       snow->density, snow->swq, snow->surf_water,
-		       &energy->deltaCC, &energy->refreeze_energy, 
-		       &snow->vapor_flux, &snow->blowing_flux, &snow->surface_flux,
-		       tmpNnodes, Cs_node, T_node, Tnew_node, Tnew_fbflag, Tnew_fbcount,
-		       alpha, beta, bubble_node, Zsum_node, expt_node, gamma, 
-		       ice_node, kappa_node, max_moist_node, moist_node, 
-		       soil_con, layer, veg_var, 
-		       INCLUDE_SNOW, options.NOFLUX, options.EXP_TRANS, snow->snow, 
-		       FIRST_SOLN, &NetLongBare, &TmpNetLongSnow, &T1, 
-		       &energy->deltaH, &energy->fusion, &energy->grnd_flux, 
-		       &energy->latent, &energy->latent_sub, 
-		       &energy->sensible, &energy->snow_flux, &energy->error);
+    surf_args.Nnodes = tmpNnodes;
+    Tsurf = root_solve(ROOT_SURF, Ts_old, T_lower, T_upper, ErrorString,
+		       func_surf_energy_bal, &surf_args);
  
     if(Tsurf <= -998 ) {  
       if (options.TFALLBACK) {
@@ -395,48 +483,7 @@ double calc_surf_energy_bal(double             Le,
       }
       else {
         fprintf(stderr, "SURF_DT = %.2f\n", SURF_DT);
-        error = error_calc_surf_energy_bal(Tsurf, dmy->year, dmy->month, dmy->day, dmy->hour, VEG, iveg,
-					   veg_class, delta_t, Cs1, Cs2, D1, D2, 
-					   T1_old, T2, Ts_old, energy->T,
-					   soil_con->b_infilt, bubble, dp, 
-					   expt, ice0, kappa1, kappa2, 
-					   soil_con->max_infil, max_moist, 
-					   moist, soil_con->Wcr, soil_con->Wpwp, 
-					   soil_con->depth, 
-					   soil_con->resid_moist, root, CanopLayerBnd,
-					   UnderStory, overstory, NetShortBare, 
-					   NetShortGrnd, TmpNetShortSnow, Tair, 
-					   atmos_density, atmos_pressure, 
-					   (double)soil_con->elevation, 
-					   emissivity, LongBareIn, LongSnowIn, 
-					   surf_atten, VPcanopy, VPDcanopy, 
-					   atmos_shortwave, atmos_Catm, dryFrac,
-					   &Wdew, displacement, aero_resist, aero_resist_used, 
-					   rainfall, ref_height, roughness, 
-					   wind, Le, energy->advection, 
-					   OldTSurf, snow->pack_temp, 
-					   Tsnow_surf, 
-					   kappa_snow, melt_energy, 
-					   snow_coverage, snow->density, 
-					   snow->swq, snow->surf_water, 
-					   &energy->deltaCC, 
-					   &energy->refreeze_energy, 
-					   &snow->vapor_flux, Nnodes, Cs_node, 
-					   T_node, Tnew_node, alpha, beta, 
-					   bubble_node, Zsum_node, expt_node, 
-					   gamma, ice_node, kappa_node, 
-					   max_moist_node, moist_node, 
-					   soil_con->frost_fract, 
-					   layer, veg_var, 
-					   INCLUDE_SNOW, soil_con->FS_ACTIVE, 
-					   options.NOFLUX, options.EXP_TRANS,
-					   snow->snow, FIRST_SOLN, &NetLongBare, 
-					   &TmpNetLongSnow, &T1, &energy->deltaH, 
-					   &energy->fusion, &energy->grnd_flux, 
-					   &energy->latent, 
-					   &energy->latent_sub, 
-					   &energy->sensible, 
-					   &energy->snow_flux, &energy->error, ErrorString);
+        error = error_print_surf_energy_bal(Tsurf, &surf_args, ErrorString);
         return ( ERROR );
       }
     }
@@ -449,34 +496,9 @@ double calc_surf_energy_bal(double             Le,
       tmpNnodes = Nnodes;
       FIRST_SOLN[0] = TRUE;
       
-      Tsurf = root_brent(T_lower, T_upper, ErrorString, func_surf_energy_bal,
-			 rec, nrecs, dmy->month, VEG, veg_class, iveg, delta_t,
-			 Cs1, Cs2, D1, D2, 
-			 T1_old, T2, Ts_old, energy->T, bubble, dp, 
-			 expt, ice0, kappa1, kappa2, 
-			 max_moist, moist, root, CanopLayerBnd,
-			 UnderStory, overstory, NetShortBare, NetShortGrnd, 
-			 TmpNetShortSnow, Tair, atmos_density, atmos_pressure, 
-			 emissivity, LongBareIn, LongSnowIn, surf_atten, 
-			 VPcanopy, VPDcanopy, 
-		         atmos_shortwave, atmos_Catm, dryFrac,
-			 &Wdew, displacement, aero_resist, aero_resist_used, 
-			 rainfall, ref_height, roughness, wind, Le, 
-			 energy->advection, OldTSurf, snow->pack_temp, 
-			 Tsnow_surf, kappa_snow, melt_energy, 
-			 snow_coverage, 
-			 snow->density, snow->swq, snow->surf_water,
-			 &energy->deltaCC, &energy->refreeze_energy, 
-			 &snow->vapor_flux, &snow->blowing_flux, &snow->surface_flux,
-			 tmpNnodes, Cs_node, T_node, Tnew_node, Tnew_fbflag, Tnew_fbcount,
-			 alpha, beta, bubble_node, Zsum_node, expt_node, gamma, 
-			 ice_node, kappa_node, max_moist_node, moist_node, 
-			 soil_con, layer, veg_var, 
-			 INCLUDE_SNOW, options.NOFLUX, options.EXP_TRANS, snow->snow, 
-			 FIRST_SOLN, &NetLongBare, &TmpNetLongSnow, &T1, 
-			 &energy->deltaH, &energy->fusion, &energy->grnd_flux, 
-			 &energy->latent, &energy->latent_sub, 
-			 &energy->sensible, &energy->snow_flux, &energy->error);
+      surf_args.Nnodes = tmpNnodes;
+      Tsurf = root_solve(ROOT_SURF, Tsurf, T_lower, T_upper, ErrorString,
+			 func_surf_energy_bal, &surf_args);
       
       if(Tsurf <=  -998 ) {  
         if (options.TFALLBACK) {
@@ -485,50 +507,7 @@ double calc_surf_energy_bal(double             Le,
           Tsurf_fbcount++;
         }
         else {
-	  error = error_calc_surf_energy_bal(Tsurf, dmy->year, dmy->month, dmy->day, dmy->hour, VEG, iveg,
-					     veg_class, delta_t, Cs1, Cs2, D1, 
-					     D2, T1_old, T2, Ts_old, energy->T,
-					     soil_con->b_infilt, bubble, dp, 
-					     expt, ice0, kappa1, kappa2, 
-					     soil_con->max_infil, max_moist, 
-					     moist, soil_con->Wcr, 
-					     soil_con->Wpwp, soil_con->depth, 
-					     soil_con->resid_moist, root, CanopLayerBnd,
-					     UnderStory, overstory, 
-					     NetShortBare, NetShortGrnd, 
-					     TmpNetShortSnow, Tair, 
-					     atmos_density, atmos_pressure, 
-					     (double)soil_con->elevation, 
-					     emissivity, LongBareIn, LongSnowIn, 
-					     surf_atten, VPcanopy, VPDcanopy,
-					     atmos_shortwave, atmos_Catm, dryFrac,
-					     &Wdew, displacement, 
-					     aero_resist, aero_resist_used, rainfall, ref_height, 
-					     roughness, wind, Le, 
-					     energy->advection, 
-					     OldTSurf, snow->pack_temp, 
-					     Tsnow_surf, 
-					     kappa_snow, melt_energy, 
-					     snow_coverage, snow->density, 
-					     snow->swq, snow->surf_water, 
-					     &energy->deltaCC, 
-					     &energy->refreeze_energy, 
-					     &snow->vapor_flux, Nnodes, Cs_node, 
-					     T_node, Tnew_node, alpha, beta, 
-					     bubble_node, Zsum_node, expt_node, 
-					     gamma, ice_node, kappa_node, 
-					     max_moist_node, moist_node, 
-					     soil_con->frost_fract, 
-					     layer, veg_var, INCLUDE_SNOW, 
-					     soil_con->FS_ACTIVE, options.NOFLUX, options.EXP_TRANS,
-					     snow->snow, FIRST_SOLN, &NetLongBare, 
-					     &TmpNetLongSnow, &T1, 
-					     &energy->deltaH, &energy->fusion, 
-					     &energy->grnd_flux, 
-					     &energy->latent, 
-					     &energy->latent_sub, 
-					     &energy->sensible, 
-					     &energy->snow_flux, &energy->error, ErrorString);
+	  error = error_print_surf_energy_bal(Tsurf, &surf_args, ErrorString);
           return ( ERROR );
         }
       }
@@ -545,34 +524,8 @@ double calc_surf_energy_bal(double             Le,
     // Reset model so that it solves thermal fluxes for full soil column
     FIRST_SOLN[0] = TRUE;
   
-  error = solve_surf_energy_bal(Tsurf, 
-				rec, nrecs, dmy->month, VEG, veg_class, iveg, delta_t,
-			        Cs1, Cs2, D1, D2, 
-				T1_old, T2, Ts_old, energy->T, bubble, dp, 
-				expt, ice0, kappa1, kappa2, 
-				max_moist, moist, root, CanopLayerBnd,
-				UnderStory, overstory, NetShortBare, NetShortGrnd, 
-				TmpNetShortSnow, Tair, atmos_density, atmos_pressure,
-				emissivity, LongBareIn, LongSnowIn, surf_atten, 
-				VPcanopy, VPDcanopy, 
-				atmos_shortwave, atmos_Catm, dryFrac,
-				&Wdew, displacement, aero_resist, aero_resist_used, 
-				rainfall, ref_height, roughness, wind, Le, 
-				energy->advection, OldTSurf, snow->pack_temp, 
-				Tsnow_surf, kappa_snow, melt_energy, 
-				snow_coverage, 
-				snow->density, snow->swq, snow->surf_water,
-				&energy->deltaCC, &energy->refreeze_energy, 
-				&snow->vapor_flux, &snow->blowing_flux, &snow->surface_flux,
-				Nnodes, Cs_node, T_node, Tnew_node, Tnew_fbflag, Tnew_fbcount,
-				alpha, beta, bubble_node, Zsum_node, expt_node, gamma, 
-				ice_node, kappa_node, max_moist_node, moist_node, 
-				soil_con, layer, veg_var, 
-				INCLUDE_SNOW, options.NOFLUX, options.EXP_TRANS, snow->snow, 
-				FIRST_SOLN, &NetLongBare, &TmpNetLongSnow, &T1, 
-				&energy->deltaH, &energy->fusion, &energy->grnd_flux, 
-				&energy->latent, &energy->latent_sub, 
-				&energy->sensible, &energy->snow_flux, &energy->error);
+  surf_args.Nnodes = Nnodes;
+  error = func_surf_energy_bal(Tsurf, &surf_args);
   if(error == ERROR)
     return(ERROR);
   else
@@ -743,40 +696,16 @@ double calc_surf_energy_bal(double             Le,
     
 }
 
-double solve_surf_energy_bal(double Tsurf, ...) {
-
-  va_list ap;
-
-  double error;
-
-  va_start(ap, Tsurf);
-  error = func_surf_energy_bal(Tsurf, ap);
-  va_end(ap);
-
-  return error;
-
-}
-
-double error_calc_surf_energy_bal(double Tsurf, ...) {
-
-  va_list ap;
-
-  double error;
-
-  va_start(ap, Tsurf);
-  error = error_print_surf_energy_bal(Tsurf, ap);
-  va_end(ap);
-
-  return error;
-
-}
-
-double error_print_surf_energy_bal(double Ts, va_list ap) {
+double error_print_surf_energy_bal(double Ts, surf_energy_bal_struct *args,
+				   char *ErrorString) {
 /**********************************************************************
   Modifications:
   2009-Mar-03 Fixed format string for print statement, eliminates
 	      compiler WARNING.						KAC via TJB
   2012-Jan-28 Added Told_node array.					TJB
+  2015-Feb-02 Variables are now read from the surf_energy_bal_struct
+	      that was passed to root_brent(); the soil parameters and
+	      date are taken from its soil_con and dmy.			GT
 **********************************************************************/
 
   extern option_struct options;
@@ -838,7 +767,7 @@ double error_print_surf_energy_bal(double Ts, va_list ap) {
   double vpd;
   double atmos_shortwave;
   double atmos_Catm;
-  double dryFrac;
+  double *dryFrac;
 
   double *Wdew;
   double *displacement;
@@ -915,148 +844,145 @@ double error_print_surf_energy_bal(double Ts, va_list ap) {
   double *snow_flux;
   double *store_error;
 
-  char *ErrorString;
-
   /* Define internal routine variables */
   int                i;
 
   /***************************
-    Read Variables from List
+    Read Variables from Struct
   ***************************/
 
   /* general model terms */
-  year                    = (int) va_arg(ap, int);
-  month                   = (int) va_arg(ap, int);
-  day                     = (int) va_arg(ap, int);
-  hour                    = (int) va_arg(ap, int);
-  VEG                     = (int) va_arg(ap, int);
-  iveg                    = (int) va_arg(ap, int);
-  veg_class               = (int) va_arg(ap, int);
+  year                    = args->dmy->year;
+  month                   = args->dmy->month;
+  day                     = args->dmy->day;
+  hour                    = args->dmy->hour;
+  VEG                     = args->VEG;
+  iveg                    = args->iveg;
+  veg_class               = args->veg_class;
 
-  delta_t                 = (double) va_arg(ap, double);
+  delta_t                 = args->delta_t;
 
   /* soil layer terms */
-  Cs1                     = (double) va_arg(ap, double);
-  Cs2                     = (double) va_arg(ap, double);
-  D1                      = (double) va_arg(ap, double);
-  D2                      = (double) va_arg(ap, double);
-  T1_old                  = (double) va_arg(ap, double);
-  T2                      = (double) va_arg(ap, double);
-  Ts_old                  = (double) va_arg(ap, double);
-  Told_node               = (double *) va_arg(ap, double *);
-  b_infilt                = (double) va_arg(ap, double);
-  bubble                  = (double) va_arg(ap, double);
-  dp                      = (double) va_arg(ap, double);
-  expt                    = (double) va_arg(ap, double);
-  ice0                    = (double) va_arg(ap, double);
-  kappa1                  = (double) va_arg(ap, double);
-  kappa2                  = (double) va_arg(ap, double);
-  max_infil               = (double) va_arg(ap, double);
-  max_moist               = (double) va_arg(ap, double);
-  moist                   = (double) va_arg(ap, double);
-
-  Wcr                     = (double *) va_arg(ap, double *);
-  Wpwp                    = (double *) va_arg(ap, double *);
-  depth                   = (double *) va_arg(ap, double *);
-  resid_moist             = (double *) va_arg(ap, double *);
-
-  root                    = (float  *) va_arg(ap, float  *);
-  CanopLayerBnd           = (double *) va_arg(ap, double *);
+  Cs1                     = args->Cs1;
+  Cs2                     = args->Cs2;
+  D1                      = args->D1;
+  D2                      = args->D2;
+  T1_old                  = args->T1_old;
+  T2                      = args->T2;
+  Ts_old                  = args->Ts_old;
+  Told_node               = args->Told_node;
+  b_infilt                = args->soil_con->b_infilt;
+  bubble                  = args->bubble;
+  dp                      = args->dp;
+  expt                    = args->expt;
+  ice0                    = args->ice0;
+  kappa1                  = args->kappa1;
+  kappa2                  = args->kappa2;
+  max_infil               = args->soil_con->max_infil;
+  max_moist               = args->max_moist;
+  moist                   = args->moist;
+
+  Wcr                     = args->soil_con->Wcr;
+  Wpwp                    = args->soil_con->Wpwp;
+  depth                   = args->soil_con->depth;
+  resid_moist             = args->soil_con->resid_moist;
+
+  root                    = args->root;
+  CanopLayerBnd           = args->CanopLayerBnd;
 
   /* meteorological forcing terms */
-  UnderStory              = (int) va_arg(ap, int);
-  overstory               = (int) va_arg(ap, int);
-
-  NetShortBare            = (double) va_arg(ap, double);
-  NetShortGrnd            = (double) va_arg(ap, double);
-  NetShortSnow            = (double) va_arg(ap, double);
-  Tair                    = (double) va_arg(ap, double);
-  atmos_density           = (double) va_arg(ap, double);
-  atmos_pressure          = (double) va_arg(ap, double);
-  elevation               = (double) va_arg(ap, double);
-  emissivity              = (double) va_arg(ap, double);
-  LongBareIn              = (double) va_arg(ap, double);
-  LongSnowIn              = (double) va_arg(ap, double);
-  surf_atten              = (double) va_arg(ap, double);
-  vp                      = (double) va_arg(ap, double);
-  vpd                     = (double) va_arg(ap, double);
-  atmos_shortwave         = (double) va_arg(ap, double);
-  atmos_Catm              = (double) va_arg(ap, double);
-  dryFrac                 = (double) va_arg(ap, double);
-
-  Wdew                    = (double *) va_arg(ap, double *);
-  displacement            = (double *) va_arg(ap, double *);
-  ra                      = (double *) va_arg(ap, double *);
-  ra_used                 = (double *) va_arg(ap, double *);
-  rainfall                = (double) va_arg(ap, double);
-  ref_height              = (double *) va_arg(ap, double *);
-  roughness               = (double *) va_arg(ap, double *);
-  wind                    = (double *) va_arg(ap, double *);
+  UnderStory              = args->UnderStory;
+  overstory               = args->overstory;
+
+  NetShortBare            = args->NetShortBare;
+  NetShortGrnd            = args->NetShortGrnd;
+  NetShortSnow            = args->NetShortSnow;
+  Tair                    = args->Tair;
+  atmos_density           = args->atmos_density;
+  atmos_pressure          = args->atmos_pressure;
+  elevation               = (double)args->soil_con->elevation;
+  emissivity              = args->emissivity;
+  LongBareIn              = args->LongBareIn;
+  LongSnowIn              = args->LongSnowIn;
+  surf_atten              = args->surf_atten;
+  vp                      = args->vp;
+  vpd                     = args->vpd;
+  atmos_shortwave         = args->shortwave;
+  atmos_Catm              = args->Catm;
+  dryFrac                 = args->dryFrac;
+
+  Wdew                    = args->Wdew;
+  displacement            = args->displacement;
+  ra                      = args->ra;
+  ra_used                 = args->Ra_used;
+  rainfall                = args->rainfall;
+  ref_height              = args->ref_height;
+  roughness               = args->roughness;
+  wind                    = args->wind;
 
   /* latent heat terms */
-  Le                      = (double) va_arg(ap, double);
+  Le                      = args->Le;
 
   /* snowpack terms */
-  Advection               = (double) va_arg(ap, double);
-  OldTSurf                = (double) va_arg(ap, double);
-  TPack                   = (double) va_arg(ap, double);
-  Tsnow_surf              = (double) va_arg(ap, double);
-  kappa_snow              = (double) va_arg(ap, double);
-  melt_energy             = (double) va_arg(ap, double);
-  snow_coverage           = (double) va_arg(ap, double);
-  snow_density            = (double) va_arg(ap, double);
-  snow_swq                = (double) va_arg(ap, double);
-  snow_water              = (double) va_arg(ap, double);
-
-  deltaCC                 = (double *) va_arg(ap, double *);
-  refreeze_energy         = (double *) va_arg(ap, double *);
-  VaporMassFlux           = (double *) va_arg(ap, double *);
+  Advection               = args->Advection;
+  OldTSurf                = args->OldTSurf;
+  TPack                   = args->TPack;
+  Tsnow_surf              = args->Tsnow_surf;
+  kappa_snow              = args->kappa_snow;
+  melt_energy             = args->melt_energy;
+  snow_coverage           = args->snow_coverage;
+  snow_density            = args->snow_density;
+  snow_swq                = args->snow_swq;
+  snow_water              = args->snow_water;
+
+  deltaCC                 = args->deltaCC;
+  refreeze_energy         = args->refreeze_energy;
+  VaporMassFlux           = args->vapor_flux;
 
   /* soil node terms */
-  Nnodes                  = (int) va_arg(ap, int);
-
-  Cs_node                 = (double *) va_arg(ap, double *);
-  T_node                  = (double *) va_arg(ap, double *);
-  Tnew_node               = (double *) va_arg(ap, double *);
-  alpha                   = (double *) va_arg(ap, double *);
-  beta                    = (double *) va_arg(ap, double *);
-  bubble_node             = (double *) va_arg(ap, double *);
-  Zsum_node               = (double *) va_arg(ap, double *);
-  expt_node               = (double *) va_arg(ap, double *);
-  gamma                   = (double *) va_arg(ap, double *);
-  ice_node                = (double *) va_arg(ap, double *);
-  kappa_node              = (double *) va_arg(ap, double *);
-  max_moist_node          = (double *) va_arg(ap, double *);
-  moist_node              = (double *) va_arg(ap, double *);
-  frost_fract             = (double *) va_arg(ap, double *);
+  Nnodes                  = args->Nnodes;
+
+  Cs_node                 = args->Cs_node;
+  T_node                  = args->T_node;
+  Tnew_node               = args->Tnew_node;
+  alpha                   = args->alpha;
+  beta                    = args->beta;
+  bubble_node             = args->bubble_node;
+  Zsum_node               = args->Zsum_node;
+  expt_node               = args->expt_node;
+  gamma                   = args->gamma;
+  ice_node                = args->ice_node;
+  kappa_node              = args->kappa_node;
+  max_moist_node          = args->max_moist_node;
+  moist_node              = args->moist_node;
+  frost_fract             = args->soil_con->frost_fract;
 
   /* model structures */
-  layer               = (layer_data_struct *) va_arg(ap, layer_data_struct *);
-  veg_var             = (veg_var_struct *) va_arg(ap, veg_var_struct *);
+  layer               = args->layer;
+  veg_var             = args->veg_var;
 
   /* control flags */
-  INCLUDE_SNOW            = (int) va_arg(ap, int);
-  FS_ACTIVE               = (int) va_arg(ap, int);
-  NOFLUX                  = (int) va_arg(ap, int);
-  EXP_TRANS               = (int) va_arg(ap, int);
-  SNOWING                 = (int) va_arg(ap, int);
+  INCLUDE_SNOW            = args->INCLUDE_SNOW;
+  FS_ACTIVE               = args->soil_con->FS_ACTIVE;
+  NOFLUX                  = args->NOFLUX;
+  EXP_TRANS               = args->EXP_TRANS;
+  SNOWING                 = args->SNOWING;
 
-  FIRST_SOLN              = (int *) va_arg(ap, int *);
+  FIRST_SOLN              = args->FIRST_SOLN;
 
   /* returned energy balance terms */
-  NetLongBare             = (double *) va_arg(ap, double *);
-  NetLongSnow             = (double *) va_arg(ap, double *);
-  T1                      = (double *) va_arg(ap, double *);
-  deltaH                  = (double *) va_arg(ap, double *);
-  fusion                  = (double *) va_arg(ap, double *);
-  grnd_flux               = (double *) va_arg(ap, double *);
-  latent_heat             = (double *) va_arg(ap, double *);
-  latent_heat_sub         = (double *) va_arg(ap, double *);
-  sensible_heat           = (double *) va_arg(ap, double *);
-  snow_flux               = (double *) va_arg(ap, double *);
-  store_error             = (double *) va_arg(ap, double *);
-
-  ErrorString             = (char *) va_arg(ap, char *);
+  NetLongBare             = args->NetLongBare;
+  NetLongSnow             = args->NetLongSnow;
+  T1                      = args->T1;
+  deltaH                  = args->deltaH;
+  fusion                  = args->fusion;
+  grnd_flux               = args->grnd_flux;
+  latent_heat             = args->latent_heat;
+  latent_heat_sub         = args->latent_heat_sub;
+  sensible_heat           = args->sensible_heat;
+  snow_flux               = args->snow_flux;
+  store_error             = args->store_error;
+
 
   /***************
     Main Routine
@@ -1121,7 +1047,7 @@ double error_print_surf_energy_bal(double Ts, va_list ap) {
   fprintf(stderr, "vpd = %f\n",  vpd);
   fprintf(stderr, "atmos_shortwave = %f\n",  atmos_shortwave);
   fprintf(stderr, "atmos_Catm = %f\n",  atmos_Catm);
-  fprintf(stderr, "dryFrac = %f\n",  dryFrac);
+  fprintf(stderr, "*dryFrac = %f\n",  *dryFrac);
 
   fprintf(stderr, "*Wdew = %f\n",  *Wdew);
   fprintf(stderr, "*displacement = %f\n",  *displacement);
@@ -16,13 +16,14 @@ double calc_water_balance_error(int    rec,
 
   Modifications:
   2007-Aug-22 Added error as return value.  JCA
+  2015-Feb-02 Made running totals thread-local.  GT
 ***************************************************************/
 
-  static double last_storage;
-  static double cum_error;
-  static double max_error;
-  static int    error_cnt;
-  static int    Nrecs;
+  static THREAD_LOCAL double last_storage;
+  static THREAD_LOCAL double cum_error;
+  static THREAD_LOCAL double max_error;
+  static THREAD_LOCAL int    error_cnt;
+  static THREAD_LOCAL int    Nrecs;
 
   double error;
 
@@ -71,11 +72,12 @@ double calc_energy_balance_error(int    rec,
   Modifications:
   2012-Oct-25 Changed to return the energy balance error to the
 	      parent function for tracking purposes.		CL via TJB
+  2015-Feb-02 Made running totals thread-local.			GT
 ***************************************************************/
 
-  static double cum_error;
-  static double max_error;
-  static int    Nrecs;
+  static THREAD_LOCAL double cum_error;
+  static THREAD_LOCAL double max_error;
+  static THREAD_LOCAL int    Nrecs;
 
   double error;
 
@@ -39,7 +39,8 @@
 
   programmer: Ted Bohn
   date      : October 20, 2006
-  changes   :
+  changes   : 2015-Feb-02 CiLayer is taken from the thread's scratch
+              arrays instead of being allocated on every call.	GT
   references: 
 ********************************************************************************/
 
@@ -75,6 +76,7 @@ void canopy_assimilation(char    Ctype,
                          double *NPP)
 {
   extern option_struct options;
+  extern THREAD_LOCAL scratch_struct scratch;
   double  h;
   double  pz;
   int     cidx;
@@ -92,7 +94,7 @@ void canopy_assimilation(char    Ctype,
      temperature is equal air_temp */
   pz = PS_PM * exp(-(double)elevation/h);
 
-  CiLayer = (double*)calloc(options.Ncanopy,sizeof(double));
+  CiLayer = scratch.CiLayer;
 
   if (!strcasecmp(mode,"ci")) {
 
@@ -200,7 +202,5 @@ void canopy_assimilation(char    Ctype,
   *Raut = *Rmaint + *Rgrowth;
   *NPP = *GPP - *Raut;
 
-  free((char*)CiLayer);
-
 }
 
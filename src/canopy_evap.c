@@ -108,7 +108,7 @@ double canopy_evap(layer_data_struct *layer,
 {
 
   /** declare global variables **/
-  extern veg_lib_struct *veg_lib; 
+  extern THREAD_LOCAL veg_lib_struct *veg_lib; 
   extern option_struct options;
 
   /** declare local variables **/
@@ -246,9 +246,12 @@ void transpiration(layer_data_struct *layer,
   2013-Jul-25 Save dryFrac for use elsewhere.				TJB
   2013-Jul-25 Added photosynthesis terms.				TJB
   2014-Apr-25 Switched LAI from veg_lib to veg_var.			TJB
+  2015-Feb-02 gsLayer is taken from the thread's scratch arrays
+	      instead of being allocated on every call.			GT
 **********************************************************************/
 {
-  extern veg_lib_struct *veg_lib;
+  extern THREAD_LOCAL veg_lib_struct *veg_lib;
+  extern THREAD_LOCAL scratch_struct scratch;
   extern option_struct options;
 
   int    i;
@@ -408,7 +411,7 @@ void transpiration(layer_data_struct *layer,
     /* Initialize conductances for aggregation over soil layers */
     gc =  0;
     if (options.CARBON) {
-      gsLayer = (double *)calloc(options.Ncanopy, sizeof(double));
+      gsLayer = scratch.gsLayer;
       for (cidx=0; cidx<options.Ncanopy; cidx++) {
         gsLayer[cidx] = 0;
       }
@@ -498,8 +501,6 @@ void transpiration(layer_data_struct *layer,
       }
     }
 
-    if (options.CARBON) free((char *)gsLayer);
-
   }
 
   /****************************************************************
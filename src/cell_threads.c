@@ -0,0 +1,574 @@
+/*
+ * Purpose: threaded cell driver - simulates grid cells in parallel
+ * Usage  : Part of VIC
+ * Created: 2015-Feb-02
+ * Notes  : The main thread reads the cell parameters (soil, veg, lake,
+ *          snow band), which must be read sequentially, and queues one
+ *          job per cell.  Each worker thread owns its own atmos, output
+ *          list, output files, and forcing file handles, and runs whole
+ *          cells via run_cell().  With PREFETCH = TRUE the main thread
+ *          also reads each cell's forcings before queueing it, so that
+ *          all input is read by the main thread while the workers run
+ *          the preceding cells.  Access to the shared initial state file
+ *          and output state file is ordered by the order in which cells
+ *          were queued, so that both files are read and written in the
+ *          same order as a serial run.  Jobs are recycled: each job
+ *          owns an arena, which it exchanges for the main thread's
+ *          param_arena when it is queued, so that the cell's parameters
+ *          go with it and the main thread reads the next cell into the
+ *          (already sized) arena of a finished job.
+ *
+ *          If a cell fails (run_cell() returns ERROR), no further cells
+ *          are queued, and queued cells after it are dropped without
+ *          being run, as the serial grid loop stops at the failing
+ *          cell.  Cells after the failing cell that were already
+ *          running stop at their next record; when their turn to save
+ *          their state comes (after all cells before them), their
+ *          output files are removed (or, with OUTPUT_CONTAINER, their
+ *          index entries cleared) and their state is not saved, so
+ *          that the output is that of the serial run.  A grid cell
+ *          error that ends the simulation (CONTINUEONERROR = FALSE) is
+ *          passed to cell_error() instead of vicerror(): the failing
+ *          cell closes its files and fails like any other, and
+ *          finish_cell_threads() returns the error to the main thread,
+ *          which reports it with vicerror() after the cells before
+ *          the failing one have finished.  Other errors that call
+ *          vicerror() or nrerror() directly (e.g. failed memory
+ *          allocations) still exit from the worker at once.
+ */
+
+/****************************************************************************/
+/*			  PREPROCESSOR DIRECTIVES                           */
+/****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <vicNl.h>
+
+static char vcid[] = "$Id$";
+
+#define N_CELL_TURNS 2
+
+typedef struct cell_job {
+  int               seq;      /* position of this job in the queue order */
+  int               cellnum;
+  soil_con_struct   soil_con;
+  veg_con_struct   *veg_con;
+  lake_con_struct   lake_con;
+  double          **forcing_data;  /* prefetched forcings, or NULL */
+  double         ***veg_hist_data;
+  veg_lib_struct   *veg_lib;  /* snapshot of veg_lib for this cell */
+  arena_struct      arena;    /* holds the parameters above */
+  struct cell_job  *next;
+} cell_job_struct;
+
+static struct {
+  int                   active;
+  int                   nthreads;
+  int                   startrec;
+  int                   queued;
+  int                   nqueued;
+  int                   max_queued;
+  int                   done;
+  int                   stop;
+  int                   stop_seq;   /* seq of the first failed cell */
+  int                   fatal;      /* TRUE if that cell's error ends
+                                       the simulation */
+  char                  errstr[MAXSTRING]; /* and its error message */
+  int                   turn[N_CELL_TURNS];
+  cell_job_struct      *head;
+  cell_job_struct      *tail;
+  cell_job_struct      *free_jobs;  /* finished jobs, for reuse */
+  pthread_t            *threads;
+  pthread_mutex_t       lock;
+  pthread_cond_t        job_ready;
+  pthread_cond_t        job_taken;
+  pthread_cond_t        turn_done;
+  dmy_struct           *dmy;
+  filep_struct         *filep;
+  filenames_struct     *filenames;
+  filep_struct          prefetch_filep;      /* main thread's copies */
+  filenames_struct      prefetch_filenames;  /* for reading forcings */
+  out_data_file_struct *out_data_files;
+  out_data_struct      *out_data;
+  param_set_struct     *param_set;
+} pool;
+
+static THREAD_LOCAL int  cur_seq;
+static THREAD_LOCAL int  in_worker;       /* TRUE in the worker threads */
+static THREAD_LOCAL int  cell_fatal;      /* set by cell_error() */
+static THREAD_LOCAL char cell_errstr[MAXSTRING];
+
+static void *cell_worker(void *arg);
+static void commit_state(FILE *, FILE *);
+static void discard_cell_output(out_data_file_struct *);
+
+/****************************************************************************/
+/*			     start_cell_threads()                           */
+/****************************************************************************/
+void start_cell_threads(int                   nthreads,
+                        dmy_struct           *dmy,
+                        int                   startrec,
+                        filep_struct         *filep,
+                        filenames_struct     *filenames,
+                        out_data_file_struct *out_data_files,
+                        out_data_struct      *out_data)
+/*******************************************************************
+  start_cell_threads
+
+  Starts nthreads worker threads.  filep, filenames, out_data_files,
+  and out_data are the main thread's copies; each worker makes its own
+  copy of them.  They must remain valid until finish_cell_threads()
+  returns.
+
+  With PREFETCH = TRUE, only one cell per worker is read ahead, since
+  each queued cell then holds all of its forcings in memory.
+*******************************************************************/
+{
+  extern THREAD_LOCAL param_set_struct param_set;
+  extern option_struct options;
+  int i;
+
+  pool.nthreads       = nthreads;
+  pool.startrec       = startrec;
+  pool.queued         = 0;
+  pool.nqueued        = 0;
+  if (options.PREFETCH)
+    pool.max_queued   = nthreads;
+  else
+    pool.max_queued   = 2*nthreads;
+  pool.done           = FALSE;
+  pool.stop           = FALSE;
+  pool.stop_seq       = 0;
+  pool.fatal          = FALSE;
+  pool.errstr[0]      = '\0';
+  for (i=0; i<N_CELL_TURNS; i++)
+    pool.turn[i] = 0;
+  pool.head           = NULL;
+  pool.tail           = NULL;
+  pool.free_jobs      = NULL;
+  pool.dmy            = dmy;
+  pool.filep          = filep;
+  pool.filenames      = filenames;
+  pool.prefetch_filep     = *filep;
+  pool.prefetch_filenames = *filenames;
+  pool.out_data_files = out_data_files;
+  pool.out_data       = out_data;
+  pool.param_set      = &param_set;
+
+  pthread_mutex_init(&pool.lock, NULL);
+  pthread_cond_init(&pool.job_ready, NULL);
+  pthread_cond_init(&pool.job_taken, NULL);
+  pthread_cond_init(&pool.turn_done, NULL);
+
+  pool.threads = (pthread_t *)calloc(nthreads, sizeof(pthread_t));
+  if (pool.threads == NULL)
+    nrerror("Memory allocation error in start_cell_threads().");
+  pool.active = TRUE;
+  for (i=0; i<nthreads; i++) {
+    if (pthread_create(&pool.threads[i], NULL, cell_worker, NULL) != 0)
+      nrerror("Unable to create worker thread in start_cell_threads().");
+  }
+
+}
+
+/****************************************************************************/
+/*				 queue_cell()                               */
+/****************************************************************************/
+int queue_cell(int              cellnum,
+               soil_con_struct *soil_con,
+               veg_con_struct  *veg_con,
+               lake_con_struct *lake_con)
+/*******************************************************************
+  queue_cell
+
+  Hands a cell whose parameters have been read to the worker threads.
+  The job takes ownership of veg_con and of the soil_con arrays by
+  taking over param_arena, and keeps a snapshot of veg_lib, which
+  read_soilparam() and read_vegparam() update for each cell.  Blocks
+  while the queue is full; then, if PREFETCH is TRUE, reads the cell's
+  forcings while the workers are busy with the cells already queued.
+  Returns ERROR if a worker has requested that no further cells be
+  run.
+*******************************************************************/
+{
+  extern THREAD_LOCAL veg_lib_struct *veg_lib;
+  extern THREAD_LOCAL arena_struct param_arena;
+  extern option_struct options;
+  cell_job_struct *job;
+  arena_struct     arena;
+  int Nlib;
+
+  pthread_mutex_lock(&pool.lock);
+  job = pool.free_jobs;
+  if (job != NULL)
+    pool.free_jobs = job->next;
+  pthread_mutex_unlock(&pool.lock);
+  if (job == NULL) {
+    job = (cell_job_struct *)calloc(1, sizeof(cell_job_struct));
+    if (job == NULL)
+      nrerror("Memory allocation error in queue_cell().");
+  }
+  arena       = job->arena;
+  job->arena  = param_arena;
+  param_arena = arena;
+  job->cellnum  = cellnum;
+  job->soil_con = *soil_con;
+  job->veg_con  = veg_con;
+  job->lake_con = *lake_con;
+  job->forcing_data  = NULL;
+  job->veg_hist_data = NULL;
+  job->veg_lib  = NULL;
+  if (!options.OUTPUT_FORCE) {
+    Nlib = veg_lib[0].NVegLibTypes + N_PET_TYPES_NON_NAT;
+    job->veg_lib = (veg_lib_struct *)arena_calloc(&job->arena, Nlib,
+                                                  sizeof(veg_lib_struct));
+    memcpy(job->veg_lib, veg_lib, Nlib*sizeof(veg_lib_struct));
+  }
+  job->next     = NULL;
+
+  pthread_mutex_lock(&pool.lock);
+  while (pool.queued >= pool.max_queued && !pool.stop)
+    pthread_cond_wait(&pool.job_taken, &pool.lock);
+  if (pool.stop) {
+    reset_arena(&job->arena);
+    job->next = pool.free_jobs;
+    pool.free_jobs = job;
+    pthread_mutex_unlock(&pool.lock);
+    return(ERROR);
+  }
+  if (options.PREFETCH) {
+    /* Only the main thread adds jobs, so the free slot remains free */
+    pthread_mutex_unlock(&pool.lock);
+    job->forcing_data = read_cell_forcing(&pool.prefetch_filep,
+                                          &pool.prefetch_filenames,
+                                          &job->soil_con, job->veg_con,
+                                          &job->veg_hist_data);
+    pthread_mutex_lock(&pool.lock);
+  }
+  if (pool.tail == NULL)
+    pool.head = job;
+  else
+    pool.tail->next = job;
+  pool.tail = job;
+  job->seq = pool.nqueued++;
+  pool.queued++;
+  pthread_cond_signal(&pool.job_ready);
+  pthread_mutex_unlock(&pool.lock);
+
+  return(0);
+
+}
+
+/****************************************************************************/
+/*			     finish_cell_threads()                          */
+/****************************************************************************/
+int finish_cell_threads(char *ErrStr)
+/*******************************************************************
+  finish_cell_threads
+
+  Waits for the worker threads to run all queued cells, then stops
+  them.  Returns ERROR, and copies the error message to ErrStr, if
+  the first failed cell had an error that ends the simulation (see
+  cell_error()); the caller should then report it with vicerror().
+  Otherwise returns 0.
+*******************************************************************/
+{
+  cell_job_struct *job;
+  int i;
+
+  pthread_mutex_lock(&pool.lock);
+  pool.done = TRUE;
+  pthread_cond_broadcast(&pool.job_ready);
+  pthread_mutex_unlock(&pool.lock);
+
+  for (i=0; i<pool.nthreads; i++)
+    pthread_join(pool.threads[i], NULL);
+
+  pool.active = FALSE;
+  while (pool.free_jobs != NULL) {
+    job = pool.free_jobs;
+    pool.free_jobs = job->next;
+    free_arena(&job->arena);
+    free((char *)job);
+  }
+  free((char *)pool.threads);
+  pthread_mutex_destroy(&pool.lock);
+  pthread_cond_destroy(&pool.job_ready);
+  pthread_cond_destroy(&pool.job_taken);
+  pthread_cond_destroy(&pool.turn_done);
+
+  if (pool.fatal) {
+    strcpy(ErrStr, pool.errstr);
+    return(ERROR);
+  }
+
+  return(0);
+
+}
+
+/****************************************************************************/
+/*			  cell_error(), cell_cancelled()                    */
+/****************************************************************************/
+int cell_error(char *ErrStr)
+/*******************************************************************
+  cell_error
+
+  Handles a grid cell error that ends the simulation.  Outside the
+  worker threads this calls vicerror(), which does not return.  In a
+  worker thread it saves ErrStr for finish_cell_threads() and returns
+  ERROR; the caller must then close the cell's files and return
+  ERROR from run_cell(), so that the cells queued before it can
+  finish before the error is reported.
+*******************************************************************/
+{
+  if (!in_worker)
+    vicerror(ErrStr);
+
+  cell_fatal = TRUE;
+  strcpy(cell_errstr, ErrStr);
+
+  return(ERROR);
+
+}
+
+int cell_cancelled()
+/*******************************************************************
+  cell_cancelled
+
+  Returns TRUE if a cell queued before the calling thread's current
+  cell has failed, in which case the current cell's output will be
+  discarded and it can stop.  Returns FALSE outside the worker
+  threads.
+*******************************************************************/
+{
+  int cancelled;
+
+  if (!in_worker) return(FALSE);
+
+  pthread_mutex_lock(&pool.lock);
+  cancelled = (pool.stop && cur_seq > pool.stop_seq);
+  pthread_mutex_unlock(&pool.lock);
+
+  return(cancelled);
+
+}
+
+/****************************************************************************/
+/*			   wait_cell_turn(), end_cell_turn()                */
+/****************************************************************************/
+void wait_cell_turn(int which)
+/*******************************************************************
+  wait_cell_turn
+
+  Blocks until all cells queued before the calling thread's current
+  cell have finished the ordered section "which" (INIT_STATE_TURN or
+  SAVE_STATE_TURN).  Each
+  cell must call wait_cell_turn() and end_cell_turn() exactly once
+  per section.  Does nothing when the cell threads are not running.
+*******************************************************************/
+{
+  if (!pool.active) return;
+
+  pthread_mutex_lock(&pool.lock);
+  while (pool.turn[which] != cur_seq)
+    pthread_cond_wait(&pool.turn_done, &pool.lock);
+  pthread_mutex_unlock(&pool.lock);
+
+}
+
+void end_cell_turn(int which)
+{
+  if (!pool.active) return;
+
+  pthread_mutex_lock(&pool.lock);
+  pool.turn[which]++;
+  pthread_cond_broadcast(&pool.turn_done);
+  pthread_mutex_unlock(&pool.lock);
+
+}
+
+/****************************************************************************/
+/*				 cell_worker()                              */
+/****************************************************************************/
+static void *cell_worker(void *arg)
+/*******************************************************************
+  cell_worker
+
+  Worker thread: takes jobs from the queue and runs them.  The model
+  state for each cell is written to a temporary file and appended to
+  the state file in cell order.  Once a cell has failed, jobs after it
+  are dropped, and cells after it that were already running discard
+  their output and do not save their state.
+*******************************************************************/
+{
+  extern THREAD_LOCAL veg_lib_struct *veg_lib;
+  extern THREAD_LOCAL param_set_struct param_set;
+  extern THREAD_LOCAL arena_struct cell_arena;
+  extern option_struct options;
+  extern global_param_struct global_param;
+
+  int                   ErrorFlag;
+  int                   Nveg_hist;
+  int                   skip;
+  int                   discard;
+  cell_job_struct      *job;
+  atmos_data_struct    *atmos;
+  veg_hist_struct     **veg_hist;
+  out_data_file_struct *out_data_files;
+  out_data_struct      *out_data;
+  filep_struct          filep;
+  filenames_struct      filenames;
+
+  in_worker = TRUE;
+
+  /** Private copies of the per-run structures **/
+  pthread_mutex_lock(&pool.lock);
+  param_set      = *pool.param_set;
+  filep          = *pool.filep;
+  filenames      = *pool.filenames;
+  out_data_files = copy_out_data_files(pool.out_data_files, pool.out_data);
+  out_data       = copy_output_list(pool.out_data);
+  pthread_mutex_unlock(&pool.lock);
+  alloc_atmos(global_param.nrecs, &atmos);
+  veg_hist  = NULL;
+  Nveg_hist = 0;
+  if (options.ASYNC_OUTPUT)
+    start_output_writer(options.OUTPUT_QUEUE_LEN);
+
+  while (TRUE) {
+
+    /** Get next job **/
+    pthread_mutex_lock(&pool.lock);
+    while (pool.head == NULL && !pool.done)
+      pthread_cond_wait(&pool.job_ready, &pool.lock);
+    job = pool.head;
+    if (job != NULL) {
+      pool.head = job->next;
+      if (pool.head == NULL) pool.tail = NULL;
+      pool.queued--;
+      pthread_cond_signal(&pool.job_taken);
+    }
+    skip = (job != NULL && pool.stop && job->seq > pool.stop_seq);
+    pthread_mutex_unlock(&pool.lock);
+    if (job == NULL) break;
+
+    /** Run the cell, unless a cell before it has failed **/
+    veg_lib = job->veg_lib;
+    cur_seq = job->seq;
+    if (!skip) {
+      cell_fatal = FALSE;
+      if (pool.filep->statefile != NULL) {
+        filep.statefile = tmpfile();
+        if (filep.statefile == NULL)
+          nrerror("Unable to open temporary state file in cell_worker().");
+      }
+      ErrorFlag = run_cell(job->cellnum, &job->soil_con, job->veg_con,
+                           &job->lake_con, job->forcing_data,
+                           job->veg_hist_data, pool.dmy, pool.startrec,
+                           &filep, &filenames, atmos, &veg_hist, &Nveg_hist,
+                           out_data_files, out_data);
+
+      /* record the failure before this cell's state turn ends, so that
+         the cells after it see it when they get their turn */
+      if (ErrorFlag == ERROR) {
+        pthread_mutex_lock(&pool.lock);
+        if (!pool.stop || job->seq < pool.stop_seq) {
+          pool.stop_seq = job->seq;
+          pool.fatal    = cell_fatal;
+          if (cell_fatal)
+            strcpy(pool.errstr, cell_errstr);
+        }
+        pool.stop = TRUE;
+        pthread_cond_broadcast(&pool.job_taken);
+        pthread_mutex_unlock(&pool.lock);
+      }
+
+      /** Once all cells before this one have finished, keep or discard
+          its output, and append its state to the state file **/
+      wait_cell_turn(SAVE_STATE_TURN);
+      pthread_mutex_lock(&pool.lock);
+      discard = (pool.stop && job->seq > pool.stop_seq);
+      pthread_mutex_unlock(&pool.lock);
+      if (discard)
+        discard_cell_output(out_data_files);
+      if (filep.statefile != NULL) {
+        if (!discard)
+          commit_state(filep.statefile, pool.filep->statefile);
+        fclose(filep.statefile);
+        filep.statefile = NULL;
+      }
+      end_cell_turn(SAVE_STATE_TURN);
+    }
+    else if (job->forcing_data != NULL) {
+      set_veg_forcing_nelem(job->veg_con);
+      free_cell_forcing(job->forcing_data, job->veg_hist_data);
+    }
+
+    /** Release the cell's parameters and recycle the job **/
+    veg_lib = NULL;
+    reset_arena(&job->arena);
+    pthread_mutex_lock(&pool.lock);
+    job->next = pool.free_jobs;
+    pool.free_jobs = job;
+    pthread_mutex_unlock(&pool.lock);
+
+  }
+
+  finish_output_writer();
+  free_atmos(global_param.nrecs, &atmos);
+  free_veg_hist(global_param.nrecs, Nveg_hist, &veg_hist);
+  free_out_data_files(&out_data_files);
+  free_out_data(&out_data);
+  free_arena(&cell_arena);
+
+  return(NULL);
+
+}
+
+static void commit_state(FILE *tmpstate, FILE *statefile)
+/*******************************************************************
+  commit_state
+
+  Copies the contents of a cell's temporary state file to the end of
+  the state file.
+*******************************************************************/
+{
+  char   buf[BUFSIZ];
+  size_t n;
+
+  rewind(tmpstate);
+  while ((n = fread(buf, 1, BUFSIZ, tmpstate)) > 0) {
+    if (fwrite(buf, 1, n, statefile) != n)
+      nrerror("Unable to write to the state file in commit_state().");
+  }
+  fflush(statefile);
+
+}
+
+static void discard_cell_output(out_data_file_struct *out_data_files)
+/*******************************************************************
+  discard_cell_output
+
+  Removes the output files of a cell that has been closed, or, with
+  OUTPUT_CONTAINER, marks the cell as not run in the containers.
+*******************************************************************/
+{
+  extern option_struct options;
+  char filename[MAXSTRING];
+  int  filenum;
+
+  for (filenum=0; filenum<options.Noutfiles; filenum++) {
+    if (out_data_files[filenum].container != NULL) {
+      discard_container_cell(&out_data_files[filenum]);
+      continue;
+    }
+    strcpy(filename, out_data_files[filenum].filename);
+    if (options.COMPRESS)
+      strcat(filename, ".gz");
+    remove(filename);
+  }
+
+}
@@ -11,7 +11,7 @@ void close_files(filep_struct         *filep,
 /**********************************************************************
 	close_files	Dag Lohmann		January 1996
 
-  This routine closes all forcing data files, and output files.
+  This routine closes all output files.
 
   Modifications:
   7-19-96  Files are now gzipped when they are closed.  This
@@ -27,28 +27,39 @@ void close_files(filep_struct         *filep,
 	      out_data_files structure.					TJB
   2006-Oct-16 Merged infiles and outfiles structs into filep_struct.	TJB
   2012-Jan-16 Removed LINK_DEBUG code					BN
+  2015-Feb-02 Forcing files are now closed by read_cell_forcing() as
+	      soon as they have been read.				GT
+  2015-Feb-02 Waits for the asynchronous output writer to write all
+	      pending records before closing the output files.		GT
+  2015-Feb-02 Output files are no longer gzipped here; when COMPRESS
+	      is TRUE they are written compressed (see
+	      open_compressed_file()).					GT
+  2015-Feb-02 Writes and frees the record buffers of BINARY output
+	      files before closing them.				GT
+  2015-Feb-02 Does the same for ASCII output files.			GT
+  2015-Feb-02 With OUTPUT_CONTAINER, there are no files to close; the
+	      cell's record count is stored in the containers.		GT
 **********************************************************************/
 {
   extern option_struct options;
   int filenum;
 
-  /**********************
-    Close All Input Files
-    **********************/
-
-  fclose(filep->forcing[0]);
-  if(options.COMPRESS) compress_files(fnames->forcing[0]);
-  if(filep->forcing[1]!=NULL) {
-    fclose(filep->forcing[1]);
-    if(options.COMPRESS) compress_files(fnames->forcing[1]);
-  }
-
   /*******************
     Close Output Files
     *******************/
   for (filenum=0; filenum<options.Noutfiles; filenum++) {
-    fclose(out_data_files[filenum].fh);
-    if(options.COMPRESS) compress_files(out_data_files[filenum].filename);
+    flush_out_data_file(&out_data_files[filenum]);
+    if (out_data_files[filenum].container != NULL)
+      finish_container_cell(&out_data_files[filenum]);
+    free((char *)out_data_files[filenum].buf);
+    out_data_files[filenum].buf = NULL;
+  }
+  flush_output_writer();
+  for (filenum=0; filenum<options.Noutfiles; filenum++) {
+    if (out_data_files[filenum].fh != NULL) {
+      fclose(out_data_files[filenum].fh);
+      out_data_files[filenum].fh = NULL;
+    }
   }
 
 }
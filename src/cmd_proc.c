@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <getopt.h>
 #include <vicNl.h>
 
 static char vcid[] = "$Id$";
@@ -20,12 +21,23 @@ filenames_struct cmd_proc(int argc, char *argv[])
             using the "-g" flag.                                KAC
   2003-Oct-03 Added -v option to display version information.		TJB
   2012-Jan-16 Removed LINK_DEBUG code					BN
+  2015-Feb-02 Added -t option to set the number of worker threads.	GT
+  2015-Feb-02 Added -shard option (also accepted as -s) to run one shard
+	      of the active cells.					GT
+  2015-Feb-02 Options are now parsed with getopt_long_only(), so that
+	      -shard is recognized as a whole word (also as
+	      -shard=<shard>/<nshards>) rather than as -s with the
+	      argument "hard".						GT
 **********************************************************************/
 {
   extern option_struct options;
-  extern int getopt();
   extern char *optarg;
+  extern int optind;
   extern char *optstring;
+  static struct option long_options[] = {
+    {"shard", required_argument, NULL, 's'},
+    {NULL, 0, NULL, 0}
+  };
 
   filenames_struct names;
   int              optchar;
@@ -38,7 +50,8 @@ filenames_struct cmd_proc(int argc, char *argv[])
   
   GLOBAL_SET = FALSE;
 
-  while((optchar = getopt(argc, argv, optstring)) != EOF) {
+  while((optchar = getopt_long_only(argc, argv, optstring,
+                                   long_options, NULL)) != EOF) {
     switch((char)optchar) {
     case 'v':
       /** Version information **/
@@ -55,6 +68,25 @@ filenames_struct cmd_proc(int argc, char *argv[])
       strcpy(names.global, optarg);
       GLOBAL_SET = TRUE;
       break;
+    case 't':
+      /** Number of Worker Threads **/
+      options.NTHREADS = atoi(optarg);
+      if (options.NTHREADS < 1) {
+        fprintf(stderr,"ERROR: The number of threads given with '-t' must be a positive integer\n");
+        usage(argv[0]);
+        exit(1);
+      }
+      break;
+    case 's':
+      /** Shard of the active cells to run, given as k/N **/
+      if (sscanf(optarg,"%d/%d",&options.SHARD,&options.NSHARDS) != 2
+          || options.NSHARDS < 1 || options.SHARD < 0
+          || options.SHARD >= options.NSHARDS) {
+        fprintf(stderr,"ERROR: The shard given with '-shard' must be of the form <shard>/<nshards>, with 0 <= shard < nshards\n");
+        usage(argv[0]);
+        exit(1);
+      }
+      break;
     default:
       /** Print Usage if Invalid Command Line Arguments **/
       usage(argv[0]);
@@ -81,13 +113,20 @@ void usage(char *temp)
 
   Modifications:
   2013-Dec-28 Removed user_def.h.				TJB
+  2015-Feb-02 Added -t option.					GT
+  2015-Feb-02 Added -shard option.				GT
 **********************************************************************/
 {
-  fprintf(stderr,"Usage: %s [-v | -o | -g<global_parameter_file>]\n",temp);
+  fprintf(stderr,"Usage: %s [-v | -o | -g<global_parameter_file> [-t<nthreads>] [-shard <shard>/<nshards>]]\n",temp);
   fprintf(stderr,"  v: display version information\n");
   fprintf(stderr,"  o: display compile-time options settings (set in vicNl_def.h)\n");
   fprintf(stderr,"  g: read model parameters from <global_parameter_file>.\n");
   fprintf(stderr,"       <global_parameter_file> is a file that contains all needed model\n");
   fprintf(stderr,"       parameters as well as model option flags, and the names and\n");
   fprintf(stderr,"       locations of all other files.\n");
+  fprintf(stderr,"  t: simulate grid cells in parallel using <nthreads> worker threads;\n");
+  fprintf(stderr,"       overrides NTHREADS in the global parameter file.\n");
+  fprintf(stderr,"  shard: run only the active grid cells whose index (counting from 0\n");
+  fprintf(stderr,"       in soil parameter file order) modulo <nshards> equals <shard>;\n");
+  fprintf(stderr,"       overrides SHARD and NSHARDS in the global parameter file.\n");
 }
@@ -1,27 +1,165 @@
+#define _GNU_SOURCE /* for fopencookie() */
 #include <stdio.h>
+#include <string.h>
 #include <strings.h>
 #include <stdlib.h>
+#include <zlib.h>
 #include <vicNl.h>
 
 static char vcid[] = "$Id$";
 
+#define COMPRESS_BUF_SIZE 65536
+
 void compress_files(char string[])
 /**********************************************************************
   compress_files.c	Keith Cherkauer		September 10, 1997
 
-  This subroutine compresses the file "string" using a system call.
+  This subroutine compresses the file "string" to "string.gz".
 
+  Modifications:
+  2015-Feb-02 Does nothing if "string" does not exist, which is the
+	      case for input files that open_file() read from their
+	      compressed (.gz) versions.				GT
+  2015-Feb-02 The file is now compressed in process, with zlib at
+	      options.COMPRESS_LEVEL, instead of by a background
+	      "gzip" process.  As before, "string" is replaced by
+	      "string.gz".  Output files are no longer passed to this
+	      routine; they are written compressed by
+	      open_compressed_file().					GT
 **********************************************************************/
 {
+  extern option_struct options;
+
+  char   zipname[MAXSTRING];
+  char   mode[4];
+  char  *buf;
+  size_t n;
+  int    status;
+  FILE  *fp;
+  gzFile gz;
 
-  char command[MAXSTRING];
+  /** input files read from name.gz are already compressed **/
+  if ((fp = fopen(string,"rb")) == NULL) return;
 
-  /** uncompress and open zipped file **/
 #if VERBOSE
   fprintf(stderr,"zipping \"%s\".\n",string);
 #endif
 
-  sprintf(command,"nice gzip -f %s &",string);
-  system(command);
+  strcpy(zipname,string);
+  strcat(zipname,".gz");
+  sprintf(mode,"wb%d",options.COMPRESS_LEVEL);
+  if ((gz = gzopen(zipname,mode)) == NULL) {
+    fprintf(stderr,"WARNING: unable to create \"%s\"; \"%s\" was not compressed.\n",zipname,string);
+    fclose(fp);
+    return;
+  }
+
+  if ((buf = (char *)malloc(COMPRESS_BUF_SIZE)) == NULL)
+    nrerror("Memory allocation error in compress_files().");
+  status = 0;
+  while ((n = fread(buf,1,COMPRESS_BUF_SIZE,fp)) > 0) {
+    if (gzwrite(gz,buf,(unsigned)n) != (int)n) {
+      status = -1;
+      break;
+    }
+  }
+  if (ferror(fp)) status = -1;
+  free((char *)buf);
+  fclose(fp);
+  if (gzclose(gz) != Z_OK) status = -1;
+
+  /** like gzip, only remove the original once it is safely compressed **/
+  if (status == 0)
+    remove(string);
+  else {
+    fprintf(stderr,"WARNING: error writing \"%s\"; \"%s\" was not compressed.\n",zipname,string);
+    remove(zipname);
+  }
+
+}
+
+/* write callbacks return the number of bytes written; on error
+   fopencookie() expects 0 (never a negative value), funopen() -1 */
+#ifdef __GLIBC__
+static ssize_t gz_write(void *cookie, const char *buf, size_t size)
+#else
+static int gz_write(void *cookie, const char *buf, int size)
+#endif
+{
+  int n;
+
+  if (size == 0) return 0;
+  n = gzwrite((gzFile)cookie, buf, (unsigned)size);
+#ifdef __GLIBC__
+  return (n <= 0) ? 0 : n;
+#else
+  return (n <= 0) ? -1 : n;
+#endif
+}
+
+static int gz_close(void *cookie)
+{
+  return (gzclose((gzFile)cookie) == Z_OK) ? 0 : EOF;
+}
+
+FILE *open_compressed_file(char string[],
+                           char type[])
+/**********************************************************************
+  open_compressed_file
+
+  Opens "string.gz" for writing and returns a stream; everything
+  written to the stream is compressed (with zlib, at
+  options.COMPRESS_LEVEL) as it is written, so that no uncompressed
+  copy of the file is ever written to disk.  The compressed file is
+  completed when the stream is closed with fclose().
+
+  Used in place of open_file() for the output files when COMPRESS is
+  TRUE.  Since the asynchronous output writer writes to this stream,
+  the compression is done by the writer thread when ASYNC_OUTPUT is
+  TRUE.
+
+  Modifications:
+  2015-Feb-02 Created to replace the "nice gzip -f" of each output
+	      file in close_files().					GT
+  2015-Feb-02 gz_write() returns 0 on error with fopencookie(), which
+	      does not accept negative return values.			GT
+**********************************************************************/
+{
+  extern option_struct options;
+
+  char   zipname[MAXSTRING];
+  char   mode[4];
+  gzFile gz;
+  FILE  *stream;
+#ifdef __GLIBC__
+  cookie_io_functions_t gz_funcs = { NULL, gz_write, NULL, gz_close };
+#endif
+
+  strcpy(zipname,string);
+  strcat(zipname,".gz");
+  sprintf(mode,"wb%d",options.COMPRESS_LEVEL);
+
+  gz = gzopen(zipname,mode);
+  if (gz != NULL) {
+    gzbuffer(gz,COMPRESS_BUF_SIZE);
+#ifdef __GLIBC__
+    stream = fopencookie(gz,type,gz_funcs);
+#else
+    stream = funopen(gz,NULL,gz_write,NULL,gz_close);
+#endif
+    if (stream == NULL) gzclose(gz);
+  }
+  else stream = NULL;
+  if (stream == NULL) {
+    fprintf(stderr,"\n Error opening \"%s\".",zipname);
+    fprintf(stderr,"\n");
+    nrerror("Unable to open File");
+  }
+
+#if VERBOSE
+  fprintf(stderr,"%s opened (compressed).\n",zipname);
+#endif
+
+  return stream;
 
 }
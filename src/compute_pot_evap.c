@@ -27,7 +27,7 @@ void compute_pot_evap(int veg_class,
 
 ****************************************************************************/
 {
-  extern veg_lib_struct *veg_lib;
+  extern THREAD_LOCAL veg_lib_struct *veg_lib;
   extern char ref_veg_ref_crop[];
 
   int NVegLibTypes;
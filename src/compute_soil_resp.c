@@ -35,7 +35,8 @@
 
   programmer: Ted Bohn
   date      : July 25, 2013
-  changes   :
+  changes   : 2015-Feb-02 Evaluates each node in one pass, without
+              temporary arrays.						GT
   references: 
 ********************************************************************************/
 
@@ -62,80 +63,61 @@ void compute_soil_resp(int Nnodes,
   extern option_struct options;
   int i;
   double Tref;
-  double *TK;
+  double TK;
   double fTLitter;
-  double *fTSoil;
+  double fTSoil;
   double fMLitter;
-  double *fMSoil;
-  double *CInterNode;
-  double *CSlowNode;
-  double *RhInter;
-  double *RhSlow;
+  double fMSoil;
+  double CInterNode;
+  double CSlowNode;
+  double RhInter;
+  double RhSlow;
 
-  /* Allocate temp arrays */
-  TK = (double*)calloc(Nnodes,sizeof(double));
-  fTSoil = (double*)calloc(Nnodes,sizeof(double));
-  fMSoil = (double*)calloc(Nnodes,sizeof(double));
-  CInterNode = (double*)calloc(Nnodes,sizeof(double));
-  CSlowNode = (double*)calloc(Nnodes,sizeof(double));
-  RhInter = (double*)calloc(Nnodes,sizeof(double));
-  RhSlow = (double*)calloc(Nnodes,sizeof(double));
-
-  /* Compute Lloyd-Taylor temperature dependence */
+  /* Litter pool: Lloyd-Taylor temperature dependence and moisture
+     dependence at the top node */
   Tref = 10+KELVIN; /* reference temperature of 10 C */
-  for (i=0; i<Nnodes; i++) {
-    TK[i] = T[i]+KELVIN;
-    if (TK[i] < T0_LT) TK[i] = T0_LT;
-  }
-  fTLitter = exp( E0_LT * ( 1/(Tref-T0_LT) - 1/(TK[0]-T0_LT) ) );
-  for (i=0; i<Nnodes; i++) {
-    fTSoil[i] = exp( E0_LT * ( 1/(Tref-T0_LT) - 1/(TK[i]-T0_LT) ) );
-  }
-
-  /* Compute moisture dependence */
-  for (i=0; i<Nnodes; i++) {
-    if (w[i] < wminFM) w[i] = wminFM;
-    if (w[i] > wmaxFM) w[i] = wmaxFM;
-  }
+  TK = T[0]+KELVIN;
+  if (TK < T0_LT) TK = T0_LT;
+  fTLitter = exp( E0_LT * ( 1/(Tref-T0_LT) - 1/(TK-T0_LT) ) );
+  if (w[0] < wminFM) w[0] = wminFM;
+  if (w[0] > wmaxFM) w[0] = wmaxFM;
   if (w[0] <= woptFM)
    fMLitter = (w[0]-wminFM)*(w[0]-wmaxFM)/((w[0]-wminFM)*(w[0]-wmaxFM)-(w[0]-woptFM)*(w[0]-woptFM));
   else
    fMLitter = Rhsat + (1-Rhsat)*(w[0]-wminFM)*(w[0]-wmaxFM)/((w[0]-wminFM)*(w[0]-wmaxFM)-(w[0]-woptFM)*(w[0]-woptFM));
   if (fMLitter > 1.0) fMLitter = 1.0;
   if (fMLitter < 0.0) fMLitter = 0.0;
-  for (i=0; i<Nnodes; i++) {
-    if (w[i] <= woptFM)
-     fMSoil[i] = (w[i]-wminFM)*(w[i]-wmaxFM)/((w[i]-wminFM)*(w[i]-wmaxFM)-(w[i]-woptFM)*(w[i]-woptFM));
-    else
-     fMSoil[i] = Rhsat + (1-Rhsat)*(w[i]-wminFM)*(w[i]-wmaxFM)/((w[i]-wminFM)*(w[i]-wmaxFM)-(w[i]-woptFM)*(w[i]-woptFM));
-    if (fMSoil[i] > 1.0) fMSoil[i] = 1.0;
-    if (fMSoil[i] < 0.0) fMSoil[i] = 0.0;
-  }
-
-  /* Compute C per node */
-  for (i=0; i<Nnodes; i++) {
-    CInterNode[i] = CInter * dZ[i]/dZTot;
-    CSlowNode[i] = CSlow * dZ[i]/dZTot;
-  }
 
   /* Compute Rh for various pools, nodes; C fluxes in [gC/m2d] */
   *RhLitter = Rfactor*(fTLitter*fMLitter/(tauLitter*365.25*24/dt))*CLitter;
   *RhInterTot = 0;
   *RhSlowTot = 0;
   for (i=0; i<Nnodes; i++) {
-    RhInter[i] = Rfactor*(fTSoil[i]*fMSoil[i]/(tauInter*365.25*24/dt))*CInterNode[i];
-    RhSlow[i] = Rfactor*(fTSoil[i]*fMSoil[i]/(tauSlow*365.25*24/dt))*CSlowNode[i];
-    *RhInterTot += RhInter[i];
-    *RhSlowTot += RhSlow[i];
-  }
 
-  free((char *)TK);
-  free((char *)fTSoil);
-  free((char *)fMSoil);
-  free((char *)CInterNode);
-  free((char *)CSlowNode);
-  free((char *)RhInter);
-  free((char *)RhSlow);
+    /* Lloyd-Taylor temperature dependence */
+    TK = T[i]+KELVIN;
+    if (TK < T0_LT) TK = T0_LT;
+    fTSoil = exp( E0_LT * ( 1/(Tref-T0_LT) - 1/(TK-T0_LT) ) );
+
+    /* Moisture dependence */
+    if (w[i] < wminFM) w[i] = wminFM;
+    if (w[i] > wmaxFM) w[i] = wmaxFM;
+    if (w[i] <= woptFM)
+     fMSoil = (w[i]-wminFM)*(w[i]-wmaxFM)/((w[i]-wminFM)*(w[i]-wmaxFM)-(w[i]-woptFM)*(w[i]-woptFM));
+    else
+     fMSoil = Rhsat + (1-Rhsat)*(w[i]-wminFM)*(w[i]-wmaxFM)/((w[i]-wminFM)*(w[i]-wmaxFM)-(w[i]-woptFM)*(w[i]-woptFM));
+    if (fMSoil > 1.0) fMSoil = 1.0;
+    if (fMSoil < 0.0) fMSoil = 0.0;
+
+    /* C per node */
+    CInterNode = CInter * dZ[i]/dZTot;
+    CSlowNode = CSlow * dZ[i]/dZTot;
+
+    RhInter = Rfactor*(fTSoil*fMSoil/(tauInter*365.25*24/dt))*CInterNode;
+    RhSlow = Rfactor*(fTSoil*fMSoil/(tauSlow*365.25*24/dt))*CSlowNode;
+    *RhInterTot += RhInter;
+    *RhSlowTot += RhSlow;
+  }
 
 }
 
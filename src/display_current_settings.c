@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <vicNl.h>
 
 static char vcid[] = "$Id$";
@@ -67,13 +68,22 @@ void display_current_settings(int                 mode,
   2014-Mar-28 Removed DIST_PRCP option.					TJB
   2014-Apr-25 Added LAI_SRC, VEGPARAM_ALB, and ALB_SRC options.		TJB
   2014-Apr-25 Added VEGPARAM_VEGCOVER and VEGCOVER_SRC options.		TJB
+  2015-Feb-02 Added NTHREADS option.					GT
+  2015-Feb-02 Added SHARD and NSHARDS options.				GT
+  2015-Feb-02 Added PREFETCH option.					GT
+  2015-Feb-02 Added ASYNC_OUTPUT and OUTPUT_QUEUE_LEN options.		GT
+  2015-Feb-02 Added COMPRESS_LEVEL option.				GT
+  2015-Feb-02 Added OUTPUT_CONTAINER option.				GT
+  2015-Feb-02 Added FORCING_CACHE.					GT
+  2015-Feb-02 Added ROOT_SOLVER option.					GT
+  2015-Feb-02 Added IMPLICIT_JACOBIAN option.				GT
 
 **********************************************************************/
 {
 
   extern char *version;
   extern option_struct options;
-  extern param_set_struct param_set;
+  extern THREAD_LOCAL param_set_struct param_set;
 
   int file_num;
 
@@ -216,10 +226,26 @@ void display_current_settings(int                 mode,
     fprintf(stderr,"IMPLICIT\t\tTRUE\n");
   else
     fprintf(stderr,"IMPLICIT\t\tFALSE\n");
+  if (options.IMPLICIT_JACOBIAN == JACOBIAN_ANALYTIC)
+    fprintf(stderr,"IMPLICIT_JACOBIAN\tANALYTIC\n");
+  else
+    fprintf(stderr,"IMPLICIT_JACOBIAN\tFD\n");
   if (options.NOFLUX)
     fprintf(stderr,"NOFLUX\t\t\tTRUE\n");
   else
     fprintf(stderr,"NOFLUX\t\t\tFALSE\n");
+  if (options.ASYNC_OUTPUT)
+    fprintf(stderr,"ASYNC_OUTPUT\t\tTRUE\n");
+  else
+    fprintf(stderr,"ASYNC_OUTPUT\t\tFALSE\n");
+  fprintf(stderr,"OUTPUT_QUEUE_LEN\t%d\n",options.OUTPUT_QUEUE_LEN);
+  fprintf(stderr,"NSHARDS\t\t\t%d\n",options.NSHARDS);
+  fprintf(stderr,"NTHREADS\t\t%d\n",options.NTHREADS);
+  if (options.PREFETCH)
+    fprintf(stderr,"PREFETCH\t\tTRUE\n");
+  else
+    fprintf(stderr,"PREFETCH\t\tFALSE\n");
+  fprintf(stderr,"SHARD\t\t\t%d\n",options.SHARD);
   if (options.MTCLIM_SWE_CORR)
     fprintf(stderr,"MTCLIM_SWE_CORR\t\tTRUE\n");
   else
@@ -246,6 +272,10 @@ void display_current_settings(int                 mode,
     fprintf(stderr,"SPATIAL_SNOW\t\tTRUE\n");
   else
     fprintf(stderr,"SPATIAL_SNOW\t\tFALSE\n");
+  if (options.ROOT_SOLVER == ROOT_NEWTON)
+    fprintf(stderr,"ROOT_SOLVER\t\tNEWTON\n");
+  else
+    fprintf(stderr,"ROOT_SOLVER\t\tBRENT\n");
   if (options.SNOW_DENSITY == DENS_BRAS)
     fprintf(stderr,"SNOW_DENSITY\t\tDENS_BRAS\n");
   else if (options.SNOW_DENSITY == DENS_SNTHRM)
@@ -305,6 +335,8 @@ void display_current_settings(int                 mode,
     }
   }
   fprintf(stderr,"GRID_DECIMAL\t\t%d\n",options.GRID_DECIMAL);
+  if (strcmp(names->forcing_cache,"MISSING") != 0)
+    fprintf(stderr,"FORCING_CACHE\t\t%s\n",names->forcing_cache);
   if (options.ALMA_INPUT)
     fprintf(stderr,"ALMA_INPUT\t\tTRUE\n");
   else
@@ -429,10 +461,15 @@ void display_current_settings(int                 mode,
     fprintf(stderr,"COMPRESS\t\tTRUE\n");
   else
     fprintf(stderr,"COMPRESS\t\tFALSE\n");
+  fprintf(stderr,"COMPRESS_LEVEL\t\t%d\n",options.COMPRESS_LEVEL);
   if (options.MOISTFRACT)
     fprintf(stderr,"MOISTFRACT\t\tTRUE\n");
   else
     fprintf(stderr,"MOISTFRACT\t\tFALSE\n");
+  if (options.OUTPUT_CONTAINER)
+    fprintf(stderr,"OUTPUT_CONTAINER\tTRUE\n");
+  else
+    fprintf(stderr,"OUTPUT_CONTAINER\tFALSE\n");
   if (options.OUTPUT_FORCE)
     fprintf(stderr,"OUTPUT_FORCE\t\tTRUE\n");
   else
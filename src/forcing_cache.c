@@ -0,0 +1,370 @@
+/*
+ * Purpose: cache of prepared forcings - stores the atmos and veg_hist
+ *          arrays computed by initialize_atmos() so that reruns can load
+ *          them instead of recomputing them
+ * Usage  : Part of VIC
+ * Created: 2015-Feb-02
+ * Notes  : Enabled by FORCING_CACHE <dir> in the global parameter file.
+ *          Each cache entry is one file, <dir>/<lat>_<lng>_<key>, where
+ *          <key> is a hash (forcing_cache_key()) of everything that
+ *          initialize_atmos() depends on: the cell's forcings as read from
+ *          its forcing files, the soil and vegetation parameters it uses,
+ *          the simulation dates and time steps, and the options that
+ *          control the disaggregation of the forcings (LW_TYPE, VP_ITER,
+ *          SNOW_STEP, etc.).  Any change to these gives a different key,
+ *          so a stale entry is never used.
+ *
+ *          File layout (native byte order and type sizes, so that the
+ *          file can be mmap()ed; every block is 8-byte aligned):
+ *
+ *            forcing_cache_header_struct
+ *            atmos fields:    N_ATMOS_FIELDS doubles blocks of
+ *                             nrecs*(NR+1) values, in the order of
+ *                             atmos_field() below, followed by snowflag
+ *                             (nrecs*(NR+1) chars, padded to 8 bytes)
+ *            veg_hist fields: albedo, LAI, vegcover; each nrecs*nveg*(NR+1)
+ *                             doubles, record by record
+ *            AboveTreeLine:   nbands chars
+ *
+ *          Entries are written to a temporary file which is then renamed,
+ *          so concurrent runs never see a partial entry.
+ */
+
+/****************************************************************************/
+/*			  PREPROCESSOR DIRECTIVES                           */
+/****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vicNl.h>
+
+static char vcid[] = "$Id$";
+
+#define FORCING_CACHE_MAGIC   "VICFC03"   /* bumped when the forcing disaggregation
+                                          changes, e.g. the MTCLIM radiation */
+#define N_ATMOS_FIELDS        15
+
+typedef struct {
+  char               magic[8];
+  unsigned long long key;
+  int                nrecs;
+  int                nvals;    /* NR+1 */
+  int                nveg;
+  int                nbands;
+} forcing_cache_header_struct;
+
+static double *atmos_field(atmos_data_struct *, int);
+static void    hash_bytes(unsigned long long *, const void *, size_t);
+static void    cache_file_name(char *, char *, soil_con_struct *,
+                               unsigned long long);
+
+#define HASH_VAL(h,x) hash_bytes((h), &(x), sizeof(x))
+
+/****************************************************************************/
+/*			     forcing_cache_key()                            */
+/****************************************************************************/
+unsigned long long forcing_cache_key(double            **forcing_data,
+                                     double           ***veg_hist_data,
+                                     soil_con_struct    *soil_con,
+                                     veg_con_struct     *veg_con,
+                                     veg_lib_struct     *veg_lib)
+/*******************************************************************
+  forcing_cache_key
+
+  Returns a 64-bit hash (FNV-1a) of all inputs of initialize_atmos():
+  the forcing arrays returned by read_cell_forcing(), the soil and
+  vegetation parameters and options that it (and the routines it
+  calls) use, and the simulation dates and time steps.
+*******************************************************************/
+{
+  extern option_struct       options;
+  extern THREAD_LOCAL param_set_struct param_set;
+  extern global_param_struct global_param;
+  extern int                 NR, NF;
+
+  unsigned long long h;
+  int                i, j, v, nveg, version;
+
+  h = 14695981039346656037ULL;
+  version = 1;
+  HASH_VAL(&h, version);
+
+  /* Simulation dates and time steps */
+  HASH_VAL(&h, global_param.nrecs);
+  HASH_VAL(&h, global_param.dt);
+  HASH_VAL(&h, global_param.startyear);
+  HASH_VAL(&h, global_param.startmonth);
+  HASH_VAL(&h, global_param.startday);
+  HASH_VAL(&h, global_param.starthour);
+  HASH_VAL(&h, global_param.wind_h);
+  HASH_VAL(&h, global_param.MAX_SNOW_TEMP);
+  HASH_VAL(&h, NR);
+  HASH_VAL(&h, NF);
+
+  /* Options */
+  HASH_VAL(&h, options.SNOW_STEP);
+  HASH_VAL(&h, options.SNOW_BAND);
+  HASH_VAL(&h, options.ALMA_INPUT);
+  HASH_VAL(&h, options.COMPUTE_TREELINE);
+  HASH_VAL(&h, options.FROZEN_SOIL);
+  HASH_VAL(&h, options.FULL_ENERGY);
+  HASH_VAL(&h, options.JULY_TAVG_SUPPLIED);
+  HASH_VAL(&h, options.LW_CLOUD);
+  HASH_VAL(&h, options.LW_TYPE);
+  HASH_VAL(&h, options.MIN_WIND_SPEED);
+  HASH_VAL(&h, options.MTCLIM_SWE_CORR);
+  HASH_VAL(&h, options.PLAPSE);
+  HASH_VAL(&h, options.SW_PREC_THRESH);
+  HASH_VAL(&h, options.VP_INTERP);
+  HASH_VAL(&h, options.VP_ITER);
+
+  /* Soil parameters */
+  HASH_VAL(&h, soil_con->lat);
+  HASH_VAL(&h, soil_con->lng);
+  HASH_VAL(&h, soil_con->time_zone_lng);
+  HASH_VAL(&h, soil_con->elevation);
+  HASH_VAL(&h, soil_con->slope);
+  HASH_VAL(&h, soil_con->aspect);
+  HASH_VAL(&h, soil_con->ehoriz);
+  HASH_VAL(&h, soil_con->whoriz);
+  HASH_VAL(&h, soil_con->annual_prec);
+  HASH_VAL(&h, soil_con->rough);
+  HASH_VAL(&h, soil_con->cell_area);
+  if (options.JULY_TAVG_SUPPLIED)
+    HASH_VAL(&h, soil_con->avgJulyAirTemp);
+  hash_bytes(&h, soil_con->Tfactor, options.SNOW_BAND*sizeof(double));
+  hash_bytes(&h, soil_con->AboveTreeLine, options.SNOW_BAND*sizeof(char));
+
+  /* Vegetation parameters (monthly climatologies of the veg_hist fields) */
+  nveg = veg_con[0].vegetat_type_num;
+  HASH_VAL(&h, nveg);
+  for (v = 0; v < nveg; v++) {
+    HASH_VAL(&h, veg_con[v].veg_class);
+    hash_bytes(&h, veg_lib[veg_con[v].veg_class].albedo, sizeof(veg_lib[0].albedo));
+    hash_bytes(&h, veg_lib[veg_con[v].veg_class].LAI, sizeof(veg_lib[0].LAI));
+    hash_bytes(&h, veg_lib[veg_con[v].veg_class].vegcover, sizeof(veg_lib[0].vegcover));
+  }
+
+  /* Forcings */
+  HASH_VAL(&h, param_set.FORCE_DT);
+  for (i = 0; i < N_FORCING_TYPES; i++) {
+    HASH_VAL(&h, param_set.TYPE[i].SUPPLIED);
+    if (!param_set.TYPE[i].SUPPLIED) continue;
+    if (i != ALBEDO && i != LAI_IN && i != VEGCOVER)
+      hash_bytes(&h, forcing_data[i], (size_t)global_param.nrecs*NF*sizeof(double));
+    else {
+      HASH_VAL(&h, param_set.TYPE[i].N_ELEM);
+      for (j = 0; j < param_set.TYPE[i].N_ELEM; j++)
+        hash_bytes(&h, veg_hist_data[i][j], (size_t)global_param.nrecs*NF*sizeof(double));
+    }
+  }
+
+  return(h);
+
+}
+
+/****************************************************************************/
+/*			     read_forcing_cache()                           */
+/****************************************************************************/
+int read_forcing_cache(char                cache_dir[],
+                       unsigned long long  key,
+                       soil_con_struct    *soil_con,
+                       int                 nveg,
+                       atmos_data_struct  *atmos,
+                       veg_hist_struct   **veg_hist)
+/*******************************************************************
+  read_forcing_cache
+
+  Loads the prepared forcings of the cell from its cache entry, if
+  there is one for this key.  Returns TRUE if atmos, veg_hist, and
+  soil_con->AboveTreeLine were loaded; FALSE if there is no (usable)
+  entry, in which case the caller must compute them.
+*******************************************************************/
+{
+  extern option_struct       options;
+  extern global_param_struct global_param;
+  extern int                 NR;
+
+  char                        filename[MAXSTRING];
+  int                         i, rec, status;
+  size_t                      n;
+  FILE                       *fp;
+  forcing_cache_header_struct header;
+
+  cache_file_name(filename, cache_dir, soil_con, key);
+  if ((fp = fopen(filename, "rb")) == NULL)
+    return(FALSE);
+
+  n = (size_t)global_param.nrecs*(NR+1);
+  status = (fread(&header, sizeof(header), 1, fp) == 1
+            && strcmp(header.magic, FORCING_CACHE_MAGIC) == 0
+            && header.key == key
+            && header.nrecs == global_param.nrecs
+            && header.nvals == NR+1
+            && header.nveg == nveg
+            && header.nbands == options.SNOW_BAND);
+  for (i = 0; i < N_ATMOS_FIELDS; i++)
+    status = status && fread(atmos_field(atmos, i), sizeof(double), n, fp) == n;
+  status = status && fread(atmos[0].snowflag, sizeof(char), n, fp) == n;
+  if (n % 8)
+    status = status && fseek(fp, 8 - n % 8, SEEK_CUR) == 0;
+  if (nveg > 0) {
+    for (rec = 0; rec < global_param.nrecs; rec++)
+      status = status && fread(veg_hist[rec][0].albedo, sizeof(double), nveg*(NR+1), fp) == nveg*(NR+1);
+    for (rec = 0; rec < global_param.nrecs; rec++)
+      status = status && fread(veg_hist[rec][0].LAI, sizeof(double), nveg*(NR+1), fp) == nveg*(NR+1);
+    for (rec = 0; rec < global_param.nrecs; rec++)
+      status = status && fread(veg_hist[rec][0].vegcover, sizeof(double), nveg*(NR+1), fp) == nveg*(NR+1);
+  }
+  /* AboveTreeLine is read last, so that it is unchanged if the entry
+     turns out to be unusable */
+  status = status && fread(soil_con->AboveTreeLine, sizeof(char), options.SNOW_BAND, fp) == options.SNOW_BAND;
+  fclose(fp);
+
+  if (!status) {
+    /* atmos and veg_hist will be recomputed by the caller */
+    fprintf(stderr,"WARNING: forcing cache file %s is not usable; recomputing forcings.\n", filename);
+    return(FALSE);
+  }
+
+  fprintf(stderr,"\nRead prepared forcings from cache file %s\n", filename);
+  return(TRUE);
+
+}
+
+/****************************************************************************/
+/*			     write_forcing_cache()                          */
+/****************************************************************************/
+void write_forcing_cache(char                cache_dir[],
+                         unsigned long long  key,
+                         soil_con_struct    *soil_con,
+                         int                 nveg,
+                         atmos_data_struct  *atmos,
+                         veg_hist_struct   **veg_hist)
+/*******************************************************************
+  write_forcing_cache
+
+  Writes the cell's prepared forcings (as computed by
+  initialize_atmos()) to its cache entry.  Failure to write the entry
+  only produces a warning.
+*******************************************************************/
+{
+  extern option_struct       options;
+  extern global_param_struct global_param;
+  extern int                 NR;
+
+  char                        filename[MAXSTRING];
+  char                        tmpname[MAXSTRING+32];
+  char                        pad[8];
+  int                         i, rec, status;
+  size_t                      n;
+  FILE                       *fp;
+  forcing_cache_header_struct header;
+
+  cache_file_name(filename, cache_dir, soil_con, key);
+  sprintf(tmpname, "%s.tmp%ld", filename, (long)getpid());
+  if ((fp = fopen(tmpname, "wb")) == NULL) {
+    fprintf(stderr,"WARNING: unable to create forcing cache file %s.\n", tmpname);
+    return;
+  }
+
+  memset(&header, 0, sizeof(header));
+  strcpy(header.magic, FORCING_CACHE_MAGIC);
+  header.key    = key;
+  header.nrecs  = global_param.nrecs;
+  header.nvals  = NR+1;
+  header.nveg   = nveg;
+  header.nbands = options.SNOW_BAND;
+  memset(pad, 0, sizeof(pad));
+
+  n = (size_t)global_param.nrecs*(NR+1);
+  status = (fwrite(&header, sizeof(header), 1, fp) == 1);
+  for (i = 0; i < N_ATMOS_FIELDS; i++)
+    status = status && fwrite(atmos_field(atmos, i), sizeof(double), n, fp) == n;
+  status = status && fwrite(atmos[0].snowflag, sizeof(char), n, fp) == n;
+  if (n % 8)
+    status = status && fwrite(pad, sizeof(char), 8 - n % 8, fp) == 8 - n % 8;
+  if (nveg > 0) {
+    for (rec = 0; rec < global_param.nrecs; rec++)
+      status = status && fwrite(veg_hist[rec][0].albedo, sizeof(double), nveg*(NR+1), fp) == nveg*(NR+1);
+    for (rec = 0; rec < global_param.nrecs; rec++)
+      status = status && fwrite(veg_hist[rec][0].LAI, sizeof(double), nveg*(NR+1), fp) == nveg*(NR+1);
+    for (rec = 0; rec < global_param.nrecs; rec++)
+      status = status && fwrite(veg_hist[rec][0].vegcover, sizeof(double), nveg*(NR+1), fp) == nveg*(NR+1);
+  }
+  status = status && fwrite(soil_con->AboveTreeLine, sizeof(char), options.SNOW_BAND, fp) == options.SNOW_BAND;
+  if (fclose(fp) != 0) status = FALSE;
+
+  if (!status || rename(tmpname, filename) != 0) {
+    fprintf(stderr,"WARNING: unable to write forcing cache file %s.\n", filename);
+    remove(tmpname);
+  }
+
+}
+
+/****************************************************************************/
+/*				atmos_field()                               */
+/****************************************************************************/
+static double *atmos_field(atmos_data_struct *atmos, int i)
+/*******************************************************************
+  atmos_field
+
+  Returns the block holding the i'th double field of atmos (see
+  alloc_atmos()).
+*******************************************************************/
+{
+  switch (i) {
+  case 0:  return(atmos[0].air_temp);
+  case 1:  return(atmos[0].Catm);
+  case 2:  return(atmos[0].channel_in);
+  case 3:  return(atmos[0].coszen);
+  case 4:  return(atmos[0].density);
+  case 5:  return(atmos[0].fdir);
+  case 6:  return(atmos[0].longwave);
+  case 7:  return(atmos[0].par);
+  case 8:  return(atmos[0].prec);
+  case 9:  return(atmos[0].pressure);
+  case 10: return(atmos[0].shortwave);
+  case 11: return(atmos[0].tskc);
+  case 12: return(atmos[0].vp);
+  case 13: return(atmos[0].vpd);
+  default: return(atmos[0].wind);
+  }
+}
+
+static void hash_bytes(unsigned long long *h, const void *p, size_t n)
+/*******************************************************************
+  hash_bytes
+
+  Adds n bytes at p to the FNV-1a hash *h.
+*******************************************************************/
+{
+  const unsigned char *c = (const unsigned char *)p;
+  size_t               i;
+
+  for (i = 0; i < n; i++) {
+    *h ^= c[i];
+    *h *= 1099511628211ULL;
+  }
+}
+
+static void cache_file_name(char               *filename,
+                            char               *cache_dir,
+                            soil_con_struct    *soil_con,
+                            unsigned long long  key)
+/*******************************************************************
+  cache_file_name
+
+  Builds the name of the cell's cache entry for this key.
+*******************************************************************/
+{
+  extern option_struct options;
+
+  char junk[32];
+
+  sprintf(junk, "%%s/%%.%if_%%.%if_%%016llx", options.GRID_DECIMAL,
+          options.GRID_DECIMAL);
+  sprintf(filename, junk, cache_dir, soil_con->lat, soil_con->lng, key);
+}
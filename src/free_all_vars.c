@@ -21,36 +21,12 @@ void free_all_vars(all_vars_struct *all_vars,
   2009-Jul-31 Removed extra veg tile for lake/wetland.			TJB
   2013-Jul-29 Added freeing of photosynthesis terms.			TJB
   2014-Mar-28 Removed DIST_PRCP option.					TJB
+  2015-Feb-02 The structures are allocated from cell_arena, which is
+	      reset here.						GT
 **********************************************************************/
 {
-  extern option_struct options;
+  extern THREAD_LOCAL arena_struct cell_arena;
 
-  int i, j, k, Nitems;
-
-  Nitems = Nveg + 1;
-
-  for(j=0;j<Nitems;j++) {
-    free((char *)all_vars[0].cell[j]);
-  }
-  free((char *)all_vars[0].cell);
-  for(j=0;j<Nitems;j++) {
-    if (options.CARBON) {
-      for ( k = 0 ; k < options.SNOW_BAND ; k++ ) {
-        free((char *)all_vars[0].veg_var[j][k].NscaleFactor);
-        free((char *)all_vars[0].veg_var[j][k].aPARLayer);
-        free((char *)all_vars[0].veg_var[j][k].CiLayer);
-        free((char *)all_vars[0].veg_var[j][k].rsLayer);
-      }
-    }
-    free((char *)(*all_vars).veg_var[j]);
-  }
-  free((char *)(*all_vars).veg_var);
-  for(j=0;j<Nitems;j++) {
-    free((char *)all_vars[0].energy[j]);
-  }
-  free((char *)all_vars[0].energy);
-  for(i=0;i<Nitems;i++)
-    free((char *)all_vars[0].snow[i]);
-  free((char *)all_vars[0].snow);
+  reset_arena(&cell_arena);
 
 }
@@ -148,14 +148,15 @@ int  solve_T_profile(double *T,
   2013-Dec-26 Removed EXCESS_ICE option.				TJB
   2013-Dec-27 Moved SPATIAL_FROST to options_struct.			TJB
   2013-Dec-27 Removed QUICK_FS option.					TJB
+  2015-Feb-02 Made saved coefficients thread-local.			GT
 **********************************************************************/
 
   extern option_struct options;
-  static double A[MAX_NODES];
-  static double B[MAX_NODES];
-  static double C[MAX_NODES];
-  static double D[MAX_NODES];
-  static double E[MAX_NODES];
+  static THREAD_LOCAL double A[MAX_NODES];
+  static THREAD_LOCAL double B[MAX_NODES];
+  static THREAD_LOCAL double C[MAX_NODES];
+  static THREAD_LOCAL double D[MAX_NODES];
+  static THREAD_LOCAL double E[MAX_NODES];
 
   double *aa, *bb, *cc, *dd, *ee, Bexp;
 
@@ -394,6 +395,10 @@ int calc_soil_thermal_fluxes(int     Nnodes,
   2013-Dec-27 Moved SPATIAL_FROST to options_struct.			TJB
   2013-Dec-27 Removed QUICK_FS option.					TJB
   2014-Mar-28 Modified cold nose hack to also cover warm nose case.	TJB
+  2015-Feb-02 The arguments of soil_thermal_eqn() are now stored in a
+	      soil_node_struct that is passed to root_brent() and
+	      error_print_solve_T_profile(), replacing the va_list
+	      argument lists and the error_solve_T_profile() wrapper.	GT
   **********************************************************************/
 
   /** Eventually the nodal ice contents will also have to be updated **/
@@ -410,6 +415,7 @@ int calc_soil_thermal_fluxes(int     Nnodes,
   double oldT;
   char ErrorString[MAXSTRING];
   double Tlast[MAX_NODES];
+  soil_node_struct node_args;
 
   Error = 0;
   Done = FALSE;
@@ -440,12 +446,24 @@ int calc_soil_thermal_fluxes(int     Nnodes,
 	  T[j] = (A[j]*T0[j]+B[j]*(T[j+1]-T[j-1])+C[j]*(T[j+1]+T[j-1])-D[j]*(T[j+1]-T[j-1])+E[j]*(0.-ice[j]))/(A[j]+2.*C[j]);
       }
       else {
+	node_args.TL        = T[j+1];
+	node_args.TU        = T[j-1];
+	node_args.T0        = T0[j];
+	node_args.moist     = moist[j];
+	node_args.max_moist = max_moist[j];
+	node_args.bubble    = bubble[j];
+	node_args.expt      = expt[j];
+	node_args.ice0      = ice[j];
+	node_args.gamma     = gamma[j-1];
+	node_args.A         = A[j];
+	node_args.B         = B[j];
+	node_args.C         = C[j];
+	node_args.D         = D[j];
+	node_args.E         = E[j];
+	node_args.EXP_TRANS = EXP_TRANS;
+	node_args.node      = j;
 	T[j] = root_brent(T0[j]-(SOIL_DT), T0[j]+(SOIL_DT),
-			  ErrorString, soil_thermal_eqn, 
-			  T[j+1], T[j-1], T0[j], moist[j], max_moist[j], 
-			  bubble[j], expt[j], 
-			  ice[j], gamma[j-1], 
-			  A[j], B[j], C[j], D[j], E[j], EXP_TRANS, j);
+			  ErrorString, soil_thermal_eqn, &node_args);
 	if(T[j] <= -998 ) {
           if (options.TFALLBACK) {
             T[j] = T0[j];
@@ -453,10 +471,7 @@ int calc_soil_thermal_fluxes(int     Nnodes,
             Tfbcount[j]++;
           }
           else {
-	    error_solve_T_profile(T[j], T[j+1], T[j-1], T0[j], moist[j], 
-				  max_moist[j], bubble[j], expt[j], ice[j], 
-				  gamma[j-1], A[j], B[j], C[j], D[j], 
-				  E[j], ErrorString);
+	    error_print_solve_T_profile(T[j], &node_args, ErrorString);
             return ( ERROR );
 	  }
 	}
@@ -478,14 +493,24 @@ int calc_soil_thermal_fluxes(int     Nnodes,
 	  T[j] = (A[j]*T0[j]+B[j]*(T[j]-T[j-1])+C[j]*(T[j]+T[j-1])-D[j]*(T[j]-T[j-1])+E[j]*(0.-ice[j]))/(A[j]+2.*C[j]);
       }
       else {
+	node_args.TL        = T[Nnodes-1];
+	node_args.TU        = T[Nnodes-2];
+	node_args.T0        = T0[Nnodes-1];
+	node_args.moist     = moist[Nnodes-1];
+	node_args.max_moist = max_moist[Nnodes-1];
+	node_args.bubble    = bubble[j];
+	node_args.expt      = expt[Nnodes-1];
+	node_args.ice0      = ice[Nnodes-1];
+	node_args.gamma     = gamma[Nnodes-2];
+	node_args.A         = A[j];
+	node_args.B         = B[j];
+	node_args.C         = C[j];
+	node_args.D         = D[j];
+	node_args.E         = E[j];
+	node_args.EXP_TRANS = EXP_TRANS;
+	node_args.node      = j;
 	T[Nnodes-1] = root_brent(T0[Nnodes-1]-SOIL_DT, T0[Nnodes-1]+SOIL_DT,
-				 ErrorString, soil_thermal_eqn, T[Nnodes-1],
-				 T[Nnodes-2], T0[Nnodes-1], 
-				 moist[Nnodes-1], max_moist[Nnodes-1], 
-				 bubble[j], expt[Nnodes-1], 
-				 ice[Nnodes-1], 
-				 gamma[Nnodes-2], 
-				 A[j], B[j], C[j], D[j], E[j], EXP_TRANS, j);
+				 ErrorString, soil_thermal_eqn, &node_args);
 	if(T[j] <= -998 ) {
           if (options.TFALLBACK) {
             T[j] = T0[j];
@@ -493,13 +518,7 @@ int calc_soil_thermal_fluxes(int     Nnodes,
             Tfbcount[j]++;
           }
           else {
-	    error_solve_T_profile(T[Nnodes-1], T[Nnodes-1],
-				  T[Nnodes-2], T0[Nnodes-1], 
-				  moist[Nnodes-1], max_moist[Nnodes-1], 
-				  bubble[Nnodes-1], 
-				  expt[Nnodes-1], ice[Nnodes-1], 
-				  gamma[Nnodes-2], 
-				  A[j], B[j], C[j], D[j], E[j], ErrorString);
+	    error_print_solve_T_profile(T[Nnodes-1], &node_args, ErrorString);
             return ( ERROR );
           }
         }
@@ -553,21 +572,8 @@ int calc_soil_thermal_fluxes(int     Nnodes,
 
 }
 
-double error_solve_T_profile (double Tj, ...) {
-
-  va_list ap;
-
-  double error;
-
-  va_start(ap,Tj);
-  error = error_print_solve_T_profile(Tj, ap);
-  va_end(ap);
-
-  return error;
-
-}
-
-double error_print_solve_T_profile(double T, va_list ap) {
+double error_print_solve_T_profile(double T, soil_node_struct *args,
+				   char *ErrorString) {
 
   double TL;
   double TU;
@@ -583,23 +589,21 @@ double error_print_solve_T_profile(double T, va_list ap) {
   double C;
   double D;
   double E;
-  char *ErrorString;
-
-  TL        = (double) va_arg(ap, double);
-  TU        = (double) va_arg(ap, double);
-  T0        = (double) va_arg(ap, double);
-  moist     = (double) va_arg(ap, double);
-  max_moist = (double) va_arg(ap, double);
-  bubble    = (double) va_arg(ap, double);
-  expt      = (double) va_arg(ap, double);
-  ice0      = (double) va_arg(ap, double);
-  gamma     = (double) va_arg(ap, double);
-  A         = (double) va_arg(ap, double);
-  B         = (double) va_arg(ap, double);
-  C         = (double) va_arg(ap, double);
-  D         = (double) va_arg(ap, double);
-  E         = (double) va_arg(ap, double);
-  ErrorString = (char *) va_arg(ap, char *);
+
+  TL        = args->TL;
+  TU        = args->TU;
+  T0        = args->T0;
+  moist     = args->moist;
+  max_moist = args->max_moist;
+  bubble    = args->bubble;
+  expt      = args->expt;
+  ice0      = args->ice0;
+  gamma     = args->gamma;
+  A         = args->A;
+  B         = args->B;
+  C         = args->C;
+  D         = args->D;
+  E         = args->E;
   
   fprintf(stderr, "%s", ErrorString);
   fprintf(stderr, "ERROR: solve_T_profile failed to converge to a solution in root_brent.  Variable values will be dumped to the screen, check for invalid values.\n");
@@ -635,6 +639,16 @@ void fda_heat_eqn(double T_2[], double res[], int n, int init, ...)
   Heat Equation for implicit scheme (used to calculate residual of the heat equation)
   passed from solve_T_profile_implicit
   By Ming Pan, mpan@Princeton.EDU
+
+  init==1: store the parameters (the remaining arguments) and set the
+           first guess T_2 = T0
+  init==0: calculate the residuals res at T_2; the remaining argument
+           (focus) is -1 for all nodes, or the node whose neighbours
+           are to be recalculated (used by fdjac3)
+  init==2: calculate the tridiagonal Jacobian of the residuals at the
+           T_2 of the last init==0 call with focus==-1; the remaining
+           arguments are the sub-, main and super-diagonals (a, b, c)
+           to be filled (IMPLICIT_JACOBIAN = ANALYTIC)
  
   Modifications:
   2006-Aug-08 Integrated with 4.1.0 (from 4.0.3).				JCA
@@ -657,44 +671,53 @@ void fda_heat_eqn(double T_2[], double res[], int n, int init, ...)
 	      now all nodes are checked and corrected if necessary.		TJB
   2013-Jan-08 Excluded bottom node from check in cold nose fix.			TJB
   2013-Dec-26 Removed EXCESS_ICE option.				TJB
+  2015-Feb-02 Made saved parameters and work arrays thread-local.	GT
+  2015-Feb-02 Added init==2, which returns the analytic Jacobian
+	      (including the dependence of ice content, kappa and Cs
+	      on T) for newt_raph when IMPLICIT_JACOBIAN = ANALYTIC.	GT
   **********************************************************************/
     
-  static double  deltat;
-  static int     FS_ACTIVE;
-  static int     NOFLUX;
-  static int     EXP_TRANS;
-  static double *T0;
-  static double *moist;
-  static double *ice;
-  static double *kappa;
-  static double *Cs;
-  static double *max_moist;
-  static double *bubble;
-  static double *expt;
-  static double *alpha;
-  static double *beta;
-  static double *gamma;
-  static double *Zsum;
-  static double Dp;
-  static double *bulk_dens_min;
-  static double *soil_dens_min;
-  static double *quartz;
-  static double *bulk_density;
-  static double *soil_density;
-  static double *organic;
-  static double *depth;
-  static int Nlayers;
+  static THREAD_LOCAL double  deltat;
+  static THREAD_LOCAL int     FS_ACTIVE;
+  static THREAD_LOCAL int     NOFLUX;
+  static THREAD_LOCAL int     EXP_TRANS;
+  static THREAD_LOCAL double *T0;
+  static THREAD_LOCAL double *moist;
+  static THREAD_LOCAL double *ice;
+  static THREAD_LOCAL double *kappa;
+  static THREAD_LOCAL double *Cs;
+  static THREAD_LOCAL double *max_moist;
+  static THREAD_LOCAL double *bubble;
+  static THREAD_LOCAL double *expt;
+  static THREAD_LOCAL double *alpha;
+  static THREAD_LOCAL double *beta;
+  static THREAD_LOCAL double *gamma;
+  static THREAD_LOCAL double *Zsum;
+  static THREAD_LOCAL double Dp;
+  static THREAD_LOCAL double *bulk_dens_min;
+  static THREAD_LOCAL double *soil_dens_min;
+  static THREAD_LOCAL double *quartz;
+  static THREAD_LOCAL double *bulk_density;
+  static THREAD_LOCAL double *soil_density;
+  static THREAD_LOCAL double *organic;
+  static THREAD_LOCAL double *depth;
+  static THREAD_LOCAL int Nlayers;
   
   // variables used to calculate residual of the heat equation
   // defined here
-  static double Ts;
-  static double Tb;
+  static THREAD_LOCAL double Ts;
+  static THREAD_LOCAL double Tb;
   
   // locally used variables
-  static double ice_new[MAX_NODES], Cs_new[MAX_NODES], kappa_new[MAX_NODES];
-  static double DT[MAX_NODES],DT_down[MAX_NODES],DT_up[MAX_NODES],T_up[MAX_NODES];
-  static double Dkappa[MAX_NODES];
-  static double Bexp;
+  static THREAD_LOCAL double ice_new[MAX_NODES], Cs_new[MAX_NODES], kappa_new[MAX_NODES];
+  static THREAD_LOCAL double DT[MAX_NODES],DT_down[MAX_NODES],DT_up[MAX_NODES],T_up[MAX_NODES];
+  static THREAD_LOCAL double Dkappa[MAX_NODES];
+  static THREAD_LOCAL double Bexp;
+  static THREAD_LOCAL int node_lidx[MAX_NODES];
+  double dice[MAX_NODES], dkappa[MAX_NODES], dCs[MAX_NODES];
+  double *a, *b, *c;
+  double c1, c_down, c_up, c_tr;
+  double soil_fract;
   char PAST_BOTTOM;
   double storage_term, flux_term, phase_term, flux_term1, flux_term2;
   double Lsum;
@@ -750,7 +773,7 @@ void fda_heat_eqn(double T_2[], double res[], int n, int init, ...)
   }
   
   // calculate residuals if init==0
-  else {
+  else if (init==0) {
     // get the range of columns to calculate
     va_start(arg_addr, init);
     focus = va_arg(arg_addr, int);
@@ -764,6 +787,7 @@ void fda_heat_eqn(double T_2[], double res[], int n, int init, ...)
 
       for (i=0; i<n+1; i++) {
 	kappa_new[i]=kappa[i];
+	node_lidx[i]=lidx;
 	if(i>=1) {  //all but surface node
 	  // update ice contents
 	  if (T_2[i-1]<0) {
@@ -956,6 +980,72 @@ void fda_heat_eqn(double T_2[], double res[], int n, int init, ...)
         res[i] = flux_term + phase_term - storage_term;
       }
     } // end of calculation of focus node only
-  } // end of non-init
+  }
+
+  // calculate the tridiagonal Jacobian if init==2
+  else {
+    // the Jacobian is evaluated at the T_2 of the last call with
+    // init==0 (focus==-1), whose nodal states and differences are
+    // reused here.  Unfrozen nodes, including those between the ice
+    // onset temperature and 0 C, have no ice content slope.
+    va_start(arg_addr, init);
+    a = va_arg(arg_addr, double *);
+    b = va_arg(arg_addr, double *);
+    c = va_arg(arg_addr, double *);
+
+    // derivatives of the nodal ice content, conductivity and heat
+    // capacity with respect to the node's own temperature
+    dkappa[0] = 0;
+    for (i=1; i<n+1; i++) {
+      dice[i] = 0;
+      dkappa[i] = 0;
+      dCs[i] = 0;
+      if (ice_new[i]>0) {
+	lidx = node_lidx[i];
+	dice[i] = -maximum_unfrozen_water_slope(T_2[i-1], max_moist[i], bubble[i], expt[i]);
+	dkappa[i] = -dice[i] * soil_conductivity_slope(moist[i], moist[i] - ice_new[i],
+						       soil_dens_min[lidx], bulk_dens_min[lidx], quartz[lidx],
+						       soil_density[lidx], bulk_density[lidx], organic[lidx]);
+	// heat capacity is linear in the ice content (water = moist - ice)
+	soil_fract = bulk_density[lidx]/soil_density[lidx];
+	dCs[i] = dice[i] * (volumetric_heat_capacity(soil_fract, 0., 1., organic[lidx])
+			    - volumetric_heat_capacity(soil_fract, 1., 0., organic[lidx]));
+      }
+    }
+
+    // flux_term1 = c1*Dkappa*DT
+    // flux_term2 = kappa_new*(c_down*DT_down - c_up*DT_up - c_tr*DT)
+    for (i=0; i<n; i++) {
+      if(!EXP_TRANS) {
+	c1 = 1./alpha[i]/alpha[i];
+	c_down = 1./gamma[i]/(0.5*alpha[i]);
+	c_up = 1./beta[i]/(0.5*alpha[i]);
+	c_tr = 0;
+      }
+      else { //grid transformation
+	c_down = 1./(Bexp*(Zsum[i+1]+1.))/(Bexp*(Zsum[i+1]+1.));
+	c_up = c_down;
+	c1 = c_down/4.;
+	c_tr = 1./2./(Bexp*(Zsum[i+1]+1.)*(Zsum[i+1]+1.));
+      }
+
+      // d res[i] / d T_2[i-1]
+      a[i] = c1*(-Dkappa[i] - dkappa[i]*DT[i]) + kappa_new[i+1]*(c_up + c_tr);
+
+      // d res[i] / d T_2[i+1]
+      c[i] = c1*Dkappa[i] + kappa_new[i+1]*(c_down - c_tr);
+      if (i<n-1)
+	c[i] += c1*dkappa[i+2]*DT[i];
+
+      // d res[i] / d T_2[i]
+      b[i] = dkappa[i+1]*(c_down*DT_down[i] - c_up*DT_up[i] - c_tr*DT[i])
+	- kappa_new[i+1]*(c_down + c_up);
+      if (i==n-1 && NOFLUX)
+	b[i] += c1*dkappa[i+1]*DT[i];
+      b[i] += ice_density*Lf*dice[i+1]/deltat;
+      b[i] -= (Cs_new[i+1] + dCs[i+1]*(T_2[i] - T0[i+1])
+	       + (Cs_new[i+1]-Cs[i+1]) + T_2[i]*dCs[i+1])/deltat;
+    }
+  }
   
 }
@@ -113,10 +113,15 @@ int  full_energy(int                  gridcell,
   2014-Mar-28 Removed DIST_PRCP option.						TJB
   2014-Apr-25 Added non-climatological veg params.				TJB
   2014-Apr-25 Added partial vegcover fraction.					TJB
+  2015-Feb-02 aero_resist is now an array on the stack instead of
+	      being allocated on every call.					GT
+  2015-Feb-02 The aerodynamic resistances of the PET reference
+	      surfaces are only computed when options.OUTPUT_PET is
+	      TRUE.								GT
 
 **********************************************************************/
 {
-  extern veg_lib_struct *veg_lib;
+  extern THREAD_LOCAL veg_lib_struct *veg_lib;
   extern option_struct   options;
   char                   overstory;
   int                    i, j, p;
@@ -142,7 +147,8 @@ int  full_energy(int                  gridcell,
   double                 displacement[3];
   double                 roughness[3];
   double                 ref_height[3];
-  double               **aero_resist;
+  double                 aero_resist_data[N_PET_TYPES+1][3];
+  double                *aero_resist[N_PET_TYPES+1];
   double                 Cv;
   double                 Le;
   double                 Melt[2*MAX_BANDS];
@@ -171,10 +177,10 @@ int  full_energy(int                  gridcell,
   energy_bal_struct    **energy;
   snow_data_struct     **snow;
 
-  /* Allocate aero_resist array */
-  aero_resist = (double**)calloc(N_PET_TYPES+1,sizeof(double*));
+  /* Initialize aero_resist array */
   for (p=0; p<N_PET_TYPES+1; p++) {
-    aero_resist[p] = (double*)calloc(3,sizeof(double));
+    aero_resist[p] = aero_resist_data[p];
+    aero_resist[p][0] = aero_resist[p][1] = aero_resist[p][2] = 0;
   }
 
   /* set local pointers */
@@ -326,7 +332,7 @@ int  full_energy(int                  gridcell,
 
       /* Loop over types of potential evap, plus current veg */
       /* Current veg will be last */
-      for (p=0; p<N_PET_TYPES+1; p++) {
+      for (p=(options.OUTPUT_PET ? 0 : N_PET_TYPES); p<N_PET_TYPES+1; p++) {
 
         /* Initialize wind speeds */
         tmp_wind[0] = atmos->wind[NR];
@@ -468,11 +474,6 @@ int  full_energy(int                  gridcell,
     }
   }
 
-  for (p=0; p<N_PET_TYPES+1; p++) {
-    free((char *)aero_resist[p]);
-  }
-  free((char *)aero_resist);
-
   /****************************
      Run Lake Model           
   ****************************/
@@ -5,14 +5,19 @@
 
 static char vcid[] = "$Id$";
 
-double func_atmos_energy_bal(double Tcanopy, va_list ap) {
+double func_atmos_energy_bal(double Tcanopy, void *ctx) {
 /**********************************************************************
   func_atmos_energy_bal.c      Keith Cherkauer        February 6, 2001
 
   This routine solves the atmospheric exchange energy balance.
 
+  Modifications:
+  2015-Feb-02 Arguments are now passed in an atmos_energy_bal_struct
+	      rather than a va_list.					GT
 **********************************************************************/
 
+  atmos_energy_bal_struct *args = (atmos_energy_bal_struct *)ctx;
+
   double  LatentHeat;
   double  NetRadiation;
   double  Ra;
@@ -25,15 +30,15 @@ double func_atmos_energy_bal(double Tcanopy, va_list ap) {
   // internal routine variables
   double  Error;
 
-  // extract variables from va_arg
-  LatentHeat    = (double)  va_arg(ap, double);
-  NetRadiation  = (double)  va_arg(ap, double);
-  Ra            = (double)  va_arg(ap, double);
-  Tair          = (double)  va_arg(ap, double);
-  atmos_density = (double)  va_arg(ap, double);
-  InSensible    = (double)  va_arg(ap, double);
+  // extract variables from argument struct
+  LatentHeat    = args->LatentHeat;
+  NetRadiation  = args->NetRadiation;
+  Ra            = args->Ra;
+  Tair          = args->Tair;
+  atmos_density = args->atmos_density;
+  InSensible    = args->InSensible;
 
-  SensibleHeat  = (double *)va_arg(ap, double *);
+  SensibleHeat  = args->SensibleHeat;
 
   // compute sensible heat flux between canopy and atmosphere
   (*SensibleHeat) = atmos_density * Cp * (Tair - Tcanopy) / Ra;
@@ -5,7 +5,7 @@
 
 static char vcid[] = "$Id$";
 
-double func_surf_energy_bal(double Ts, va_list ap)
+double func_surf_energy_bal(double Ts, void *ctx)
 /**********************************************************************
 	func_surf_energy_bal	Keith Cherkauer		January 3, 1996
 
@@ -115,10 +115,18 @@ double func_surf_energy_bal(double Ts, va_list ap)
   2014-Apr-25 Added partial veg cover fraction, bare soil evap between
 	      the plants, and re-scaling of LAI & plant fluxes from
 	      global to local and back.					TJB
+  2015-Feb-02 Made IMPLICIT error counters thread-local.		GT
+  2015-Feb-02 Arguments are now passed in a surf_energy_bal_struct
+	      rather than a va_list.  The month is taken from the
+	      struct's dmy.						GT
+  2015-Feb-02 transp is now an array on the stack, so that no memory
+	      is allocated while the energy balance is iterated.	GT
 **********************************************************************/
 {
   extern option_struct options;
-  extern veg_lib_struct *veg_lib;
+  extern THREAD_LOCAL veg_lib_struct *veg_lib;
+
+  surf_energy_bal_struct *args = (surf_energy_bal_struct *)ctx;
 
   /* define routine input variables */
 
@@ -133,7 +141,7 @@ double func_surf_energy_bal(double Ts, va_list ap)
   int Error;
   
   //error counting variables for IMPLICIT option
-  static int error_cnt0, error_cnt1;  
+  static THREAD_LOCAL int error_cnt0, error_cnt1;  
 
   double delta_t;
 
@@ -293,7 +301,7 @@ double func_surf_energy_bal(double Ts, va_list ap)
   double T1_plus;
   double D1_minus;
   double D1_plus;
-  double *transp;
+  double transp[MAX_LAYERS];
   double Ra_bare[3];
   double tmp_wind[3];
   double tmp_height;
@@ -302,133 +310,133 @@ double func_surf_energy_bal(double Ts, va_list ap)
   double tmp_ref_height[3];
 
   /************************************
-    Read variables from variable list 
+    Read variables from argument struct
   ************************************/
 
   /* general model terms */
-  rec                     = (int) va_arg(ap, int);
-  nrecs                    = (int) va_arg(ap, int);
-  month                   = (int) va_arg(ap, int);
-  VEG                     = (int) va_arg(ap, int);
-  veg_class               = (int) va_arg(ap, int);
-  iveg                    = (int) va_arg(ap, int);
-  delta_t                 = (double) va_arg(ap, double);
+  rec                     = args->rec;
+  nrecs                    = args->nrecs;
+  month                   = args->dmy->month;
+  VEG                     = args->VEG;
+  veg_class               = args->veg_class;
+  iveg                    = args->iveg;
+  delta_t                 = args->delta_t;
 
   /* soil layer terms */
-  Cs1                     = (double) va_arg(ap, double);
-  Cs2                     = (double) va_arg(ap, double);
-  D1                      = (double) va_arg(ap, double);
-  D2                      = (double) va_arg(ap, double);
-  T1_old                  = (double) va_arg(ap, double);
-  T2                      = (double) va_arg(ap, double);
-  Ts_old                  = (double) va_arg(ap, double);
-  Told_node               = (double *) va_arg(ap, double *);
-  bubble                  = (double) va_arg(ap, double);
-  dp                      = (double) va_arg(ap, double);
-  expt                    = (double) va_arg(ap, double);
-  ice0                    = (double) va_arg(ap, double);
-  kappa1                  = (double) va_arg(ap, double);
-  kappa2                  = (double) va_arg(ap, double);
-  max_moist               = (double) va_arg(ap, double);
-  moist                   = (double) va_arg(ap, double);
-
-  root                    = (float  *) va_arg(ap, float  *);
-  CanopLayerBnd           = (double *) va_arg(ap, double *);
+  Cs1                     = args->Cs1;
+  Cs2                     = args->Cs2;
+  D1                      = args->D1;
+  D2                      = args->D2;
+  T1_old                  = args->T1_old;
+  T2                      = args->T2;
+  Ts_old                  = args->Ts_old;
+  Told_node               = args->Told_node;
+  bubble                  = args->bubble;
+  dp                      = args->dp;
+  expt                    = args->expt;
+  ice0                    = args->ice0;
+  kappa1                  = args->kappa1;
+  kappa2                  = args->kappa2;
+  max_moist               = args->max_moist;
+  moist                   = args->moist;
+
+  root                    = args->root;
+  CanopLayerBnd           = args->CanopLayerBnd;
 
   /* meteorological forcing terms */
-  UnderStory              = (int) va_arg(ap, int);
-  overstory               = (int) va_arg(ap, int);
-
-  NetShortBare            = (double) va_arg(ap, double);
-  NetShortGrnd            = (double) va_arg(ap, double);
-  NetShortSnow            = (double) va_arg(ap, double);
-  Tair                    = (double) va_arg(ap, double);
-  atmos_density           = (double) va_arg(ap, double);
-  atmos_pressure          = (double) va_arg(ap, double);
-  emissivity              = (double) va_arg(ap, double);
-  LongBareIn              = (double) va_arg(ap, double);
-  LongSnowIn              = (double) va_arg(ap, double);
-  surf_atten              = (double) va_arg(ap, double);
-  vp                      = (double) va_arg(ap, double);
-  vpd                     = (double) va_arg(ap, double);
-  shortwave               = (double) va_arg(ap, double);
-  Catm                    = (double) va_arg(ap, double);
-  dryFrac                 = (double *) va_arg(ap, double *);
-
-  Wdew                    = (double *) va_arg(ap, double *);
-  displacement            = (double *) va_arg(ap, double *);
-  ra                      = (double *) va_arg(ap, double *);
-  Ra_used                 = (double *) va_arg(ap, double *);
-  rainfall                = (double) va_arg(ap, double);
-  ref_height              = (double *) va_arg(ap, double *);
-  roughness               = (double *) va_arg(ap, double *);
-  wind                    = (double *) va_arg(ap, double *);
+  UnderStory              = args->UnderStory;
+  overstory               = args->overstory;
+
+  NetShortBare            = args->NetShortBare;
+  NetShortGrnd            = args->NetShortGrnd;
+  NetShortSnow            = args->NetShortSnow;
+  Tair                    = args->Tair;
+  atmos_density           = args->atmos_density;
+  atmos_pressure          = args->atmos_pressure;
+  emissivity              = args->emissivity;
+  LongBareIn              = args->LongBareIn;
+  LongSnowIn              = args->LongSnowIn;
+  surf_atten              = args->surf_atten;
+  vp                      = args->vp;
+  vpd                     = args->vpd;
+  shortwave               = args->shortwave;
+  Catm                    = args->Catm;
+  dryFrac                 = args->dryFrac;
+
+  Wdew                    = args->Wdew;
+  displacement            = args->displacement;
+  ra                      = args->ra;
+  Ra_used                 = args->Ra_used;
+  rainfall                = args->rainfall;
+  ref_height              = args->ref_height;
+  roughness               = args->roughness;
+  wind                    = args->wind;
 
   /* latent heat terms */
-  Le                      = (double) va_arg(ap, double);
+  Le                      = args->Le;
 
   /* snowpack terms */
-  Advection               = (double) va_arg(ap, double);
-  OldTSurf                = (double) va_arg(ap, double);
-  TPack                   = (double) va_arg(ap, double);
-  Tsnow_surf              = (double) va_arg(ap, double);
-  kappa_snow              = (double) va_arg(ap, double);
-  melt_energy             = (double) va_arg(ap, double);
-  snow_coverage           = (double) va_arg(ap, double);
-  snow_density            = (double) va_arg(ap, double);
-  snow_swq                = (double) va_arg(ap, double);
-  snow_water              = (double) va_arg(ap, double);
+  Advection               = args->Advection;
+  OldTSurf                = args->OldTSurf;
+  TPack                   = args->TPack;
+  Tsnow_surf              = args->Tsnow_surf;
+  kappa_snow              = args->kappa_snow;
+  melt_energy             = args->melt_energy;
+  snow_coverage           = args->snow_coverage;
+  snow_density            = args->snow_density;
+  snow_swq                = args->snow_swq;
+  snow_water              = args->snow_water;
     
-  deltaCC                 = (double *) va_arg(ap, double *);
-  refreeze_energy         = (double *) va_arg(ap, double *);
-  vapor_flux              = (double *) va_arg(ap, double *);
-  blowing_flux            = (double *) va_arg(ap, double *);
-  surface_flux            = (double *) va_arg(ap, double *);
+  deltaCC                 = args->deltaCC;
+  refreeze_energy         = args->refreeze_energy;
+  vapor_flux              = args->vapor_flux;
+  blowing_flux            = args->blowing_flux;
+  surface_flux            = args->surface_flux;
 
   /* soil node terms */
-  Nnodes                  = (int) va_arg(ap, int);
-
-  Cs_node                 = (double *) va_arg(ap, double *);
-  T_node                  = (double *) va_arg(ap, double *);
-  Tnew_node               = (double *) va_arg(ap, double *);
-  Tnew_fbflag             = (char *) va_arg(ap, char *);
-  Tnew_fbcount            = (int *) va_arg(ap, int *);
-  alpha                   = (double *) va_arg(ap, double *);
-  beta                    = (double *) va_arg(ap, double *);
-  bubble_node             = (double *) va_arg(ap, double *);
-  Zsum_node               = (double *) va_arg(ap, double *);
-  expt_node               = (double *) va_arg(ap, double *);
-  gamma                   = (double *) va_arg(ap, double *);
-  ice_node                = (double *) va_arg(ap, double *);
-  kappa_node              = (double *) va_arg(ap, double *);
-  max_moist_node          = (double *) va_arg(ap, double *);
-  moist_node              = (double *) va_arg(ap, double *);
+  Nnodes                  = args->Nnodes;
+
+  Cs_node                 = args->Cs_node;
+  T_node                  = args->T_node;
+  Tnew_node               = args->Tnew_node;
+  Tnew_fbflag             = args->Tnew_fbflag;
+  Tnew_fbcount            = args->Tnew_fbcount;
+  alpha                   = args->alpha;
+  beta                    = args->beta;
+  bubble_node             = args->bubble_node;
+  Zsum_node               = args->Zsum_node;
+  expt_node               = args->expt_node;
+  gamma                   = args->gamma;
+  ice_node                = args->ice_node;
+  kappa_node              = args->kappa_node;
+  max_moist_node          = args->max_moist_node;
+  moist_node              = args->moist_node;
 
   /* model structures */
-  soil_con                = (soil_con_struct *) va_arg(ap, soil_con_struct *);
-  layer               = (layer_data_struct *) va_arg(ap, layer_data_struct *);
-  veg_var             = (veg_var_struct *) va_arg(ap, veg_var_struct *);
+  soil_con                = args->soil_con;
+  layer               = args->layer;
+  veg_var             = args->veg_var;
 
   /* control flags */
-  INCLUDE_SNOW            = (int) va_arg(ap, int);
-  NOFLUX                  = (int) va_arg(ap, int);
-  EXP_TRANS               = (int) va_arg(ap, int);
-  SNOWING                 = (int) va_arg(ap, int);
+  INCLUDE_SNOW            = args->INCLUDE_SNOW;
+  NOFLUX                  = args->NOFLUX;
+  EXP_TRANS               = args->EXP_TRANS;
+  SNOWING                 = args->SNOWING;
 
-  FIRST_SOLN              = (int *) va_arg(ap, int *);
+  FIRST_SOLN              = args->FIRST_SOLN;
 
   /* returned energy balance terms */
-  NetLongBare             = (double *) va_arg(ap, double *);
-  NetLongSnow             = (double *) va_arg(ap, double *);
-  T1                      = (double *) va_arg(ap, double *);
-  deltaH                  = (double *) va_arg(ap, double *);
-  fusion                  = (double *) va_arg(ap, double *);
-  grnd_flux               = (double *) va_arg(ap, double *);
-  latent_heat             = (double *) va_arg(ap, double *);
-  latent_heat_sub         = (double *) va_arg(ap, double *);
-  sensible_heat           = (double *) va_arg(ap, double *);
-  snow_flux               = (double *) va_arg(ap, double *);
-  store_error             = (double *) va_arg(ap, double *);
+  NetLongBare             = args->NetLongBare;
+  NetLongSnow             = args->NetLongSnow;
+  T1                      = args->T1;
+  deltaH                  = args->deltaH;
+  fusion                  = args->fusion;
+  grnd_flux               = args->grnd_flux;
+  latent_heat             = args->latent_heat;
+  latent_heat_sub         = args->latent_heat_sub;
+  sensible_heat           = args->sensible_heat;
+  snow_flux               = args->snow_flux;
+  store_error             = args->store_error;
 
   /* take additional variables from soil_con structure */
   b_infilt = soil_con->b_infilt;
@@ -463,7 +471,6 @@ double func_surf_energy_bal(double Ts, va_list ap)
   TMean = Ts;
   Tmp = TMean + KELVIN;
 
-  transp = (double *) calloc(options.Nlayer,sizeof(double));
   for (i=0; i<options.Nlayer; i++) {
     transp[i] = 0;
   }
@@ -752,8 +759,6 @@ double func_surf_energy_bal(double Ts, va_list ap)
   }
   else Evap = 0.;
 
-  free(transp);
-  
   /**********************************************************************
     Compute the Latent Heat Flux from the Surface and Covering Vegetation
   **********************************************************************/
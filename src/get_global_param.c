@@ -117,10 +117,22 @@ global_param_struct get_global_param(filenames_struct *names,
   2014-Mar-28 Removed DIST_PRCP option.				                TJB
   2014-Apr-25 Changed LAI_FROM_* to FROM_*; added ALB_SRC.			TJB
   2014-Apr-25 Added VEGCOVER_SRC.						TJB
+  2015-Feb-02 Added NTHREADS option; a value given on the command line
+	      (-t) takes precedence.						GT
+  2015-Feb-02 Added SHARD and NSHARDS options; values given on the
+	      command line (-shard) take precedence.  When sharding, the
+	      shard is appended to the output state file name.		GT
+  2015-Feb-02 Added PREFETCH option.						GT
+  2015-Feb-02 Added ASYNC_OUTPUT and OUTPUT_QUEUE_LEN options.			GT
+  2015-Feb-02 Added COMPRESS_LEVEL option.					GT
+  2015-Feb-02 Added OUTPUT_CONTAINER option.					GT
+  2015-Feb-02 Added FORCING_CACHE.						GT
+  2015-Feb-02 Added ROOT_SOLVER option.						GT
+  2015-Feb-02 Added IMPLICIT_JACOBIAN option.					GT
 **********************************************************************/
 {
   extern option_struct    options;
-  extern param_set_struct param_set;
+  extern THREAD_LOCAL param_set_struct param_set;
   extern int              NF, NR;
 
   char cmdstr[MAXSTRING];
@@ -134,6 +146,8 @@ global_param_struct get_global_param(filenames_struct *names,
   int  tmpstartdate;
   int  tmpenddate;
   int  lastvalidday;
+  int  shard;
+  int  nshards;
   int  lastday[] = {
             31, /* JANUARY */
             28, /* FEBRUARY */
@@ -175,6 +189,7 @@ global_param_struct get_global_param(filenames_struct *names,
   }
   file_num             = 0;
   global.skipyear      = 0;
+  strcpy(names->forcing_cache,"MISSING");
   strcpy(names->init_state,   "MISSING");
   global.stateyear     = MISSING;
   global.statemonth    = MISSING;
@@ -187,6 +202,8 @@ global_param_struct get_global_param(filenames_struct *names,
   strcpy(names->lakeparam,    "MISSING");
   strcpy(names->result_dir,   "MISSING");
   global.out_dt        = MISSING;
+  shard                = MISSING;
+  nshards              = MISSING;
 
 
   /** Read through global control file to find parameters **/
@@ -282,6 +299,11 @@ global_param_struct get_global_param(filenames_struct *names,
         if(strcasecmp("TRUE",flgstr)==0) options.IMPLICIT=TRUE;
         else options.IMPLICIT = FALSE;
       }
+      else if(strcasecmp("IMPLICIT_JACOBIAN",optstr)==0) {
+        sscanf(cmdstr,"%*s %s",flgstr);
+        if(strcasecmp("ANALYTIC",flgstr)==0) options.IMPLICIT_JACOBIAN=JACOBIAN_ANALYTIC;
+        else options.IMPLICIT_JACOBIAN = JACOBIAN_FD;
+      }
       else if(strcasecmp("EXP_TRANS",optstr)==0) {
         sscanf(cmdstr,"%*s %s",flgstr);
         if(strcasecmp("TRUE",flgstr)==0) options.EXP_TRANS=TRUE;
@@ -321,6 +343,29 @@ global_param_struct get_global_param(filenames_struct *names,
         if(strcasecmp("TRUE",flgstr)==0) options.CONTINUEONERROR=TRUE;
         else options.CONTINUEONERROR = FALSE;
       }
+      else if(strcasecmp("NTHREADS",optstr)==0) {
+        if (options.NTHREADS == 0)
+          sscanf(cmdstr,"%*s %d",&options.NTHREADS);
+      }
+      else if(strcasecmp("ASYNC_OUTPUT",optstr)==0) {
+        sscanf(cmdstr,"%*s %s",flgstr);
+        if(strcasecmp("TRUE",flgstr)==0) options.ASYNC_OUTPUT=TRUE;
+        else options.ASYNC_OUTPUT = FALSE;
+      }
+      else if(strcasecmp("OUTPUT_QUEUE_LEN",optstr)==0) {
+        sscanf(cmdstr,"%*s %d",&options.OUTPUT_QUEUE_LEN);
+      }
+      else if(strcasecmp("PREFETCH",optstr)==0) {
+        sscanf(cmdstr,"%*s %s",flgstr);
+        if(strcasecmp("TRUE",flgstr)==0) options.PREFETCH=TRUE;
+        else options.PREFETCH = FALSE;
+      }
+      else if(strcasecmp("SHARD",optstr)==0) {
+        sscanf(cmdstr,"%*s %d",&shard);
+      }
+      else if(strcasecmp("NSHARDS",optstr)==0) {
+        sscanf(cmdstr,"%*s %d",&nshards);
+      }
       else if(strcasecmp("COMPUTE_TREELINE",optstr)==0) {
         sscanf(cmdstr,"%*s %s",flgstr);
         if(strcasecmp("FALSE",flgstr)==0) options.COMPUTE_TREELINE=FALSE;
@@ -392,6 +437,11 @@ global_param_struct get_global_param(filenames_struct *names,
         sscanf(cmdstr,"%*s %s",flgstr);
         options.SW_PREC_THRESH = atof(flgstr);
       }
+      else if(strcasecmp("ROOT_SOLVER",optstr)==0) {
+        sscanf(cmdstr,"%*s %s",flgstr);
+        if(strcasecmp("NEWTON",flgstr)==0) options.ROOT_SOLVER=ROOT_NEWTON;
+        else options.ROOT_SOLVER = ROOT_BRENT;
+      }
       else if(strcasecmp("TFALLBACK",optstr)==0) {
         sscanf(cmdstr,"%*s %s",flgstr);
         if(strcasecmp("TRUE",flgstr)==0) options.TFALLBACK=TRUE;
@@ -670,6 +720,9 @@ global_param_struct get_global_param(filenames_struct *names,
       /*************************************
        Define output files
       *************************************/
+      else if(strcasecmp("FORCING_CACHE",optstr)==0) {
+        sscanf(cmdstr,"%*s %s",names->forcing_cache);
+      }
       else if(strcasecmp("RESULT_DIR",optstr)==0) {
         sscanf(cmdstr,"%*s %s",names->result_dir);
       }
@@ -684,11 +737,19 @@ global_param_struct get_global_param(filenames_struct *names,
         if(strcasecmp("TRUE",flgstr)==0) options.COMPRESS=TRUE;
         else options.COMPRESS = FALSE;
       }
+      else if(strcasecmp("COMPRESS_LEVEL",optstr)==0) {
+        sscanf(cmdstr,"%*s %d",&options.COMPRESS_LEVEL);
+      }
       else if(strcasecmp("BINARY_OUTPUT",optstr)==0) {
         sscanf(cmdstr,"%*s %s",flgstr);
         if(strcasecmp("TRUE",flgstr)==0) options.BINARY_OUTPUT=TRUE;
         else options.BINARY_OUTPUT = FALSE;
       }
+      else if(strcasecmp("OUTPUT_CONTAINER",optstr)==0) {
+        sscanf(cmdstr,"%*s %s",flgstr);
+        if(strcasecmp("TRUE",flgstr)==0) options.OUTPUT_CONTAINER=TRUE;
+        else options.OUTPUT_CONTAINER = FALSE;
+      }
       else if(strcasecmp("ALMA_OUTPUT",optstr)==0) {
         sscanf(cmdstr,"%*s %s",flgstr);
         if(strcasecmp("TRUE",flgstr)==0) options.ALMA_OUTPUT=TRUE;
@@ -872,6 +933,51 @@ global_param_struct get_global_param(filenames_struct *names,
   if ( strcmp ( names->soil, "MISSING" ) == 0 )
     nrerror("No soil parameter file has been defined.  Make sure that the global file defines the soil parameter file on the line that begins with \"SOIL\".");
 
+  // Validate number of worker threads
+  if (options.NTHREADS == 0)
+    options.NTHREADS = 1;
+  else if (options.NTHREADS < 0) {
+    sprintf(ErrStr,"The specified number of threads (%d) < 1.  Make sure that NTHREADS (or -t on the command line) is a positive integer.",options.NTHREADS);
+    nrerror(ErrStr);
+  }
+
+  // Validate asynchronous output information
+  if (options.ASYNC_OUTPUT && options.OUTPUT_QUEUE_LEN < 1) {
+    sprintf(ErrStr,"OUTPUT_QUEUE_LEN (%d) must be at least 1.",options.OUTPUT_QUEUE_LEN);
+    nrerror(ErrStr);
+  }
+
+  // Validate compression level
+  if (options.COMPRESS && (options.COMPRESS_LEVEL < 1 || options.COMPRESS_LEVEL > 9)) {
+    sprintf(ErrStr,"COMPRESS_LEVEL (%d) must be between 1 and 9.",options.COMPRESS_LEVEL);
+    nrerror(ErrStr);
+  }
+
+  // Validate output container information
+  if (options.OUTPUT_CONTAINER && options.COMPRESS) {
+    sprintf(ErrStr,"OUTPUT_CONTAINER and COMPRESS cannot both be TRUE.  Output containers are not compressed; compress them after the run if needed.");
+    nrerror(ErrStr);
+  }
+
+  // Validate sharding information
+  if (options.NSHARDS == 0) {
+    /* not set on the command line */
+    if (nshards == MISSING) {
+      if (shard != MISSING && shard != 0)
+        nrerror("SHARD was specified, but NSHARDS has not been defined.  Make sure that the global file defines NSHARDS.");
+      options.NSHARDS = 1;
+      options.SHARD = 0;
+    }
+    else {
+      options.NSHARDS = nshards;
+      options.SHARD = (shard == MISSING) ? 0 : shard;
+    }
+  }
+  if (options.NSHARDS < 1 || options.SHARD < 0 || options.SHARD >= options.NSHARDS) {
+    sprintf(ErrStr,"Invalid shard specification (shard %d of %d).  NSHARDS must be >= 1 and SHARD must be between 0 and NSHARDS-1.",options.SHARD,options.NSHARDS);
+    nrerror(ErrStr);
+  }
+
   /*******************************************************************************
     Validate parameters required for normal simulations but NOT for OUTPUT_FORCE
   *******************************************************************************/
@@ -962,6 +1068,9 @@ global_param_struct get_global_param(filenames_struct *names,
   if( options.SAVE_STATE ) {
     sprintf(names->statefile,"%s_%04i%02i%02i", names->statefile,
           global.stateyear, global.statemonth, global.stateday);
+    if (options.NSHARDS > 1)
+      sprintf(names->statefile+strlen(names->statefile),".shard%dof%d",
+            options.SHARD, options.NSHARDS);
   }
   if( options.INIT_STATE && options.SAVE_STATE && (strcmp( names->init_state, names->statefile ) == 0))  {
       sprintf(ErrStr,"The save state file (%s) has the same name as the initialize state file (%s).  The initialize state file will be destroyed when the save state file is opened.", names->statefile, names->init_state);
@@ -1078,6 +1187,12 @@ global_param_struct get_global_param(filenames_struct *names,
   fprintf(stderr,"Run Snow Model Using a Time Step of %d hours\n", 
 	  options.SNOW_STEP);
   fprintf(stderr,"Compress Output Files.........(%d)\n",options.COMPRESS);
+  fprintf(stderr,"Compression Level.............(%d)\n",options.COMPRESS_LEVEL);
+  fprintf(stderr,"Number of Worker Threads......(%d)\n",options.NTHREADS);
+  fprintf(stderr,"Prefetch Forcings.............(%d)\n",options.PREFETCH);
+  fprintf(stderr,"Asynchronous Output...........(%d)\n",options.ASYNC_OUTPUT);
+  fprintf(stderr,"Shard of Active Cells.........(%d of %d)\n",options.SHARD,
+	  options.NSHARDS);
   fprintf(stderr,"Correct Precipitation.........(%d)\n",options.CORRPREC);
   fprintf(stderr,"\n");
   fprintf(stderr,"Using %d Snow Bands\n",options.SNOW_BAND);
@@ -1089,6 +1204,8 @@ global_param_struct get_global_param(filenames_struct *names,
     fprintf(stderr,"Model output is in standard BINARY format.\n");
   else 
     fprintf(stderr,"Model output is in standard ASCII format.\n");
+  if ( options.OUTPUT_CONTAINER )
+    fprintf(stderr,"Model output of all cells is written to one container file per output file.\n");
 
 #endif // VERBOSE
 
@@ -21,16 +21,28 @@
   2012-Jan-16 Removed LINK_DEBUG code					BN
   2013-Dec-27 Removed QUICK_FS option.					TJB
   2014-May-20 Added ref_veg_vegcover.					TJB
+  2015-Feb-02 Added -t to optstring.  Made veg_lib, Error, and param_set
+	      thread-local, since they hold per-cell state; worker
+	      threads of the threaded cell driver copy them from the
+	      main thread.						GT
+  2015-Feb-02 Added -s (-shard) to optstring.				GT
+  2015-Feb-02 Added the thread-local arenas cell_arena, for a cell's
+	      model state, and param_arena, for the cell parameters
+	      read by the main thread.					GT
+  2015-Feb-02 Added the thread-local scratch arrays.			GT
 **********************************************************************/
 char *version = "4.2.b 2015-January-22";
-char *optstring = "g:vo";
+char *optstring = "g:vot:s:";
 int flag;
 
 global_param_struct global_param;
-veg_lib_struct *veg_lib;
+THREAD_LOCAL veg_lib_struct *veg_lib;
 option_struct options;
-Error_struct Error;
-param_set_struct param_set;
+THREAD_LOCAL Error_struct Error;
+THREAD_LOCAL param_set_struct param_set;
+THREAD_LOCAL arena_struct cell_arena;
+THREAD_LOCAL arena_struct param_arena;
+THREAD_LOCAL scratch_struct scratch;
 
   /**************************************************************************
     Define some reference landcover types that always exist regardless
@@ -14,7 +14,6 @@
  * COMMENTS:     
  */
 
-#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <vicNl.h>
@@ -116,6 +115,14 @@ static char vcid[] = "$Id$";
 	      and clarified the descriptions of the SPATIAL_SNOW
 	      option.								TJB
   2013-Dec-27 Moved SPATIAL_SNOW from compile-time to run-time options.	TJB
+  2015-Feb-02 The arguments of IceEnergyBalance() are now stored in an
+	      ice_energy_bal_struct that is passed to root_brent(),
+	      IceEnergyBalance() and ErrorPrintIcePackEnergyBalance(),
+	      replacing the va_list argument lists and the
+	      CalcIcePackEnergyBalance() and ErrorIcePackEnergyBalance()
+	      wrappers.								GT
+  2015-Feb-02 The surface layer temperature is found by root_solve(),
+	      with the previous surface temperature as first guess.		GT
 *****************************************************************************/
 int ice_melt(double            z2,
 	      double            aero_resist,
@@ -193,6 +200,7 @@ int ice_melt(double            z2,
   double melt_energy = 0.;
 
   char ErrorString[MAXSTRING];
+  ice_energy_bal_struct ice_args;
 
   SnowFall = snowfall / 1000.; /* convert to m */
   RainFall = rainfall / 1000.; /* convert to m */
@@ -296,19 +304,47 @@ int ice_melt(double            z2,
   blowing_flux = snow->blowing_flux;
   surface_flux = snow->surface_flux;
 
+  /* Store the arguments of the ice pack energy balance */
+  ice_args.Dt                 = (double)delta_t;
+  ice_args.Ra                 = aero_resist;
+  ice_args.Ra_used            = aero_resist_used;
+  ice_args.Z                  = z2;
+  ice_args.Displacement       = displacement;
+  ice_args.Z0                 = Z0;
+  ice_args.Wind               = wind;
+  ice_args.ShortRad           = net_short;
+  ice_args.LongRadIn          = longwave;
+  ice_args.AirDens            = density;
+  ice_args.Lv                 = Le;
+  ice_args.Tair               = air_temp;
+  ice_args.Press              = pressure * 1000.;
+  ice_args.Vpd                = vpd * 1000.;
+  ice_args.EactAir            = vp * 1000.;
+  ice_args.Rain               = RainFall;
+  ice_args.SweSurfaceLayer    = SurfaceSwq;
+  ice_args.SurfaceLiquidWater = snow->surf_water;
+  ice_args.OldTSurf           = OldTSurf;
+  ice_args.RefreezeEnergy     = &RefreezeEnergy;
+  ice_args.vapor_flux         = &vapor_flux;
+  ice_args.blowing_flux       = &blowing_flux;
+  ice_args.surface_flux       = &surface_flux;
+  ice_args.AdvectedEnergy     = &advection;
+  ice_args.DeltaColdContent   = deltaCC;
+  ice_args.Tfreeze            = Tcutoff;
+  ice_args.AvgCond            = avgcond;
+  ice_args.SWconducted        = SWconducted;
+  ice_args.SnowDepth          = snow->swq*RHO_W/RHOSNOW;
+  ice_args.SnowDensity        = RHOSNOW;
+  ice_args.SurfAttenuation    = surf_atten;
+  ice_args.qf                 = &SnowFlux;
+  ice_args.LatentHeat         = &latent_heat;
+  ice_args.LatentHeatSub      = &latent_heat_sub;
+  ice_args.SensibleHeat       = &sensible_heat;
+  ice_args.LongRadOut         = &LWnet;
+
   /* Calculate the surface energy balance for snow_temp = 0.0 */
 
-  Qnet = CalcIcePackEnergyBalance((double)0.0, (double)delta_t, aero_resist,
-				  aero_resist_used, z2, displacement, Z0, wind, net_short, 
-				  longwave, density, Le, air_temp,
-				  pressure * 1000., vpd * 1000., vp * 1000.,
-				  RainFall, SurfaceSwq, 
-				  snow->surf_water, OldTSurf, &RefreezeEnergy,
-				  &vapor_flux, &blowing_flux, &surface_flux,
-				  &advection, deltaCC, Tcutoff, avgcond, 
-				  SWconducted, snow->swq*RHO_W/RHOSNOW, 
-				  RHOSNOW, surf_atten, &SnowFlux, 
-				  &latent_heat, &latent_heat_sub, &sensible_heat, &LWnet);
+  Qnet = IceEnergyBalance((double)0.0, &ice_args);
 
   snow->vapor_flux = vapor_flux;
   snow->surface_flux = surface_flux;
@@ -417,21 +453,10 @@ int ice_melt(double            z2,
   else  {
     /* Calculate surface layer temperature using "Brent method" */
     if (SurfaceSwq > MIN_SWQ_EB_THRES) {
-      snow->surf_temp = root_brent((double)(snow->surf_temp-SNOW_DT), 
+      snow->surf_temp = root_solve(ROOT_ICE, snow->surf_temp,
+				   (double)(snow->surf_temp-SNOW_DT), 
 				   (double)(snow->surf_temp+SNOW_DT), ErrorString,
-				   IceEnergyBalance, (double)delta_t, 
-				   aero_resist, aero_resist_used, z2, 
-				   displacement, Z0, wind, net_short, longwave,
-				   density, Le, air_temp, pressure * 1000.,
-				   vpd * 1000., vp * 1000., RainFall, 
-				   SurfaceSwq,
-				   snow->surf_water, OldTSurf, &RefreezeEnergy, 
-				   &vapor_flux, &blowing_flux, &surface_flux,
-				   &advection, deltaCC, Tcutoff, 
-				   avgcond, SWconducted,
-				   snow->swq*RHO_W/RHOSNOW,
-				   RHOSNOW,surf_atten,&SnowFlux,
-				   &latent_heat, &latent_heat_sub, &sensible_heat, &LWnet);
+				   IceEnergyBalance, &ice_args);
 
       if (snow->surf_temp <= -998) {
         if (options.TFALLBACK) {
@@ -440,18 +465,7 @@ int ice_melt(double            z2,
           snow->surf_temp_fbcount++;
         }
         else {
-          ErrorIcePackEnergyBalance(snow->surf_temp, (double)delta_t, aero_resist,
-				    aero_resist_used, z2, displacement, Z0, wind, net_short,
-				    longwave, density, Le, air_temp,
-				    pressure * 1000., vpd * 1000., vp * 1000.,
-				    RainFall, SurfaceSwq, 
-				    snow->surf_water, OldTSurf, &RefreezeEnergy,
-				    &vapor_flux, &blowing_flux, &surface_flux,
-				    &advection, deltaCC, Tcutoff, 
-				    avgcond, SWconducted,		
-				    snow->swq*RHO_W/RHOSNOW, RHOSNOW,surf_atten,
-				    &SnowFlux, &latent_heat, &latent_heat_sub,
-				    &sensible_heat, &LWnet, ErrorString);
+          ErrorPrintIcePackEnergyBalance(snow->surf_temp, &ice_args, ErrorString);
           return( ERROR );
         }
       }
@@ -461,17 +475,7 @@ int ice_melt(double            z2,
       snow->surf_temp = 999;
     }
     if (snow->surf_temp > -998 && snow->surf_temp < 999) {
-      Qnet = CalcIcePackEnergyBalance(snow->surf_temp, (double)delta_t, aero_resist,
-				      aero_resist_used, z2, displacement, Z0, wind, net_short,
-				      longwave, density, Le, air_temp,
-				      pressure * 1000., vpd * 1000., 
-				      vp * 1000.,RainFall, SurfaceSwq, 
-				      snow->surf_water, OldTSurf, &RefreezeEnergy, 
-				      &vapor_flux, &blowing_flux, &surface_flux,
-				      &advection, deltaCC, Tcutoff, 
-				      avgcond, SWconducted, snow->swq*RHO_W/RHOSNOW, 
-				      RHOSNOW,surf_atten, &SnowFlux, &latent_heat,
-				      &latent_heat_sub, &sensible_heat, &LWnet);
+      Qnet = IceEnergyBalance(snow->surf_temp, &ice_args);
 
       snow->vapor_flux = vapor_flux;
       snow->surface_flux = surface_flux;
@@ -664,54 +668,9 @@ int ice_melt(double            z2,
 
 }
 
-/*****************************************************************************
-  Function name: CalcIcePackEnergyBalance()
-
-  Purpose      : Dummy function to make a direct call to
-                 IceEnergyBalance() possible.
-
-  Required     : 
-    double TSurf - IcePack surface temperature (C)
-    other arguments required by IcePackEnergyBalance()
-
-  Returns      :
-    double Qnet - Net energy exchange at the IcePack snow surface (W/m^2)
-
-  Modifies     : none
-
-  Comments     : function is local to this module
-*****************************************************************************/
-double CalcIcePackEnergyBalance(double Tsurf, ...)
-{
-
-  va_list ap;                   /* Used in traversing variable argument list
-                                 */ 
-  double Qnet;                   /* Net energy exchange at the IcePack snow
-                                   surface (W/m^2) */
-
-  va_start(ap, Tsurf);
-  Qnet = IceEnergyBalance(Tsurf, ap);
-  va_end(ap);
-  
-  return Qnet;
-}
-
-double ErrorIcePackEnergyBalance(double Tsurf, ...)
-{
-
-  va_list ap;                   /* Used in traversing variable argument list
-                                 */ 
-  double Qnet;                   /* Net energy exchange at the IcePack snow
-                                   surface (W/m^2) */
-
-  va_start(ap, Tsurf);
-  Qnet = ErrorPrintIcePackEnergyBalance(Tsurf, ap);
-  va_end(ap);
-  
-  return Qnet;
-}
-
-double ErrorPrintIcePackEnergyBalance(double TSurf, va_list ap)
+double ErrorPrintIcePackEnergyBalance(double TSurf,
+				      ice_energy_bal_struct *args,
+				      char *ErrorString)
 {
 
 
@@ -760,46 +719,44 @@ double ErrorPrintIcePackEnergyBalance(double TSurf, va_list ap)
   double *SensibleHeat;		/* Sensible heat exchange at surface (W/m2) */
   double *LWnet;
 
-  char *ErrorString;
 
   /* initialize variables */
-  Dt                 = (double) va_arg(ap, double);
-  Ra                 = (double) va_arg(ap, double);
-  Ra_used            = (double *) va_arg(ap, double *);
-  Z                  = (double) va_arg(ap, double);
-  Displacement       = (double) va_arg(ap, double);
-  Z0                 = (double) va_arg(ap, double);
-  Wind               = (double) va_arg(ap, double);
-  ShortRad           = (double) va_arg(ap, double);
-  LongRadIn          = (double) va_arg(ap, double);
-  AirDens            = (double) va_arg(ap, double);
-  Lv                 = (double) va_arg(ap, double);
-  Tair               = (double) va_arg(ap, double);
-  Press              = (double) va_arg(ap, double);
-  Vpd                = (double) va_arg(ap, double);
-  EactAir            = (double) va_arg(ap, double);
-  Rain               = (double) va_arg(ap, double);
-  SweSurfaceLayer    = (double) va_arg(ap, double);
-  SurfaceLiquidWater = (double) va_arg(ap, double);
-  OldTSurf           = (double) va_arg(ap, double);
-  RefreezeEnergy     = (double *) va_arg(ap, double *);
-  vapor_flux         = (double *) va_arg(ap, double *);
-  blowing_flux       = (double *) va_arg(ap, double *);
-  surface_flux       = (double *) va_arg(ap, double *);
-  AdvectedEnergy     = (double *) va_arg(ap, double *);
-  DeltaColdContent   = (double) va_arg(ap, double);
-  Tfreeze            = (double) va_arg(ap, double);
-  AvgCond            = (double) va_arg(ap, double);
-  SWconducted        = (double) va_arg(ap, double);
-  SnowDepth          = (double) va_arg(ap, double);
-  SnowDensity        = (double) va_arg(ap, double);
-  SurfAttenuation    = (double) va_arg(ap, double);
-  GroundFlux         = (double *) va_arg(ap, double *);
-  LatentHeat         = (double *) va_arg(ap, double *);
-  LatentHeatSub      = (double *) va_arg(ap, double *);
-  SensibleHeat       = (double *) va_arg(ap, double *);
-  LWnet              = (double *) va_arg(ap, double *);
-  ErrorString        = (char *) va_arg(ap, double *);
+  Dt                 = args->Dt;
+  Ra                 = args->Ra;
+  Ra_used            = args->Ra_used;
+  Z                  = args->Z;
+  Displacement       = args->Displacement;
+  Z0                 = args->Z0;
+  Wind               = args->Wind;
+  ShortRad           = args->ShortRad;
+  LongRadIn          = args->LongRadIn;
+  AirDens            = args->AirDens;
+  Lv                 = args->Lv;
+  Tair               = args->Tair;
+  Press              = args->Press;
+  Vpd                = args->Vpd;
+  EactAir            = args->EactAir;
+  Rain               = args->Rain;
+  SweSurfaceLayer    = args->SweSurfaceLayer;
+  SurfaceLiquidWater = args->SurfaceLiquidWater;
+  OldTSurf           = args->OldTSurf;
+  RefreezeEnergy     = args->RefreezeEnergy;
+  vapor_flux         = args->vapor_flux;
+  blowing_flux       = args->blowing_flux;
+  surface_flux       = args->surface_flux;
+  AdvectedEnergy     = args->AdvectedEnergy;
+  DeltaColdContent   = args->DeltaColdContent;
+  Tfreeze            = args->Tfreeze;
+  AvgCond            = args->AvgCond;
+  SWconducted        = args->SWconducted;
+  SnowDepth          = args->SnowDepth;
+  SnowDensity        = args->SnowDensity;
+  SurfAttenuation    = args->SurfAttenuation;
+  GroundFlux         = args->qf;
+  LatentHeat         = args->LatentHeat;
+  LatentHeatSub      = args->LatentHeatSub;
+  SensibleHeat       = args->SensibleHeat;
+  LWnet              = args->LongRadOut;
   
   /* print variables */
   fprintf(stderr, "%s", ErrorString);
@@ -4,9 +4,19 @@
 
 static char vcid[] = "$Id$";
 
+static double forcing_value(double **, int, int);
+static int    is_flux_forcing(int);
+static int    local_forcing_used(int);
+static int   *local_time_index(int, int, int, int);
+static double hourly_sum(const double *, int);
+static double step_sum(const double *);
+static void   veg_hist_forcing(double *, double **, int, int, int, int,
+                               const int *, double);
+
 void initialize_atmos(atmos_data_struct        *atmos,
                       dmy_struct               *dmy,
-		      FILE                    **infile,
+		      double                  **forcing_data,
+		      double                 ***veg_hist_data,
 		      veg_lib_struct           *veg_lib,
 		      veg_con_struct           *veg_con,
                       veg_hist_struct         **veg_hist,
@@ -134,10 +144,31 @@ void initialize_atmos(atmos_data_struct        *atmos,
   2013-Dec-27 Moved OUTPUT_FORCE to options_struct.				TJB
   2014-Apr-25 Added LAI and albedo.						TJB
   2014-Apr-25 Added partial vegcover fraction.					TJB
+  2015-Feb-02 Replaced the forcing file pointers in the argument list
+	      with the forcing arrays read by read_cell_forcing(), so that
+	      the forcings can be read ahead of time.  The arrays are
+	      freed here.							GT
+  2015-Feb-02 Fixed the MIN_WIND_SPEED check for daily wind, which
+	      used the loop index after the loop and so went one past
+	      the end of atmos[rec].wind when NF == 1; it now checks
+	      wind[NR].  This matters now that the records of each
+	      atmos field are contiguous.				GT
+  2015-Feb-02 The forcing arrays are now freed by free_cell_forcing().	GT
+  2015-Feb-02 Restructured: the map from model steps to local hours is
+	      computed once, the supplied forcings are converted and
+	      referenced to local time in one pass (only those that are
+	      used), and the atmos fields are filled in two passes over the
+	      records instead of one pass per field.  Fixed the sub-daily
+	      QAIR and REL_HUMID conversions, which used pressure and air
+	      temperature of the wrong snow step (one past the end); the
+	      daily tmax and tmin derived from sub-daily AIR_TEMP, which
+	      were taken from the first day for every day; and the
+	      sub-daily forcing index on the padded local days, which
+	      could run past the ends of the forcing arrays.		GT
 **********************************************************************/
 {
   extern option_struct       options;
-  extern param_set_struct    param_set;
+  extern THREAD_LOCAL param_set_struct    param_set;
   extern global_param_struct global_param;
   extern int                 NR, NF;
 
@@ -149,11 +180,16 @@ void initialize_atmos(atmos_data_struct        *atmos,
   int     day;
   int     hour;
   int     rec;
-  int     step;
   int     idx;
+  int     n;
+  int     dt;
   int    *tmaxhour;
   int    *tminhour;
-  double  deltat;
+  int    *step_hour;
+  int    *src_idx[2];
+  int     hour_shift;
+  int     prec_from;
+  int     wind_from_en;
   double  cell_area;
   double  theta_l;
   double  theta_s;
@@ -165,14 +201,10 @@ void initialize_atmos(atmos_data_struct        *atmos,
   double  ehoriz;
   double  whoriz;
   double  annual_prec;
-  double  wind_h;
-  double  roughness;
   double  avgJulyAirTemp;
   double *Tfactor;
   char   *AboveTreeLine;
-  double  min_Tfactor;
-  double  shortwave;
-  double  svp_tair;
+  double  min_Tfactor = 0;
   double *hourlyrad;
   double *fdir;
   double *prec;
@@ -181,19 +213,14 @@ void initialize_atmos(atmos_data_struct        *atmos,
   double *tair;
   double *tskc;
   double *daily_vp;
-  double *dailyrad;
-  double  min, max;
-  double  rainonly;
+  double *local;
+  double  value;
   int     Ndays;
   int     stepspday;
   double  sum, sum2;
-  double ***veg_hist_data;
   double ***local_veg_hist_data;
-  double **forcing_data;
   double **local_forcing_data;
   int     type;
-  double  air_temp;
-  double  factor;
   double  delta_t_minus;
   double  delta_t_plus;
   int have_dewpt;
@@ -201,21 +228,20 @@ void initialize_atmos(atmos_data_struct        *atmos,
   int hour_offset_int;
   int tmp_starthour, tmp_endhour;
   int local_startyear, local_startmonth, local_startday;
-  int local_starthour, local_endhour;
+  int local_starthour;
   int day_in_year, year, month, days_in_month;
   int tmp_nrecs;
   int Ndays_local;
   dmy_struct *dmy_local;
   dmy_struct dmy_tmp;
   int month_days[12] = {31,28,31,30,31,30,31,31,30,31,30,31};
-  int fstepspday;
   int tmp_int;
   double tmp_double;
+  double sw_day_mean;
   int save_prec_supplied;
   int save_wind_supplied;
   int save_vp_supplied;
 
-  wind_h = global_param.wind_h;
   theta_l = (double)soil_con->time_zone_lng;
   theta_s = (double)soil_con->lng;
   hour_offset = (theta_l-theta_s)*24/360;
@@ -231,7 +257,6 @@ void initialize_atmos(atmos_data_struct        *atmos,
   ehoriz = soil_con->ehoriz;
   whoriz = soil_con->whoriz;
   annual_prec = soil_con->annual_prec;
-  roughness = soil_con->rough;
   cell_area = soil_con->cell_area;
   avgJulyAirTemp = soil_con->avgJulyAirTemp;
   Tfactor = soil_con->Tfactor;
@@ -255,11 +280,7 @@ void initialize_atmos(atmos_data_struct        *atmos,
 //    nrerror("Input meteorological forcing files must contain either WIND (wind speed) or both WIND_N (north component of wind speed) and WIND_E (east component of wind speed); check input files\n");
 
   /* Assign N_ELEM for veg-dependent forcings */
-  if (!options.OUTPUT_FORCE) {
-    param_set.TYPE[LAI_IN].N_ELEM = veg_con[0].vegetat_type_num;
-    param_set.TYPE[VEGCOVER].N_ELEM = veg_con[0].vegetat_type_num;
-    param_set.TYPE[ALBEDO].N_ELEM = veg_con[0].vegetat_type_num;
-  }
+  set_veg_forcing_nelem(veg_con);
   /* compute number of simulation days */
   tmp_starthour = 0;
   tmp_endhour = 24 - global_param.dt;
@@ -350,127 +371,77 @@ void initialize_atmos(atmos_data_struct        *atmos,
   tminhour   = (int *)    calloc(Ndays_local, sizeof(int));
   tskc       = (double *) calloc(Ndays_local*24, sizeof(double));
   daily_vp   = (double *) calloc(Ndays_local, sizeof(double));
-  dailyrad   = (double *) calloc(Ndays_local, sizeof(double));
   fdir       = (double *) calloc(Ndays_local*24, sizeof(double));
+  step_hour  = (int *)    calloc(global_param.nrecs*NF, sizeof(int));
   
   if (hourlyrad == NULL || prec == NULL || tair == NULL || tmax == NULL ||
       tmaxhour == NULL || tmin == NULL || tminhour == NULL || tskc == NULL ||
-      daily_vp == NULL || dailyrad == NULL || fdir == NULL)
+      daily_vp == NULL || fdir == NULL || step_hour == NULL)
     nrerror("Memory allocation failure in initialize_atmos()");
   
-  /*******************************
-    read in meteorological data 
-  *******************************/
-
-  forcing_data = read_forcing_data(infile, global_param, &veg_hist_data);
-  
-  fprintf(stderr,"\nRead meteorological forcing file\n");
-
   /*************************************************
     Pre-processing
   *************************************************/
 
   /*************************************************
-    Convert units from ALMA to VIC standard, if necessary
-  *************************************************/
-  if (options.ALMA_INPUT) {
-    for (type=0; type<N_FORCING_TYPES; type++) {
-      if (param_set.TYPE[type].SUPPLIED) {
-        /* Convert moisture flux rates to accumulated moisture flux per time step */
-        if (   type == PREC
-            || type == RAINF
-            || type == CRAINF
-            || type == LSRAINF
-            || type == SNOWF
-            || type == CSNOWF
-            || type == LSSNOWF
-            || type == CHANNEL_IN
-           ) {
-          for (idx=0; idx<(global_param.nrecs*NF); idx++) {
-            forcing_data[type][idx] *= param_set.FORCE_DT[param_set.TYPE[type].SUPPLIED-1] * 3600;
-          }
-        }
-        /* Convert temperatures from K to C */
-        else if (   type == AIR_TEMP
-                 || type == TMIN
-                 || type == TMAX
-                ) {
-          for (idx=0; idx<(global_param.nrecs*NF); idx++) {
-            forcing_data[type][idx] -= KELVIN;
-          }
-        }
-      }
-    }
-  }
-  else {
-    for (type=0; type<N_FORCING_TYPES; type++) {
-      if (param_set.TYPE[type].SUPPLIED) {
-        /* Convert pressures from kPa to Pa */
-        if (   type == PRESSURE
-            || type == VP
-           ) {
-          for (idx=0; idx<(global_param.nrecs*NF); idx++) {
-            forcing_data[type][idx] *= kPa2Pa;
-          }
-        }
-      }
-    }
-  }
-
-  /*************************************************
-    If provided, translate rainfall and snowfall
-    into total precipitation
-    NOTE: this overwrites any PREC data that was supplied
+    If provided, rainfall and snowfall are translated
+    into total precipitation, and WIND_E and WIND_N
+    into WIND, when the forcings are referenced to
+    local time below
+    NOTE: this overwrites any PREC or WIND data that
+    was supplied
   *************************************************/
 
+  prec_from = PREC;
   if(param_set.TYPE[RAINF].SUPPLIED && param_set.TYPE[SNOWF].SUPPLIED) {
     /* rainfall and snowfall supplied */
-    if (forcing_data[PREC] == NULL) {
-      forcing_data[PREC] = (double *)calloc((global_param.nrecs * NF),sizeof(double));
-    }
-    for (idx=0; idx<(global_param.nrecs*NF); idx++) {
-      forcing_data[PREC][idx] = forcing_data[RAINF][idx] + forcing_data[SNOWF][idx];
-    }
+    prec_from = RAINF;
     param_set.TYPE[PREC].SUPPLIED = param_set.TYPE[RAINF].SUPPLIED;
   }
   else if(param_set.TYPE[CRAINF].SUPPLIED && param_set.TYPE[LSRAINF].SUPPLIED
     && param_set.TYPE[CSNOWF].SUPPLIED && param_set.TYPE[LSSNOWF].SUPPLIED) {
     /* convective and large-scale rainfall and snowfall supplied */
-    if (forcing_data[PREC] == NULL) {
-      forcing_data[PREC] = (double *)calloc((global_param.nrecs * NF),sizeof(double));
-    }
-    for (idx=0; idx<(global_param.nrecs*NF); idx++) {
-      forcing_data[PREC][idx] = forcing_data[CRAINF][idx] + forcing_data[LSRAINF][idx]
-                               + forcing_data[CSNOWF][idx] + forcing_data[LSSNOWF][idx];
-    }
+    prec_from = LSRAINF;
     param_set.TYPE[PREC].SUPPLIED = param_set.TYPE[LSRAINF].SUPPLIED;
   }
 
-  /*************************************************
-    If provided, translate WIND_E and WIND_N into WIND
-    NOTE: this overwrites any WIND data that was supplied
-  *************************************************/
-
+  wind_from_en = FALSE;
   if(param_set.TYPE[WIND_E].SUPPLIED && param_set.TYPE[WIND_N].SUPPLIED) {
     /* specific wind_e and wind_n supplied */
-    if (forcing_data[WIND] == NULL) {
-      forcing_data[WIND] = (double *)calloc((global_param.nrecs * NF),sizeof(double));
-    }
-    for (idx=0; idx<(global_param.nrecs*NF); idx++) {
-      forcing_data[WIND][idx] = sqrt( forcing_data[WIND_E][idx]*forcing_data[WIND_E][idx]
-                                    + forcing_data[WIND_N][idx]*forcing_data[WIND_N][idx] );
-    }
+    wind_from_en = TRUE;
     param_set.TYPE[WIND].SUPPLIED = param_set.TYPE[WIND_E].SUPPLIED;
   }
 
+  /*************************************************
+    Time index map: local hour at which each snow
+    step of each model step starts.  The local arrays
+    start at hour 0 of the first local day.
+  *************************************************/
+
+  hour_shift = (global_param.starthour - hour_offset_int < 0) ? 24 : 0;
+  for (rec = 0; rec < global_param.nrecs; rec++)
+    for (i = 0; i < NF; i++)
+      step_hour[rec*NF+i] = rec*global_param.dt + i*options.SNOW_STEP
+                            + global_param.starthour - hour_offset_int + hour_shift;
+
   /*************************************************
     Create new forcing arrays referenced to local time
     This will simplify subsequent data processing
+    Units are converted from ALMA to VIC standard, or
+    from kPa to Pa, as the arrays are filled.
   *************************************************/
 
   local_forcing_data = (double **) calloc(N_FORCING_TYPES, sizeof(double*));
   local_veg_hist_data = (double ***) calloc(N_FORCING_TYPES, sizeof(double**));
+  if (local_forcing_data == NULL || local_veg_hist_data == NULL)
+    nrerror("Memory allocation failure in initialize_atmos()");
+  src_idx[0] = src_idx[1] = NULL;
   for (type=0; type<N_FORCING_TYPES; type++) {
+    /* Only the forcings that are used below are referenced to local
+       time; precipitation and vapor pressure are always needed */
+    if (!local_forcing_used(type)
+        || !(param_set.TYPE[type].SUPPLIED || type == PREC || type == VP))
+      continue;
     // Allocate enough space for hourly data
     if (type != ALBEDO && type != LAI_IN && type != VEGCOVER) {
       if ( ( local_forcing_data[type] = (double *)calloc(Ndays_local*24, sizeof(double)) ) == NULL ) {
@@ -487,292 +458,107 @@ void initialize_atmos(atmos_data_struct        *atmos,
         }
       }
     }
-    if (param_set.TYPE[type].SUPPLIED) {
-      if (param_set.FORCE_DT[param_set.TYPE[type].SUPPLIED-1] == 24) {
-        // Daily forcings in non-local time will straddle local day boundaries and need to be padded with an extra day at start or end
-        for (idx=0; idx<Ndays_local; idx++) {
-          i = idx;
-          if (hour_offset_int > 0) i--; // W. Hemisphere, in GMT time
-          if (i < 0) i = 0; // W. Hemisphere, in GMT time; pad extra day in front
-          if (i >= Ndays) i = Ndays-1; // E. Hemisphere, in GMT time; pad extra day at end
-          if (type != ALBEDO && type != LAI_IN && type != VEGCOVER) {
-            local_forcing_data[type][idx] = forcing_data[type][i];
-          }
-          else {
-            for (v=0; v<param_set.TYPE[type].N_ELEM; v++) {
-              local_veg_hist_data[type][v][idx] = veg_hist_data[type][v][i];
-            }
-          }
-        }
-      }
-      else {
-        // Local sub-daily forcings will be hourly for coding convenience
-        // Sub-daily forcings need to a) start at hour 0, local time and b) draw from the correct element of the supplied forcings (if the supplied forcings are not in local time)
-        fstepspday = 24/param_set.FORCE_DT[param_set.TYPE[type].SUPPLIED-1];
-        for (idx=0; idx<(Ndays_local*24); idx++) {
-          i = (idx - global_param.starthour + hour_offset_int)/param_set.FORCE_DT[param_set.TYPE[type].SUPPLIED-1];
-          if (i < 0) i += fstepspday;
-          if (i >= (Ndays*fstepspday)) i -= fstepspday;
-          if (   type == PREC
-              || type == RAINF
-              || type == CRAINF
-              || type == LSRAINF
-              || type == SNOWF
-              || type == CSNOWF
-              || type == LSSNOWF
-              || type == CHANNEL_IN
-             ) {
-            /* Amounts per step need to be scaled to new step length */
-            local_forcing_data[type][idx] = forcing_data[type][i]/param_set.FORCE_DT[param_set.TYPE[type].SUPPLIED-1];
-          }
-          else {
-            /* All other forcings are assumed constant over hourly substeps */
-            if (type != ALBEDO && type != LAI_IN && type != VEGCOVER) {
-              local_forcing_data[type][idx] = forcing_data[type][i];
-            }
-            else {
-              for (v=0; v<param_set.TYPE[type].N_ELEM; v++) {
-                local_veg_hist_data[type][v][idx] = veg_hist_data[type][v][i];
-              }
-            }
-          }
-        }
-      }
-    }
-  }
+    if (!param_set.TYPE[type].SUPPLIED)
+      continue;
 
-  /*************************************************
-    Incoming Channel Flow
-  *************************************************/
+    k = param_set.TYPE[type].SUPPLIED-1;
+    dt = param_set.FORCE_DT[k];
+    if (src_idx[k] == NULL)
+      src_idx[k] = local_time_index(dt, Ndays, Ndays_local, hour_offset_int);
+    // Daily forcings stay daily; local sub-daily forcings will be hourly for coding convenience
+    n = (dt == 24) ? Ndays_local : Ndays_local*24;
 
-  if(param_set.TYPE[CHANNEL_IN].SUPPLIED) {
-    if(param_set.FORCE_DT[param_set.TYPE[CHANNEL_IN].SUPPLIED-1] == 24) {
-      /* daily channel_in provided */
-      for (rec = 0; rec < global_param.nrecs; rec++) {
-        sum = 0;
-        for (j = 0; j < NF; j++) {
-          hour = rec*global_param.dt + j*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-          if (global_param.starthour - hour_offset_int < 0) hour += 24;
-          idx = (int)((float)hour/24.0);
-          atmos[rec].channel_in[j] = local_forcing_data[CHANNEL_IN][idx] / (float)(NF*stepspday); // divide evenly over the day
-          atmos[rec].channel_in[j] *= 1000/cell_area; // convert to mm over grid cell 
-          sum += atmos[rec].channel_in[j];
-        }
-        if(NF>1) atmos[rec].channel_in[NR] = sum;
-      }
-    }
-    else {
-      /* sub-daily channel_in provided */
-      for(rec = 0; rec < global_param.nrecs; rec++) {
-        sum = 0;
-        for(i = 0; i < NF; i++) {
-          hour = rec*global_param.dt + i*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-          atmos[rec].channel_in[i] = 0;
-          while (hour < rec*global_param.dt + (i+1)*options.SNOW_STEP + global_param.starthour - hour_offset_int) {
-            idx = hour;
-            if (idx < 0) idx += 24;
-	    atmos[rec].channel_in[i] += local_forcing_data[CHANNEL_IN][idx];
-            hour++;
-          }
-	  atmos[rec].channel_in[i] *= 1000/cell_area; // convert to mm over grid cell 
-	  sum += atmos[rec].channel_in[i];
+    if (type == ALBEDO || type == LAI_IN || type == VEGCOVER) {
+      for (v=0; v<param_set.TYPE[type].N_ELEM; v++) {
+        for (idx=0; idx<n; idx++) {
+          local_veg_hist_data[type][v][idx] = veg_hist_data[type][v][src_idx[k][idx]];
         }
-        if(NF>1) atmos[rec].channel_in[NR] = sum;
-      }
-    }
-  }
-  else {
-    for(rec = 0; rec < global_param.nrecs; rec++) {
-      sum = 0;
-      for(i = 0; i < NF; i++) {
-        atmos[rec].channel_in[i] = 0;
-        sum += atmos[rec].channel_in[i];
       }
-      if(NF>1) atmos[rec].channel_in[NR] = sum;
+      continue;
+    }
+
+    local = local_forcing_data[type];
+    for (idx=0; idx<n; idx++) {
+      i = src_idx[k][idx];
+      if (type == PREC && prec_from == RAINF)
+        value = forcing_value(forcing_data, RAINF, i) + forcing_value(forcing_data, SNOWF, i);
+      else if (type == PREC && prec_from == LSRAINF)
+        value = forcing_value(forcing_data, CRAINF, i) + forcing_value(forcing_data, LSRAINF, i)
+              + forcing_value(forcing_data, CSNOWF, i) + forcing_value(forcing_data, LSSNOWF, i);
+      else if (type == WIND && wind_from_en)
+        value = sqrt( forcing_data[WIND_E][i]*forcing_data[WIND_E][i]
+                    + forcing_data[WIND_N][i]*forcing_data[WIND_N][i] );
+      else
+        value = forcing_value(forcing_data, type, i);
+      if (dt < 24) {
+        /* Amounts per step need to be scaled to new step length;
+           all other forcings are assumed constant over hourly substeps */
+        if (is_flux_forcing(type))
+          value /= dt;
+        else if (type == WIND && value < options.MIN_WIND_SPEED)
+          value = options.MIN_WIND_SPEED;
+      }
+      local[idx] = value;
     }
   }
 
   /*************************************************
-    Precipitation
+    Daily inputs to MTCLIM: precipitation, maximum
+    and minimum air temperature, and vapor pressure
+    and shortwave if supplied
   *************************************************/
 
-  if(param_set.FORCE_DT[param_set.TYPE[PREC].SUPPLIED-1] == 24) {
-    /* daily precipitation provided */
-    for (rec = 0; rec < global_param.nrecs; rec++) {
-      sum = 0;
-      for (j = 0; j < NF; j++) {
-        hour = rec*global_param.dt + j*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-        if (global_param.starthour - hour_offset_int < 0) hour += 24;
-        idx = (int)((float)hour/24.0);
-        atmos[rec].prec[j] = local_forcing_data[PREC][idx] / (float)(NF*stepspday); // divide evenly over the day
-        sum += atmos[rec].prec[j];
-      }
-      if(NF>1) atmos[rec].prec[NR] = sum;
-    }
-    for (day = 0; day < Ndays_local; day++) {
+  for (day = 0; day < Ndays_local; day++) {
+
+    /* Precipitation */
+    if(param_set.FORCE_DT[param_set.TYPE[PREC].SUPPLIED-1] == 24) {
       prec[day] = local_forcing_data[PREC][day];
     }
-  }
-  else {
-    /* sub-daily precipitation provided */
-    for(rec = 0; rec < global_param.nrecs; rec++) {
-      sum = 0;
-      for(i = 0; i < NF; i++) {
-        hour = rec*global_param.dt + i*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-        if (global_param.starthour - hour_offset_int < 0) hour += 24;
-        atmos[rec].prec[i] = 0;
-        for (idx = hour; idx < hour+options.SNOW_STEP; idx++) {
-	  atmos[rec].prec[i] += local_forcing_data[PREC][idx];
-        }
-	sum += atmos[rec].prec[i];
-      }
-      if(NF>1) atmos[rec].prec[NR] = sum;
-    }
-    for (day = 0; day < Ndays_local; day++) {
+    else {
       prec[day] = 0;
       for (hour=0; hour<24; hour++) {
         prec[day] += local_forcing_data[PREC][day*24+hour];
       }
     }
-  }
-
-  /*************************************************
-    Wind Speed
-  *************************************************/
-
-  if (param_set.TYPE[WIND].SUPPLIED) {
-    if(param_set.FORCE_DT[param_set.TYPE[WIND].SUPPLIED-1] == 24) {
-      /* daily wind provided */
-      for (rec = 0; rec < global_param.nrecs; rec++) {
-        sum = 0;
-        for (j = 0; j < NF; j++) {
-          hour = rec*global_param.dt + j*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-          if (global_param.starthour - hour_offset_int < 0) hour += 24;
-          idx = (int)((float)hour/24.0);
-          atmos[rec].wind[j] = local_forcing_data[WIND][idx]; // assume constant over the day
-          sum += atmos[rec].wind[j];
-        }
-        if(NF>1) atmos[rec].wind[NR] = sum / (float)NF;
-	if(global_param.dt == 24) {
-	  if(atmos[rec].wind[j] < options.MIN_WIND_SPEED)
-	    atmos[rec].wind[j] = options.MIN_WIND_SPEED;
-	}
-      }
-    }
-    else {
-      /* sub-daily wind provided */
-      for(rec = 0; rec < global_param.nrecs; rec++) {
-        sum = 0;
-        for(i = 0; i < NF; i++) {
-          hour = rec*global_param.dt + i*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-          if (global_param.starthour - hour_offset_int < 0) hour += 24;
-          atmos[rec].wind[i] = 0;
-          for (idx = hour; idx < hour+options.SNOW_STEP; idx++) {
-	    if(local_forcing_data[WIND][idx] < options.MIN_WIND_SPEED)
-	      atmos[rec].wind[i] += options.MIN_WIND_SPEED;
-	    else
-	      atmos[rec].wind[i] += local_forcing_data[WIND][idx];
-          }
-          atmos[rec].wind[i] /= options.SNOW_STEP;
-	  sum += atmos[rec].wind[i];
-        }
-        if(NF>1) atmos[rec].wind[NR] = sum / (float)NF;
-      }
-    }
-  }
-  else {
-    /* no wind data provided, use default constant */
-    for (rec = 0; rec < global_param.nrecs; rec++) {
-      for (i = 0; i < NF; i++) {
-	atmos[rec].wind[i] = DEFAULT_WIND_SPEED;
-      }
-      atmos[rec].wind[NR] = DEFAULT_WIND_SPEED;	
-    }
-  }
-
-  /*************************************************
-    Air Temperature, part 1.
-  *************************************************/
-
-  /************************************************
-    Set maximum daily air temperature if provided 
-  ************************************************/
 
-  if(param_set.TYPE[TMAX].SUPPLIED) {
-    if(param_set.FORCE_DT[param_set.TYPE[TMAX].SUPPLIED-1] == 24) {
-      /* daily tmax provided */
-      for (day = 0; day < Ndays_local; day++) {
+    /* Maximum and minimum daily air temperature, if provided */
+    if(param_set.TYPE[TMAX].SUPPLIED) {
+      if(param_set.FORCE_DT[param_set.TYPE[TMAX].SUPPLIED-1] == 24)
 	tmax[day] = local_forcing_data[TMAX][day];
-      }
-    }
-    else {
-      /* sub-daily tmax provided */
-      for (day = 0; day < Ndays_local; day++) {
+      else
 	tmax[day] = local_forcing_data[TMAX][day*24];
-      }
     }
-  }
-
-  /************************************************
-    Set minimum daily air temperature if provided 
-  ************************************************/
-
-  if(param_set.TYPE[TMIN].SUPPLIED) {
-    if(param_set.FORCE_DT[param_set.TYPE[TMIN].SUPPLIED-1] == 24) {
-      /* daily tmin provided */
-      for (day = 0; day < Ndays_local; day++) {
+    if(param_set.TYPE[TMIN].SUPPLIED) {
+      if(param_set.FORCE_DT[param_set.TYPE[TMIN].SUPPLIED-1] == 24)
 	tmin[day] = local_forcing_data[TMIN][day];
-      }
-    }
-    else {
-      /* sub-daily tmin provided */
-      for (day = 0; day < Ndays_local; day++) {
+      else
 	tmin[day] = local_forcing_data[TMIN][day*24];
-      }
-    }
-  }
-
-  /*************************************************
-    Store sub-daily air temperature if provided
-  *************************************************/
-
-  if(param_set.TYPE[AIR_TEMP].SUPPLIED) {
-    for(rec = 0; rec < global_param.nrecs; rec++) {
-      sum = 0;
-      for(i = 0; i < NF; i++) {
-        hour = rec*global_param.dt + i*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-        if (global_param.starthour - hour_offset_int < 0) hour += 24;
-        atmos[rec].air_temp[i] = 0;
-        for (idx = hour; idx < hour+options.SNOW_STEP; idx++) {
-	  atmos[rec].air_temp[i] += local_forcing_data[AIR_TEMP][idx];
-        }
-        atmos[rec].air_temp[i] /= options.SNOW_STEP;
-	sum += atmos[rec].air_temp[i];
-      }
-      if(NF>1) atmos[rec].air_temp[NR] = sum / (float)NF;
     }
-  }
 
-  /******************************************************
-    Determine Tmax and Tmin from sub-daily temperatures
-  ******************************************************/
-
-  if(!(param_set.TYPE[TMAX].SUPPLIED && param_set.TYPE[TMIN].SUPPLIED)) {
-    for (day=0; day<Ndays_local; day++) {
+    /* Otherwise, determine Tmax and Tmin from sub-daily temperatures */
+    if(!(param_set.TYPE[TMAX].SUPPLIED && param_set.TYPE[TMIN].SUPPLIED)) {
       tmax[day] = tmin[day] = -9999;
       for (hour = 0; hour < 24; hour++) {
-        if ( hour >= 9 && ( tmax[day] == -9999 || local_forcing_data[AIR_TEMP][hour] > tmax[day] ) ) tmax[day] = local_forcing_data[AIR_TEMP][hour];
-        if ( hour < 12 && ( tmin[day] == -9999 || local_forcing_data[AIR_TEMP][hour] < tmin[day] ) ) tmin[day] = local_forcing_data[AIR_TEMP][hour];
+        if ( hour >= 9 && ( tmax[day] == -9999 || local_forcing_data[AIR_TEMP][day*24+hour] > tmax[day] ) ) tmax[day] = local_forcing_data[AIR_TEMP][day*24+hour];
+        if ( hour < 12 && ( tmin[day] == -9999 || local_forcing_data[AIR_TEMP][day*24+hour] < tmin[day] ) ) tmin[day] = local_forcing_data[AIR_TEMP][day*24+hour];
       }
     }
-  }
-
-
-  /*************************************************
-    Vapor Pressure, part 1.
-  *************************************************/
 
-  if(!param_set.TYPE[VP].SUPPLIED) {
+    /* Vapor Pressure, part 1. */
+    if(param_set.TYPE[VP].SUPPLIED) {
+      if(param_set.FORCE_DT[param_set.TYPE[VP].SUPPLIED-1] == 24) {
+        /* daily vp provided */
+        daily_vp[day] = local_forcing_data[VP][day];
+      }
+      else {
+        /* sub-daily vp provided */
+        daily_vp[day] = 0;
+        for (hour=0; hour<24; hour++) {
+          daily_vp[day] += local_forcing_data[VP][day*24+hour];
+        }
+        daily_vp[day] /= 24;
+      }
+    }
 
     /*************************************************
       If provided, translate specific humidity and atm. pressure
@@ -781,41 +567,36 @@ void initialize_atmos(atmos_data_struct        *atmos,
       specific humidity after call to MTCLIM
     *************************************************/
 
-    if(param_set.TYPE[QAIR].SUPPLIED && param_set.TYPE[PRESSURE].SUPPLIED) {
+    else if(param_set.TYPE[QAIR].SUPPLIED && param_set.TYPE[PRESSURE].SUPPLIED) {
       /* specific humidity and atm. pressure supplied */
       if(param_set.FORCE_DT[param_set.TYPE[QAIR].SUPPLIED-1] == 24) {
-        for (day=0; day<Ndays_local; day++) {
-          if(param_set.FORCE_DT[param_set.TYPE[PRESSURE].SUPPLIED-1] < 24) {
-            tmp_double = 0;
-            for (hour=0; hour<24; hour++) {
-              tmp_double += local_forcing_data[PRESSURE][day*24+hour];
-            }
-            tmp_double /= 24;
-          }
-          else {
-            tmp_double = local_forcing_data[PRESSURE][day];
+        if(param_set.FORCE_DT[param_set.TYPE[PRESSURE].SUPPLIED-1] < 24) {
+          tmp_double = 0;
+          for (hour=0; hour<24; hour++) {
+            tmp_double += local_forcing_data[PRESSURE][day*24+hour];
           }
-          local_forcing_data[VP][day] = local_forcing_data[QAIR][day] * tmp_double / EPS;
-          daily_vp[day] = local_forcing_data[VP][day];
+          tmp_double /= 24;
+        }
+        else {
+          tmp_double = local_forcing_data[PRESSURE][day];
         }
+        local_forcing_data[VP][day] = local_forcing_data[QAIR][day] * tmp_double / EPS;
+        daily_vp[day] = local_forcing_data[VP][day];
       }
       else {
-        for (day=0; day<Ndays_local; day++) {
-          daily_vp[day] = 0;
-          for (hour=0; hour<24; hour++) {
-            if(param_set.FORCE_DT[param_set.TYPE[PRESSURE].SUPPLIED-1] == 24) {
-              tmp_double = local_forcing_data[PRESSURE][day];
-            }
-            else {
-              tmp_double = local_forcing_data[PRESSURE][day*24+hour];
-            }
-            local_forcing_data[VP][day*24+hour] = local_forcing_data[QAIR][day*24+hour] * tmp_double / EPS;
-            daily_vp[day] += local_forcing_data[VP][day*24+hour];
+        daily_vp[day] = 0;
+        for (hour=0; hour<24; hour++) {
+          if(param_set.FORCE_DT[param_set.TYPE[PRESSURE].SUPPLIED-1] == 24) {
+            tmp_double = local_forcing_data[PRESSURE][day];
+          }
+          else {
+            tmp_double = local_forcing_data[PRESSURE][day*24+hour];
           }
-          daily_vp[day] /= 24;
+          local_forcing_data[VP][day*24+hour] = local_forcing_data[QAIR][day*24+hour] * tmp_double / EPS;
+          daily_vp[day] += local_forcing_data[VP][day*24+hour];
         }
+        daily_vp[day] /= 24;
       }
-      param_set.TYPE[VP].SUPPLIED = param_set.TYPE[QAIR].SUPPLIED;
     }
 
     /*************************************************
@@ -828,105 +609,37 @@ void initialize_atmos(atmos_data_struct        *atmos,
     else if(param_set.TYPE[REL_HUMID].SUPPLIED && param_set.TYPE[AIR_TEMP].SUPPLIED) {
       /* relative humidity and air temperature supplied */
       if(param_set.FORCE_DT[param_set.TYPE[REL_HUMID].SUPPLIED-1] == 24) {
-        for (day=0; day<Ndays_local; day++) {
-          if(param_set.FORCE_DT[param_set.TYPE[AIR_TEMP].SUPPLIED-1] < 24) {
-            tmp_double = 0;
-            for (hour=0; hour<24; hour++) {
-              tmp_double += svp(local_forcing_data[AIR_TEMP][day*24+hour]);
-            }
-            tmp_double /= 24;
-          }
-          else {
-            tmp_double = svp(local_forcing_data[AIR_TEMP][day]);
-          }
-          local_forcing_data[VP][day] = local_forcing_data[REL_HUMID][day] * tmp_double / 100;
-          daily_vp[day] = local_forcing_data[VP][day];
-        }
-      }
-      else {
-        for (day=0; day<Ndays_local; day++) {
-          daily_vp[day] = 0;
+        if(param_set.FORCE_DT[param_set.TYPE[AIR_TEMP].SUPPLIED-1] < 24) {
+          tmp_double = 0;
           for (hour=0; hour<24; hour++) {
-            if(param_set.FORCE_DT[param_set.TYPE[AIR_TEMP].SUPPLIED-1] == 24) {
-              tmp_double = svp(local_forcing_data[AIR_TEMP][day]);
-            }
-            else {
-              tmp_double = svp(local_forcing_data[AIR_TEMP][day*24+hour]);
-            }
-            local_forcing_data[VP][day*24+hour] = local_forcing_data[REL_HUMID][day*24+hour] * tmp_double / 100;
-            daily_vp[day] += local_forcing_data[VP][day*24+hour];
+            tmp_double += svp(local_forcing_data[AIR_TEMP][day*24+hour]);
           }
-          daily_vp[day] /= 24;
+          tmp_double /= 24;
         }
-      }
-      param_set.TYPE[VP].SUPPLIED = param_set.TYPE[REL_HUMID].SUPPLIED;
-    }
-
-  } // end if VP not supplied
-
-  /*************************************************
-    If vapor pressure supplied, transfer to appropriate arrays
-  *************************************************/
-
-  if(param_set.TYPE[VP].SUPPLIED) {
-
-    have_dewpt = 2; // flag for MTCLIM
-
-    if(param_set.FORCE_DT[param_set.TYPE[VP].SUPPLIED-1] == 24) {
-      /* daily vp provided */
-      for (day=0; day<Ndays_local; day++) {
-        daily_vp[day] = local_forcing_data[VP][day];
-      }
-      for (rec = 0; rec < global_param.nrecs; rec++) {
-        sum = 0;
-        for (j = 0; j < NF; j++) {
-          hour = rec*global_param.dt + j*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-          if (global_param.starthour - hour_offset_int < 0) hour += 24;
-          idx = (int)((float)hour/24.0);
-          atmos[rec].vp[j] = local_forcing_data[VP][idx]; // assume constant over the day
-          sum += atmos[rec].vp[j];
+        else {
+          tmp_double = svp(local_forcing_data[AIR_TEMP][day]);
         }
-        if(NF>1) atmos[rec].vp[NR] = sum / (float)NF;
+        local_forcing_data[VP][day] = local_forcing_data[REL_HUMID][day] * tmp_double / 100;
+        daily_vp[day] = local_forcing_data[VP][day];
       }
-    }
-    else {
-      /* sub-daily vp provided */
-      for (day=0; day<Ndays_local; day++) {
+      else {
         daily_vp[day] = 0;
         for (hour=0; hour<24; hour++) {
+          if(param_set.FORCE_DT[param_set.TYPE[AIR_TEMP].SUPPLIED-1] == 24) {
+            tmp_double = svp(local_forcing_data[AIR_TEMP][day]);
+          }
+          else {
+            tmp_double = svp(local_forcing_data[AIR_TEMP][day*24+hour]);
+          }
+          local_forcing_data[VP][day*24+hour] = local_forcing_data[REL_HUMID][day*24+hour] * tmp_double / 100;
           daily_vp[day] += local_forcing_data[VP][day*24+hour];
         }
         daily_vp[day] /= 24;
       }
-      for(rec = 0; rec < global_param.nrecs; rec++) {
-        sum = 0;
-        for(i = 0; i < NF; i++) {
-          hour = rec*global_param.dt + i*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-          if (global_param.starthour - hour_offset_int < 0) hour += 24;
-          atmos[rec].vp[i] = 0;
-          for (idx = hour; idx < hour+options.SNOW_STEP; idx++) {
-	    atmos[rec].vp[i] += local_forcing_data[VP][idx];
-          }
-          atmos[rec].vp[i] /= options.SNOW_STEP;
-	  sum += atmos[rec].vp[i];
-        }
-        if(NF>1) atmos[rec].vp[NR] = sum / (float)NF;
-      }
     }
 
-  }
-  else {
-    have_dewpt = 0;
-  } // end if VP supplied
-
-
-  /*************************************************
-    Shortwave, part 1.
-  *************************************************/
-
-  if (param_set.TYPE[SHORTWAVE].SUPPLIED) {
-    have_shortwave = 1; // flag for MTCLIM
-    for (day=0; day<Ndays_local; day++) {
+    /* Shortwave, part 1. */
+    if (param_set.TYPE[SHORTWAVE].SUPPLIED) {
       for (hour=0; hour<24; hour++) {
         if(param_set.FORCE_DT[param_set.TYPE[SHORTWAVE].SUPPLIED-1] == 24) {
           hourlyrad[day*24+hour] = local_forcing_data[SHORTWAVE][day];
@@ -936,11 +649,20 @@ void initialize_atmos(atmos_data_struct        *atmos,
         }
       }
     }
+
   }
-  else {
-    have_shortwave = 0;
+
+  /* vapor pressure computed from humidity is treated as supplied from here on */
+  if(!param_set.TYPE[VP].SUPPLIED) {
+    if(param_set.TYPE[QAIR].SUPPLIED && param_set.TYPE[PRESSURE].SUPPLIED)
+      param_set.TYPE[VP].SUPPLIED = param_set.TYPE[QAIR].SUPPLIED;
+    else if(param_set.TYPE[REL_HUMID].SUPPLIED && param_set.TYPE[AIR_TEMP].SUPPLIED)
+      param_set.TYPE[VP].SUPPLIED = param_set.TYPE[REL_HUMID].SUPPLIED;
   }
 
+  have_dewpt = (param_set.TYPE[VP].SUPPLIED) ? 2 : 0; // flag for MTCLIM
+  have_shortwave = (param_set.TYPE[SHORTWAVE].SUPPLIED) ? 1 : 0; // flag for MTCLIM
+
   /**************************************************
     Use MTCLIM algorithms to estimate hourly shortwave,
     daily vapor pressure, and cloud radiation attenuation.
@@ -957,8 +679,7 @@ void initialize_atmos(atmos_data_struct        *atmos,
 
   /***********************************************************
     Shortwave, part 2.
-    Transfer the hourly shortwave from MTCLIM to atmos array.
-    This hourly shortwave is one of the following:
+    The hourly shortwave from MTCLIM is one of the following:
     a) exactly equal to the supplied shortwave, if supplied shortwave was hourly
     b) equal to the supplied shortwave when aggregated up to the DT of the supplied shortwave (with hourly variability estimated by MTCLIM)
     c) completely estimated by MTCLIM, if no shortwave was supplied as a forcing
@@ -966,144 +687,147 @@ void initialize_atmos(atmos_data_struct        *atmos,
 
   // Ignore MTCLIM estimates if sub-daily SW was supplied
   if (param_set.TYPE[SHORTWAVE].SUPPLIED && param_set.FORCE_DT[param_set.TYPE[SHORTWAVE].SUPPLIED-1] < 24) {
-    for (day=0; day<Ndays_local; day++) {
-      for (hour=0; hour<24; hour++) {
-        hourlyrad[day*24+hour] = local_forcing_data[SHORTWAVE][day*24+hour];
-      }
-    }
-  }
-  // Transfer hourlyrad to atmos structure
-  for(rec = 0; rec < global_param.nrecs; rec++) {
-    sum = 0;
-    for(i = 0; i < NF; i++) {
-      hour = rec*global_param.dt + i*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-      if (global_param.starthour - hour_offset_int < 0) hour += 24;
-      atmos[rec].shortwave[i] = 0;
-      for (idx = hour; idx < hour+options.SNOW_STEP; idx++) {
-	atmos[rec].shortwave[i] += hourlyrad[idx];
-      }
-      atmos[rec].shortwave[i] /= options.SNOW_STEP;
-      sum += atmos[rec].shortwave[i];
+    for (idx=0; idx<Ndays_local*24; idx++) {
+      hourlyrad[idx] = local_forcing_data[SHORTWAVE][idx];
     }
-    if(NF>1) atmos[rec].shortwave[NR] = sum / (float)NF;
   }
 
   /**************************************************************************
     Air Temperature, part 2.
-  **************************************************************************/
-
-  /**************************************************************************
     Calculate the hours at which the minimum and maximum temperatures occur
     (if sub-daily air_temp will be estimated) and/or at which daily vapor
-    pressure will occur (if daily vapor pressure is estimated)
+    pressure will occur (if daily vapor pressure is estimated), and if
+    sub-daily air temperature was not supplied, calculate it from tmax
+    and tmin
   **************************************************************************/
   set_max_min_hour(hourlyrad, Ndays_local, tmaxhour, tminhour);
 
-  if(!param_set.TYPE[AIR_TEMP].SUPPLIED) {
-
-    /**********************************************************************
-      Calculate the subdaily and daily temperature based on tmax and tmin 
-    **********************************************************************/
+  if(param_set.TYPE[AIR_TEMP].SUPPLIED) {
+    for (idx=0; idx<Ndays_local*24; idx++)
+      tair[idx] = local_forcing_data[AIR_TEMP][idx];
+  }
+  else
     HourlyT(1, Ndays_local, tmaxhour, tmax, tminhour, tmin, tair);
-    for(rec = 0; rec < global_param.nrecs; rec++) {
-      sum = 0;
-      for(i = 0; i < NF; i++) {
-        hour = rec*global_param.dt + i*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-        if (global_param.starthour - hour_offset_int < 0) hour += 24;
-        atmos[rec].air_temp[i] = 0;
-        for (idx = hour; idx < hour+options.SNOW_STEP; idx++) {
-	  atmos[rec].air_temp[i] += tair[idx];
+
+  /**************************************************************************
+    First pass over the model steps: all forcings that do not depend on
+    the sub-daily vapor pressure.  Each model step's NF snow steps start
+    at local hour step_hour[rec*NF+i], in local day step_hour[rec*NF+i]/24.
+  **************************************************************************/
+
+  for (rec = 0; rec < global_param.nrecs; rec++) {
+
+    for (i = 0; i < NF; i++) {
+      hour = step_hour[rec*NF+i];
+      day = hour/24;
+
+      /* Incoming Channel Flow */
+      if(!param_set.TYPE[CHANNEL_IN].SUPPLIED) {
+        atmos[rec].channel_in[i] = 0;
+      }
+      else if(param_set.FORCE_DT[param_set.TYPE[CHANNEL_IN].SUPPLIED-1] == 24) {
+        /* daily channel_in provided */
+        atmos[rec].channel_in[i] = local_forcing_data[CHANNEL_IN][day] / (float)(NF*stepspday); // divide evenly over the day
+        atmos[rec].channel_in[i] *= 1000/cell_area; // convert to mm over grid cell 
+      }
+      else {
+        /* sub-daily channel_in provided; starting hour is not shifted to the first local day */
+        atmos[rec].channel_in[i] = 0;
+        for (idx = hour-hour_shift; idx < hour-hour_shift+options.SNOW_STEP; idx++) {
+          atmos[rec].channel_in[i] += local_forcing_data[CHANNEL_IN][(idx < 0) ? idx+24 : idx];
         }
-        atmos[rec].air_temp[i] /= options.SNOW_STEP;
-        sum += atmos[rec].air_temp[i];
+        atmos[rec].channel_in[i] *= 1000/cell_area; // convert to mm over grid cell 
       }
-      if(NF>1) atmos[rec].air_temp[NR] = sum / (float)NF;
-    }
 
-  }
+      /* Precipitation */
+      if(param_set.FORCE_DT[param_set.TYPE[PREC].SUPPLIED-1] == 24) {
+        /* daily precipitation provided */
+        atmos[rec].prec[i] = local_forcing_data[PREC][day] / (float)(NF*stepspday); // divide evenly over the day
+      }
+      else {
+        /* sub-daily precipitation provided */
+        atmos[rec].prec[i] = hourly_sum(local_forcing_data[PREC], hour);
+      }
 
+      /* Wind Speed */
+      if (!param_set.TYPE[WIND].SUPPLIED) {
+        /* no wind data provided, use default constant */
+        atmos[rec].wind[i] = DEFAULT_WIND_SPEED;
+      }
+      else if(param_set.FORCE_DT[param_set.TYPE[WIND].SUPPLIED-1] == 24) {
+        /* daily wind provided */
+        atmos[rec].wind[i] = local_forcing_data[WIND][day]; // assume constant over the day
+      }
+      else {
+        /* sub-daily wind provided (already limited to MIN_WIND_SPEED) */
+        atmos[rec].wind[i] = hourly_sum(local_forcing_data[WIND], hour) / options.SNOW_STEP;
+      }
 
-  /**************************************************************************
-    Atmospheric Pressure and Density
-  **************************************************************************/
+      /* Air Temperature (supplied, or estimated from tmax and tmin) */
+      atmos[rec].air_temp[i] = hourly_sum(tair, hour) / options.SNOW_STEP;
 
-  /*************************************************
-    Store atmospheric density if provided (kg/m^3)
-  *************************************************/
+      /* Shortwave */
+      atmos[rec].shortwave[i] = hourly_sum(hourlyrad, hour) / options.SNOW_STEP;
 
-  if (param_set.TYPE[DENSITY].SUPPLIED) {
-    if(param_set.FORCE_DT[param_set.TYPE[DENSITY].SUPPLIED-1] == 24) {
-      /* daily density provided */
-      for (rec = 0; rec < global_param.nrecs; rec++) {
-        sum = 0;
-        for (j = 0; j < NF; j++) {
-          hour = rec*global_param.dt + j*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-          if (global_param.starthour - hour_offset_int < 0) hour += 24;
-          idx = (int)((float)hour/24.0);
-          atmos[rec].density[j] = local_forcing_data[DENSITY][idx]; // assume constant over the day
-          sum += atmos[rec].density[j];
-        }
-        if(NF>1) atmos[rec].density[NR] = sum / (float)NF;
+      /* Atmospheric density if provided (kg/m^3) */
+      if (param_set.TYPE[DENSITY].SUPPLIED) {
+        if(param_set.FORCE_DT[param_set.TYPE[DENSITY].SUPPLIED-1] == 24)
+          atmos[rec].density[i] = local_forcing_data[DENSITY][day]; // assume constant over the day
+        else
+          atmos[rec].density[i] = hourly_sum(local_forcing_data[DENSITY], hour) / options.SNOW_STEP;
       }
     }
+
+    if(NF>1) {
+      atmos[rec].channel_in[NR] = step_sum(atmos[rec].channel_in);
+      atmos[rec].prec[NR] = step_sum(atmos[rec].prec);
+      atmos[rec].air_temp[NR] = step_sum(atmos[rec].air_temp) / (float)NF;
+      atmos[rec].shortwave[NR] = step_sum(atmos[rec].shortwave) / (float)NF;
+      if (param_set.TYPE[DENSITY].SUPPLIED)
+        atmos[rec].density[NR] = step_sum(atmos[rec].density) / (float)NF;
+    }
+    if (!param_set.TYPE[WIND].SUPPLIED)
+      atmos[rec].wind[NR] = DEFAULT_WIND_SPEED;
     else {
-      /* sub-daily density provided */
-      for(rec = 0; rec < global_param.nrecs; rec++) {
-        sum = 0;
-        for(i = 0; i < NF; i++) {
-          hour = rec*global_param.dt + i*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-          if (global_param.starthour - hour_offset_int < 0) hour += 24;
-          atmos[rec].density[i] = 0;
-          for (idx = hour; idx < hour+options.SNOW_STEP; idx++) {
-	    atmos[rec].density[i] += local_forcing_data[DENSITY][idx];
-          }
-          atmos[rec].density[i] /= options.SNOW_STEP;
-	  sum += atmos[rec].density[i];
-        }
-        if(NF>1) atmos[rec].density[NR] = sum / (float)NF;
+      if(NF>1) atmos[rec].wind[NR] = step_sum(atmos[rec].wind) / (float)NF;
+      if(global_param.dt == 24 && param_set.FORCE_DT[param_set.TYPE[WIND].SUPPLIED-1] == 24) {
+        if(atmos[rec].wind[NR] < options.MIN_WIND_SPEED)
+          atmos[rec].wind[NR] = options.MIN_WIND_SPEED;
       }
     }
-  }
 
-  /**************************************
-    Estimate Atmospheric Pressure (Pa) 
-  **************************************/
+    /**************************************
+      Atmospheric Pressure (Pa) 
+    **************************************/
 
-  if(!param_set.TYPE[PRESSURE].SUPPLIED) {
-    if(!param_set.TYPE[DENSITY].SUPPLIED) {
-      /* Estimate pressure */
-      if (options.PLAPSE) {
-        /* Assume average virtual temperature in air column
-           between ground and sea level = KELVIN+atmos[rec].air_temp[NR] + 0.5*elevation*T_LAPSE */
-        for (rec = 0; rec < global_param.nrecs; rec++) {
+    if(!param_set.TYPE[PRESSURE].SUPPLIED) {
+      if(!param_set.TYPE[DENSITY].SUPPLIED) {
+        /* Estimate pressure */
+        if (options.PLAPSE) {
+          /* Assume average virtual temperature in air column
+             between ground and sea level = KELVIN+atmos[rec].air_temp[NR] + 0.5*elevation*T_LAPSE */
           atmos[rec].pressure[NR] = PS_PM*exp(-elevation*G/(Rd*(KELVIN+atmos[rec].air_temp[NR]+0.5*elevation*T_LAPSE)));
           for (i = 0; i < NF; i++) {
             atmos[rec].pressure[i] = PS_PM*exp(-elevation*G/(Rd*(KELVIN+atmos[rec].air_temp[i]+0.5*elevation*T_LAPSE)));
           }
         }
-      }
-      else {
-        /* set pressure to constant value */
-        for (rec = 0; rec < global_param.nrecs; rec++) {
+        else {
+          /* set pressure to constant value */
 	  atmos[rec].pressure[NR] = 95500.;
 	  for (i = 0; i < NF; i++) {
 	    atmos[rec].pressure[i] = atmos[rec].pressure[NR];
 	  }
         }
       }
-    }
-    else {
-      /* use observed densities to estimate pressure */
-      if (options.PLAPSE) {
-        for (rec = 0; rec < global_param.nrecs; rec++) {
+      else {
+        /* use observed densities to estimate pressure */
+        if (options.PLAPSE) {
           atmos[rec].pressure[NR] = (KELVIN+atmos[rec].air_temp[NR])*atmos[rec].density[NR]*Rd;
           for (i = 0; i < NF; i++) {
             atmos[rec].pressure[i] = (KELVIN+atmos[rec].air_temp[i])*atmos[rec].density[i]*Rd;
           }
         }
-      }
-      else {
-        for (rec = 0; rec < global_param.nrecs; rec++) {
+        else {
 	  atmos[rec].pressure[NR] = (275.0 + atmos[rec].air_temp[NR]) *atmos[rec].density[NR]/0.003486;
 	  for (i = 0; i < NF; i++) {
 	    atmos[rec].pressure[i] = (275.0 + atmos[rec].air_temp[i]) *atmos[rec].density[i]/0.003486;
@@ -1111,113 +835,62 @@ void initialize_atmos(atmos_data_struct        *atmos,
         }
       }
     }
-  }
-  else {
-    /* observed atmospheric pressure supplied */
-    if(param_set.FORCE_DT[param_set.TYPE[PRESSURE].SUPPLIED-1] == 24) {
-      /* daily pressure provided */
-      for (rec = 0; rec < global_param.nrecs; rec++) {
-        sum = 0;
-        for (j = 0; j < NF; j++) {
-          hour = rec*global_param.dt + j*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-          if (global_param.starthour - hour_offset_int < 0) hour += 24;
-          idx = (int)((float)hour/24.0);
-          atmos[rec].pressure[j] = local_forcing_data[PRESSURE][idx]; // assume constant over the day
-          sum += atmos[rec].pressure[j];
-        }
-        if(NF>1) atmos[rec].pressure[NR] = sum / (float)NF;
-      }
-    }
     else {
-      /* sub-daily pressure provided */
-      for(rec = 0; rec < global_param.nrecs; rec++) {
-        sum = 0;
-        for(i = 0; i < NF; i++) {
-          hour = rec*global_param.dt + i*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-          if (global_param.starthour - hour_offset_int < 0) hour += 24;
-          atmos[rec].pressure[i] = 0;
-          for (idx = hour; idx < hour+options.SNOW_STEP; idx++) {
-	    atmos[rec].pressure[i] += local_forcing_data[PRESSURE][idx];
-          }
-          atmos[rec].pressure[i] /= options.SNOW_STEP;
-	  sum += atmos[rec].pressure[i];
-        }
-        if(NF>1) atmos[rec].pressure[NR] = sum / (float)NF;
+      /* observed atmospheric pressure supplied */
+      for (i = 0; i < NF; i++) {
+        hour = step_hour[rec*NF+i];
+        if(param_set.FORCE_DT[param_set.TYPE[PRESSURE].SUPPLIED-1] == 24)
+          atmos[rec].pressure[i] = local_forcing_data[PRESSURE][hour/24]; // assume constant over the day
+        else
+          atmos[rec].pressure[i] = hourly_sum(local_forcing_data[PRESSURE], hour) / options.SNOW_STEP;
       }
+      if(NF>1) atmos[rec].pressure[NR] = step_sum(atmos[rec].pressure) / (float)NF;
     }
-  }
 
-  /********************************************************
-    Estimate Atmospheric Density if not provided (kg/m^3)
-  ********************************************************/
+    /********************************************************
+      Estimate Atmospheric Density if not provided (kg/m^3)
+    ********************************************************/
 
-  if(!param_set.TYPE[DENSITY].SUPPLIED) {
-    /* use pressure to estimate density */
-    if (options.PLAPSE) {
-      for (rec = 0; rec < global_param.nrecs; rec++) {
+    if(!param_set.TYPE[DENSITY].SUPPLIED) {
+      /* use pressure to estimate density */
+      if (options.PLAPSE) {
         atmos[rec].density[NR] = atmos[rec].pressure[NR]/(Rd*(KELVIN+atmos[rec].air_temp[NR]));
         for (i = 0; i < NF; i++) {
           atmos[rec].density[i] = atmos[rec].pressure[i]/(Rd*(KELVIN+atmos[rec].air_temp[i]));
         }
       }
-    }
-    else {
-      for (rec = 0; rec < global_param.nrecs; rec++) {
+      else {
         atmos[rec].density[NR] = 0.003486*atmos[rec].pressure[NR]/ (275.0 + atmos[rec].air_temp[NR]);
         for (i = 0; i < NF; i++) {
 	  atmos[rec].density[i] = 0.003486*atmos[rec].pressure[i]/ (275.0 + atmos[rec].air_temp[i]);
         }
       }
     }
-  }
 
-  /**************************************************************************
-    Vapor Pressure, part 2.
-  **************************************************************************/
-
-  if(!param_set.TYPE[VP].SUPPLIED) {
+    /**************************************************************************
+      Vapor Pressure, part 2.
+      Handle cases of daily QAIR or RH supplied without pressure or
+      temperature: we couldn't use them earlier because atmospheric
+      pressure or air temperature wasn't available at that time.  Now
+      it is, so use it to estimate daily vp.
+    **************************************************************************/
 
-    /* handle cases of daily QAIR or RH supplied without pressure or temperature */
-
-    if(param_set.TYPE[QAIR].SUPPLIED && param_set.FORCE_DT[param_set.TYPE[QAIR].SUPPLIED-1] == 24) {
-
-      /**************************************************************************
-        If we arrive here, it means we couldn't use Qair earlier because
-        atmospheric pressure wasn't available at that time.  Now it is
-        available, so use Qair and pressure to estimate vp.
-      **************************************************************************/
-      for (rec = 0; rec < global_param.nrecs; rec++) {
-        sum = 0;
+    if(!param_set.TYPE[VP].SUPPLIED) {
+      if(param_set.TYPE[QAIR].SUPPLIED && param_set.FORCE_DT[param_set.TYPE[QAIR].SUPPLIED-1] == 24) {
         for (j = 0; j < NF; j++) {
-          hour = rec*global_param.dt + j*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-          if (global_param.starthour - hour_offset_int < 0) hour += 24;
-          idx = (int)((float)hour/24.0);
+          idx = step_hour[rec*NF+j]/24;
           daily_vp[idx] = local_forcing_data[QAIR][idx] * atmos[rec].pressure[j] / EPS;
         }
       }
-
-    } // end if QAIR supplied
-
-    else if(param_set.TYPE[REL_HUMID].SUPPLIED && param_set.FORCE_DT[param_set.TYPE[REL_HUMID].SUPPLIED-1] == 24) {
-
-      /**************************************************************************
-        If we arrive here, it means we couldn't use RH earlier because
-        air temperature wasn't available at that time.  Now it is
-        available, so use RH and temperature to estimate vp.
-      **************************************************************************/
-      for (rec = 0; rec < global_param.nrecs; rec++) {
-        sum = 0;
+      else if(param_set.TYPE[REL_HUMID].SUPPLIED && param_set.FORCE_DT[param_set.TYPE[REL_HUMID].SUPPLIED-1] == 24) {
         for (j = 0; j < NF; j++) {
-          hour = rec*global_param.dt + j*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-          if (global_param.starthour - hour_offset_int < 0) hour += 24;
-          idx = (int)((float)hour/24.0);
+          idx = step_hour[rec*NF+j]/24;
           daily_vp[idx] = local_forcing_data[REL_HUMID][idx] * svp(atmos[rec].air_temp[j]) / 100;
         }
       }
+    }
 
-    } // end if REL_HUMID supplied
-
-  } // end if VP not supplied
+  }
 
   if (!param_set.TYPE[VP].SUPPLIED || param_set.FORCE_DT[param_set.TYPE[VP].SUPPLIED-1] == 24) {
 
@@ -1276,66 +949,60 @@ void initialize_atmos(atmos_data_struct        *atmos,
 
     }
 
-    /* Transfer sub-daily VP to atmos array */
-    for(rec = 0; rec < global_param.nrecs; rec++) {
-      sum = 0;
-      for(i = 0; i < NF; i++) {
-        hour = rec*global_param.dt + i*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-        if (global_param.starthour - hour_offset_int < 0) hour += 24;
+  } // end computation of sub-daily VP
+
+  /*************************************************
+    Second pass over the model steps: vapor pressure
+    and the forcings that depend on it, and all
+    remaining forcings
+  *************************************************/
+
+  if (!options.OUTPUT_FORCE) {
+    min_Tfactor = Tfactor[0];
+    for (band = 1; band < options.SNOW_BAND; band++) {
+      if (Tfactor[band] < min_Tfactor)
+        min_Tfactor = Tfactor[band];
+    }
+  }
+
+  sw_day_mean = 0;
+  for (rec = 0; rec < global_param.nrecs; rec++) {
+
+    /*************************************************
+      Vapor Pressure, part 3.
+      Transfer sub-daily VP to atmos array.  If sub-daily
+      specific or relative humidity were supplied without
+      pressure or temperature, they overwrite the sub-daily
+      VP from MTCLIM here.
+    *************************************************/
+
+    for(i = 0; i < NF; i++) {
+      hour = step_hour[rec*NF+i];
+      if (param_set.TYPE[VP].SUPPLIED && param_set.FORCE_DT[param_set.TYPE[VP].SUPPLIED-1] < 24)
+        atmos[rec].vp[i] = hourly_sum(local_forcing_data[VP], hour) / options.SNOW_STEP;
+      else if(param_set.TYPE[QAIR].SUPPLIED && param_set.FORCE_DT[param_set.TYPE[QAIR].SUPPLIED-1] < 24) {
         atmos[rec].vp[i] = 0;
         for (idx = hour; idx < hour+options.SNOW_STEP; idx++) {
-	  atmos[rec].vp[i] += local_forcing_data[VP][idx];
+          atmos[rec].vp[i] += local_forcing_data[QAIR][idx] * atmos[rec].pressure[i] / EPS;
         }
         atmos[rec].vp[i] /= options.SNOW_STEP;
-	sum += atmos[rec].vp[i];
-      }
-      if(NF>1) atmos[rec].vp[NR] = sum / (float)NF;
-    }
-
-    /**************************************************
-      If sub-daily specific or relative humidity were supplied without pressure or temperature,
-      overwrite the sub-daily VP from MTCLIM here.
-    **************************************************/
-    if(param_set.TYPE[QAIR].SUPPLIED && param_set.FORCE_DT[param_set.TYPE[QAIR].SUPPLIED-1] < 24) {
-      for(rec = 0; rec < global_param.nrecs; rec++) {
-        sum = 0;
-        for(i = 0; i < NF; i++) {
-          hour = rec*global_param.dt + i*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-          if (global_param.starthour - hour_offset_int < 0) hour += 24;
-          atmos[rec].vp[i] = 0;
-          for (idx = hour; idx < hour+options.SNOW_STEP; idx++) {
-            atmos[rec].vp[i] += local_forcing_data[QAIR][idx] * atmos[rec].pressure[j] / EPS;
-          }
-          atmos[rec].vp[i] /= options.SNOW_STEP;
-            sum += atmos[rec].vp[i];
-        }
-        if(NF>1) atmos[rec].vp[NR] = sum / (float)NF;
       }
-    }
-    else if(param_set.TYPE[REL_HUMID].SUPPLIED && param_set.FORCE_DT[param_set.TYPE[REL_HUMID].SUPPLIED-1] < 24) {
-      for(rec = 0; rec < global_param.nrecs; rec++) {
-        sum = 0;
-        for(i = 0; i < NF; i++) {
-          hour = rec*global_param.dt + i*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-          if (global_param.starthour - hour_offset_int < 0) hour += 24;
-          atmos[rec].vp[i] = 0;
-          for (idx = hour; idx < hour+options.SNOW_STEP; idx++) {
-            atmos[rec].vp[i] += local_forcing_data[REL_HUMID][idx] * svp(atmos[rec].air_temp[j]) / 100;
-          }
-          atmos[rec].vp[i] /= options.SNOW_STEP;
-          sum += atmos[rec].vp[i];
+      else if(param_set.TYPE[REL_HUMID].SUPPLIED && param_set.FORCE_DT[param_set.TYPE[REL_HUMID].SUPPLIED-1] < 24) {
+        atmos[rec].vp[i] = 0;
+        for (idx = hour; idx < hour+options.SNOW_STEP; idx++) {
+          atmos[rec].vp[i] += local_forcing_data[REL_HUMID][idx] * svp(atmos[rec].air_temp[i]) / 100;
         }
-        if(NF>1) atmos[rec].vp[NR] = sum / (float)NF;
+        atmos[rec].vp[i] /= options.SNOW_STEP;
       }
+      else
+        atmos[rec].vp[i] = hourly_sum(local_forcing_data[VP], hour) / options.SNOW_STEP;
     }
+    if(NF>1) atmos[rec].vp[NR] = step_sum(atmos[rec].vp) / (float)NF;
 
-  } // end computation of sub-daily VP
-
-  /*************************************************
-    Vapor Pressure Deficit
-  *************************************************/
+    /*************************************************
+      Vapor Pressure Deficit
+    *************************************************/
 
-  for(rec = 0; rec < global_param.nrecs; rec++) {
     sum = 0;
     sum2 = 0;
     for(i = 0; i < NF; i++) {
@@ -1354,396 +1021,126 @@ void initialize_atmos(atmos_data_struct        *atmos,
     else { // do not recompute vp[NR]; vpd[NR] is computed relative to vp[NR] and air_temp[NR]
       atmos[rec].vpd[NR] = (svp(atmos[rec].air_temp[NR]) - atmos[rec].vp[NR]);
     }
-  }
 
-  /*************************************************
-    Cloud Transmissivity (from MTCLIM)
-  *************************************************/
+    /*************************************************
+      Cloud Transmissivity and Direct Shortwave
+      Fraction (from MTCLIM), Longwave, PAR, and
+      Atmospheric Carbon Dioxide Mixing Ratio
+    *************************************************/
 
-  for (rec = 0; rec < global_param.nrecs; rec++) {
-    sum = 0;
-    for (j = 0; j < NF; j++) {
-      hour = rec*global_param.dt + j*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-      if (global_param.starthour - hour_offset_int < 0) hour += 24;
-      idx = (int)((float)hour/24.0);
-      atmos[rec].tskc[j] = tskc[idx]; // assume constant over the day
-      sum += atmos[rec].tskc[j];
+    if (param_set.TYPE[PAR].SUPPLIED && param_set.FORCE_DT[param_set.TYPE[PAR].SUPPLIED-1] == 24) {
+      /* mean shortwave over the day, for the daily par */
+      tmp_int = (int)(rec/stepspday)*stepspday;
+      sw_day_mean = 0;
+      for (j=0; j<stepspday; j++)
+        sw_day_mean += atmos[tmp_int+j].shortwave[NR];
+      sw_day_mean /= stepspday;
     }
-    if(NF>1) atmos[rec].tskc[NR] = sum / (float)NF;
-  }
 
-  /*************************************************
-    Longwave
-  *************************************************/
+    for (i = 0; i < NF; i++) {
+      hour = step_hour[rec*NF+i];
+      day = hour/24;
 
-  if ( !param_set.TYPE[LONGWAVE].SUPPLIED ) {
-    /** Incoming longwave radiation not supplied **/
-    for (rec = 0; rec < global_param.nrecs; rec++) {
-      sum = 0;
-      for (i = 0; i < NF; i++) {
+      atmos[rec].tskc[i] = tskc[day]; // assume constant over the day
+      atmos[rec].fdir[i] = fdir[day]; // assume constant over the day
+
+      if ( !param_set.TYPE[LONGWAVE].SUPPLIED ) {
+        /** Incoming longwave radiation not supplied **/
 	calc_longwave(&(atmos[rec].longwave[i]), atmos[rec].tskc[i],
 		      atmos[rec].air_temp[i], atmos[rec].vp[i]);
-        sum += atmos[rec].longwave[i];
       }
-      if(NF>1) atmos[rec].longwave[NR] = sum / (float)NF;
-    }
-  }
-  else {
-    if(param_set.FORCE_DT[param_set.TYPE[LONGWAVE].SUPPLIED-1] == 24) {
-      /* daily incoming longwave radiation provided */
-      for (rec = 0; rec < global_param.nrecs; rec++) {
-        sum = 0;
-        for (j = 0; j < NF; j++) {
-          hour = rec*global_param.dt + j*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-          if (global_param.starthour - hour_offset_int < 0) hour += 24;
-          idx = (int)((float)hour/24.0);
-          atmos[rec].longwave[j] = local_forcing_data[LONGWAVE][idx]; // assume constant over the day
-          sum += atmos[rec].longwave[j];
-        }
-        if(NF>1) atmos[rec].longwave[NR] = sum / (float)NF;
+      else if(param_set.FORCE_DT[param_set.TYPE[LONGWAVE].SUPPLIED-1] == 24) {
+        /* daily incoming longwave radiation provided */
+        atmos[rec].longwave[i] = local_forcing_data[LONGWAVE][day]; // assume constant over the day
       }
-    }
-    else {
-      /* sub-daily incoming longwave radiation provided */
-      for(rec = 0; rec < global_param.nrecs; rec++) {
-        sum = 0;
-        for(i = 0; i < NF; i++) {
-          hour = rec*global_param.dt + i*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-          if (global_param.starthour - hour_offset_int < 0) hour += 24;
-          atmos[rec].longwave[i] = 0;
-          for (idx = hour; idx < hour+options.SNOW_STEP; idx++) {
-	    atmos[rec].longwave[i] += local_forcing_data[LONGWAVE][idx];
-          }
-          atmos[rec].longwave[i] /= options.SNOW_STEP;
-	  sum += atmos[rec].longwave[i];
-        }
-        if(NF>1) atmos[rec].longwave[NR] = sum / (float)NF;
+      else {
+        /* sub-daily incoming longwave radiation provided */
+        atmos[rec].longwave[i] = hourly_sum(local_forcing_data[LONGWAVE], hour) / options.SNOW_STEP;
       }
-    }
-  }
 
-  if (!options.OUTPUT_FORCE) {
-
-    /****************************************************
-      Albedo
-    ****************************************************/
-
-    /* First, assign default climatology */
-    for (rec = 0; rec < global_param.nrecs; rec++) {
-      for(v = 0; v < veg_con[0].vegetat_type_num; v++) {
-        for (j = 0; j < NF; j++) {
-          veg_hist[rec][v].albedo[j] = veg_lib[veg_con[v].veg_class].albedo[dmy[rec].month-1];
-        }
+      if ( !param_set.TYPE[PAR].SUPPLIED ) {
+        /** par not supplied **/
+        atmos[rec].par[i] = SW2PAR * atmos[rec].shortwave[i];
       }
-    }
-
-    if(param_set.TYPE[ALBEDO].SUPPLIED) {
-      if(param_set.FORCE_DT[param_set.TYPE[ALBEDO].SUPPLIED-1] == 24) {
-        /* daily albedo provided */
-        for (rec = 0; rec < global_param.nrecs; rec++) {
-          for(v = 0; v < veg_con[0].vegetat_type_num; v++) {
-            sum = 0;
-            for (j = 0; j < NF; j++) {
-              hour = rec*global_param.dt + j*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-              if (global_param.starthour - hour_offset_int < 0) hour += 24;
-              idx = (int)((float)hour/24.0);
-              if (local_veg_hist_data[ALBEDO][v][idx] != NODATA_VH)
-  	      veg_hist[rec][v].albedo[j] = local_veg_hist_data[ALBEDO][v][idx]; // assume constant over the day
-              sum += veg_hist[rec][v].albedo[j];
-            }
-            if(NF>1) veg_hist[rec][v].albedo[NR] = sum / (float)NF;
-          }
-        }
+      else if(param_set.FORCE_DT[param_set.TYPE[PAR].SUPPLIED-1] == 24) {
+        /* daily par provided */
+        if (sw_day_mean > 0)
+          atmos[rec].par[i] = local_forcing_data[PAR][day]*atmos[rec].shortwave[i]/sw_day_mean;
+        else
+          atmos[rec].par[i] = 0;
       }
       else {
-        /* sub-daily albedo provided */
-        for(rec = 0; rec < global_param.nrecs; rec++) {
-          for(v = 0; v < veg_con[0].vegetat_type_num; v++) {
-            sum = 0;
-            for(i = 0; i < NF; i++) {
-              hour = rec*global_param.dt + i*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-              veg_hist[rec][v].albedo[i] = 0;
-              while (hour < rec*global_param.dt + (i+1)*options.SNOW_STEP + global_param.starthour - hour_offset_int) {
-                idx = hour;
-                if (idx < 0) idx += 24;
-                if (local_veg_hist_data[ALBEDO][v][idx] != NODATA_VH)
-  	        veg_hist[rec][v].albedo[i] = local_veg_hist_data[ALBEDO][v][idx];
-                hour++;
-              }
-  	    sum += veg_hist[rec][v].albedo[i];
-            }
-            if(NF>1) veg_hist[rec][v].albedo[NR] = sum / (float)NF;
-          }
-        }
+        /* sub-daily par provided */
+        atmos[rec].par[i] = hourly_sum(local_forcing_data[PAR], hour) / options.SNOW_STEP;
       }
-    }
 
-    /****************************************************
-      Leaf Area Index (LAI)
-    ****************************************************/
-
-    /* First, assign default climatology */
-    for (rec = 0; rec < global_param.nrecs; rec++) {
-      for(v = 0; v < veg_con[0].vegetat_type_num; v++) {
-        for (j = 0; j < NF; j++) {
-          veg_hist[rec][v].LAI[j] = veg_lib[veg_con[v].veg_class].LAI[dmy[rec].month-1];
-        }
+      if ( !param_set.TYPE[CATM].SUPPLIED ) {
+        /** Atmospheric carbon dioxide concentration not supplied **/
+        atmos[rec].Catm[i] = CatmCurrent * 1e-6; // convert ppm to mixing ratio
       }
-    }
-
-    if(param_set.TYPE[LAI_IN].SUPPLIED) {
-      if(param_set.FORCE_DT[param_set.TYPE[LAI_IN].SUPPLIED-1] == 24) {
-        /* daily LAI provided */
-        for (rec = 0; rec < global_param.nrecs; rec++) {
-          for(v = 0; v < veg_con[0].vegetat_type_num; v++) {
-            sum = 0;
-            for (j = 0; j < NF; j++) {
-              hour = rec*global_param.dt + j*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-              if (global_param.starthour - hour_offset_int < 0) hour += 24;
-              idx = (int)((float)hour/24.0);
-              if (local_veg_hist_data[LAI_IN][v][idx] != NODATA_VH)
-  	      veg_hist[rec][v].LAI[j] = local_veg_hist_data[LAI_IN][v][idx]; // assume constant over the day
-              sum += veg_hist[rec][v].LAI[j];
-            }
-            if(NF>1) veg_hist[rec][v].LAI[NR] = sum / (float)NF;
-          }
-        }
+      else if(param_set.FORCE_DT[param_set.TYPE[CATM].SUPPLIED-1] == 24) {
+        /* daily atmospheric carbon dioxide concentration provided */
+        atmos[rec].Catm[i] = local_forcing_data[CATM][day]*1e-6; // convert ppm to mixing ratio
       }
       else {
-        /* sub-daily LAI provided */
-        for(rec = 0; rec < global_param.nrecs; rec++) {
-          for(v = 0; v < veg_con[0].vegetat_type_num; v++) {
-            sum = 0;
-            for(i = 0; i < NF; i++) {
-              hour = rec*global_param.dt + i*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-              veg_hist[rec][v].LAI[i] = 0;
-              while (hour < rec*global_param.dt + (i+1)*options.SNOW_STEP + global_param.starthour - hour_offset_int) {
-                idx = hour;
-                if (idx < 0) idx += 24;
-                if (local_veg_hist_data[LAI_IN][v][idx] != NODATA_VH)
-  	        veg_hist[rec][v].LAI[i] = local_veg_hist_data[LAI_IN][v][idx];
-                hour++;
-              }
-  	    sum += veg_hist[rec][v].LAI[i];
-            }
-            if(NF>1) veg_hist[rec][v].LAI[NR] = sum / (float)NF;
-          }
+        /* sub-daily atmospheric carbon dioxide concentration provided */
+        atmos[rec].Catm[i] = 0;
+        for (idx = hour; idx < hour+options.SNOW_STEP; idx++) {
+	  atmos[rec].Catm[i] += local_forcing_data[CATM][idx]*1e-6; // convert ppm to mixing ratio
         }
+        atmos[rec].Catm[i] /= options.SNOW_STEP;
       }
     }
 
-    /****************************************************
-      Fractional Vegetation Cover
-    ****************************************************/
-
-    /* First, assign default climatology */
-    for (rec = 0; rec < global_param.nrecs; rec++) {
-      for(v = 0; v < veg_con[0].vegetat_type_num; v++) {
-        for (j = 0; j < NF; j++) {
-          veg_hist[rec][v].vegcover[j] = veg_lib[veg_con[v].veg_class].vegcover[dmy[rec].month-1];
-        }
-      }
+    if(NF>1) {
+      atmos[rec].tskc[NR] = step_sum(atmos[rec].tskc) / (float)NF;
+      atmos[rec].fdir[NR] = step_sum(atmos[rec].fdir) / (float)NF;
+      atmos[rec].longwave[NR] = step_sum(atmos[rec].longwave) / (float)NF;
+      atmos[rec].par[NR] = step_sum(atmos[rec].par) / (float)NF;
+      atmos[rec].Catm[NR] = step_sum(atmos[rec].Catm) / (float)NF;
     }
 
-    if(param_set.TYPE[VEGCOVER].SUPPLIED) {
-      if(param_set.FORCE_DT[param_set.TYPE[VEGCOVER].SUPPLIED-1] == 24) {
-        /* daily vegcover provided */
-        for (rec = 0; rec < global_param.nrecs; rec++) {
-          for(v = 0; v < veg_con[0].vegetat_type_num; v++) {
-            sum = 0;
-            for (j = 0; j < NF; j++) {
-              hour = rec*global_param.dt + j*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-              if (global_param.starthour - hour_offset_int < 0) hour += 24;
-              idx = (int)((float)hour/24.0);
-              if (local_veg_hist_data[VEGCOVER][v][idx] != NODATA_VH) {
-  	      veg_hist[rec][v].vegcover[j] = local_veg_hist_data[VEGCOVER][v][idx]; // assume constant over the day
-                if (veg_hist[rec][v].vegcover[j] < MIN_VEGCOVER) veg_hist[rec][v].vegcover[j] = MIN_VEGCOVER;
-              }
-              sum += veg_hist[rec][v].vegcover[j];
-            }
-            if(NF>1) veg_hist[rec][v].vegcover[NR] = sum / (float)NF;
-          }
-        }
-      }
-      else {
-        /* sub-daily vegcover provided */
-        for(rec = 0; rec < global_param.nrecs; rec++) {
-          for(v = 0; v < veg_con[0].vegetat_type_num; v++) {
-            sum = 0;
-            for(i = 0; i < NF; i++) {
-              hour = rec*global_param.dt + i*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-              veg_hist[rec][v].vegcover[i] = 0;
-              while (hour < rec*global_param.dt + (i+1)*options.SNOW_STEP + global_param.starthour - hour_offset_int) {
-                idx = hour;
-                if (idx < 0) idx += 24;
-                if (local_veg_hist_data[VEGCOVER][v][idx] != NODATA_VH) {
-  	        veg_hist[rec][v].vegcover[i] = local_veg_hist_data[VEGCOVER][v][idx];
-                  if (veg_hist[rec][v].vegcover[i] < MIN_VEGCOVER) veg_hist[rec][v].vegcover[i] = MIN_VEGCOVER;
-                }
-                hour++;
-              }
-  	    sum += veg_hist[rec][v].vegcover[i];
-            }
-            if(NF>1) veg_hist[rec][v].vegcover[NR] = sum / (float)NF;
-          }
-        }
-      }
-    }
-  }
-  /*************************************************
-    Cosine of Solar Zenith Angle
-  *************************************************/
+    /*************************************************
+      Cosine of Solar Zenith Angle
+    *************************************************/
 
-  for (rec = 0; rec < global_param.nrecs; rec++) {
     dmy_tmp.year = dmy[rec].year;
     dmy_tmp.month = dmy[rec].month;
     dmy_tmp.day = dmy[rec].day;
     dmy_tmp.day_in_year = dmy[rec].day_in_year;
     for (j = 0; j < NF; j++) {
-      hour = rec*global_param.dt + j*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-      if (global_param.starthour - hour_offset_int < 0) hour += 24;
-      dmy_tmp.hour = hour+0.5*options.SNOW_STEP;
+      dmy_tmp.hour = step_hour[rec*NF+j]+0.5*options.SNOW_STEP;
       atmos[rec].coszen[j] = compute_coszen(phi,theta_s,theta_l,dmy_tmp);
     }
     if (NF>1) {
       dmy_tmp.hour = dmy[rec].hour + 0.5*global_param.dt;
       atmos[rec].coszen[NR] = compute_coszen(phi,theta_s,theta_l,dmy_tmp);
     }
-  }
 
-  /*************************************************
-    Direct Shortwave Fraction (from MTCLIM)
-  *************************************************/
-
-  for (rec = 0; rec < global_param.nrecs; rec++) {
-    sum = 0;
-    for (j = 0; j < NF; j++) {
-      hour = rec*global_param.dt + j*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-      if (global_param.starthour - hour_offset_int < 0) hour += 24;
-      idx = (int)((float)hour/24.0);
-      atmos[rec].fdir[j] = fdir[idx]; // assume constant over the day
-      sum += atmos[rec].fdir[j];
-    }
-    if(NF>1) atmos[rec].fdir[NR] = sum / (float)NF;
-  }
+    if (!options.OUTPUT_FORCE) {
 
-  /*************************************************
-    Photosynthetically Active Radiation
-  *************************************************/
+      /****************************************************
+        Albedo, Leaf Area Index (LAI), and Fractional
+        Vegetation Cover: default climatology, replaced
+        by the supplied values where they are not missing
+      ****************************************************/
 
-  if ( !param_set.TYPE[PAR].SUPPLIED ) {
-    /** par not supplied **/
-    for (rec = 0; rec < global_param.nrecs; rec++) {
-      sum = 0;
-      for (i = 0; i < NF; i++) {
-        atmos[rec].par[i] = SW2PAR * atmos[rec].shortwave[i];
-        sum += atmos[rec].par[i];
-      }
-      if(NF>1) atmos[rec].par[NR] = sum / (float)NF;
-    }
-  }
-  else {
-    if(param_set.FORCE_DT[param_set.TYPE[PAR].SUPPLIED-1] == 24) {
-      /* daily par provided */
-      for (rec = 0; rec < global_param.nrecs; rec++) {
-        sum = 0;
-        for (j = 0; j < NF; j++) {
-          hour = rec*global_param.dt + j*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-          if (global_param.starthour - hour_offset_int < 0) hour += 24;
-          idx = (int)((float)hour/24.0);
-          tmp_int = (int)(rec/stepspday)*stepspday;
-          tmp_double = 0;
-          for (i=0; i<stepspday; i++)
-            tmp_double += atmos[tmp_int+i].shortwave[NR];
-          tmp_double /= stepspday;
-          if (tmp_double > 0)
-            atmos[rec].par[j] = local_forcing_data[PAR][idx]*atmos[rec].shortwave[j]/tmp_double;
-          else
-            atmos[rec].par[j] = 0;
-          sum += atmos[rec].par[j];
-        }
-        if(NF>1) atmos[rec].par[NR] = sum / (float)NF;
-      }
-    }
-    else {
-      /* sub-daily par provided */
-      for(rec = 0; rec < global_param.nrecs; rec++) {
-        sum = 0;
-        for(i = 0; i < NF; i++) {
-          hour = rec*global_param.dt + i*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-          if (global_param.starthour - hour_offset_int < 0) hour += 24;
-          atmos[rec].par[i] = 0;
-          for (idx = hour; idx < hour+options.SNOW_STEP; idx++) {
-	    atmos[rec].par[i] += local_forcing_data[PAR][idx];
-          }
-          atmos[rec].par[i] /= options.SNOW_STEP;
-	  sum += atmos[rec].par[i];
-        }
-        if(NF>1) atmos[rec].par[NR] = sum / (float)NF;
-      }
-    }
-  }
-
-  /*************************************************
-    Atmospheric Carbon Dioxide Mixing Ratio
-  *************************************************/
-
-  if ( !param_set.TYPE[CATM].SUPPLIED ) {
-    /** Atmospheric carbon dioxide concentration not supplied **/
-    for (rec = 0; rec < global_param.nrecs; rec++) {
-      sum = 0;
-      for (i = 0; i < NF; i++) {
-        atmos[rec].Catm[i] = CatmCurrent * 1e-6; // convert ppm to mixing ratio
-        sum += atmos[rec].Catm[i];
-      }
-      if(NF>1) atmos[rec].Catm[NR] = sum / (float)NF;
-    }
-  }
-  else {
-    if(param_set.FORCE_DT[param_set.TYPE[CATM].SUPPLIED-1] == 24) {
-      /* daily atmospheric carbon dioxide concentration provided */
-      for (rec = 0; rec < global_param.nrecs; rec++) {
-        sum = 0;
-        for (j = 0; j < NF; j++) {
-          hour = rec*global_param.dt + j*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-          if (global_param.starthour - hour_offset_int < 0) hour += 24;
-          idx = (int)((float)hour/24.0);
-          atmos[rec].Catm[j] = local_forcing_data[CATM][idx]*1e-6; // convert ppm to mixing ratio
-          sum += atmos[rec].Catm[j];
-        }
-        if(NF>1) atmos[rec].Catm[NR] = sum / (float)NF;
-      }
-    }
-    else {
-      /* sub-daily atmospheric carbon dioxide concentration provided */
-      for(rec = 0; rec < global_param.nrecs; rec++) {
-        sum = 0;
-        for(i = 0; i < NF; i++) {
-          hour = rec*global_param.dt + i*options.SNOW_STEP + global_param.starthour - hour_offset_int;
-          if (global_param.starthour - hour_offset_int < 0) hour += 24;
-          atmos[rec].Catm[i] = 0;
-          for (idx = hour; idx < hour+options.SNOW_STEP; idx++) {
-	    atmos[rec].Catm[i] += local_forcing_data[CATM][idx]*1e-6; // convert ppm to mixing ratio
-          }
-          atmos[rec].Catm[i] /= options.SNOW_STEP;
-	  sum += atmos[rec].Catm[i];
-        }
-        if(NF>1) atmos[rec].Catm[NR] = sum / (float)NF;
+      for(v = 0; v < veg_con[0].vegetat_type_num; v++) {
+        veg_hist_forcing(veg_hist[rec][v].albedo, local_veg_hist_data[ALBEDO],
+                         ALBEDO, v, rec, hour_shift, step_hour,
+                         veg_lib[veg_con[v].veg_class].albedo[dmy[rec].month-1]);
+        veg_hist_forcing(veg_hist[rec][v].LAI, local_veg_hist_data[LAI_IN],
+                         LAI_IN, v, rec, hour_shift, step_hour,
+                         veg_lib[veg_con[v].veg_class].LAI[dmy[rec].month-1]);
+        veg_hist_forcing(veg_hist[rec][v].vegcover, local_veg_hist_data[VEGCOVER],
+                         VEGCOVER, v, rec, hour_shift, step_hour,
+                         veg_lib[veg_con[v].veg_class].vegcover[dmy[rec].month-1]);
       }
-    }
-  }
 
-  /****************************************************
-    Determine if Snow will Fall During Each Time Step
-  ****************************************************/
+      /****************************************************
+        Determine if Snow will Fall During Each Time Step
+      ****************************************************/
 
-  if (!options.OUTPUT_FORCE) {
-    min_Tfactor = Tfactor[0];
-    for (band = 1; band < options.SNOW_BAND; band++) {
-      if (Tfactor[band] < min_Tfactor)
-        min_Tfactor = Tfactor[band];
-    }
-    for (rec = 0; rec < global_param.nrecs; rec++) {
       atmos[rec].snowflag[NR] = FALSE;
       for (i = 0; i < NF; i++) {
         if ((atmos[rec].air_temp[i] + min_Tfactor) < global_param.MAX_SNOW_TEMP
@@ -1754,7 +1151,9 @@ void initialize_atmos(atmos_data_struct        *atmos,
         else
 	  atmos[rec].snowflag[i] = FALSE;
       }
+
     }
+
   }
 
   param_set.TYPE[PREC].SUPPLIED = save_prec_supplied;
@@ -1771,30 +1170,22 @@ void initialize_atmos(atmos_data_struct        *atmos,
   free(tminhour);
   free(tskc);
   free(daily_vp);
-  free(dailyrad);
   free(fdir);
+  free(step_hour);
+  free(src_idx[0]);
+  free(src_idx[1]);
 
+  free_cell_forcing(forcing_data, veg_hist_data);
   for(i=0;i<N_FORCING_TYPES;i++)  {
-    if (param_set.TYPE[i].SUPPLIED) {
-      if (i != ALBEDO && i != LAI_IN && i != VEGCOVER) {
-        free(forcing_data[i]);
-      }
-      else {
-        for (j=0;j<param_set.TYPE[i].N_ELEM;j++) free(veg_hist_data[i][j]);
-        free(veg_hist_data[i]);
-      }
-    }
     if (i != ALBEDO && i != LAI_IN && i != VEGCOVER) {
       free(local_forcing_data[i]);
     }
-    else {
+    else if (local_veg_hist_data[i] != NULL) {
       for (j=0;j<param_set.TYPE[i].N_ELEM;j++) free(local_veg_hist_data[i][j]);
       free(local_veg_hist_data[i]);
     }
   }
-  free(forcing_data);
   free(local_forcing_data);
-  free(veg_hist_data);
   free(local_veg_hist_data);
   free((char *)dmy_local);
 
@@ -1820,3 +1211,243 @@ void initialize_atmos(atmos_data_struct        *atmos,
   }
 
 }
+
+/****************************************************************************/
+/*				forcing_value()                             */
+/****************************************************************************/
+static double forcing_value(double **forcing_data, int type, int i)
+/*******************************************************************
+  forcing_value
+
+  Returns element i of the supplied forcing of the given type,
+  converted from ALMA to VIC standard units, or from kPa to Pa.
+*******************************************************************/
+{
+  extern option_struct       options;
+  extern THREAD_LOCAL param_set_struct    param_set;
+
+  if (options.ALMA_INPUT) {
+    /* Convert moisture flux rates to accumulated moisture flux per time step */
+    if (is_flux_forcing(type))
+      return(forcing_data[type][i] * (param_set.FORCE_DT[param_set.TYPE[type].SUPPLIED-1] * 3600));
+    /* Convert temperatures from K to C */
+    if (type == AIR_TEMP || type == TMIN || type == TMAX)
+      return(forcing_data[type][i] - KELVIN);
+  }
+  else {
+    /* Convert pressures from kPa to Pa */
+    if (type == PRESSURE || type == VP)
+      return(forcing_data[type][i] * kPa2Pa);
+  }
+  return(forcing_data[type][i]);
+}
+
+/****************************************************************************/
+/*				is_flux_forcing()                           */
+/****************************************************************************/
+static int is_flux_forcing(int type)
+/*******************************************************************
+  is_flux_forcing
+
+  Returns TRUE for forcings that are amounts per forcing step (as
+  opposed to states or rates that hold over the step).
+*******************************************************************/
+{
+  return(   type == PREC
+         || type == RAINF
+         || type == CRAINF
+         || type == LSRAINF
+         || type == SNOWF
+         || type == CSNOWF
+         || type == LSSNOWF
+         || type == CHANNEL_IN );
+}
+
+/****************************************************************************/
+/*			       local_forcing_used()                         */
+/****************************************************************************/
+static int local_forcing_used(int type)
+/*******************************************************************
+  local_forcing_used
+
+  Returns TRUE for forcings that initialize_atmos() reads from the
+  local-time arrays.  The components of precipitation and wind are
+  combined as they are referenced to local time, and so are not.
+*******************************************************************/
+{
+  switch (type) {
+  case AIR_TEMP:
+  case ALBEDO:
+  case CATM:
+  case CHANNEL_IN:
+  case DENSITY:
+  case LAI_IN:
+  case LONGWAVE:
+  case PAR:
+  case PREC:
+  case PRESSURE:
+  case QAIR:
+  case REL_HUMID:
+  case SHORTWAVE:
+  case TMAX:
+  case TMIN:
+  case VEGCOVER:
+  case VP:
+  case WIND:
+    return(TRUE);
+  default:
+    return(FALSE);
+  }
+}
+
+/****************************************************************************/
+/*			       local_time_index()                           */
+/****************************************************************************/
+static int *local_time_index(int dt, int Ndays, int Ndays_local,
+                             int hour_offset_int)
+/*******************************************************************
+  local_time_index
+
+  Returns the map from the local-time arrays to the elements of a
+  forcing file with step dt.  Daily forcings stay daily; sub-daily
+  forcings are mapped to hourly local arrays that start at hour 0,
+  local time.
+*******************************************************************/
+{
+  extern global_param_struct global_param;
+
+  int  idx;
+  int  i;
+  int  fstepspday;
+  int *map;
+
+  if (dt == 24) {
+    if ( ( map = (int *)calloc(Ndays_local, sizeof(int)) ) == NULL )
+      nrerror("Memory allocation failure in initialize_atmos()");
+    // Daily forcings in non-local time will straddle local day boundaries and need to be padded with an extra day at start or end
+    for (idx=0; idx<Ndays_local; idx++) {
+      i = idx;
+      if (hour_offset_int > 0) i--; // W. Hemisphere, in GMT time
+      if (i < 0) i = 0; // W. Hemisphere, in GMT time; pad extra day in front
+      if (i >= Ndays) i = Ndays-1; // E. Hemisphere, in GMT time; pad extra day at end
+      map[idx] = i;
+    }
+  }
+  else {
+    if ( ( map = (int *)calloc(Ndays_local*24, sizeof(int)) ) == NULL )
+      nrerror("Memory allocation failure in initialize_atmos()");
+    // Sub-daily forcings need to draw from the correct element of the supplied forcings (if the supplied forcings are not in local time)
+    fstepspday = 24/dt;
+    for (idx=0; idx<(Ndays_local*24); idx++) {
+      i = (idx - global_param.starthour + hour_offset_int)/dt;
+      while (i < 0) i += fstepspday; // pad with the first day
+      while (i >= (Ndays*fstepspday)) i -= fstepspday; // pad with the last day
+      map[idx] = i;
+    }
+  }
+
+  return(map);
+}
+
+/****************************************************************************/
+/*				hourly_sum()                                */
+/****************************************************************************/
+static double hourly_sum(const double *x, int hour)
+/*******************************************************************
+  hourly_sum
+
+  Returns the sum of the hourly values x over the snow step that
+  starts at the given local hour.
+*******************************************************************/
+{
+  extern option_struct options;
+
+  int    idx;
+  double sum;
+
+  sum = 0;
+  for (idx = hour; idx < hour+options.SNOW_STEP; idx++)
+    sum += x[idx];
+
+  return(sum);
+}
+
+/****************************************************************************/
+/*				 step_sum()                                 */
+/****************************************************************************/
+static double step_sum(const double *x)
+/*******************************************************************
+  step_sum
+
+  Returns the sum of the NF snow-step values of x.
+*******************************************************************/
+{
+  extern int NF;
+
+  int    i;
+  double sum;
+
+  sum = 0;
+  for (i = 0; i < NF; i++)
+    sum += x[i];
+
+  return(sum);
+}
+
+/****************************************************************************/
+/*			       veg_hist_forcing()                           */
+/****************************************************************************/
+static void veg_hist_forcing(double       *x,
+                             double      **local,
+                             int           type,
+                             int           v,
+                             int           rec,
+                             int           hour_shift,
+                             const int    *step_hour,
+                             double        clim)
+/*******************************************************************
+  veg_hist_forcing
+
+  Fills the snow-step values x of albedo, LAI or vegcover for
+  vegetation tile v in record rec: the climatological value clim,
+  replaced by the supplied values (local) where they are not missing.
+*******************************************************************/
+{
+  extern option_struct       options;
+  extern THREAD_LOCAL param_set_struct    param_set;
+  extern int                 NR, NF;
+
+  int i;
+  int hour;
+  int idx;
+
+  /* First, assign default climatology */
+  for (i = 0; i < NF; i++)
+    x[i] = clim;
+
+  if (!param_set.TYPE[type].SUPPLIED)
+    return;
+
+  for (i = 0; i < NF; i++) {
+    if (param_set.FORCE_DT[param_set.TYPE[type].SUPPLIED-1] == 24) {
+      /* daily values provided; assume constant over the day */
+      idx = step_hour[rec*NF+i]/24;
+      if (local[v][idx] != NODATA_VH) {
+        x[i] = local[v][idx];
+        if (type == VEGCOVER && x[i] < MIN_VEGCOVER) x[i] = MIN_VEGCOVER;
+      }
+    }
+    else {
+      /* sub-daily values provided; starting hour is not shifted to the first local day */
+      x[i] = 0;
+      for (hour = step_hour[rec*NF+i]-hour_shift; hour < step_hour[rec*NF+i]-hour_shift+options.SNOW_STEP; hour++) {
+        idx = (hour < 0) ? hour+24 : hour;
+        if (local[v][idx] != NODATA_VH) {
+          x[i] = local[v][idx];
+          if (type == VEGCOVER && x[i] < MIN_VEGCOVER) x[i] = MIN_VEGCOVER;
+        }
+      }
+    }
+  }
+  if(NF>1) x[NR] = step_sum(x) / (float)NF;
+}
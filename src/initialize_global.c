@@ -133,10 +133,21 @@ void initialize_global() {
   2014-Mar-28 Removed DIST_PRCP option.						TJB
   2014-Apr-25 Added LAI_SRC, VEGPARAM_ALB, and ALB_SRC options.			TJB
   2014-Apr-25 Added VEGPARAM_VEGCOVER and VEGCOVER_SRC options.			TJB
+  2015-Feb-02 Added NTHREADS option.						GT
+  2015-Feb-02 Added SHARD and NSHARDS options.					GT
+  2015-Feb-02 Added PREFETCH option.						GT
+  2015-Feb-02 Added ASYNC_OUTPUT and OUTPUT_QUEUE_LEN options.			GT
+  2015-Feb-02 Added COMPRESS_LEVEL option.					GT
+  2015-Feb-02 Added OUTPUT_CONTAINER option.					GT
+  2015-Feb-02 Added ROOT_SOLVER option.						GT
+  2015-Feb-02 Added IMPLICIT_JACOBIAN option.					GT
+  2015-Feb-02 Default OUTPUT_QUEUE_LEN is now 8, since each queued
+	      record is a block of up to OUT_BUF_SIZE bytes.			GT
+  2015-Feb-02 Added OUTPUT_PET option.						GT
 *********************************************************************/
 
   extern option_struct options;
-  extern param_set_struct param_set;
+  extern THREAD_LOCAL param_set_struct param_set;
 
   int i, j;
 
@@ -157,6 +168,7 @@ void initialize_global() {
   options.FULL_ENERGY           = FALSE;
   options.GRND_FLUX_TYPE        = GF_410;
   options.IMPLICIT              = TRUE;
+  options.IMPLICIT_JACOBIAN     = JACOBIAN_FD;
   options.LAKES                 = FALSE;
   options.LAKE_PROFILE          = FALSE;
   options.LW_CLOUD              = LW_CLOUD_DEARDORFF;
@@ -172,6 +184,7 @@ void initialize_global() {
   options.QUICK_FLUX            = TRUE;
   options.QUICK_SOLVE           = FALSE;
   options.RC_MODE               = RC_JARVIS;
+  options.ROOT_SOLVER           = ROOT_BRENT;
   options.ROOT_ZONES            = MISSING;
   options.SHARE_LAYER_MOIST     = TRUE;
   options.SNOW_BAND             = 1;
@@ -204,11 +217,23 @@ void initialize_global() {
   options.ALMA_OUTPUT           = FALSE;
   options.BINARY_OUTPUT         = FALSE;
   options.COMPRESS              = FALSE;
+  options.COMPRESS_LEVEL        = 6;
   options.MOISTFRACT            = FALSE;
   options.Noutfiles             = 2;
+  options.OUTPUT_CONTAINER      = FALSE;
   options.OUTPUT_FORCE          = FALSE;
+  options.OUTPUT_PET            = TRUE;
   options.PRT_HEADER            = FALSE;
   options.PRT_SNOW_BAND         = FALSE;
+  // execution options
+  options.ASYNC_OUTPUT          = FALSE;
+  options.NSHARDS               = 0; /* 0 = not yet set; resolved to 1 in
+                                        get_global_param() */
+  options.NTHREADS              = 0; /* 0 = not yet set; resolved to 1 in
+                                        get_global_param() */
+  options.OUTPUT_QUEUE_LEN      = 8;
+  options.PREFETCH              = FALSE;
+  options.SHARD                 = 0;
 
   /** Initialize forcing file input controls **/
 
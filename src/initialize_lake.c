@@ -76,6 +76,7 @@ int initialize_lake (lake_var_struct   *lake,
 	      option.							TJB
   2013-Jul-25 Added soil carbon terms.					TJB
   2013-Dec-27 Moved SPATIAL_FROST to options_struct.			TJB
+  2015-Feb-02 Node arrays of lake->energy now hold options.Nnode entries.	GT
 **********************************************************************/
 {
   extern option_struct options;
@@ -251,7 +252,7 @@ int initialize_lake (lake_var_struct   *lake,
     lake->energy.Cs[i]          = 0.0;
     lake->energy.kappa[i]       = 0.0;
   }
-  for (i=0; i<MAX_NODES; i++) {
+  for (i=0; i<options.Nnode; i++) {
     lake->energy.Cs_node[i]     = 0.0;
     lake->energy.ice[i]         = 0.0;
     lake->energy.kappa_node[i]  = 0.0;
@@ -127,7 +127,7 @@ int initialize_model_state(all_vars_struct     *all_vars,
 **********************************************************************/
 {
   extern option_struct options;
-  extern veg_lib_struct *veg_lib;
+  extern THREAD_LOCAL veg_lib_struct *veg_lib;
 
   char     ErrStr[MAXSTRING];
   char     FIRST_VEG;
@@ -679,7 +679,7 @@ int update_thermal_nodes(all_vars_struct     *all_vars,
 **********************************************************************/
 {
   extern option_struct options;
-  extern veg_lib_struct *veg_lib;
+  extern THREAD_LOCAL veg_lib_struct *veg_lib;
   char     ErrStr[MAXSTRING];
   char     FIRST_VEG;
   int      veg, index;
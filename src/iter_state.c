@@ -0,0 +1,226 @@
+/*
+ * Purpose: save and restore the state that the passes of the
+ *          over/understory iteration in surface_fluxes() start from
+ * Usage  : Part of VIC
+ * Created: 2015-Feb-02
+ * Notes  : Each pass of the iteration used to start from whole copies
+ *          of the snow and soil energy records, the two vegetation
+ *          records, the snow record and the soil layers, and the
+ *          records were copied back once the iteration converged.
+ *          surface_fluxes() now works on its records directly and
+ *          resets them before each repeated pass from the fields
+ *          listed in iter_state_struct, which are the only fields a
+ *          pass modifies (the snow record is kept whole).  The first
+ *          pass, and the only one when CLOSE_ENERGY is FALSE, needs no
+ *          reset at all.
+ */
+
+/****************************************************************************/
+/*			  PREPROCESSOR DIRECTIVES                           */
+/****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vicNl.h>
+
+static char vcid[] = "$Id$";
+
+static void save_energy_state(energy_iter_state_struct *state,
+                              energy_bal_struct        *energy)
+{
+  extern option_struct options;
+
+  int i;
+
+  state->AlbedoOver        = energy->AlbedoOver;
+  state->AlbedoUnder       = energy->AlbedoUnder;
+  state->frozen            = energy->frozen;
+  state->Nfrost            = energy->Nfrost;
+  state->Nthaw             = energy->Nthaw;
+  state->Tcanopy           = energy->Tcanopy;
+  state->Tcanopy_fbflag    = energy->Tcanopy_fbflag;
+  state->Tcanopy_fbcount   = energy->Tcanopy_fbcount;
+  state->Tfoliage          = energy->Tfoliage;
+  state->Tfoliage_fbflag   = energy->Tfoliage_fbflag;
+  state->Tfoliage_fbcount  = energy->Tfoliage_fbcount;
+  state->Tsurf             = energy->Tsurf;
+  state->Tsurf_fbflag      = energy->Tsurf_fbflag;
+  state->Tsurf_fbcount     = energy->Tsurf_fbcount;
+  state->advected_sensible = energy->advected_sensible;
+  state->advection         = energy->advection;
+  state->AtmosError        = energy->AtmosError;
+  state->AtmosLatent       = energy->AtmosLatent;
+  state->AtmosLatentSub    = energy->AtmosLatentSub;
+  state->AtmosSensible     = energy->AtmosSensible;
+  state->canopy_advection  = energy->canopy_advection;
+  state->canopy_latent     = energy->canopy_latent;
+  state->canopy_latent_sub = energy->canopy_latent_sub;
+  state->canopy_refreeze   = energy->canopy_refreeze;
+  state->canopy_sensible   = energy->canopy_sensible;
+  state->deltaCC           = energy->deltaCC;
+  state->deltaH            = energy->deltaH;
+  state->error             = energy->error;
+  state->fusion            = energy->fusion;
+  state->grnd_flux         = energy->grnd_flux;
+  state->latent            = energy->latent;
+  state->latent_sub        = energy->latent_sub;
+  state->LongOverIn        = energy->LongOverIn;
+  state->LongUnderOut      = energy->LongUnderOut;
+  state->melt_energy       = energy->melt_energy;
+  state->NetLongAtmos      = energy->NetLongAtmos;
+  state->NetLongOver       = energy->NetLongOver;
+  state->NetLongUnder      = energy->NetLongUnder;
+  state->NetShortAtmos     = energy->NetShortAtmos;
+  state->NetShortGrnd      = energy->NetShortGrnd;
+  state->NetShortOver      = energy->NetShortOver;
+  state->NetShortUnder     = energy->NetShortUnder;
+  state->refreeze_energy   = energy->refreeze_energy;
+  state->sensible          = energy->sensible;
+  state->ShortOverIn       = energy->ShortOverIn;
+  state->snow_flux         = energy->snow_flux;
+  for (i = 0; i < MAX_FRONTS; i++) {
+    state->fdepth[i] = energy->fdepth[i];
+    state->tdepth[i] = energy->tdepth[i];
+  }
+  memcpy(state->T,         energy->T,         options.Nnode*sizeof(double));
+  memcpy(state->T_fbflag,  energy->T_fbflag,  options.Nnode*sizeof(char));
+  memcpy(state->T_fbcount, energy->T_fbcount, options.Nnode*sizeof(int));
+}
+
+static void restore_energy_state(energy_iter_state_struct *state,
+                                 energy_bal_struct        *energy)
+{
+  extern option_struct options;
+
+  int i;
+
+  energy->AlbedoOver        = state->AlbedoOver;
+  energy->AlbedoUnder       = state->AlbedoUnder;
+  energy->frozen            = state->frozen;
+  energy->Nfrost            = state->Nfrost;
+  energy->Nthaw             = state->Nthaw;
+  energy->Tcanopy           = state->Tcanopy;
+  energy->Tcanopy_fbflag    = state->Tcanopy_fbflag;
+  energy->Tcanopy_fbcount   = state->Tcanopy_fbcount;
+  energy->Tfoliage          = state->Tfoliage;
+  energy->Tfoliage_fbflag   = state->Tfoliage_fbflag;
+  energy->Tfoliage_fbcount  = state->Tfoliage_fbcount;
+  energy->Tsurf             = state->Tsurf;
+  energy->Tsurf_fbflag      = state->Tsurf_fbflag;
+  energy->Tsurf_fbcount     = state->Tsurf_fbcount;
+  energy->advected_sensible = state->advected_sensible;
+  energy->advection         = state->advection;
+  energy->AtmosError        = state->AtmosError;
+  energy->AtmosLatent       = state->AtmosLatent;
+  energy->AtmosLatentSub    = state->AtmosLatentSub;
+  energy->AtmosSensible     = state->AtmosSensible;
+  energy->canopy_advection  = state->canopy_advection;
+  energy->canopy_latent     = state->canopy_latent;
+  energy->canopy_latent_sub = state->canopy_latent_sub;
+  energy->canopy_refreeze   = state->canopy_refreeze;
+  energy->canopy_sensible   = state->canopy_sensible;
+  energy->deltaCC           = state->deltaCC;
+  energy->deltaH            = state->deltaH;
+  energy->error             = state->error;
+  energy->fusion            = state->fusion;
+  energy->grnd_flux         = state->grnd_flux;
+  energy->latent            = state->latent;
+  energy->latent_sub        = state->latent_sub;
+  energy->LongOverIn        = state->LongOverIn;
+  energy->LongUnderOut      = state->LongUnderOut;
+  energy->melt_energy       = state->melt_energy;
+  energy->NetLongAtmos      = state->NetLongAtmos;
+  energy->NetLongOver       = state->NetLongOver;
+  energy->NetLongUnder      = state->NetLongUnder;
+  energy->NetShortAtmos     = state->NetShortAtmos;
+  energy->NetShortGrnd      = state->NetShortGrnd;
+  energy->NetShortOver      = state->NetShortOver;
+  energy->NetShortUnder     = state->NetShortUnder;
+  energy->refreeze_energy   = state->refreeze_energy;
+  energy->sensible          = state->sensible;
+  energy->ShortOverIn       = state->ShortOverIn;
+  energy->snow_flux         = state->snow_flux;
+  for (i = 0; i < MAX_FRONTS; i++) {
+    energy->fdepth[i] = state->fdepth[i];
+    energy->tdepth[i] = state->tdepth[i];
+  }
+  memcpy(energy->T,         state->T,         options.Nnode*sizeof(double));
+  memcpy(energy->T_fbflag,  state->T_fbflag,  options.Nnode*sizeof(char));
+  memcpy(energy->T_fbcount, state->T_fbcount, options.Nnode*sizeof(int));
+}
+
+void save_iter_state(iter_state_struct *state,
+                     energy_bal_struct *snow_energy,
+                     energy_bal_struct *soil_energy,
+                     veg_var_struct    *snow_veg_var,
+                     veg_var_struct    *soil_veg_var,
+                     snow_data_struct  *snow,
+                     layer_data_struct *layer,
+                     int                Nlayers)
+/**********************************************************************
+  save_iter_state
+
+  Stores the state that every pass of the surface_fluxes() iteration
+  starts from.  The node arrays of state->snow_energy and
+  state->soil_energy must already be allocated.
+**********************************************************************/
+{
+  int lidx, k;
+
+  save_energy_state(&state->snow_energy, snow_energy);
+  save_energy_state(&state->soil_energy, soil_energy);
+
+  state->snow_veg_var.NPPfactor   = snow_veg_var->NPPfactor;
+  state->snow_veg_var.rc          = snow_veg_var->rc;
+  state->snow_veg_var.throughfall = snow_veg_var->throughfall;
+  state->soil_veg_var.NPPfactor   = soil_veg_var->NPPfactor;
+  state->soil_veg_var.rc          = soil_veg_var->rc;
+  state->soil_veg_var.throughfall = soil_veg_var->throughfall;
+
+  state->snow = *snow;
+
+  for (lidx = 0; lidx < Nlayers; lidx++) {
+    state->layer[lidx].bare_evap_frac = layer[lidx].bare_evap_frac;
+    for (k = 0; k < MAX_FROST_AREAS; k++)
+      state->layer[lidx].ice[k] = layer[lidx].ice[k];
+    state->layer[lidx].T = layer[lidx].T;
+  }
+}
+
+void restore_iter_state(iter_state_struct *state,
+                        energy_bal_struct *snow_energy,
+                        energy_bal_struct *soil_energy,
+                        veg_var_struct    *snow_veg_var,
+                        veg_var_struct    *soil_veg_var,
+                        snow_data_struct  *snow,
+                        layer_data_struct *layer,
+                        int                Nlayers)
+/**********************************************************************
+  restore_iter_state
+
+  Resets the records modified by a pass of the surface_fluxes()
+  iteration to the state stored by save_iter_state().
+**********************************************************************/
+{
+  int lidx, k;
+
+  restore_energy_state(&state->snow_energy, snow_energy);
+  restore_energy_state(&state->soil_energy, soil_energy);
+
+  snow_veg_var->NPPfactor   = state->snow_veg_var.NPPfactor;
+  snow_veg_var->rc          = state->snow_veg_var.rc;
+  snow_veg_var->throughfall = state->snow_veg_var.throughfall;
+  soil_veg_var->NPPfactor   = state->soil_veg_var.NPPfactor;
+  soil_veg_var->rc          = state->soil_veg_var.rc;
+  soil_veg_var->throughfall = state->soil_veg_var.throughfall;
+
+  *snow = state->snow;
+
+  for (lidx = 0; lidx < Nlayers; lidx++) {
+    layer[lidx].bare_evap_frac = state->layer[lidx].bare_evap_frac;
+    for (k = 0; k < MAX_FROST_AREAS; k++)
+      layer[lidx].ice[k] = state->layer[lidx].ice[k];
+    layer[lidx].T = state->layer[lidx].T;
+  }
+}
@@ -1933,6 +1933,7 @@ int water_balance (lake_var_struct *lake, lake_con_struct lake_con, int dt, all_
   2013-Dec-26 Removed EXCESS_ICE option.				TJB
   2013-Dec-27 Moved SPATIAL_FROST to options_struct.			TJB
   2013-Dec-27 Removed QUICK_FS option.					TJB
+  2015-Feb-02 delta_moist and moist are now arrays on the stack.	GT
 **********************************************************************/
 {
   extern option_struct   options;
@@ -1965,8 +1966,8 @@ int water_balance (lake_var_struct *lake, lake_con_struct lake_con, int dt, all_
   double Dsmax, resid_moist, liq, rel_moist;
   double *frost_fract;
   double volume_save;
-  double *delta_moist;
-  double *moist;
+  double delta_moist[MAX_LAYERS];
+  double moist[MAX_LAYERS];
   double max_newfraction;
   double depth_in_save;
 
@@ -1977,9 +1978,6 @@ int water_balance (lake_var_struct *lake, lake_con_struct lake_con, int dt, all_
 
   frost_fract = soil_con.frost_fract;
 
-  delta_moist = (double*)calloc(options.Nlayer,sizeof(double));
-  moist = (double*)calloc(options.Nlayer,sizeof(double));
-
   /**********************************************************************
    * 1. Preliminary stuff
    **********************************************************************/
@@ -2373,9 +2371,6 @@ int water_balance (lake_var_struct *lake, lake_con_struct lake_con, int dt, all_
     advect_carbon_storage(lakefrac, newfraction, lake, &(cell[iveg][band]));
   }
 
-  free((char*)delta_moist);
-  free((char*)moist);
-
   return(0);
 
 }
@@ -19,12 +19,20 @@ all_vars_struct make_all_vars(int  nveg)
   2006-Nov-07 Removed LAKE_MODEL option.  TJB
   2009-Jul-31 Removed extra lake/wetland tile.			TJB
   2014-Mar-28 Removed DIST_PRCP option.					TJB
+  2015-Feb-02 Allocates the work arrays of the per-time step routines
+	      from cell_arena.						GT
+  2015-Feb-02 Allocates the thermal node arrays of the lake energy
+	      record and of the scratch energy records.			GT
+  2015-Feb-02 Allocates the node arrays of scratch.iter_state.	GT
 **********************************************************************/
 {
   extern option_struct options;
+  extern THREAD_LOCAL arena_struct cell_arena;
+  extern THREAD_LOCAL scratch_struct scratch;
 
   all_vars_struct temp;
   int              Nitems;
+  int              i;
 
   Nitems = nveg + 1;
 
@@ -32,6 +40,24 @@ all_vars_struct make_all_vars(int  nveg)
   temp.energy = make_energy_bal(Nitems);
   temp.veg_var  = make_veg_var(Nitems);
   temp.cell     = make_cell_data(Nitems,options.Nlayer);
+  make_energy_nodes(&temp.lake_var.energy);
+
+  scratch.CiLayer       = arena_calloc(&cell_arena, options.Ncanopy, sizeof(double));
+  scratch.gsLayer       = arena_calloc(&cell_arena, options.Ncanopy, sizeof(double));
+  scratch.LAIlayer      = arena_calloc(&cell_arena, options.Ncanopy, sizeof(double));
+  scratch.faPAR         = arena_calloc(&cell_arena, options.Ncanopy, sizeof(double));
+  scratch.store_gsLayer = arena_calloc(&cell_arena, options.Ncanopy, sizeof(double));
+  scratch.dZ            = arena_calloc(&cell_arena, options.Nnode, sizeof(double));
+  scratch.dZCum         = arena_calloc(&cell_arena, options.Nnode, sizeof(double));
+  scratch.w             = arena_calloc(&cell_arena, options.Nnode, sizeof(double));
+  for (i = 0; i < 2; i++)
+    make_energy_nodes(&scratch.energy[i]);
+  scratch.iter_state.snow_energy.T         = arena_calloc(&cell_arena, options.Nnode, sizeof(double));
+  scratch.iter_state.snow_energy.T_fbflag  = arena_calloc(&cell_arena, options.Nnode, sizeof(char));
+  scratch.iter_state.snow_energy.T_fbcount = arena_calloc(&cell_arena, options.Nnode, sizeof(int));
+  scratch.iter_state.soil_energy.T         = arena_calloc(&cell_arena, options.Nnode, sizeof(double));
+  scratch.iter_state.soil_energy.T_fbflag  = arena_calloc(&cell_arena, options.Nnode, sizeof(char));
+  scratch.iter_state.soil_energy.T_fbcount = arena_calloc(&cell_arena, options.Nnode, sizeof(int));
 
   return (temp);
 
@@ -11,17 +11,20 @@ cell_data_struct **make_cell_data(int veg_type_num, int Nlayer)
   This subroutine makes an array of type cell, which contains soil
   column variables for a single grid cell.
 
+  Modifications:
+  2015-Feb-02 Allocated from cell_arena.				GT
 **********************************************************************/
 {
   extern option_struct options;
+  extern THREAD_LOCAL arena_struct cell_arena;
 
   int i;
   cell_data_struct **temp;
 
-  temp = (cell_data_struct**) calloc(veg_type_num, 
+  temp = (cell_data_struct**) arena_calloc(&cell_arena, veg_type_num, 
                                   sizeof(cell_data_struct*));
   for(i=0;i<veg_type_num;i++) {
-    temp[i] = (cell_data_struct*) calloc(options.SNOW_BAND, 
+    temp[i] = (cell_data_struct*) arena_calloc(&cell_arena, options.SNOW_BAND, 
 					 sizeof(cell_data_struct));
 /*     for(j=0;j<options.SNOW_BAND;j++) { */
 /*       temp[i][j].layer  */
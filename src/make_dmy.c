@@ -35,7 +35,7 @@ dmy_struct *make_dmy(global_param_struct *global)
   2013-Nov-21 Added check on start hour in computation of forceskip.	TJB
 **********************************************************************/
 {
-  extern param_set_struct param_set;
+  extern THREAD_LOCAL param_set_struct param_set;
 
   dmy_struct *temp;
   int    hr, year, day, month, jday, ii, daymax;
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <vicNl.h>
  
 static char vcid[] = "$Id$";
@@ -15,25 +16,107 @@ energy_bal_struct **make_energy_bal(int nveg)
   01-Nov-04 Removed modification of Nnodes, as this was preventing
 	    correct reading/writing of state files for QUICK_FLUX
 	    =TRUE.						TJB
+  2015-Feb-02 Allocated from cell_arena.			GT
+  2015-Feb-02 Allocates the thermal node arrays of each record.	GT
 
 **********************************************************************/
 {
   extern option_struct options;
+  extern THREAD_LOCAL arena_struct cell_arena;
 
   int i, j;
   energy_bal_struct **temp;
 
-  temp = (energy_bal_struct**) calloc(nveg, 
+  temp = (energy_bal_struct**) arena_calloc(&cell_arena, nveg, 
 				      sizeof(energy_bal_struct*));
 
   /** Initialize all records to unfrozen conditions */
   for(i = 0; i < nveg; i++) {
-    temp[i] = (energy_bal_struct*) calloc(options.SNOW_BAND, 
+    temp[i] = (energy_bal_struct*) arena_calloc(&cell_arena, options.SNOW_BAND, 
 					  sizeof(energy_bal_struct));
     for(j = 0; j < options.SNOW_BAND; j++) {
+      make_energy_nodes(&temp[i][j]);
       temp[i][j].frozen = FALSE;
     }
   }
 
   return temp;
 }
+
+void make_energy_nodes(energy_bal_struct *energy)
+/**********************************************************************
+  make_energy_nodes
+
+  Allocates the thermal node arrays of an energy balance structure from
+  cell_arena, options.Nnode entries each, in one block.
+**********************************************************************/
+{
+  extern option_struct options;
+  extern THREAD_LOCAL arena_struct cell_arena;
+
+  int     Nnode;
+  double *node_data;
+
+  Nnode = options.Nnode;
+  node_data = (double *) arena_calloc(&cell_arena, 1,
+                                      5*Nnode*sizeof(double)
+                                      + Nnode*sizeof(int)
+                                      + Nnode*sizeof(char));
+  energy->Cs_node    = &node_data[0*Nnode];
+  energy->ice        = &node_data[1*Nnode];
+  energy->kappa_node = &node_data[2*Nnode];
+  energy->moist      = &node_data[3*Nnode];
+  energy->T          = &node_data[4*Nnode];
+  energy->T_fbcount  = (int *)&node_data[5*Nnode];
+  energy->T_fbflag   = (char *)&energy->T_fbcount[Nnode];
+}
+
+void copy_energy_bal(energy_bal_struct *dst,
+                     energy_bal_struct *src)
+/**********************************************************************
+  copy_energy_bal
+
+  Copies the contents of src, including its thermal node arrays, to
+  dst, which keeps its own node arrays.
+**********************************************************************/
+{
+  extern option_struct options;
+
+  double *Cs_node;
+  double *ice;
+  double *kappa_node;
+  double *moist;
+  double *T;
+  char   *T_fbflag;
+  int    *T_fbcount;
+  size_t  n;
+
+  if (dst == src) return;
+
+  Cs_node    = dst->Cs_node;
+  ice        = dst->ice;
+  kappa_node = dst->kappa_node;
+  moist      = dst->moist;
+  T          = dst->T;
+  T_fbflag   = dst->T_fbflag;
+  T_fbcount  = dst->T_fbcount;
+
+  *dst = *src;
+
+  dst->Cs_node    = Cs_node;
+  dst->ice        = ice;
+  dst->kappa_node = kappa_node;
+  dst->moist      = moist;
+  dst->T          = T;
+  dst->T_fbflag   = T_fbflag;
+  dst->T_fbcount  = T_fbcount;
+
+  n = options.Nnode;
+  memcpy(dst->Cs_node,    src->Cs_node,    n*sizeof(double));
+  memcpy(dst->ice,        src->ice,        n*sizeof(double));
+  memcpy(dst->kappa_node, src->kappa_node, n*sizeof(double));
+  memcpy(dst->moist,      src->moist,      n*sizeof(double));
+  memcpy(dst->T,          src->T,          n*sizeof(double));
+  memcpy(dst->T_fbflag,   src->T_fbflag,   n*sizeof(char));
+  memcpy(dst->T_fbcount,  src->T_fbcount,  n*sizeof(int));
+}
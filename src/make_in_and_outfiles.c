@@ -5,10 +5,12 @@
 
 static char vcid[] = "$Id$";
 
-void make_in_and_outfiles(filep_struct         *filep, 
+void make_in_and_outfiles(int                   cellnum,
+			  filep_struct         *filep, 
 			  filenames_struct     *filenames,
 			  soil_con_struct      *soil,
-			  out_data_file_struct *out_data_files)
+			  out_data_file_struct *out_data_files,
+			  out_data_struct      *out_data)
 /**********************************************************************
 	make_in_and_outfile	Dag Lohman	January 1996
 
@@ -33,50 +35,48 @@ void make_in_and_outfiles(filep_struct         *filep,
 	      in global parameter file.					TJB
   2011-May-25 Expanded latchar, lngchar, and junk allocations to handle
 	      GRID_DECIMAL > 4.						TJB
+  2015-Feb-02 The forcing files are now opened (and read) by
+	      read_cell_forcing(), so that they can be read ahead of
+	      the cell's simulation.  This routine now only opens the
+	      output files.						GT
+  2015-Feb-02 When COMPRESS is TRUE, the output files are opened with
+	      open_compressed_file(), which writes them compressed.	GT
+  2015-Feb-02 With BINARY_OUTPUT, allocates each output file's record
+	      buffer, sized from the file's variables and their types,
+	      so that write_data() can write records in large blocks.	GT
+  2015-Feb-02 Allocates the buffers of ASCII output files too.		GT
+  2015-Feb-02 Added cellnum to the argument list.  With
+	      OUTPUT_CONTAINER, no files are opened; the cell is added
+	      to the output containers instead.				GT
+  2015-Feb-02 The date fields of a binary record depend on the file's
+	      own output interval.					GT
 
 **********************************************************************/
 {
   extern option_struct    options;
-  extern param_set_struct param_set;
   extern FILE *open_file(char string[], char type[]);
 
+
   char   latchar[20], lngchar[20], junk[6];
   int filenum;
+  int var_idx;
+  int varid;
+  size_t reclen;
+  size_t elemsize;
 
   sprintf(junk, "%%.%if", options.GRID_DECIMAL);
   sprintf(latchar, junk, soil->lat);
   sprintf(lngchar, junk, soil->lng);
  
-  /********************************
-  Input Forcing Files
-  ********************************/
-
-  strcpy(filenames->forcing[0], filenames->f_path_pfx[0]);
-  strcat(filenames->forcing[0], latchar);
-  strcat(filenames->forcing[0], "_");
-  strcat(filenames->forcing[0], lngchar);
-  if(param_set.FORCE_FORMAT[0] == BINARY)
-    filep->forcing[0] = open_file(filenames->forcing[0], "rb");
-  else
-    filep->forcing[0] = open_file(filenames->forcing[0], "r");
-
-  filep->forcing[1] = NULL;
-  if(strcasecmp(filenames->f_path_pfx[1],"MISSING")!=0) {
-    strcpy(filenames->forcing[1], filenames->f_path_pfx[1]);
-    strcat(filenames->forcing[1], latchar);
-    strcat(filenames->forcing[1], "_");
-    strcat(filenames->forcing[1], lngchar);
-    if(param_set.FORCE_FORMAT[0] == BINARY) 
-      filep->forcing[1] = open_file(filenames->forcing[1], "rb");
-    else 
-      filep->forcing[1] = open_file(filenames->forcing[1], "r");
-  }
-
   /********************************
   Output Files
   ********************************/
 
   for (filenum=0; filenum<options.Noutfiles; filenum++) {
+    if (options.OUTPUT_CONTAINER) {
+      start_container_cell(&out_data_files[filenum], cellnum, soil);
+      continue;
+    }
     strcpy(out_data_files[filenum].filename, filenames->result_dir);
     strcat(out_data_files[filenum].filename, "/");
     strcat(out_data_files[filenum].filename, out_data_files[filenum].prefix);
@@ -84,9 +84,64 @@ void make_in_and_outfiles(filep_struct         *filep,
     strcat(out_data_files[filenum].filename, latchar);
     strcat(out_data_files[filenum].filename, "_");
     strcat(out_data_files[filenum].filename, lngchar);
-    if(options.BINARY_OUTPUT)
+    if(options.COMPRESS)
+      out_data_files[filenum].fh = open_compressed_file(out_data_files[filenum].filename, "wb");
+    else if(options.BINARY_OUTPUT)
       out_data_files[filenum].fh = open_file(out_data_files[filenum].filename, "wb");
     else out_data_files[filenum].fh = open_file(out_data_files[filenum].filename, "w");
   }
 
+  /********************************
+  Output Buffers
+  ********************************/
+
+  if(options.BINARY_OUTPUT) {
+    for (filenum=0; filenum<options.Noutfiles; filenum++) {
+      // Record layout: the date (see write_data()), then each variable's
+      // elements as the variable's binary type
+      reclen = 0;
+      if (!options.OUTPUT_FORCE) {
+        if (out_data_files[filenum].out_dt > 0 && out_data_files[filenum].out_dt < 24)
+          reclen += 4 * sizeof(int);
+        else
+          reclen += 3 * sizeof(int);
+      }
+      for (var_idx=0; var_idx<out_data_files[filenum].nvars; var_idx++) {
+        varid = out_data_files[filenum].varid[var_idx];
+        switch (out_data[varid].type) {
+          case OUT_TYPE_CHAR:   elemsize = sizeof(char); break;
+          case OUT_TYPE_SINT:   elemsize = sizeof(short int); break;
+          case OUT_TYPE_USINT:  elemsize = sizeof(unsigned short int); break;
+          case OUT_TYPE_INT:    elemsize = sizeof(int); break;
+          case OUT_TYPE_FLOAT:  elemsize = sizeof(float); break;
+          case OUT_TYPE_DOUBLE: elemsize = sizeof(double); break;
+          default:              elemsize = 0; break;
+        }
+        reclen += elemsize * out_data[varid].nelem;
+      }
+      out_data_files[filenum].reclen = reclen;
+      out_data_files[filenum].buflen = 0;
+      out_data_files[filenum].bufrecs = 0;
+      if (reclen > 0 && reclen < OUT_BUF_SIZE)
+        out_data_files[filenum].bufsize = (OUT_BUF_SIZE / reclen) * reclen;
+      else
+        out_data_files[filenum].bufsize = reclen;
+      out_data_files[filenum].buf = (char *)malloc(out_data_files[filenum].bufsize + 1);
+      if (out_data_files[filenum].buf == NULL)
+        nrerror("Memory allocation error in make_in_and_outfiles().");
+    }
+  }
+  else {
+    for (filenum=0; filenum<options.Noutfiles; filenum++) {
+      // Lines of text; write_data() grows the buffer if a line needs it
+      out_data_files[filenum].reclen = 0;
+      out_data_files[filenum].buflen = 0;
+      out_data_files[filenum].bufrecs = 0;
+      out_data_files[filenum].bufsize = OUT_BUF_SIZE;
+      out_data_files[filenum].buf = (char *)malloc(out_data_files[filenum].bufsize);
+      if (out_data_files[filenum].buf == NULL)
+        nrerror("Memory allocation error in make_in_and_outfiles().");
+    }
+  }
+
 } 
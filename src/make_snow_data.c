@@ -15,19 +15,21 @@ snow_data_struct **make_snow_data(int nveg)
   07-09-98 modified to make te make a two dimensional array which 
            also accounts for a variable number of snow elevation
            bands                                               KAC
+  2015-Feb-02 Allocated from cell_arena.			GT
 
 **********************************************************************/
 {
   extern option_struct options;
+  extern THREAD_LOCAL arena_struct cell_arena;
 
   int                i;
   snow_data_struct **temp;
 
-  temp = (snow_data_struct **) calloc(nveg, 
+  temp = (snow_data_struct **) arena_calloc(&cell_arena, nveg, 
 				      sizeof(snow_data_struct *));
 
   for(i=0;i<nveg;i++) {
-    temp[i] = (snow_data_struct *) calloc(options.SNOW_BAND, 
+    temp[i] = (snow_data_struct *) arena_calloc(&cell_arena, options.SNOW_BAND, 
 					  sizeof(snow_data_struct));
   }
     
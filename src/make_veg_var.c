@@ -15,23 +15,25 @@ veg_var_struct **make_veg_var(int veg_type_num)
   07-13-98 modified to add structure definitions for all defined 
            elevation bands                                       KAC
   2013-Jul-25 Added photosynthesis terms.				TJB
+  2015-Feb-02 Allocated from cell_arena.				GT
 **********************************************************************/
 {
   extern option_struct options;
+  extern THREAD_LOCAL arena_struct cell_arena;
   
   int              i, j;
   veg_var_struct **temp;
 
-  temp = (veg_var_struct **) calloc(veg_type_num, sizeof(veg_var_struct *));
+  temp = (veg_var_struct **) arena_calloc(&cell_arena, veg_type_num, sizeof(veg_var_struct *));
   for(i=0;i<veg_type_num;i++) {
-    temp[i] = (veg_var_struct *) calloc(options.SNOW_BAND, sizeof(veg_var_struct));
+    temp[i] = (veg_var_struct *) arena_calloc(&cell_arena, options.SNOW_BAND, sizeof(veg_var_struct));
 
     if (options.CARBON) {
       for ( j = 0 ; j < options.SNOW_BAND ; j++ ) {
-         temp[i][j].NscaleFactor = (double *)calloc(options.Ncanopy,sizeof(double));
-         temp[i][j].aPARLayer = (double *)calloc(options.Ncanopy,sizeof(double));
-         temp[i][j].CiLayer = (double *)calloc(options.Ncanopy,sizeof(double));
-         temp[i][j].rsLayer = (double *)calloc(options.Ncanopy,sizeof(double));
+         temp[i][j].NscaleFactor = (double *)arena_calloc(&cell_arena,options.Ncanopy,sizeof(double));
+         temp[i][j].aPARLayer = (double *)arena_calloc(&cell_arena,options.Ncanopy,sizeof(double));
+         temp[i][j].CiLayer = (double *)arena_calloc(&cell_arena,options.Ncanopy,sizeof(double));
+         temp[i][j].rsLayer = (double *)arena_calloc(&cell_arena,options.Ncanopy,sizeof(double));
       }
     }
 
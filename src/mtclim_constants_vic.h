@@ -25,6 +25,10 @@ Sat Aug 21 16:58:43 1999
   2011-Nov-04 Updated to MTCLIM 4.3				TJB
   2012-Feb-16 Removed calc_srad_humidity().			TJB
   2013-Jul-25 Added data->s_fdir.				TJB
+  2015-Feb-02 Added radgeom_struct, the per-site table of daily
+	      radiation geometry (including the SRADDT steps with the
+	      sun above the horizon), and its cache functions.		GT
+  2015-Feb-02 Added PRCP_WINDOW.					GT
 
 */
 
@@ -54,6 +58,7 @@ Sat Aug 21 16:58:43 1999
 #ifndef PI
 #define PI       3.14159265
 #endif
+#define PRCP_WINDOW   90  /* days in effective annual precip window */
 /* end vic_change */
 
 /****************************
@@ -111,6 +116,46 @@ typedef struct
   /* end vic_change */
 } data_struct;
 
+/* start vic_change */
+#define N_OPTAM       21  /* number of tabulated optical air masses */
+#define N_TRANS_MOM   20  /* terms of the transmittance series at high sun */
+
+/* Daily radiation geometry of a site.  Depends only on the site's
+   latitude, slope, aspect and horizons, so it is computed once per
+   distinct site and shared by all cells (see get_radgeom()).  Index
+   is yearday-1; yearday 366 = yearday 365. */
+typedef struct radgeom_struct
+{
+  double lat;                 /* key: site latitude, dec. degrees */
+  double slp;                 /* key: site slope, degrees */
+  double asp;                 /* key: site aspect, degrees */
+  double ehoriz;              /* key: site east horizon, degrees */
+  double whoriz;              /* key: site west horizon, degrees */
+  double cosegeom[366];       /* cos(lat)*cos(decl) */
+  double sinegeom[366];       /* sin(lat)*sin(decl) */
+  double daylength[366];      /* daylength (s) */
+  double h_first[366];        /* hour angle (radians) of the first */
+  int    s_first[366];        /* SRADDT step with the sun above the flat
+                                 horizon, and the SRADDT slot of the day
+                                 (0-86400/SRADDT-1) it falls in */
+  int    n_steps[366];        /* number of SRADDT steps with the sun
+                                 above the flat horizon (see calc_radgeom()) */
+  double cza_sum[366];        /* sum of cos(zenith) over those steps */
+  double flat_potrad[366];    /* daylight average potential radiation,
+                                 flat surface (W/m2) */
+  double slope_potrad[366];   /* daylight average potential radiation,
+                                 direct on slope (W/m2) */
+  double optam_wt[366][N_OPTAM];     /* fraction of the daily flat potential
+                                        radiation received at each of the
+                                        tabulated optical air masses */
+  double trans_mom[366][N_TRANS_MOM]; /* moments sum(am^k/k!) over the
+                                        rest of the day (air mass <= 2.9),
+                                        weighted by the fraction of the
+                                        daily flat potential radiation */
+  struct radgeom_struct *next;
+} radgeom_struct;
+/* end vic_change */
+
 /********************************
  **                             **
  **    FUNCTION PROTOTYPES      **
@@ -123,7 +168,9 @@ int calc_prcp(const control_struct *ctrl, const parameter_struct *p,
 /* start vic_change */
 int calc_srad_humidity_iterative(const control_struct *ctrl,
 				 const parameter_struct *p, data_struct *data,
-				 double **tiny_radfract);
+				 const radgeom_struct *geom);
+const radgeom_struct *get_radgeom(const parameter_struct *p);
+double radfract(const radgeom_struct *geom, int yday, double t1, double t2);
 int snowpack(const control_struct *ctrl, const parameter_struct *p, 
 	      data_struct *data);
 void compute_srad_humidity_onetime(int ndays, const control_struct *ctrl, data_struct *data, double *tdew, double *pva, double *ttmax0, double *flat_potrad, double *slope_potrad, double sky_prop, double *daylength, double *pet, double *parray, double pa, double *dtr);
@@ -49,6 +49,20 @@
   2013-Jul-19 Fixed bug in shortwave computation for case when daily shortwave
 	      is supplied by the user.						HFC via TJB
   2013-Jul-25 Added data->s_fdir.						TJB
+  2015-Feb-02 The daily radiation geometry (daylength, flat and slope
+	      potential radiation, and the weights for the daily
+	      transmittance) is computed by get_radgeom() and cached per
+	      site geometry, instead of stepping the hour angle every
+	      SRADDT seconds for every cell.  get_radgeom() takes the same
+	      steps, once per geometry; the pressure-dependent daily
+	      transmittance is recovered from its tables to round-off.
+	      tiny_radfract is replaced by radfract(), which sums the same
+	      SRADDT steps in closed form.  Daily and hourly forcings are
+	      unchanged to round-off.						GT
+  2015-Feb-02 The dtr and precip totals are computed in one pass, and
+	      the 90-day precip windows are read in place instead of from
+	      an (ndays+90) copy of the record.  The window sums are added
+	      in the original order, so the results are unchanged.	GT
 */
 
 /*
@@ -297,6 +311,7 @@ MTCLIM version 3.1 testing
 #include <string.h>
 #include <time.h>
 #include <math.h>
+#include <pthread.h>
 #include <vicNl.h>
 
 #include <mtclim_constants_vic.h>   /* physical constants */
@@ -534,37 +549,28 @@ int snowpack(const control_struct *ctrl, const parameter_struct *p,
 /* Note: too many changes to maintain the start/end vic change comments */
 int calc_srad_humidity_iterative(const control_struct *ctrl,
 				 const parameter_struct *p, data_struct *data,
-				 double **tiny_radfract)
+				 const radgeom_struct *geom)
 {
   int ok=1;
   int i,j,ndays;
   int start_yday,end_yday,isloop;
-  int ami,yday;
+  int yday;
   double ttmax0[366];
   double flat_potrad[366];
   double slope_potrad[366];
   double daylength[366];
   double *dtr, *sm_dtr;
-  double *parray, *window, *t_fmax, *tdew;
+  double *parray, *lead_in, *t_fmax, *tdew;
   double *pet;
   double sum_prcp,ann_prcp,effann_prcp;
   double sum_pet,ann_pet;
   double tmax,tmin;
   double t1,t2;
   double pratio;
-  double lat,coslat,sinlat,dt,h,dh;
-  double cosslp,sinslp,cosasp,sinasp;
-  double bsg1,bsg2,bsg3;
-  double decl,cosdecl,sindecl,cosegeom,sinegeom,coshss,hss;
-  double sc,dir_beam_topa;
-  double sum_flat_potrad,sum_slope_potrad,sum_trans;
-  double cosh,sinh;
-  double cza,cbsa,coszeh,coszwh;
-  double dir_flat_topa,am;
   double t_tmax,b;
   double tmink,ratio,ratio2,ratio3,tdewk;
   double pvs,vpd;
-  double trans1,trans2;
+  double trans1,logtrans1;
   double t_final,pdif,pdir,srad1,srad2; 
   double pa;
   double sky_prop;
@@ -577,8 +583,6 @@ int calc_srad_humidity_iterative(const control_struct *ctrl,
 		      6.18,6.88,7.77,8.90,10.39,12.44,15.36,19.79,26.96,30.00};
   
   /* start vic_change */
-  int tinystep;
-  int tinystepspday;
   extern option_struct options;
   double tfmax_tmp;
   /* end vic_change */
@@ -609,11 +613,6 @@ int calc_srad_humidity_iterative(const control_struct *ctrl,
     printf("Error allocating for effective annual precip array\n");
     ok=0;
   }
-  /* allocate space for the prcp totaling array */
-  if (!(window = (double*) malloc((ndays+90)*sizeof(double)))) {
-    printf("Error allocating for prcp totaling array\n");
-    ok = 0;
-  }
   /* allocate space for t_fmax */
   if (!(t_fmax = (double*) malloc(ndays * sizeof(double)))) {
     printf("Error allocating for p_tt_max array\n");
@@ -645,13 +644,16 @@ int calc_srad_humidity_iterative(const control_struct *ctrl,
     ok=0;
   }
 
-  /* calculate diurnal temperature range for transmittance calculations */
+  /* calculate diurnal temperature range for transmittance calculations,
+     and the total precip (one pass over the record) */
+  sum_prcp = 0.0;
   for (i=0 ; i<ndays ; i++) {
     tmax = data->tmax[i];
     tmin = data->tmin[i];
     if (tmax < tmin) 
       tmax = tmin;
     dtr[i] = tmax-tmin;
+    sum_prcp += data->s_prcp[i];
   }
   
   /* smooth dtr array: After Bristow and Campbell, 1984 */
@@ -669,24 +671,15 @@ int calc_srad_humidity_iterative(const control_struct *ctrl,
   }
 
   /* calculate the annual total precip */
-  sum_prcp = 0.0;
-  for (i=0 ; i<ndays ; i++) {
-    sum_prcp += data->s_prcp[i];
-  }
   ann_prcp = (sum_prcp/(double)ndays) * 365.25;
-  if (ann_prcp == 0.0) ann_prcp = 1.0;
 	
   /* Generate the effective annual precip, based on a 3-month
      moving-window. Requires some special case handling for the
      beginning of the record and for short records. */
   /* check if there are at least 90 days in this input file, if not,
      use a simple total scaled to effective annual precip */
-  if (ndays < 90) {
-    sum_prcp = 0.0;
-    for (i=0 ; i<ndays ; i++) {
-      sum_prcp += data->s_prcp[i];
-    }
-    effann_prcp = (sum_prcp/(double)ndays) * 365.25;
+  if (ndays < PRCP_WINDOW) {
+    effann_prcp = ann_prcp;
     /* if the effective annual precip for this period
        is less than 8 cm, set the effective annual precip to 8 cm
        to reflect an arid condition, while avoiding possible
@@ -712,33 +705,35 @@ int calc_srad_humidity_iterative(const control_struct *ctrl,
       isloop = (end_yday == 365 || end_yday == 366) ? 1 : 0;
     }
     
-    /* fill the first 90 days of window */
-    for (i=0 ; i<90 ; i++) {
-      if (isloop) 
-	window[i] = data->s_prcp[ndays-90+i];
-      else 
-	window[i] = data->s_prcp[i];
-    }
-    /* fill the rest of the window array */
-    for (i=0 ; i<ndays ; i++) {
-      window[i+90] = data->s_prcp[i];
-    }
+    /* the window for day i is the 90 days before day i; for the first
+       90 days, it starts in the lead-in (the last or the first 90 days
+       of the record), so that window element k is
+       k < 90 ? lead_in[k] : s_prcp[k-90] */
+    lead_in = (isloop) ? &(data->s_prcp[ndays-PRCP_WINDOW]) : data->s_prcp;
     
     /* for each day, calculate the effective annual precip from 
        scaled 90-day total */
     for (i=0 ; i<ndays ; i++)	{
       sum_prcp = 0.0;
-      for (j=0 ; j<90 ; j++) {
-	sum_prcp += window[i+j];
+      if (i < PRCP_WINDOW) {
+	for (j=i ; j<PRCP_WINDOW ; j++)
+	  sum_prcp += lead_in[j];
+	for (j=0 ; j<i ; j++)
+	  sum_prcp += data->s_prcp[j];
+      }
+      else {
+	for (j=i-PRCP_WINDOW ; j<i ; j++)
+	  sum_prcp += data->s_prcp[j];
       }
-      sum_prcp = (sum_prcp/90.0) * 365.25;
+      effann_prcp = (sum_prcp/90.0) * 365.25;
       /* if the effective annual precip for this 90-day period
 	 is less than 8 cm, set the effective annual precip to 8 cm
 	 to reflect an arid condition, while avoiding possible
 	 division-by-zero errors and very large ratios (PET/Pann) */
-      parray[i] = (sum_prcp < 8.0) ? 8.0 : sum_prcp;
+      parray[i] = (effann_prcp < 8.0) ? 8.0 : effann_prcp;
     }
   } /* end if ndays >= 90 */	
+  if (ann_prcp == 0.0) ann_prcp = 1.0;
   
   /*****************************************
    *                                       *
@@ -759,176 +754,28 @@ int calc_srad_humidity_iterative(const control_struct *ctrl,
   trans1 = pow(TBASE,pratio);
   
   /* STEP (3) build 366-day array of ttmax0, potential rad, and daylength */
-  
-  /* precalculate the transcendentals */
-  lat = p->site_lat;
-  /* check for (+/-) 90 degrees latitude, throws off daylength calc */
-  lat *= RADPERDEG;
-  if (lat > 1.5707) 
-    lat = 1.5707;
-  if (lat < -1.5707) 
-    lat = -1.5707;
-  coslat = cos(lat);
-  sinlat = sin(lat);
-  cosslp = cos(p->site_slp * RADPERDEG);
-  sinslp = sin(p->site_slp * RADPERDEG);
-  cosasp = cos(p->site_asp * RADPERDEG);
-  sinasp = sin(p->site_asp * RADPERDEG);
-  /* cosine of zenith angle for east and west horizons */
-  coszeh = cos(1.570796 - (p->site_ehoriz * RADPERDEG));
-  coszwh = cos(1.570796 - (p->site_whoriz * RADPERDEG));
-  
-  /* sub-daily time and angular increment information */
-  dt = SRADDT;                /* set timestep */ 
-  dh = dt / SECPERRAD;        /* calculate hour-angle step */
   /* start vic_change */
-  tinystepspday = 86400/SRADDT;
-  /* end vic_change */
-
-  /* begin loop through yeardays */
-  for (i=0 ; i<365 ; i++) {
-    /* calculate cos and sin of declination */
-    decl = MINDECL * cos(((double)i + DAYSOFF) * RADPERDAY);
-    cosdecl = cos(decl);
-    sindecl = sin(decl);
-    
-    /* do some precalculations for beam-slope geometry (bsg) */
-    bsg1 = -sinslp * sinasp * cosdecl;
-    bsg2 = (-cosasp * sinslp * sinlat + cosslp * coslat) * cosdecl;
-    bsg3 = (cosasp * sinslp * coslat + cosslp * sinlat) * sindecl;
-    
-    /* calculate daylength as a function of lat and decl */
-    cosegeom = coslat * cosdecl;
-    sinegeom = sinlat * sindecl;
-    coshss = -(sinegeom) / cosegeom;
-    if (coshss < -1.0) 
-      coshss = -1.0;  /* 24-hr daylight */
-    if (coshss > 1.0) 
-      coshss = 1.0;    /* 0-hr daylight */
-    hss = acos(coshss);                /* hour angle at sunset (radians) */
-    /* daylength (seconds) */
-    daylength[i] = 2.0 * hss * SECPERRAD;
-    
-    /* start vic_change */
-    if (daylength[i] > 86400)
-      daylength[i] = 86400;
-    /* end vic_change */
-    
-    /* solar constant as a function of yearday (W/m^2) */
-    sc = 1368.0 + 45.5*sin((2.0*PI*(double)i/365.25) + 1.7);
-    /* extraterrestrial radiation perpendicular to beam, total over
-       the timestep (J) */
-    dir_beam_topa = sc * dt;
-    
-    sum_trans = 0.0;
-    sum_flat_potrad = 0.0;
-    sum_slope_potrad = 0.0;
-    
-    /* begin sub-daily hour-angle loop, from -hss to hss */
-    for (h=-hss ; h<hss ; h+=dh) {
-      /* precalculate cos and sin of hour angle */
-      cosh = cos(h);
-      sinh = sin(h);
-      
-      /* calculate cosine of solar zenith angle */
-      cza = cosegeom * cosh + sinegeom;
-      
-      /* calculate cosine of beam-slope angle */
-      cbsa = sinh * bsg1 + cosh * bsg2 + bsg3;
-      
-      /* check if sun is above a flat horizon */
-      if (cza > 0.0) {
-	/* when sun is above the ideal (flat) horizon, do all the
-	   flat-surface calculations to determine daily total
-	   transmittance, and save flat-surface potential radiation
-	   for later calculations of diffuse radiation */
-	
-	/* potential radiation for this time period, flat surface,
-	   top of atmosphere */
-	dir_flat_topa = dir_beam_topa * cza;
-	
-	/* determine optical air mass */
-	am = 1.0/(cza + 0.0000001);
-	if (am > 2.9) {
-	  ami = (int)(acos(cza)/RADPERDEG) - 69;
-	  if (ami < 0) 
-	    ami = 0;
-	  if (ami > 20) 
-	    ami = 20;
-	  am = optam[ami];
-	}
-	
-	/* correct instantaneous transmittance for this optical
-	   air mass */
-	trans2 = pow(trans1,am);
-	
-	/* instantaneous transmittance is weighted by potential
-	   radiation for flat surface at top of atmosphere to get
-	   daily total transmittance */
-	sum_trans += trans2 * dir_flat_topa;
-	
-	/* keep track of total potential radiation on a flat
-	   surface for ideal horizons */
-	sum_flat_potrad += dir_flat_topa;
-	
-	/* keep track of whether this time step contributes to
-	   component 1 (direct on slope) */
-	if ((h<0.0 && cza>coszeh && cbsa>0.0) ||
-	    (h>=0.0 && cza>coszwh && cbsa>0.0)) {
-	  
-	  /* sun between east and west horizons, and direct on
-	     slope. this period contributes to component 1 */
-	  sum_slope_potrad += dir_beam_topa * cbsa;
-	}
-	
-      } /* end if sun above ideal horizon */
-      else dir_flat_topa = -1;
-
-      /* start vic_change */
-      tinystep = (12L * 3600L + h * SECPERRAD)/SRADDT;
-      if (tinystep < 0)
-	tinystep = 0;
-      if (tinystep > tinystepspday-1)
-	tinystep = tinystepspday-1;
-      if (dir_flat_topa > 0)
-	tiny_radfract[i][tinystep] = dir_flat_topa;
-      else
-	tiny_radfract[i][tinystep] = 0;
-      /* end vic_change */
-      
-    } /* end of sub-daily hour-angle loop */
-    
-    /* start vic_change */
-    if (daylength[i] && sum_flat_potrad > 0) {
-      for (j = 0; j < tinystepspday; j++)
-	tiny_radfract[i][j] /= sum_flat_potrad;
-    }
-    /* end vic_change */
-
-    /* calculate maximum daily total transmittance and daylight average
-       flux density for a flat surface and the slope */
+  /* potential radiation and daylength depend only on the site geometry,
+     and are taken from geom.  ttmax0, the daily total transmittance
+     weighted by flat-surface potential radiation, is the sum over the
+     tabulated optical air masses weighted by geom's radiation fractions,
+     plus the series in log(trans1) for the steps with lower air mass
+     (see calc_radgeom()). */
+  logtrans1 = log(trans1);
+  for (i=0 ; i<366 ; i++) {
+    daylength[i] = geom->daylength[i];
+    flat_potrad[i] = geom->flat_potrad[i];
+    slope_potrad[i] = geom->slope_potrad[i];
+    ttmax0[i] = 0.0;
     if (daylength[i]) {
-      ttmax0[i] = sum_trans / sum_flat_potrad;
-      flat_potrad[i] = sum_flat_potrad / daylength[i];
-      slope_potrad[i] = sum_slope_potrad / daylength[i];
-    }
-    else {
-      ttmax0[i] = 0.0;
-      flat_potrad[i] = 0.0;
-      slope_potrad[i] = 0.0;
+      for (j=N_TRANS_MOM-1 ; j>=0 ; j--)
+	ttmax0[i] = ttmax0[i] * logtrans1 + geom->trans_mom[i][j];
+      for (j=0 ; j<N_OPTAM ; j++) {
+	if (geom->optam_wt[i][j] > 0.0)
+	  ttmax0[i] += geom->optam_wt[i][j] * pow(trans1,optam[j]);
+      }
     }
-
-  } /* end of i=365 days loop */
-  
-  /* force yearday 366 = yearday 365 */
-  ttmax0[365] = ttmax0[364];
-  flat_potrad[365] = flat_potrad[364];
-  slope_potrad[365] = slope_potrad[364];
-  daylength[365] = daylength[364];
-  
-  /* start vic_change */
-  for (j = 0 ; j < tinystepspday; j++)
-    tiny_radfract[365][j] = tiny_radfract[364][j];
+  }
   /* end vic_change */
 
   /* STEP (4)  calculate the sky proportion for diffuse radiation */
@@ -1082,7 +929,6 @@ int calc_srad_humidity_iterative(const control_struct *ctrl,
   free(dtr);
   free(sm_dtr);
   free(parray);
-  free(window);
   free(t_fmax);
   free(tdew);
   free(pet);
@@ -1222,6 +1068,316 @@ void compute_srad_humidity_onetime(int ndays, const control_struct *ctrl, data_s
 
 }
 
+/* New functions, not originally part of MTCLIM code */
+
+/* The daily radiation geometry used to be integrated by stepping the hour
+   angle at SRADDT intervals for every cell.  The same steps are now taken
+   once per distinct site geometry, and their sums are cached for the
+   whole run in a form that does not depend on the cell's pressure. */
+
+static radgeom_struct *radgeom_cache = NULL;
+static pthread_mutex_t radgeom_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* calc_radgeom() fills in the daily radiation geometry of the site given by
+   geom's key (lat, slp, asp, ehoriz, whoriz).  The hour angle is stepped
+   from -hss by SRADDT seconds exactly as in the original MTCLIM loop.  The
+   transmittance of each step, pow(trans1,am), is the only term that
+   depends on the cell; it is stored as the potential radiation received
+   at each tabulated optical air mass, plus, for the steps with am <= 2.9,
+   the moments trans_mom[k] = sum(dir_flat_topa * am^k / k!), from which
+   the sum of pow(trans1,am)*dir_flat_topa is recovered as the series
+   sum(trans_mom[k] * log(trans1)^k).  With am <= 2.9 the series is
+   converged to round-off for any trans1 above 0.7 (trans1 = TBASE^pratio
+   is 0.87 at standard pressure). */
+static void calc_radgeom(radgeom_struct *geom)
+{
+  int i,j,k;
+  int ami,tinystep,tinystepspday;
+  double lat,coslat,sinlat;
+  double cosslp,sinslp,cosasp,sinasp;
+  double bsg1,bsg2,bsg3;
+  double decl,cosdecl,sindecl,cosegeom,sinegeom,coshss,hss;
+  double coszeh,coszwh;
+  double sc,dt,dh,h,cosh,sinh,cza,cbsa,am,term;
+  double dir_beam_topa,dir_flat_topa;
+  double sum_flat_potrad,sum_slope_potrad;
+  double mom[N_TRANS_MOM];
+
+  /* precalculate the transcendentals */
+  lat = geom->lat;
+  /* check for (+/-) 90 degrees latitude, throws off daylength calc */
+  lat *= RADPERDEG;
+  if (lat > 1.5707) 
+    lat = 1.5707;
+  if (lat < -1.5707) 
+    lat = -1.5707;
+  coslat = cos(lat);
+  sinlat = sin(lat);
+  cosslp = cos(geom->slp * RADPERDEG);
+  sinslp = sin(geom->slp * RADPERDEG);
+  cosasp = cos(geom->asp * RADPERDEG);
+  sinasp = sin(geom->asp * RADPERDEG);
+  /* cosine of zenith angle for east and west horizons */
+  coszeh = cos(1.570796 - (geom->ehoriz * RADPERDEG));
+  coszwh = cos(1.570796 - (geom->whoriz * RADPERDEG));
+
+  /* sub-daily time and angular increment information */
+  dt = SRADDT;                /* set timestep */ 
+  dh = dt / SECPERRAD;        /* calculate hour-angle step */
+  tinystepspday = 86400/SRADDT;
+
+  for (i=0 ; i<365 ; i++) {
+    /* calculate cos and sin of declination */
+    decl = MINDECL * cos(((double)i + DAYSOFF) * RADPERDAY);
+    cosdecl = cos(decl);
+    sindecl = sin(decl);
+    
+    /* do some precalculations for beam-slope geometry (bsg) */
+    bsg1 = -sinslp * sinasp * cosdecl;
+    bsg2 = (-cosasp * sinslp * sinlat + cosslp * coslat) * cosdecl;
+    bsg3 = (cosasp * sinslp * coslat + cosslp * sinlat) * sindecl;
+    
+    /* calculate daylength as a function of lat and decl */
+    cosegeom = coslat * cosdecl;
+    sinegeom = sinlat * sindecl;
+    coshss = -(sinegeom) / cosegeom;
+    if (coshss < -1.0) 
+      coshss = -1.0;  /* 24-hr daylight */
+    if (coshss > 1.0) 
+      coshss = 1.0;    /* 0-hr daylight */
+    hss = acos(coshss);                /* hour angle at sunset (radians) */
+    geom->cosegeom[i] = cosegeom;
+    geom->sinegeom[i] = sinegeom;
+    /* daylength (seconds) */
+    geom->daylength[i] = 2.0 * hss * SECPERRAD;
+    if (geom->daylength[i] > 86400)
+      geom->daylength[i] = 86400;
+    
+    /* solar constant as a function of yearday (W/m^2) */
+    sc = 1368.0 + 45.5*sin((2.0*PI*(double)i/365.25) + 1.7);
+    /* extraterrestrial radiation perpendicular to beam, total over
+       the timestep (J) */
+    dir_beam_topa = sc * dt;
+
+    sum_flat_potrad = 0.0;
+    sum_slope_potrad = 0.0;
+    for (j=0 ; j<N_OPTAM ; j++)
+      geom->optam_wt[i][j] = 0.0;
+    for (k=0 ; k<N_TRANS_MOM ; k++)
+      mom[k] = 0.0;
+    geom->h_first[i] = 0.0;
+    geom->s_first[i] = 0;
+    geom->n_steps[i] = 0;
+    geom->cza_sum[i] = 0.0;
+
+    /* sub-daily hour-angle loop, from -hss to hss */
+    for (h=-hss ; h<hss ; h+=dh) {
+      cosh = cos(h);
+      cza = cosegeom * cosh + sinegeom;
+      
+      /* check if sun is above a flat horizon */
+      if (cza > 0.0) {
+	/* potential radiation for this time period, flat surface,
+	   top of atmosphere */
+	dir_flat_topa = dir_beam_topa * cza;
+
+	/* file it under its optical air mass */
+	am = 1.0/(cza + 0.0000001);
+	if (am > 2.9) {
+	  ami = (int)(acos(cza)/RADPERDEG) - 69;
+	  if (ami < 0) 
+	    ami = 0;
+	  if (ami > 20) 
+	    ami = 20;
+	  geom->optam_wt[i][ami] += dir_flat_topa;
+	}
+	else {
+	  term = dir_flat_topa;
+	  for (k=0 ; k<N_TRANS_MOM ; k++) {
+	    mom[k] += term;
+	    term *= am;
+	  }
+	}
+
+	sum_flat_potrad += dir_flat_topa;
+
+	/* sun between east and west horizons, and direct on slope
+	   (sin(h) is not needed on slopes facing due north or south) */
+	if ((h<0.0 && cza>coszeh) || (h>=0.0 && cza>coszwh)) {
+	  sinh = (bsg1 != 0.0) ? sin(h) * bsg1 : 0.0;
+	  cbsa = sinh + cosh * bsg2 + bsg3;
+	  if (cbsa > 0.0)
+	    sum_slope_potrad += dir_beam_topa * cbsa;
+	}
+
+	/* SRADDT slot of the day this step falls in.  The sunlit steps
+	   fall in consecutive slots, except that with 24-hr daylight the
+	   first two both fall in slot 0, where the second one replaced
+	   the first in tiny_radfract.  radfract() needs only the first
+	   step that kept its slot, and the number of steps. */
+	tinystep = (12L * 3600L + h * SECPERRAD)/SRADDT;
+	if (tinystep < 0)
+	  tinystep = 0;
+	if (tinystep > tinystepspday-1)
+	  tinystep = tinystepspday-1;
+	if (geom->n_steps[i] == 0 || tinystep == geom->s_first[i]) {
+	  geom->h_first[i] = h;
+	  geom->s_first[i] = tinystep;
+	  geom->n_steps[i] = 1;
+	}
+	else
+	  geom->n_steps[i]++;
+	geom->cza_sum[i] += cza;
+      }
+    } /* end of sub-daily hour-angle loop */
+
+    if (geom->daylength[i] && sum_flat_potrad > 0.0) {
+      /* daylight average flux density for a flat surface and the slope */
+      geom->flat_potrad[i] = sum_flat_potrad / geom->daylength[i];
+      geom->slope_potrad[i] = sum_slope_potrad / geom->daylength[i];
+      /* transmittance weights, as fractions of the flat potential
+	 radiation */
+      for (j=0 ; j<N_OPTAM ; j++)
+	geom->optam_wt[i][j] /= sum_flat_potrad;
+      term = 1.0 / sum_flat_potrad;
+      for (k=0 ; k<N_TRANS_MOM ; k++) {
+	geom->trans_mom[i][k] = mom[k] * term;
+	term /= (double)(k+1);
+      }
+    }
+    else {
+      geom->flat_potrad[i] = 0.0;
+      geom->slope_potrad[i] = 0.0;
+      for (j=0 ; j<N_OPTAM ; j++)
+	geom->optam_wt[i][j] = 0.0;
+      for (k=0 ; k<N_TRANS_MOM ; k++)
+	geom->trans_mom[i][k] = 0.0;
+    }
+  }
+
+  /* force yearday 366 = yearday 365 */
+  geom->cosegeom[365] = geom->cosegeom[364];
+  geom->sinegeom[365] = geom->sinegeom[364];
+  geom->daylength[365] = geom->daylength[364];
+  geom->h_first[365] = geom->h_first[364];
+  geom->s_first[365] = geom->s_first[364];
+  geom->n_steps[365] = geom->n_steps[364];
+  geom->cza_sum[365] = geom->cza_sum[364];
+  geom->flat_potrad[365] = geom->flat_potrad[364];
+  geom->slope_potrad[365] = geom->slope_potrad[364];
+  for (j=0 ; j<N_OPTAM ; j++)
+    geom->optam_wt[365][j] = geom->optam_wt[364][j];
+  for (k=0 ; k<N_TRANS_MOM ; k++)
+    geom->trans_mom[365][k] = geom->trans_mom[364][k];
+}
+
+/* get_radgeom() returns the daily radiation geometry of the site described
+   by p, computing it if no earlier cell had the same latitude, slope,
+   aspect and horizons.  The tables are shared by all threads and kept
+   until free_radgeom_cache(). */
+const radgeom_struct *get_radgeom(const parameter_struct *p)
+{
+  radgeom_struct *geom;
+
+  pthread_mutex_lock(&radgeom_lock);
+  for (geom = radgeom_cache ; geom != NULL ; geom = geom->next) {
+    if (geom->lat == p->site_lat && geom->slp == p->site_slp
+	&& geom->asp == p->site_asp && geom->ehoriz == p->site_ehoriz
+	&& geom->whoriz == p->site_whoriz)
+      break;
+  }
+  if (geom == NULL) {
+    if (!(geom = (radgeom_struct *) malloc(sizeof(radgeom_struct))))
+      nrerror("Memory allocation error in get_radgeom().");
+    geom->lat = p->site_lat;
+    geom->slp = p->site_slp;
+    geom->asp = p->site_asp;
+    geom->ehoriz = p->site_ehoriz;
+    geom->whoriz = p->site_whoriz;
+    calc_radgeom(geom);
+    geom->next = radgeom_cache;
+    radgeom_cache = geom;
+  }
+  pthread_mutex_unlock(&radgeom_lock);
+
+  return (geom);
+}
+
+/* free_radgeom_cache() frees all tables returned by get_radgeom() */
+void free_radgeom_cache()
+{
+  radgeom_struct *next;
+
+  pthread_mutex_lock(&radgeom_lock);
+  while (radgeom_cache != NULL) {
+    next = radgeom_cache->next;
+    free(radgeom_cache);
+    radgeom_cache = next;
+  }
+  pthread_mutex_unlock(&radgeom_lock);
+}
+
+/* step_sum() returns the sum of the cosine of the solar zenith angle of
+   day yday over the SRADDT slots s1 to s2-1 (0 <= s1 <= s2 <= 86400/SRADDT)
+   that hold a step with the sun above the flat horizon.  The sunlit steps
+   are consecutive in hour angle and in slot, so the sum is taken in
+   closed form. */
+static double step_sum(const radgeom_struct *geom, int yday, int s1, int s2)
+{
+  double dh;
+  int m1, m2;
+
+  /* steps m1 to m2-1, counted from the first sunlit step */
+  m1 = s1 - geom->s_first[yday];
+  m2 = s2 - geom->s_first[yday];
+  if (m1 < 0) m1 = 0;
+  if (m2 > geom->n_steps[yday]) m2 = geom->n_steps[yday];
+  if (m2 <= m1)
+    return (0.0);
+  dh = SRADDT / SECPERRAD;
+  return (geom->cosegeom[yday] * sin(0.5 * (m2-m1) * dh) / sin(0.5 * dh)
+	  * cos(geom->h_first[yday] + 0.5 * (m1+m2-1) * dh)
+	  + geom->sinegeom[yday] * (m2-m1));
+}
+
+/* radfract() returns the fraction of the daily flat-surface potential
+   radiation of day yday (0-365) received in the SRADDT slots from t1 to
+   t2 seconds after local solar midnight (t1 and t2 multiples of SRADDT,
+   0 <= t2-t1 <= 86400; times outside 0-86400 wrap around to the same
+   day).  This is the sum over the same slots of the original
+   tiny_radfract array, which was normalized by the sum over all sunlit
+   steps. */
+double radfract(const radgeom_struct *geom, int yday, double t1, double t2)
+{
+  int s1, s2, nslots;
+  double day, sum;
+
+  nslots = 86400/SRADDT;
+  day = geom->cza_sum[yday];
+  if (day <= 0.0)
+    return (0.0);
+
+  s1 = (int)floor(t1 / SRADDT + 0.5);
+  s2 = (int)floor(t2 / SRADDT + 0.5);
+  while (s1 < 0) {
+    s1 += nslots;
+    s2 += nslots;
+  }
+  while (s1 >= nslots) {
+    s1 -= nslots;
+    s2 -= nslots;
+  }
+  if (s2 <= nslots)
+    sum = step_sum(geom, yday, s1, s2);
+  else
+    sum = step_sum(geom, yday, s1, nslots)
+      + step_sum(geom, yday, 0, s2 - nslots);
+  if (sum < 0.0)
+    sum = 0.0;
+
+  return (sum / day);
+}
+
 /* data_free frees the memory previously allocated by data_alloc() */
 int data_free(const control_struct *ctrl, data_struct *data)
 {
@@ -31,6 +31,10 @@
   2013-Jul-19 Fixed bug in shortwave computation for case when daily shortwave
 	      is supplied by the user.					HFC via TJB
   2013-Jul-25 Added data->s_fdir.					TJB
+  2015-Feb-02 Replaced the tiny_radfract array (366 x 86400 doubles per
+	      cell) with the cached radiation geometry of get_radgeom().
+	      The diurnal cycle of shortwave is now summed over the same
+	      SRADDT steps in closed form by radfract().		GT
 
 *******************************************************************************/
 /******************************************************************************/
@@ -57,12 +61,12 @@ void mtclim_init(int have_dewpt, int have_shortwave, double elevation, double sl
                    double ehoriz, double whoriz, double annual_prcp, 
 		   double lat, int Ndays, dmy_struct *dmy, 
 		   double *prec, double *tmax, double *tmin, double *vp, double *hourlyrad, 
-		   double **tiny_radfract, control_struct *ctrl, 
+		   control_struct *ctrl, 
 		   parameter_struct *p, data_struct *mtclim_data); 
 
 void mtclim_to_vic(double hour_offset, 
 		     int Ndays, dmy_struct *dmy, 
-		     double **tiny_radfract, control_struct *ctrl, 
+		     const radgeom_struct *geom, control_struct *ctrl, 
 		     data_struct *mtclim_data, double *tskc, double *vp, 
 		     double *hourlyrad, double *fdir);
 
@@ -78,32 +82,25 @@ void mtclim_wrapper(int have_dewpt, int have_shortwave, double hour_offset,
 
   Modifications:
   2012-Feb-16 Cleaned up commented code.					TJB
+  2015-Feb-02 Gets the site's radiation geometry from get_radgeom()
+	      instead of allocating tiny_radfract.			GT
 ******************************************************************************/
 {
   control_struct ctrl;
   parameter_struct p;
   data_struct mtclim_data;
-  double **tiny_radfract;
-  int i;
-
-  /* allocate space for the tiny_radfract array */
-  tiny_radfract = (double **) calloc(366, sizeof(double*));
-  if (tiny_radfract == NULL) {
-    nrerror("Memory allocation error in mtclim_init() ...\n");
-  }
-  for (i=0; i<366; i++) {
-    tiny_radfract[i] = (double *) calloc(86400, sizeof(double));
-    if (tiny_radfract[i] == NULL) {
-      nrerror("Memory allocation error in mtclim_init() ...\n");
-    }
-  }
+  const radgeom_struct *geom;
 
   /* initialize the mtclim data structures */ 
   mtclim_init(have_dewpt, have_shortwave, elevation, slope, aspect, ehoriz, whoriz,
                 annual_prcp, lat, Ndays, dmy, prec,
-		tmax, tmin, vp, hourlyrad, tiny_radfract, &ctrl, &p,
+		tmax, tmin, vp, hourlyrad, &ctrl, &p,
 		&mtclim_data);  
 
+  /* daily radiation geometry (shared by all cells with the same latitude,
+     slope, aspect and horizons) */
+  geom = get_radgeom(&p);
+
   /* calculate daily air temperatures */
   if (calc_tair(&ctrl, &p, &mtclim_data)) {
     nrerror("Error in calc_tair()... exiting\n");
@@ -120,34 +117,29 @@ void mtclim_wrapper(int have_dewpt, int have_shortwave, double hour_offset,
   }
   
   /* calculate srad and humidity with iterative algorithm */
-  if (calc_srad_humidity_iterative(&ctrl, &p, &mtclim_data, tiny_radfract)) { 
+  if (calc_srad_humidity_iterative(&ctrl, &p, &mtclim_data, geom)) { 
     nrerror("Error in calc_srad_humidity_iterative()... exiting\n");
   }
 
   /* translate the mtclim structures back to the VIC data structures */
   mtclim_to_vic(hour_offset, Ndays,
-		  dmy, tiny_radfract, &ctrl,&mtclim_data, tskc, vp,
+		  dmy, geom, &ctrl,&mtclim_data, tskc, vp,
 		  hourlyrad, fdir);
 
   /* clean up */
   if (data_free(&ctrl, &mtclim_data)) {
     nrerror("Error in data_free()... exiting\n");
   }
-  for (i=0; i<366; i++) {
-    free(tiny_radfract[i]);
-  }
-  free(tiny_radfract);
 }
   
 void mtclim_init(int have_dewpt, int have_shortwave, double elevation, double slope, double aspect,
                    double ehoriz, double whoriz, double annual_prcp, 
 		   double lat, int Ndays, dmy_struct *dmy, 
 		   double *prec, double *tmax, double *tmin, double *vp, double *hourlyrad, 
-		   double **tiny_radfract, control_struct *ctrl, 
+		   control_struct *ctrl, 
 		   parameter_struct *p, data_struct *mtclim_data)
 {
   int i,j;
-  int tinystepspday;
 
   /* initialize the control structure */
 
@@ -208,17 +200,11 @@ void mtclim_init(int have_dewpt, int have_shortwave, double elevation, double sl
     if (have_dewpt==1)
       nrerror("have_dewpt not yet implemented ...\n");
   }
-  tinystepspday = 86400/SRADDT;
-  for (i = 0; i < 366; i++) {
-    for (j = 0; j < tinystepspday; j++) {
-      tiny_radfract[i][j] = 0;
-    }
-  }
 }
 
 void mtclim_to_vic(double hour_offset, 
 		     int Ndays, dmy_struct *dmy, 
-		     double **tiny_radfract, control_struct *ctrl, 
+		     const radgeom_struct *geom, control_struct *ctrl, 
 		     data_struct *mtclim_data, double *tskc, double *vp, 
 		     double *hourlyrad, double *fdir)
 /******************************************************************************
@@ -227,24 +213,28 @@ void mtclim_to_vic(double hour_offset,
   Modifications:
   2012-Feb-16 Removed check on mtclim_data->insw for storing tinyradfract data
 	      in hourlyrad array.						TJB
+  2015-Feb-02 The fraction of the daily shortwave in each hour is computed
+	      by radfract() instead of summed from tiny_radfract.	GT
 ******************************************************************************/
 {
-  int i,j,k;
+  int i,j;
   int tinystepsphour;
-  int tinystep;
   int tiny_offset;
+  double t_start;
   double tmp_rad;
   
+  /* the hour offset is truncated to whole SRADDT steps, as it was for
+     tiny_radfract */
   tinystepsphour = 3600/SRADDT;
-
   tiny_offset = (int)((float)tinystepsphour * hour_offset);
+
   for (i = 0; i < ctrl->ndays; i++) {
     // s_srad = avg SW flux (W/m2) over daylight hours
     // s_dayl = number of seconds of daylight in current day
     // total_daily_sw = s_srad*s_dayl  (J/m2)
-    // tiny_radfrac = fraction of total daily sw falling in each SRADDT interval
-    // hourlyrad = SW flux (W/m2) over each hour = total_daily_sw * sum_over_hour(tiny_radfract) / 3600
-    //                                           = tmp_rad * sum_over_hour(tiny_radfract)
+    // radfract = fraction of total daily sw falling in an hour
+    // hourlyrad = SW flux (W/m2) over each hour = total_daily_sw * radfract / 3600
+    //                                           = tmp_rad * radfract
 
     //if radiation read from input file, assume it's a 24 hours average, 
     //else (i.e., MTCLIM calculated), assume it's a daylight period average
@@ -255,18 +245,10 @@ void mtclim_to_vic(double hour_offset,
       tmp_rad = mtclim_data->s_srad[i] * mtclim_data->s_dayl[i] / 3600.;
     }    
     for (j = 0; j < 24; j++) {
-      hourlyrad[i*24+j] = 0;
-      for (k = 0; k < tinystepsphour; k++) {
-        tinystep = j*tinystepsphour + k - tiny_offset;
-        if (tinystep < 0) {
-          tinystep += 24*tinystepsphour; 
-        }
-        if (tinystep > 24*tinystepsphour-1) {
-          tinystep -= 24*tinystepsphour; 
-        }
-        hourlyrad[i*24+j] += tiny_radfract[dmy[i*24+j].day_in_year-1][tinystep];
-      }
-      hourlyrad[i*24+j] *= tmp_rad;
+      // local solar time (s) at the start of the hour
+      t_start = (j * tinystepsphour - tiny_offset) * SRADDT;
+      hourlyrad[i*24+j] = tmp_rad * radfract(geom, dmy[i*24+j].day_in_year-1,
+                                             t_start, t_start + 3600.);
     }
   }
   
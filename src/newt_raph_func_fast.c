@@ -26,12 +26,24 @@ int newt_raph(void (*vecfunc)(double x[], double fvec[], int n, int init, ...),
  to converge during the initial formation of ice, where the shape 
  of the residual function becomes very difficult 
 
+ vecfunc(x, fvec, n, 0, -1) must return the residuals fvec at x.  The
+ Jacobian is approximated by finite differences in fdjac3, or with
+ IMPLICIT_JACOBIAN = ANALYTIC taken from vecfunc(x, fvec, n, 2, a, b, c),
+ which must return the sub-diagonal a, diagonal b and super-diagonal c
+ of the Jacobian at the x of the last residual call
+
   Modifications:
   2012-Jan-28 Replaced local precompile variable MAXSIZE with VIC's
 	      MAX_NODES so that array lengths here are always in sync
 	      with array lengths in the rest of VIC.			TJB 
+  2015-Feb-02 Added options.IMPLICIT_JACOBIAN.  With ANALYTIC the
+	      Jacobian is provided by vecfunc (called with init==2 and
+	      the diagonals a, b, c) instead of by fdjac3, which saves
+	      n residual evaluations per trial.			GT
 ******************************************************************/
 
+  extern option_struct options;
+
   int k, i, index[MAX_NODES], Error;
   double errx, errf, d, fvec[MAX_NODES], fjac[MAX_NODES*MAX_NODES], p[MAX_NODES];
   double a[MAX_NODES], b[MAX_NODES], c[MAX_NODES];
@@ -52,7 +64,10 @@ int newt_raph(void (*vecfunc)(double x[], double fvec[], int n, int init, ...),
     }
     
     // calculate the Jacobian
-    fdjac3(x, fvec, a, b, c, vecfunc, n);
+    if (options.IMPLICIT_JACOBIAN == JACOBIAN_ANALYTIC)
+      (*vecfunc)(x, fvec, n, 2, a, b, c);
+    else
+      fdjac3(x, fvec, a, b, c, vecfunc, n);
 
     for (i=0; i<n; i++) p[i]=-fvec[i];
 
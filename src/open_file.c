@@ -1,10 +1,14 @@
+#define _GNU_SOURCE /* for fopencookie() */
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <zlib.h>
 #include <vicNl.h>
 
 static char vcid[] = "$Id$";
 
+static FILE *open_gz_file(char *, char *);
+
 FILE *open_file(char string[],char type[])
 
 /******************************************************************/
@@ -29,13 +33,15 @@ FILE *open_file(char string[],char type[])
 /******************************************************************/
 /* 30-Oct-03 Added message announcing the opening of files when type
 	     is "rb".						TJB
+   2015-Feb-02 Compressed files (name.gz) are now decompressed in
+	     process, as they are read, instead of with "gzip -d";
+	     the .gz file is left untouched.  Only done for reading.	GT
  ******************************************************************/
 
 {
 
   FILE *stream;
   char zipname[MAXSTRING],
-       command[MAXSTRING],
        jnkstr[MAXSTRING];
   int  temp, headcnt, i;
 
@@ -50,22 +56,15 @@ FILE *open_file(char string[],char type[])
     /** Check if file is compressed **/
     strcpy(zipname,string);
     strcat(zipname,".gz");
-    stream = fopen(zipname,type);
-    if (stream == NULL) {
-      fprintf(stderr,"\n Error opening \"%s\".",string);
-      fprintf(stderr,"\n");
-      nrerror("Unable to open File");
-    }
-    fclose(stream);
+    if (strcmp(type,"r") == 0 || strcmp(type,"rb") == 0) {
 
-    /** uncompress and open zipped file **/
+      /** open zipped file, uncompressing it as it is read **/
 #if VERBOSE
-    fprintf(stderr,"unzipping \"%s\".",string);
+      fprintf(stderr,"unzipping \"%s\".",zipname);
 #endif
+      stream = open_gz_file(zipname,type);
 
-    sprintf(command,"gzip -d %s",zipname);
-    system(command);
-    stream = fopen(string,type);
+    }
     if (stream == NULL) {
       fprintf(stderr,"\n Error opening \"%s\".",string);
       fprintf(stderr,"\n");
@@ -134,3 +133,71 @@ FILE *open_file(char string[],char type[])
 
   return stream;
 }
+
+static ssize_t gz_read(void *cookie, char *buf, size_t size)
+{
+  int n;
+
+  n = gzread((gzFile)cookie, buf, (unsigned)size);
+  return (n < 0) ? -1 : n;
+}
+
+static int gz_seek(void *cookie, off64_t *offset, int whence)
+{
+  z_off_t pos;
+
+  pos = gzseek((gzFile)cookie, (z_off_t)*offset, whence);
+  if (pos < 0) return -1;
+  *offset = pos;
+  return 0;
+}
+
+static int gz_close(void *cookie)
+{
+  return (gzclose((gzFile)cookie) == Z_OK) ? 0 : EOF;
+}
+
+static FILE *open_gz_file(char *zipname, char *type)
+/******************************************************************
+  open_gz_file
+
+  Opens the gzip-compressed file zipname for reading, and returns a
+  stream from which the uncompressed contents are read.  Returns NULL
+  if the file cannot be opened.
+
+  With the GNU C library, the stream decompresses the file as it is
+  read (seeking is supported, as gzseek() supports it).  Elsewhere,
+  the file is decompressed into an anonymous temporary file.
+ ******************************************************************/
+{
+  gzFile  gz;
+  FILE   *stream;
+#ifdef __GLIBC__
+  cookie_io_functions_t gz_funcs = { gz_read, NULL, gz_seek, gz_close };
+#else
+  char    buf[BUFSIZ];
+  int     n;
+#endif
+
+  gz = gzopen(zipname, "rb");
+  if (gz == NULL) return NULL;
+
+#ifdef __GLIBC__
+  stream = fopencookie(gz, type, gz_funcs);
+  if (stream == NULL) gzclose(gz);
+#else
+  stream = tmpfile();
+  if (stream != NULL) {
+    while ((n = gzread(gz, buf, BUFSIZ)) > 0)
+      fwrite(buf, 1, n, stream);
+    if (n < 0) {
+      fclose(stream);
+      stream = NULL;
+    }
+    else rewind(stream);
+  }
+  gzclose(gz);
+#endif
+
+  return stream;
+}
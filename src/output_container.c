@@ -0,0 +1,396 @@
+/*
+ * Purpose: output containers - the output of all cells of a run in one
+ *          file per output file prefix
+ * Usage  : Part of VIC
+ * Created: 2015-Feb-02
+ * Notes  : When OUTPUT_CONTAINER is TRUE, the records of each output file
+ *          prefix are written to RESULT_DIR/<prefix>.vicout (or
+ *          <prefix>.shard<k>of<N>.vicout when the run is sharded) instead
+ *          of one RESULT_DIR/<prefix>_<lat>_<lng> file per cell.  Each
+ *          full output buffer (see write_data()) is written as one chunk
+ *          of whole records of one cell; a cell's chunks are linked in
+ *          time order.  The container is laid out as follows (all values
+ *          in the byte order of the machine that wrote it):
+ *
+ *            container_header_struct   at offset 0
+ *            header_len bytes          the header that PRT_HEADER writes
+ *                                      at the start of every per-cell file
+ *                                      (it is the same for all cells)
+ *            chunks                    each a container_chunk_struct
+ *                                      followed by nbytes of records, in
+ *                                      the format of the per-cell files
+ *            index                     ncells container_cell_struct
+ *                                      entries, at index_offset
+ *
+ *          Index entry i is the i-th active cell of this shard, in soil
+ *          file order.  Chunks are appended by whichever thread fills
+ *          them, so with NTHREADS > 1 the chunks of different cells are
+ *          interleaved; their offsets are reserved under the container's
+ *          lock, and they are written with pwrite().  The index and the
+ *          final header are written by close_output_containers().  The
+ *          extract_cells tool (tools/post_processing/output_container)
+ *          rebuilds the per-cell files from a container.
+ */
+
+/****************************************************************************/
+/*			  PREPROCESSOR DIRECTIVES                           */
+/****************************************************************************/
+
+#define _FILE_OFFSET_BITS 64 /* for containers larger than 2 GB */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <vicNl.h>
+
+static char vcid[] = "$Id$";
+
+#define CONTAINER_MAGIC   "VICCELLS"
+#define CONTAINER_VERSION 1
+
+typedef struct {
+  char       magic[8];     /* CONTAINER_MAGIC (not null-terminated) */
+  char       prefix[24];   /* output file prefix, e.g. "fluxes" */
+  int        version;      /* CONTAINER_VERSION */
+  int        binary;       /* 1 = BINARY_OUTPUT records; 0 = ASCII */
+  int        out_dt;       /* output time step [hours]; if negative,
+                              minus the number of calendar months */
+  int        grid_decimal; /* GRID_DECIMAL, for the per-cell file names */
+  int        header_len;   /* bytes of per-cell file header that follow
+                              this header */
+  int        ncells;       /* number of index entries */
+  long long  index_offset; /* offset of the index */
+} container_header_struct;
+
+typedef struct {
+  int        cell;         /* index entry of the cell */
+  int        first;        /* cell's record number of the first record */
+  int        nrecs;        /* number of records in the chunk */
+  int        nbytes;       /* number of bytes of records in the chunk */
+  long long  next;         /* offset of the cell's next chunk; 0 if none */
+} container_chunk_struct;
+
+typedef struct {
+  int        gridcel;      /* grid cell number */
+  int        nrecs;        /* number of records written; -1 if the cell
+                              was not run */
+  float      lat;          /* latitude */
+  float      lng;          /* longitude */
+  long long  offset;       /* offset of the cell's first chunk; 0 if none */
+} container_cell_struct;
+
+struct out_container {
+  char                    filename[MAXSTRING];
+  FILE                   *fh;
+  int                     fd;
+  container_header_struct header;
+  long long               end;      /* offset of the end of the container */
+  int                     maxcells; /* allocated size of cells */
+  container_cell_struct  *cells;
+  pthread_mutex_t         lock;
+};
+
+static struct out_container *containers = NULL;
+static int                   ncontainers = 0;
+
+static void write_at(struct out_container *, const void *, size_t, long long);
+
+/****************************************************************************/
+/*			    open_output_containers()                        */
+/****************************************************************************/
+void open_output_containers(out_data_file_struct *out_data_files,
+                            out_data_struct      *out_data,
+                            dmy_struct           *dmy,
+                            global_param_struct  *global,
+                            filenames_struct     *filenames)
+/*******************************************************************
+  open_output_containers
+
+  Creates one container per output file, writes the per-cell file
+  header (if PRT_HEADER is TRUE) into each, and points the output
+  files at their containers.  Must be called before any copies of
+  out_data_files are made.
+*******************************************************************/
+{
+  extern option_struct options;
+  struct out_container *c;
+  int                   filenum;
+
+  ncontainers = options.Noutfiles;
+  containers = (struct out_container *)calloc(ncontainers, sizeof(struct out_container));
+  if (containers == NULL)
+    nrerror("Memory allocation error in open_output_containers().");
+
+  for (filenum=0; filenum<ncontainers; filenum++) {
+    c = &containers[filenum];
+    strcpy(c->filename, filenames->result_dir);
+    strcat(c->filename, "/");
+    strcat(c->filename, out_data_files[filenum].prefix);
+    if (options.NSHARDS > 1)
+      sprintf(c->filename+strlen(c->filename), ".shard%dof%d",
+              options.SHARD, options.NSHARDS);
+    strcat(c->filename, ".vicout");
+    c->fh = open_file(c->filename, "wb");
+    c->fd = fileno(c->fh);
+
+    memcpy(c->header.magic, CONTAINER_MAGIC, sizeof(c->header.magic));
+    strncpy(c->header.prefix, out_data_files[filenum].prefix,
+            sizeof(c->header.prefix)-1);
+    c->header.version      = CONTAINER_VERSION;
+    c->header.binary       = options.BINARY_OUTPUT ? 1 : 0;
+    c->header.out_dt       = out_data_files[filenum].out_dt;
+    c->header.grid_decimal = options.GRID_DECIMAL;
+    c->header.header_len   = 0;
+    c->header.ncells       = 0;
+    c->header.index_offset = 0;
+    if (fwrite(&c->header, sizeof(container_header_struct), 1, c->fh) != 1)
+      nrerror("Unable to write to an output container in open_output_containers().");
+
+    c->maxcells = 0;
+    c->cells    = NULL;
+    pthread_mutex_init(&c->lock, NULL);
+
+    out_data_files[filenum].fh = c->fh;
+  }
+
+  /** The per-cell file header is the same for all cells **/
+  if (options.PRT_HEADER)
+    write_header(out_data_files, out_data, dmy, *global);
+
+  for (filenum=0; filenum<ncontainers; filenum++) {
+    c = &containers[filenum];
+    fflush(c->fh);
+    c->end = ftello(c->fh);
+    c->header.header_len = (int)(c->end - sizeof(container_header_struct));
+    out_data_files[filenum].fh        = NULL;
+    out_data_files[filenum].container = c;
+  }
+
+}
+
+/****************************************************************************/
+/*			     start_container_cell()                         */
+/****************************************************************************/
+void start_container_cell(out_data_file_struct *out_data_file,
+                          int                   cellnum,
+                          soil_con_struct      *soil_con)
+/*******************************************************************
+  start_container_cell
+
+  Adds a cell to an output file's container.  cellnum is the cell's
+  index among all active cells; its index entry is its index among
+  the active cells of this shard.
+*******************************************************************/
+{
+  extern option_struct options;
+  struct out_container *c = out_data_file->container;
+  int                   cell;
+  int                   i;
+
+  cell = cellnum / options.NSHARDS;
+
+  pthread_mutex_lock(&c->lock);
+  if (cell >= c->maxcells) {
+    i = c->maxcells;
+    c->maxcells = (c->maxcells > 0) ? 2*c->maxcells : 1024;
+    if (c->maxcells <= cell)
+      c->maxcells = cell + 1;
+    c->cells = (container_cell_struct *)realloc(c->cells, c->maxcells*sizeof(container_cell_struct));
+    if (c->cells == NULL)
+      nrerror("Memory allocation error in start_container_cell().");
+    for ( ; i<c->maxcells; i++) {
+      c->cells[i].gridcel = 0;
+      c->cells[i].nrecs   = -1;
+      c->cells[i].lat     = 0;
+      c->cells[i].lng     = 0;
+      c->cells[i].offset  = 0;
+    }
+  }
+  if (cell >= c->header.ncells)
+    c->header.ncells = cell + 1;
+  c->cells[cell].gridcel = soil_con->gridcel;
+  c->cells[cell].nrecs   = 0;
+  c->cells[cell].lat     = soil_con->lat;
+  c->cells[cell].lng     = soil_con->lng;
+  c->cells[cell].offset  = 0;
+  pthread_mutex_unlock(&c->lock);
+
+  out_data_file->cell       = cell;
+  out_data_file->nrecs      = 0;
+  out_data_file->last_chunk = 0;
+
+}
+
+/****************************************************************************/
+/*			     write_container_chunk()                        */
+/****************************************************************************/
+void write_container_chunk(out_data_file_struct *out_data_file)
+/*******************************************************************
+  write_container_chunk
+
+  Appends the records in an output file's buffer to its container as
+  one chunk of the current cell, and links the chunk to the cell's
+  previous chunk.
+*******************************************************************/
+{
+  struct out_container  *c = out_data_file->container;
+  container_chunk_struct chunk;
+  long long              offset;
+
+  chunk.cell   = out_data_file->cell;
+  chunk.first  = out_data_file->nrecs;
+  chunk.nrecs  = out_data_file->bufrecs;
+  chunk.nbytes = (int)out_data_file->buflen;
+  chunk.next   = 0;
+
+  pthread_mutex_lock(&c->lock);
+  if (c->fh == NULL) {
+    /* Already closed; the run is being stopped by vicerror() */
+    pthread_mutex_unlock(&c->lock);
+    return;
+  }
+  offset = c->end;
+  c->end += sizeof(container_chunk_struct) + out_data_file->buflen;
+  if (out_data_file->last_chunk == 0)
+    c->cells[out_data_file->cell].offset = offset;
+  pthread_mutex_unlock(&c->lock);
+
+  write_at(c, &chunk, sizeof(container_chunk_struct), offset);
+  write_at(c, out_data_file->buf, out_data_file->buflen,
+           offset + sizeof(container_chunk_struct));
+  if (out_data_file->last_chunk != 0)
+    write_at(c, &offset, sizeof(long long),
+             out_data_file->last_chunk + offsetof(container_chunk_struct, next));
+
+  out_data_file->last_chunk = offset;
+  out_data_file->nrecs += out_data_file->bufrecs;
+
+}
+
+/****************************************************************************/
+/*			     finish_container_cell()                        */
+/****************************************************************************/
+void finish_container_cell(out_data_file_struct *out_data_file)
+/*******************************************************************
+  finish_container_cell
+
+  Records the number of records written for the current cell in its
+  index entry.  The output file's buffer must have been flushed.
+*******************************************************************/
+{
+  struct out_container *c = out_data_file->container;
+
+  pthread_mutex_lock(&c->lock);
+  c->cells[out_data_file->cell].nrecs = out_data_file->nrecs;
+  pthread_mutex_unlock(&c->lock);
+
+}
+
+/****************************************************************************/
+/*			     discard_container_cell()                       */
+/****************************************************************************/
+void discard_container_cell(out_data_file_struct *out_data_file)
+/*******************************************************************
+  discard_container_cell
+
+  Marks the current cell of an output file as not run, as if it had
+  never been started (used for cells after a failed cell; see
+  cell_threads.c).  Its chunks stay in the container but are no
+  longer referenced by the index.
+*******************************************************************/
+{
+  struct out_container *c = out_data_file->container;
+
+  pthread_mutex_lock(&c->lock);
+  c->cells[out_data_file->cell].gridcel = 0;
+  c->cells[out_data_file->cell].nrecs   = -1;
+  c->cells[out_data_file->cell].lat     = 0;
+  c->cells[out_data_file->cell].lng     = 0;
+  c->cells[out_data_file->cell].offset  = 0;
+  while (c->header.ncells > 0 && c->cells[c->header.ncells-1].nrecs < 0)
+    c->header.ncells--;
+  pthread_mutex_unlock(&c->lock);
+
+}
+
+/****************************************************************************/
+/*			    close_output_containers()                       */
+/****************************************************************************/
+void close_output_containers()
+/*******************************************************************
+  close_output_containers
+
+  Writes the index and the final header of each container, and
+  closes it.  May be called more than once; chunks written after a
+  container has been closed are discarded.
+*******************************************************************/
+{
+  struct out_container *c;
+  int                   filenum;
+
+  for (filenum=0; filenum<ncontainers; filenum++) {
+    c = &containers[filenum];
+    pthread_mutex_lock(&c->lock);
+    if (c->fh != NULL) {
+      c->header.index_offset = c->end;
+      write_at(c, c->cells, c->header.ncells*sizeof(container_cell_struct),
+               c->header.index_offset);
+      write_at(c, &c->header, sizeof(container_header_struct), 0);
+      if (fclose(c->fh) != 0)
+        nrerror("Unable to close an output container in close_output_containers().");
+      c->fh = NULL;
+    }
+    pthread_mutex_unlock(&c->lock);
+  }
+
+}
+
+/****************************************************************************/
+/*			    free_output_containers()                        */
+/****************************************************************************/
+void free_output_containers()
+/*******************************************************************
+  free_output_containers
+
+  Frees the containers, which must have been closed.
+*******************************************************************/
+{
+  int filenum;
+
+  for (filenum=0; filenum<ncontainers; filenum++) {
+    pthread_mutex_destroy(&containers[filenum].lock);
+    free((char *)containers[filenum].cells);
+  }
+  free((char *)containers);
+  containers  = NULL;
+  ncontainers = 0;
+
+}
+
+static void write_at(struct out_container *c,
+                     const void           *ptr,
+                     size_t                n,
+                     long long             offset)
+/*******************************************************************
+  write_at
+
+  Writes n bytes to a container at the given offset.
+*******************************************************************/
+{
+  const char *p = (const char *)ptr;
+  ssize_t     w;
+
+  while (n > 0) {
+    w = pwrite(c->fd, p, n, (off_t)offset);
+    if (w <= 0) {
+      fprintf(stderr, "Error writing to \"%s\".\n", c->filename);
+      nrerror("Unable to write to an output container.");
+    }
+    p      += w;
+    n      -= w;
+    offset += w;
+  }
+
+}
@@ -2,9 +2,12 @@
 #include <stdlib.h>
 #include <vicNl.h>
 #include <string.h>
+#include <ctype.h>
 
 static char vcid[] = "$Id$";
 
+static void compile_output_format(out_data_struct *);
+
 out_data_struct *create_output_list() {
 /*************************************************************
   create_output_list()      Ted Bohn     September 08, 2006
@@ -64,6 +67,8 @@ out_data_struct *create_output_list() {
   2013-Dec-26 Removed EXCESS_ICE option.				TJB
   2014-Apr-25 Added OUT_LAI.						TJB
   2014-Apr-25 Added OUT_VEGCOVER.					TJB
+  2015-Feb-02 Removed aggdata; output variables are aggregated per
+	      output file (see set_output_aggregation()).		GT
 *************************************************************/
 
   extern option_struct options;
@@ -387,7 +392,6 @@ out_data_struct *create_output_list() {
   // Allocate space for data
   for (v=0; v<N_OUTVAR_TYPES; v++) {
     out_data[v].data = (double *)calloc(out_data[v].nelem, sizeof(double));
-    out_data[v].aggdata = (double *)calloc(out_data[v].nelem, sizeof(double));
   }
 
   // Initialize data values
@@ -404,12 +408,19 @@ void init_output_list(out_data_struct *out_data, int write, char *format, int ty
 
   This routine initializes the output information for all output variables.
 
+  Modifications:
+  2015-Feb-02 All variables are active until set_output_active()
+	      is called.						GT
+  2015-Feb-02 Compiles the format (see compile_output_format()).	GT
+
 *************************************************************/
   int varid, i;
 
   for (varid=0; varid<N_OUTVAR_TYPES; varid++) {
     out_data[varid].write = write;
+    out_data[varid].active = TRUE;
     strcpy(out_data[varid].format,format);
+    compile_output_format(&out_data[varid]);
     out_data[varid].type = type;
     out_data[varid].mult = mult;
     for(i=0; i<out_data[varid].nelem; i++) {
@@ -434,6 +445,11 @@ int set_output_var(out_data_file_struct *out_data_files,
 
   This routine updates the output information for a given output variable.
 
+  Modifications:
+  2015-Feb-02 Compiles the format (see compile_output_format()).	GT
+  2015-Feb-02 Sets the file's aggregation type of the variable to
+	      the variable's default.					GT
+
 *************************************************************/
   int varid;
   int found=FALSE;
@@ -443,13 +459,16 @@ int set_output_var(out_data_file_struct *out_data_files,
     if (strcmp(out_data[varid].varname,varname) == 0) {
       found = TRUE;
       out_data[varid].write = write;
-      if (strcmp(format,"*") != 0)
+      if (strcmp(format,"*") != 0) {
         strcpy(out_data[varid].format,format);
+        compile_output_format(&out_data[varid]);
+      }
       if (type != 0)
         out_data[varid].type = type;
       if (mult != 0)
         out_data[varid].mult = mult;
       out_data_files[filenum].varid[varnum] = varid;
+      out_data_files[filenum].aggtype[varnum] = out_data[varid].aggtype;
     }
   }
   if (!found) {
@@ -461,16 +480,186 @@ int set_output_var(out_data_file_struct *out_data_files,
 }
 
 
+void set_output_active(out_data_file_struct *out_data_files,
+                       out_data_struct *out_data) {
+/*************************************************************
+  set_output_active()
+
+  This routine marks the output variables that put_data() must
+  compute: those written to an output file, those that another
+  active variable is derived from, and those that the water and
+  energy balance checks and the save_data structure depend on.
+  It also sets options.OUTPUT_PET, so that potential evap is
+  only computed when an OUT_PET_* variable is written.
+
+*************************************************************/
+  extern option_struct options;
+  int filenum, varnum, v;
+
+  for (v=0; v<N_OUTVAR_TYPES; v++)
+    out_data[v].active = FALSE;
+  for (filenum=0; filenum<options.Noutfiles; filenum++) {
+    for (varnum=0; varnum<out_data_files[filenum].nvars; varnum++) {
+      out_data[out_data_files[filenum].varid[varnum]].active = TRUE;
+    }
+  }
+
+  // Water balance check and save_data
+  out_data[OUT_PREC].active = TRUE;
+  out_data[OUT_LAKE_CHAN_IN].active = TRUE;
+  out_data[OUT_EVAP].active = TRUE;
+  out_data[OUT_RUNOFF].active = TRUE;
+  out_data[OUT_BASEFLOW].active = TRUE;
+  out_data[OUT_SOIL_LIQ].active = TRUE;
+  out_data[OUT_SOIL_ICE].active = TRUE;
+  out_data[OUT_SOIL_MOIST].active = TRUE;
+  out_data[OUT_SWE].active = TRUE;
+  out_data[OUT_SNOW_CANOPY].active = TRUE;
+  out_data[OUT_WDEW].active = TRUE;
+  out_data[OUT_SURFSTOR].active = TRUE;
+  out_data[OUT_WATER_ERROR].active = TRUE;
+
+  // Energy balance check
+  if (options.FULL_ENERGY) {
+    out_data[OUT_NET_SHORT].active = TRUE;
+    out_data[OUT_NET_LONG].active = TRUE;
+    out_data[OUT_LATENT].active = TRUE;
+    out_data[OUT_LATENT_SUB].active = TRUE;
+    out_data[OUT_SENSIBLE].active = TRUE;
+    out_data[OUT_ADV_SENS].active = TRUE;
+    out_data[OUT_GRND_FLUX].active = TRUE;
+    out_data[OUT_DELTAH].active = TRUE;
+    out_data[OUT_FUSION].active = TRUE;
+    out_data[OUT_ADVECTION].active = TRUE;
+    out_data[OUT_DELTACC].active = TRUE;
+    out_data[OUT_SNOW_FLUX].active = TRUE;
+    out_data[OUT_RFRZ_ENERGY].active = TRUE;
+  }
+  out_data[OUT_ENERGY_ERROR].active = TRUE;
+
+  // Derived variables
+  if (out_data[OUT_AERO_RESIST].active)
+    out_data[OUT_AERO_COND].active = TRUE;
+  if (out_data[OUT_AERO_RESIST1].active)
+    out_data[OUT_AERO_COND1].active = TRUE;
+  if (out_data[OUT_AERO_RESIST2].active)
+    out_data[OUT_AERO_COND2].active = TRUE;
+  if (out_data[OUT_SMFROZFRAC].active)
+    out_data[OUT_SMLIQFRAC].active = TRUE;
+  if (out_data[OUT_REFREEZE].active)
+    out_data[OUT_RFRZ_ENERGY].active = TRUE;
+  if (out_data[OUT_R_NET].active) {
+    out_data[OUT_NET_SHORT].active = TRUE;
+    out_data[OUT_NET_LONG].active = TRUE;
+  }
+  if (out_data[OUT_NEE].active) {
+    out_data[OUT_NPP].active = TRUE;
+    out_data[OUT_RHET].active = TRUE;
+  }
+  // ALMA OUT_SUB_SNOW includes canopy sublimation
+  if (options.ALMA_OUTPUT && out_data[OUT_SUB_SNOW].active)
+    out_data[OUT_SUB_CANOP].active = TRUE;
+
+  options.OUTPUT_PET = FALSE;
+  for (v=OUT_PET_SATSOIL; v<=OUT_PET_VEGNOCR; v++) {
+    if (out_data[v].active)
+      options.OUTPUT_PET = TRUE;
+  }
+
+}
+
+
+void set_output_aggregation(out_data_file_struct *out_data_files,
+                            out_data_struct *out_data) {
+/*************************************************************
+  set_output_aggregation()
+
+  This routine sets up the aggregation of each output file over
+  its own output interval.  It checks the file's out_dt (0 means
+  OUT_STEP) and allocates the file's aggregation slots: one per
+  variable written, then one for each variable that is combined
+  with a written variable when the record is written (with
+  ALMA_OUTPUT, OUT_SUB_SNOW includes OUT_SUB_CANOP).  The average
+  of OUT_AERO_RESIST, OUT_AERO_RESIST1 and OUT_AERO_RESIST2 is
+  the inverse of the average conductance, so their AGG_TYPE_AVG
+  slots aggregate the matching OUT_AERO_COND variable.
+
+*************************************************************/
+  extern option_struct options;
+  extern global_param_struct global_param;
+  int filenum, j, v;
+  int nslots;
+  char ErrStr[MAXSTRING];
+  out_data_file_struct *file;
+
+  for (filenum=0; filenum<options.Noutfiles; filenum++) {
+    file = &out_data_files[filenum];
+
+    // Output interval
+    if (file->out_dt == 0)
+      file->out_dt = global_param.out_dt;
+    if (file->out_dt > 0) {
+      if (file->out_dt < global_param.dt || file->out_dt > 24
+          || file->out_dt % global_param.dt != 0) {
+        sprintf(ErrStr, "Invalid output step (%d) specified for output file \"%s\".  Output step must be an integer multiple of the model time step; >= model time step and <= 24; or MONTHLY or ANNUAL", file->out_dt, file->prefix);
+        nrerror(ErrStr);
+      }
+      file->out_step_ratio = file->out_dt / global_param.dt;
+    }
+    else
+      file->out_step_ratio = 0;
+    file->step_count = 0;
+
+    // Aggregation slots
+    nslots = file->nvars;
+    for (j=0; j<file->nvars; j++) {
+      if (options.ALMA_OUTPUT && file->varid[j] == OUT_SUB_SNOW)
+        nslots++;
+    }
+    file->aggvarid = (int *)calloc(nslots, sizeof(int));
+    file->aggtype = (int *)realloc(file->aggtype, nslots*sizeof(int));
+    file->aggdata = (double **)calloc(nslots, sizeof(double *));
+    file->naggvars = file->nvars;
+    for (j=0; j<file->nvars; j++) {
+      v = file->varid[j];
+      file->aggvarid[j] = v;
+      if (file->aggtype[j] == AGG_TYPE_AVG) {
+        if (v == OUT_AERO_RESIST)
+          file->aggvarid[j] = OUT_AERO_COND;
+        else if (v == OUT_AERO_RESIST1)
+          file->aggvarid[j] = OUT_AERO_COND1;
+        else if (v == OUT_AERO_RESIST2)
+          file->aggvarid[j] = OUT_AERO_COND2;
+      }
+      if (options.ALMA_OUTPUT && v == OUT_SUB_SNOW) {
+        file->aggvarid[file->naggvars] = OUT_SUB_CANOP;
+        file->aggtype[file->naggvars] = file->aggtype[j];
+        file->naggvars++;
+      }
+    }
+    for (j=0; j<file->naggvars; j++) {
+      file->aggdata[j] = (double *)calloc(out_data[file->aggvarid[j]].nelem, sizeof(double));
+    }
+
+  }
+
+}
+
+
 void zero_output_list(out_data_struct *out_data) {
 /*************************************************************
   zero_output_list()      Ted Bohn     September 08, 2006
 
   This routine resets the values of all output variables to 0.
 
+  Modifications:
+  2015-Feb-02 Only active variables are reset.			GT
+
 *************************************************************/
   int varid, i;
 
   for (varid=0; varid<N_OUTVAR_TYPES; varid++) {
+    if (!out_data[varid].active) continue;
     for(i=0; i<out_data[varid].nelem; i++) {
       out_data[varid].data[i] = 0;
     }
@@ -478,6 +667,68 @@ void zero_output_list(out_data_struct *out_data) {
 
 }
 
+out_data_struct *copy_output_list(out_data_struct *out_data) {
+/*************************************************************
+  copy_output_list()
+
+  This routine creates a copy of the list of output variables,
+  including their output settings, with its own data arrays.
+  Used to give each worker thread of the threaded cell
+  driver a private output list.
+
+*************************************************************/
+  int v;
+  out_data_struct *new_data;
+
+  new_data = (out_data_struct *)calloc(N_OUTVAR_TYPES,sizeof(out_data_struct));
+  for (v=0; v<N_OUTVAR_TYPES; v++) {
+    new_data[v] = out_data[v];
+    new_data[v].data = (double *)calloc(out_data[v].nelem, sizeof(double));
+  }
+
+  return new_data;
+
+}
+
+
+out_data_file_struct *copy_out_data_files(out_data_file_struct *out_data_files,
+                                          out_data_struct *out_data) {
+/*************************************************************
+  copy_out_data_files()
+
+  This routine creates a copy of the out_data_files array, with
+  its own varid arrays and aggregation slots.  File handles are
+  not shared; they are set when the copy's files are opened.
+
+*************************************************************/
+  extern option_struct options;
+  int filenum;
+  int j;
+  out_data_file_struct *new_files;
+
+  new_files = (out_data_file_struct *)calloc(options.Noutfiles,sizeof(out_data_file_struct));
+  for (filenum=0; filenum<options.Noutfiles; filenum++) {
+    new_files[filenum] = out_data_files[filenum];
+    new_files[filenum].fh = NULL;
+    new_files[filenum].varid = (int *)calloc(out_data_files[filenum].nvars, sizeof(int));
+    memcpy(new_files[filenum].varid, out_data_files[filenum].varid,
+           out_data_files[filenum].nvars*sizeof(int));
+    new_files[filenum].aggvarid = (int *)calloc(out_data_files[filenum].naggvars, sizeof(int));
+    memcpy(new_files[filenum].aggvarid, out_data_files[filenum].aggvarid,
+           out_data_files[filenum].naggvars*sizeof(int));
+    new_files[filenum].aggtype = (int *)calloc(out_data_files[filenum].naggvars, sizeof(int));
+    memcpy(new_files[filenum].aggtype, out_data_files[filenum].aggtype,
+           out_data_files[filenum].naggvars*sizeof(int));
+    new_files[filenum].aggdata = (double **)calloc(out_data_files[filenum].naggvars, sizeof(double *));
+    for (j=0; j<out_data_files[filenum].naggvars; j++) {
+      new_files[filenum].aggdata[j] = (double *)calloc(out_data[out_data_files[filenum].aggvarid[j]].nelem, sizeof(double));
+    }
+  }
+
+  return new_files;
+
+}
+
 void free_out_data_files(out_data_file_struct **out_data_files) {
 /*************************************************************
   free_out_data_files()      Ted Bohn     September 08, 2006
@@ -487,9 +738,16 @@ void free_out_data_files(out_data_file_struct **out_data_files) {
 *************************************************************/
   extern option_struct options;
   int filenum;
+  int j;
 
   for (filenum=0; filenum<options.Noutfiles; filenum++) {
     free((char*)(*out_data_files)[filenum].varid);
+    free((char*)(*out_data_files)[filenum].aggvarid);
+    free((char*)(*out_data_files)[filenum].aggtype);
+    for (j=0; j<(*out_data_files)[filenum].naggvars; j++) {
+      free((char*)(*out_data_files)[filenum].aggdata[j]);
+    }
+    free((char*)(*out_data_files)[filenum].aggdata);
   }
   free((char*)(*out_data_files));
 
@@ -507,9 +765,50 @@ void free_out_data(out_data_struct **out_data) {
 
   for (varid=0; varid<N_OUTVAR_TYPES; varid++) {
     free((char*)(*out_data)[varid].data);
-    free((char*)(*out_data)[varid].aggdata);
   }
   free((char*)(*out_data));
 
 }
 
+
+static void compile_output_format(out_data_struct *out_data) {
+/*************************************************************
+  compile_output_format()
+
+  This routine parses a variable's ASCII format once, so that
+  write_data() need not.  Formats of the form %[width][.prec]f
+  (an "l" before the "f" is allowed) are stored as fmt_width and
+  fmt_prec, and are written by write_data()'s own fixed-precision
+  formatter; for any other format, fmt_prec is set to -1 and the
+  value is written with snprintf().
+
+*************************************************************/
+  char *c;
+  int   width;
+  int   prec;
+
+  out_data->fmt_width = 0;
+  out_data->fmt_prec = -1;
+
+  c = out_data->format;
+  if (*c++ != '%') return;
+  // A leading 0 is the zero-padding flag
+  if (*c == '0') return;
+  width = 0;
+  while (isdigit(*c))
+    width = 10*width + (*c++ - '0');
+  prec = 6;
+  if (*c == '.') {
+    c++;
+    prec = 0;
+    while (isdigit(*c))
+      prec = 10*prec + (*c++ - '0');
+  }
+  if (*c == 'l') c++;
+  if (c[0] != 'f' || c[1] != '\0') return;
+  if (prec > MAX_FMT_PREC || width > MAX_FMT_WIDTH) return;
+
+  out_data->fmt_width = width;
+  out_data->fmt_prec = prec;
+
+}
@@ -0,0 +1,255 @@
+/*
+ * Purpose: asynchronous output writer - takes writing of the output files
+ *          off the simulation thread
+ * Usage  : Part of VIC
+ * Created: 2015-Feb-02
+ * Notes  : When ASYNC_OUTPUT is TRUE, each thread that runs cells owns a
+ *          writer thread and a ring of OUTPUT_QUEUE_LEN record buffers of
+ *          OUT_BUF_SIZE bytes each.  write_data() formats the output
+ *          records of each file into the file's own buffer; when that is
+ *          full, or the file is closed, flush_out_data_file() copies the
+ *          whole block of records into the next free ring buffer (via
+ *          output_fwrite()) and hands it to the writer thread with
+ *          end_output_record().  So one ring buffer holds one block of
+ *          records of one output file, not one line.  The writer thread
+ *          writes the buffers to their files in order.  When all buffers
+ *          are full, end_output_record() waits for the writer thread.
+ *          close_files() calls flush_output_writer() before closing a
+ *          cell's output files.
+ *
+ *          When ASYNC_OUTPUT is FALSE (or the writer has not been started)
+ *          output_fwrite() writes directly to the file.
+ */
+
+/****************************************************************************/
+/*			  PREPROCESSOR DIRECTIVES                           */
+/****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <vicNl.h>
+
+static char vcid[] = "$Id$";
+
+typedef struct {
+  FILE   *fh;    /* file the record is to be written to */
+  char   *buf;   /* formatted record */
+  size_t  len;   /* number of bytes in buf */
+  size_t  size;  /* allocated size of buf */
+} out_record_struct;
+
+typedef struct {
+  int                nrecs;   /* number of record buffers in the ring */
+  int                head;    /* next buffer to be filled */
+  int                tail;    /* next buffer to be written */
+  int                count;   /* number of filled buffers */
+  int                stop;
+  out_record_struct *rec;
+  pthread_t          thread;
+  pthread_mutex_t    lock;
+  pthread_cond_t     filled;
+  pthread_cond_t     drained;
+} out_writer_struct;
+
+static THREAD_LOCAL out_writer_struct *writer = NULL;
+
+static void *output_writer(void *arg);
+static void  grow_record(out_record_struct *, size_t);
+
+/****************************************************************************/
+/*			     start_output_writer()                          */
+/****************************************************************************/
+void start_output_writer(int nrecs)
+/*******************************************************************
+  start_output_writer
+
+  Starts the calling thread's writer thread, with a ring of nrecs
+  record buffers.  Each buffer is allocated with the size of an
+  output file's block buffer (OUT_BUF_SIZE), so that it normally
+  never has to grow.
+*******************************************************************/
+{
+  int i;
+
+  writer = (out_writer_struct *)calloc(1, sizeof(out_writer_struct));
+  if (writer == NULL)
+    nrerror("Memory allocation error in start_output_writer().");
+  writer->nrecs = nrecs;
+  writer->head  = 0;
+  writer->tail  = 0;
+  writer->count = 0;
+  writer->stop  = FALSE;
+  writer->rec   = (out_record_struct *)calloc(nrecs, sizeof(out_record_struct));
+  if (writer->rec == NULL)
+    nrerror("Memory allocation error in start_output_writer().");
+  for (i=0; i<nrecs; i++) {
+    writer->rec[i].size = OUT_BUF_SIZE;
+    writer->rec[i].buf  = (char *)malloc(OUT_BUF_SIZE);
+    if (writer->rec[i].buf == NULL)
+      nrerror("Memory allocation error in start_output_writer().");
+  }
+
+  pthread_mutex_init(&writer->lock, NULL);
+  pthread_cond_init(&writer->filled, NULL);
+  pthread_cond_init(&writer->drained, NULL);
+  if (pthread_create(&writer->thread, NULL, output_writer, writer) != 0)
+    nrerror("Unable to create output writer thread in start_output_writer().");
+
+}
+
+/****************************************************************************/
+/*			     flush_output_writer()                          */
+/****************************************************************************/
+void flush_output_writer()
+/*******************************************************************
+  flush_output_writer
+
+  Waits until all records handed to the calling thread's writer
+  thread have been written.
+*******************************************************************/
+{
+  if (writer == NULL) return;
+
+  pthread_mutex_lock(&writer->lock);
+  while (writer->count > 0)
+    pthread_cond_wait(&writer->drained, &writer->lock);
+  pthread_mutex_unlock(&writer->lock);
+
+}
+
+/****************************************************************************/
+/*			     finish_output_writer()                         */
+/****************************************************************************/
+void finish_output_writer()
+/*******************************************************************
+  finish_output_writer
+
+  Writes any remaining records, then stops the calling thread's writer
+  thread.
+*******************************************************************/
+{
+  int i;
+
+  if (writer == NULL) return;
+
+  pthread_mutex_lock(&writer->lock);
+  writer->stop = TRUE;
+  pthread_cond_signal(&writer->filled);
+  pthread_mutex_unlock(&writer->lock);
+  pthread_join(writer->thread, NULL);
+
+  pthread_mutex_destroy(&writer->lock);
+  pthread_cond_destroy(&writer->filled);
+  pthread_cond_destroy(&writer->drained);
+  for (i=0; i<writer->nrecs; i++)
+    free((char *)writer->rec[i].buf);
+  free((char *)writer->rec);
+  free((char *)writer);
+  writer = NULL;
+
+}
+
+/****************************************************************************/
+/*			        output_fwrite()                             */
+/****************************************************************************/
+void output_fwrite(const void *ptr, size_t size, size_t n, FILE *fh)
+/*******************************************************************
+  output_fwrite
+
+  Same as fwrite(), but with the asynchronous writer running, appends
+  the data to the current output record.
+*******************************************************************/
+{
+  out_record_struct *rec;
+
+  if (writer == NULL) {
+    fwrite(ptr, size, n, fh);
+    return;
+  }
+
+  rec = &writer->rec[writer->head];
+  rec->fh = fh;
+  grow_record(rec, rec->len + size*n);
+  memcpy(rec->buf + rec->len, ptr, size*n);
+  rec->len += size*n;
+
+}
+
+/****************************************************************************/
+/*			      end_output_record()                           */
+/****************************************************************************/
+void end_output_record()
+/*******************************************************************
+  end_output_record
+
+  Hands the current output record to the writer thread, then waits
+  until a record buffer is free for the next record.  Does nothing if
+  the asynchronous writer is not running or the record is empty.
+*******************************************************************/
+{
+  if (writer == NULL || writer->rec[writer->head].len == 0) return;
+
+  pthread_mutex_lock(&writer->lock);
+  writer->head = (writer->head + 1) % writer->nrecs;
+  writer->count++;
+  pthread_cond_signal(&writer->filled);
+  while (writer->count == writer->nrecs)
+    pthread_cond_wait(&writer->drained, &writer->lock);
+  pthread_mutex_unlock(&writer->lock);
+
+}
+
+/****************************************************************************/
+/*				output_writer()                             */
+/****************************************************************************/
+static void *output_writer(void *arg)
+/*******************************************************************
+  output_writer
+
+  Writer thread: writes filled record buffers to their files, in the
+  order in which they were filled.
+*******************************************************************/
+{
+  out_writer_struct *w = (out_writer_struct *)arg;
+  out_record_struct *rec;
+
+  pthread_mutex_lock(&w->lock);
+  while (TRUE) {
+    while (w->count == 0 && !w->stop)
+      pthread_cond_wait(&w->filled, &w->lock);
+    if (w->count == 0) break;
+    rec = &w->rec[w->tail];
+    pthread_mutex_unlock(&w->lock);
+
+    fwrite(rec->buf, 1, rec->len, rec->fh);
+    rec->len = 0;
+
+    pthread_mutex_lock(&w->lock);
+    w->tail = (w->tail + 1) % w->nrecs;
+    w->count--;
+    pthread_cond_signal(&w->drained);
+  }
+  pthread_mutex_unlock(&w->lock);
+
+  return(NULL);
+
+}
+
+static void grow_record(out_record_struct *rec, size_t size)
+/*******************************************************************
+  grow_record
+
+  Makes sure that a record buffer can hold at least size bytes.
+*******************************************************************/
+{
+  if (size <= rec->size) return;
+
+  while (rec->size < size)
+    rec->size *= 2;
+  rec->buf = (char *)realloc(rec->buf, rec->size);
+  if (rec->buf == NULL)
+    nrerror("Memory allocation error in grow_record().");
+
+}
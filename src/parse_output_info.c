@@ -28,6 +28,12 @@ void parse_output_info(filenames_struct      *names,
   2009-Mar-15 Added default values for format, typestr, and
 	      multstr, so that they can be omitted from global
 	      param file.					TJB
+  2015-Feb-02 Added the optional output step of each OUTFILE, in
+	      hours or MONTHLY or ANNUAL, and the optional
+	      aggregation type of each OUTVAR.			GT
+  2015-Feb-02 The output step must be a whole number of hours
+	      ("3.5" or "24h" are rejected instead of read as 3 or
+	      24).						GT
 **********************************************************************/
 {
   extern option_struct    options;
@@ -44,6 +50,11 @@ void parse_output_info(filenames_struct      *names,
   int  type;
   char multstr[20];
   float mult;
+  char stepstr[20];
+  char *endptr;
+  long out_dt;
+  char aggstr[20];
+  int  aggtype;
   int  tmp_noutfiles;
   char ErrStr[MAXSTRING];
 
@@ -79,8 +90,25 @@ void parse_output_info(filenames_struct      *names,
           sprintf(ErrStr, "Error in global param file: number of output files specified in N_OUTFILES (%d) is less than actual number of output files defined in the global param file.",options.Noutfiles);
           nrerror(ErrStr);
         }
-        sscanf(cmdstr,"%*s %s %d",(*out_data_files)[outfilenum].prefix,&((*out_data_files)[outfilenum].nvars));
+        strcpy(stepstr,"");
+        sscanf(cmdstr,"%*s %s %d %s",(*out_data_files)[outfilenum].prefix,&((*out_data_files)[outfilenum].nvars),stepstr);
+        if (strcasecmp("MONTHLY",stepstr)==0)
+          out_dt = OUT_STEP_MONTH;
+        else if (strcasecmp("ANNUAL",stepstr)==0 || strcasecmp("YEARLY",stepstr)==0)
+          out_dt = OUT_STEP_YEAR;
+        else if (stepstr[0] == '\0' || stepstr[0] == '#')
+          out_dt = 0; // 0 means OUT_STEP
+        else {
+          /* the whole token must be a whole number of hours */
+          out_dt = strtol(stepstr, &endptr, 10);
+          if (endptr == stepstr || *endptr != '\0' || out_dt < 0) {
+            sprintf(ErrStr, "Error in global param file: invalid output step \"%s\" for output file \"%s\"; must be a number of hours, MONTHLY or ANNUAL.", stepstr, (*out_data_files)[outfilenum].prefix);
+            nrerror(ErrStr);
+          }
+        }
+        (*out_data_files)[outfilenum].out_dt = out_dt;
         (*out_data_files)[outfilenum].varid = (int *)calloc((*out_data_files)[outfilenum].nvars, sizeof(int));
+        (*out_data_files)[outfilenum].aggtype = (int *)calloc((*out_data_files)[outfilenum].nvars, sizeof(int));
         outvarnum = 0;
       }
       else if(strcasecmp("OUTVAR",optstr)==0) {
@@ -90,7 +118,9 @@ void parse_output_info(filenames_struct      *names,
         strcpy(format,"");
         strcpy(typestr,"");
         strcpy(multstr,"");
-        sscanf(cmdstr,"%*s %s %s %s %s",varname, format, typestr, multstr);
+        strcpy(aggstr,"");
+        aggtype = AGG_TYPE_DEFAULT;
+        sscanf(cmdstr,"%*s %s %s %s %s %s",varname, format, typestr, multstr, aggstr);
         if (strcasecmp("",format) == 0) {
           strcpy(format,"*");
           type = OUT_TYPE_DEFAULT;
@@ -112,9 +142,29 @@ void parse_output_info(filenames_struct      *names,
           else
             mult = (float)atof(multstr);
         }
+        if (strcasecmp("AGG_TYPE_AVG", aggstr)==0)
+          aggtype = AGG_TYPE_AVG;
+        else if (strcasecmp("AGG_TYPE_BEG", aggstr)==0)
+          aggtype = AGG_TYPE_BEG;
+        else if (strcasecmp("AGG_TYPE_END", aggstr)==0)
+          aggtype = AGG_TYPE_END;
+        else if (strcasecmp("AGG_TYPE_MAX", aggstr)==0)
+          aggtype = AGG_TYPE_MAX;
+        else if (strcasecmp("AGG_TYPE_MIN", aggstr)==0)
+          aggtype = AGG_TYPE_MIN;
+        else if (strcasecmp("AGG_TYPE_SUM", aggstr)==0)
+          aggtype = AGG_TYPE_SUM;
+        else if (aggstr[0] == '\0' || aggstr[0] == '#' || strcmp("*", aggstr)==0)
+          aggtype = AGG_TYPE_DEFAULT;
+        else {
+          sprintf(ErrStr, "Error in global param file: invalid aggregation type \"%s\" for output variable %s.", aggstr, varname);
+          nrerror(ErrStr);
+        }
         if (set_output_var((*out_data_files), TRUE, outfilenum, out_data, varname, outvarnum, format, type, mult) != 0) {
           nrerror("Error in global param file: Invalid output variable specification.");
         }
+        if (aggtype != AGG_TYPE_DEFAULT)
+          (*out_data_files)[outfilenum].aggtype[outvarnum] = aggtype;
         strcpy(format,"");
         outvarnum++;
       }
@@ -554,6 +554,7 @@ print_option(option_struct *option)
     printf("\tALMA_OUTPUT        : %d\n", option->ALMA_OUTPUT);
     printf("\tBINARY_OUTPUT      : %d\n", option->BINARY_OUTPUT);
     printf("\tCOMPRESS           : %d\n", option->COMPRESS);
+    printf("\tCOMPRESS_LEVEL     : %d\n", option->COMPRESS_LEVEL);
     printf("\tMOISTFRACT         : %d\n", option->MOISTFRACT);
     printf("\tNoutfiles          : %d\n", option->Noutfiles);
     printf("\tOUTPUT_FORCE       : %d\n", option->OUTPUT_FORCE);
@@ -579,11 +580,6 @@ print_out_data(out_data_struct *out,
         printf("\t%.4lf", out->data[i]);
     }
     printf("\n");
-    printf("\taggdata:");
-    for (i = 0; i < nelem; i++) {
-        printf("\t%.4lf", out->aggdata[i]);
-    }
-    printf("\n");
 }
 
 void
@@ -596,6 +592,11 @@ print_out_data_file(out_data_file_struct *outf)
     printf("\tfh: %p\n", outf->fh);
     printf("\tnvars: %d\n", outf->nvars);
     printf("\tvarid: %p\n", outf->varid);
+    printf("\tout_dt: %d\n", outf->out_dt);
+    printf("\tnaggvars: %d\n", outf->naggvars);
+    printf("\taggvarid: %p\n", outf->aggvarid);
+    printf("\taggtype: %p\n", outf->aggtype);
+    printf("\taggdata: %p\n", outf->aggdata);
 }
 
 void
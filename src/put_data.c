@@ -4,6 +4,39 @@
 
 static char vcid[] = "$Id$";
 
+/* Output variables whose ALMA units are rates: divided by the output
+   interval [s] */
+#define N_ALMA_RATE_VARS 37
+static const int alma_rate_vars[N_ALMA_RATE_VARS] = {
+  OUT_BASEFLOW, OUT_EVAP, OUT_EVAP_BARE, OUT_EVAP_CANOP, OUT_INFLOW,
+  OUT_LAKE_BF_IN, OUT_LAKE_BF_IN_V, OUT_LAKE_BF_OUT, OUT_LAKE_BF_OUT_V,
+  OUT_LAKE_CHAN_IN, OUT_LAKE_CHAN_IN_V, OUT_LAKE_CHAN_OUT,
+  OUT_LAKE_CHAN_OUT_V, OUT_LAKE_DSTOR, OUT_LAKE_DSTOR_V, OUT_LAKE_DSWE,
+  OUT_LAKE_DSWE_V, OUT_LAKE_EVAP, OUT_LAKE_EVAP_V, OUT_LAKE_PREC_V,
+  OUT_LAKE_RCHRG, OUT_LAKE_RCHRG_V, OUT_LAKE_RO_IN, OUT_LAKE_RO_IN_V,
+  OUT_LAKE_VAPFLX, OUT_LAKE_VAPFLX_V, OUT_PREC, OUT_RAINF, OUT_REFREEZE,
+  OUT_RUNOFF, OUT_SNOW_MELT, OUT_SNOWF, OUT_SUB_BLOWING, OUT_SUB_CANOP,
+  OUT_SUB_SNOW, OUT_SUB_SURFACE, OUT_TRANSP_VEG
+};
+
+/* Output variables whose ALMA units are [K] instead of [C] */
+#define N_ALMA_TEMP_VARS 11
+static const int alma_temp_vars[N_ALMA_TEMP_VARS] = {
+  OUT_AIR_TEMP, OUT_BARESOILT, OUT_LAKE_ICE_TEMP, OUT_LAKE_SURF_TEMP,
+  OUT_SNOW_PACK_TEMP, OUT_SNOW_SURF_TEMP, OUT_SOIL_TEMP, OUT_SOIL_TNODE,
+  OUT_SOIL_TNODE_WL, OUT_SURF_TEMP, OUT_VEGT
+};
+
+#ifndef _LEAPYR
+#define LEAPYR(y) (!((y)%400) || (!((y)%4) && ((y)%100)))
+#endif
+
+static void aggregate_output(out_data_file_struct *, out_data_struct *);
+static int  end_of_output_interval(out_data_file_struct *, dmy_struct *, int);
+static void finish_output_record(out_data_file_struct *, out_data_struct *);
+static void reset_output_aggregation(out_data_file_struct *, out_data_struct *);
+static int  in_var_list(int, const int *, int);
+
 int  put_data(all_vars_struct   *all_vars,
 	      atmos_data_struct *atmos,
               soil_con_struct   *soil_con,
@@ -156,10 +189,26 @@ int  put_data(all_vars_struct   *all_vars,
   2014-Mar-28 Removed DIST_PRCP option.					TJB
   2014-Apr-25 Added OUT_LAI.						TJB
   2014-Apr-25 Added OUT_VEGCOVER.					TJB
+  2015-Feb-02 Moved step_count and the T fallback totals into save_data
+	      so that cells can be simulated concurrently; they are now
+	      reset at the start of each cell.				GT
+  2015-Feb-02 The wetland override of the lake's soil ice and T now
+	      repoints lake_var's node arrays instead of copying into
+	      them, since the copy shares them with the lake state.	GT
+  2015-Feb-02 Only the active output variables (see
+	      set_output_active()) are accumulated, aggregated and
+	      converted to ALMA units.					GT
+  2015-Feb-02 Each output file is now aggregated over its own output
+	      interval (out_data_file_struct.out_dt), which may be a
+	      number of calendar months, and is written when its
+	      interval is complete; step_count moved from save_data to
+	      out_data_file_struct.  All AGG_TYPEs are now applied:
+	      AGG_TYPE_BEG, AGG_TYPE_MAX and AGG_TYPE_MIN were never
+	      aggregated.						GT
 **********************************************************************/
 {
   extern global_param_struct global_param;
-  extern veg_lib_struct  *veg_lib;
+  extern THREAD_LOCAL veg_lib_struct  *veg_lib;
   extern option_struct    options;
   int                     veg;
   int                     index;
@@ -193,15 +242,8 @@ int  put_data(all_vars_struct   *all_vars,
   int                     v;
   int                     i;
   int                     dt_sec;
-  int                     out_dt_sec;
-  int                     out_step_ratio;
-  static int              step_count;
+  int                     filenum;
   int                     ErrorFlag;
-  static int              Tfoliage_fbcount_total;
-  static int              Tcanopy_fbcount_total;
-  static int              Tsnowsurf_fbcount_total;
-  static int              Tsurf_fbcount_total;
-  static int              Tsoil_fbcount_total;
 
   cell_data_struct      **cell;
   energy_bal_struct     **energy;
@@ -224,15 +266,16 @@ int  put_data(all_vars_struct   *all_vars,
   dp = soil_con->dp;
   skipyear = global_param.skipyear;
   dt_sec = global_param.dt*SECPHOUR;
-  out_dt_sec = global_param.out_dt*SECPHOUR;
-  out_step_ratio = (int)(out_dt_sec/dt_sec);
-  if (rec >= 0) step_count++;
-  if (rec == 0) {
-    Tsoil_fbcount_total = 0;
-    Tsurf_fbcount_total = 0;
-    Tsnowsurf_fbcount_total = 0;
-    Tcanopy_fbcount_total = 0;
-    Tfoliage_fbcount_total = 0;
+  if (rec < 0) {
+    for (filenum=0; filenum<options.Noutfiles; filenum++)
+      reset_output_aggregation(&out_data_files[filenum], out_data);
+  }
+  if (rec <= 0) {
+    save_data->Tsoil_fbcount_total = 0;
+    save_data->Tsurf_fbcount_total = 0;
+    save_data->Tsnowsurf_fbcount_total = 0;
+    save_data->Tcanopy_fbcount_total = 0;
+    save_data->Tfoliage_fbcount_total = 0;
   }
 
   // Compute treeline adjustment factors
@@ -367,11 +410,11 @@ int  put_data(all_vars_struct   *all_vars,
           collect_eb_terms(energy[veg][band],
                            snow[veg][band],
                            cell[veg][band],
-                           &Tsoil_fbcount_total,
-                           &Tsurf_fbcount_total,
-                           &Tsnowsurf_fbcount_total,
-                           &Tcanopy_fbcount_total,
-                           &Tfoliage_fbcount_total,
+                           &(save_data->Tsoil_fbcount_total),
+                           &(save_data->Tsurf_fbcount_total),
+                           &(save_data->Tsnowsurf_fbcount_total),
+                           &(save_data->Tcanopy_fbcount_total),
+                           &(save_data->Tfoliage_fbcount_total),
                            Cv,
                            ThisAreaFract,
                            ThisTreeAdjust,
@@ -388,7 +431,7 @@ int  put_data(all_vars_struct   *all_vars,
 
           // Store Wetland-Specific Variables
 
-          if (IsWet) {
+          if (IsWet && out_data[OUT_SOIL_TNODE_WL].active) {
             // Wetland soil temperatures
             for(i=0;i<options.Nnode;i++) {
               out_data[OUT_SOIL_TNODE_WL].data[i] = energy[veg][band].T[i];
@@ -409,10 +452,10 @@ int  put_data(all_vars_struct   *all_vars,
               lake_var.energy.fdepth[i]      = energy[veg][band].fdepth[i];
               lake_var.energy.tdepth[i]      = energy[veg][band].fdepth[i];
             }
-            for (i=0; i<options.Nnode; i++) {
-              lake_var.energy.ice[i]         = energy[veg][band].ice[i];
-              lake_var.energy.T[i]           = energy[veg][band].T[i];
-            }
+            // lake_var is a copy sharing its node arrays with the lake,
+            // so point it at the wetland's arrays rather than writing them
+            lake_var.energy.ice              = energy[veg][band].ice;
+            lake_var.energy.T                = energy[veg][band].T;
             for (i=0; i<N_PET_TYPES; i++) {
               lake_var.soil.pot_evap[i]      = cell[veg][band].pot_evap[i];
             }
@@ -446,11 +489,11 @@ int  put_data(all_vars_struct   *all_vars,
             collect_eb_terms(lake_var.energy,
                              lake_var.snow,
                              lake_var.soil,
-                             &Tsoil_fbcount_total,
-                             &Tsurf_fbcount_total,
-                             &Tsnowsurf_fbcount_total,
-                             &Tcanopy_fbcount_total,
-                             &Tfoliage_fbcount_total,
+                             &(save_data->Tsoil_fbcount_total),
+                             &(save_data->Tsurf_fbcount_total),
+                             &(save_data->Tsnowsurf_fbcount_total),
+                             &(save_data->Tcanopy_fbcount_total),
+                             &(save_data->Tfoliage_fbcount_total),
                              Cv,
                              ThisAreaFract,
                              ThisTreeAdjust,
@@ -541,42 +584,52 @@ int  put_data(all_vars_struct   *all_vars,
     Finish aggregation of special-case variables
    *****************************************/
   // Normalize quantities that aren't present over entire grid cell
-  if (cv_baresoil > 0) {
+  if (cv_baresoil > 0 && out_data[OUT_BARESOILT].active) {
     out_data[OUT_BARESOILT].data[0] /= cv_baresoil;
   }
-  if (cv_veg > 0) {
+  if (cv_veg > 0 && out_data[OUT_VEGT].active) {
     out_data[OUT_VEGT].data[0] /= cv_veg;
   }
-  if (cv_overstory > 0) {
+  if (cv_overstory > 0 && out_data[OUT_AERO_COND2].active) {
     out_data[OUT_AERO_COND2].data[0] /= cv_overstory;
   }
   if (cv_snow > 0) {
-    out_data[OUT_SALBEDO].data[0] /= cv_snow;
-    out_data[OUT_SNOW_SURF_TEMP].data[0] /= cv_snow;
-    out_data[OUT_SNOW_PACK_TEMP].data[0] /= cv_snow;
+    if (out_data[OUT_SALBEDO].active)
+      out_data[OUT_SALBEDO].data[0] /= cv_snow;
+    if (out_data[OUT_SNOW_SURF_TEMP].active)
+      out_data[OUT_SNOW_SURF_TEMP].data[0] /= cv_snow;
+    if (out_data[OUT_SNOW_PACK_TEMP].active)
+      out_data[OUT_SNOW_PACK_TEMP].data[0] /= cv_snow;
   }
 
   // Radiative temperature
-  out_data[OUT_RAD_TEMP].data[0] = pow(out_data[OUT_RAD_TEMP].data[0],0.25);
+  if (out_data[OUT_RAD_TEMP].active)
+    out_data[OUT_RAD_TEMP].data[0] = pow(out_data[OUT_RAD_TEMP].data[0],0.25);
 
   // Aerodynamic conductance and resistance
-  if (out_data[OUT_AERO_COND1].data[0] > SMALL) {
-    out_data[OUT_AERO_RESIST1].data[0] = 1 / out_data[OUT_AERO_COND1].data[0];
-  }
-  else {
-    out_data[OUT_AERO_RESIST1].data[0] = HUGE_RESIST;
-  }
-  if (out_data[OUT_AERO_COND2].data[0] > SMALL) {
-    out_data[OUT_AERO_RESIST2].data[0] = 1 / out_data[OUT_AERO_COND2].data[0];
-  }
-  else {
-    out_data[OUT_AERO_RESIST2].data[0] = HUGE_RESIST;
+  if (out_data[OUT_AERO_RESIST1].active) {
+    if (out_data[OUT_AERO_COND1].data[0] > SMALL) {
+      out_data[OUT_AERO_RESIST1].data[0] = 1 / out_data[OUT_AERO_COND1].data[0];
+    }
+    else {
+      out_data[OUT_AERO_RESIST1].data[0] = HUGE_RESIST;
+    }
   }
-  if (out_data[OUT_AERO_COND].data[0] > SMALL) {
-    out_data[OUT_AERO_RESIST].data[0] = 1 / out_data[OUT_AERO_COND].data[0];
+  if (out_data[OUT_AERO_RESIST2].active) {
+    if (out_data[OUT_AERO_COND2].data[0] > SMALL) {
+      out_data[OUT_AERO_RESIST2].data[0] = 1 / out_data[OUT_AERO_COND2].data[0];
+    }
+    else {
+      out_data[OUT_AERO_RESIST2].data[0] = HUGE_RESIST;
+    }
   }
-  else {
-    out_data[OUT_AERO_RESIST].data[0] = HUGE_RESIST;
+  if (out_data[OUT_AERO_RESIST].active) {
+    if (out_data[OUT_AERO_COND].data[0] > SMALL) {
+      out_data[OUT_AERO_RESIST].data[0] = 1 / out_data[OUT_AERO_COND].data[0];
+    }
+    else {
+      out_data[OUT_AERO_RESIST].data[0] = HUGE_RESIST;
+    }
   }
 
   /*****************************************
@@ -587,8 +640,10 @@ int  put_data(all_vars_struct   *all_vars,
   for (index=0; index<options.Nlayer; index++) {
     out_data[OUT_SOIL_MOIST].data[index] = out_data[OUT_SOIL_LIQ].data[index]+out_data[OUT_SOIL_ICE].data[index];
     out_data[OUT_DELSOILMOIST].data[0] += out_data[OUT_SOIL_MOIST].data[index];
-    out_data[OUT_SMLIQFRAC].data[index] = out_data[OUT_SOIL_LIQ].data[index]/out_data[OUT_SOIL_MOIST].data[index];
-    out_data[OUT_SMFROZFRAC].data[index] = 1 - out_data[OUT_SMLIQFRAC].data[index];
+    if (out_data[OUT_SMLIQFRAC].active)
+      out_data[OUT_SMLIQFRAC].data[index] = out_data[OUT_SOIL_LIQ].data[index]/out_data[OUT_SOIL_MOIST].data[index];
+    if (out_data[OUT_SMFROZFRAC].active)
+      out_data[OUT_SMFROZFRAC].data[index] = 1 - out_data[OUT_SMLIQFRAC].data[index];
   }
   if (rec >= 0) {
     out_data[OUT_DELSOILMOIST].data[0] -= save_data->total_soil_moist;
@@ -598,8 +653,10 @@ int  put_data(all_vars_struct   *all_vars,
   }
 
   // Energy terms
-  out_data[OUT_REFREEZE].data[0] = (out_data[OUT_RFRZ_ENERGY].data[0]/Lf)*dt_sec;
-  out_data[OUT_R_NET].data[0] = out_data[OUT_NET_SHORT].data[0] + out_data[OUT_NET_LONG].data[0];
+  if (out_data[OUT_REFREEZE].active)
+    out_data[OUT_REFREEZE].data[0] = (out_data[OUT_RFRZ_ENERGY].data[0]/Lf)*dt_sec;
+  if (out_data[OUT_R_NET].active)
+    out_data[OUT_R_NET].data[0] = out_data[OUT_NET_SHORT].data[0] + out_data[OUT_NET_LONG].data[0];
 
   // Save current moisture state for use in next time step
   save_data->total_soil_moist = 0;
@@ -612,8 +669,10 @@ int  put_data(all_vars_struct   *all_vars,
 
   // Carbon Terms
   if (options.CARBON) {
-    out_data[OUT_RHET].data[0] *= (double)global_param.dt/24.0; // convert to gC/m2d
-    out_data[OUT_NEE].data[0] = out_data[OUT_NPP].data[0]-out_data[OUT_RHET].data[0];
+    if (out_data[OUT_RHET].active)
+      out_data[OUT_RHET].data[0] *= (double)global_param.dt/24.0; // convert to gC/m2d
+    if (out_data[OUT_NEE].active)
+      out_data[OUT_NEE].data[0] = out_data[OUT_NPP].data[0]-out_data[OUT_RHET].data[0];
   }
 
   /********************
@@ -656,136 +715,253 @@ int  put_data(all_vars_struct   *all_vars,
     Report T Fallback Occurrences
   ********************/
   if (rec == global_param.nrecs-1) {
-    fprintf(stderr,"Total number of fallbacks in Tfoliage: %d\n", Tfoliage_fbcount_total);
-    fprintf(stderr,"Total number of fallbacks in Tcanopy: %d\n", Tcanopy_fbcount_total);
-    fprintf(stderr,"Total number of fallbacks in Tsnowsurf: %d\n", Tsnowsurf_fbcount_total);
-    fprintf(stderr,"Total number of fallbacks in Tsurf: %d\n", Tsurf_fbcount_total);
-    fprintf(stderr,"Total number of fallbacks in soil T profile: %d\n", Tsoil_fbcount_total);
+    fprintf(stderr,"Total number of fallbacks in Tfoliage: %d\n", save_data->Tfoliage_fbcount_total);
+    fprintf(stderr,"Total number of fallbacks in Tcanopy: %d\n", save_data->Tcanopy_fbcount_total);
+    fprintf(stderr,"Total number of fallbacks in Tsnowsurf: %d\n", save_data->Tsnowsurf_fbcount_total);
+    fprintf(stderr,"Total number of fallbacks in Tsurf: %d\n", save_data->Tsurf_fbcount_total);
+    fprintf(stderr,"Total number of fallbacks in soil T profile: %d\n", save_data->Tsoil_fbcount_total);
   }
 
   /********************
-    Temporal Aggregation 
+    Temporal Aggregation and Output
+    (each output file is aggregated over its own output interval,
+    and written when the interval is complete)
     ********************/
-  for (v=0; v<N_OUTVAR_TYPES; v++) {
-    if (out_data[v].aggtype == AGG_TYPE_END) {
-      for (i=0; i<out_data[v].nelem; i++) {
-        out_data[v].aggdata[i] = out_data[v].data[i];
-      }
-    }
-    else if (out_data[v].aggtype == AGG_TYPE_SUM) {
-      for (i=0; i<out_data[v].nelem; i++) {
-        out_data[v].aggdata[i] += out_data[v].data[i];
-      }
+  for (filenum=0; filenum<options.Noutfiles; filenum++) {
+    aggregate_output(&out_data_files[filenum], out_data);
+    if (end_of_output_interval(&out_data_files[filenum], dmy, rec)) {
+      finish_output_record(&out_data_files[filenum], out_data);
+      if(rec >= skipyear)
+        write_data(&out_data_files[filenum], out_data, dmy);
+      reset_output_aggregation(&out_data_files[filenum], out_data);
     }
-    else if (out_data[v].aggtype == AGG_TYPE_AVG) {
-      for (i=0; i<out_data[v].nelem; i++) {
-        out_data[v].aggdata[i] += out_data[v].data[i]/out_step_ratio;
-      }
+  }
+
+  return (0);
+
+}
+
+static void aggregate_output(out_data_file_struct *out_data_file,
+                             out_data_struct      *out_data)
+/**********************************************************************
+  aggregate_output
+
+  Adds the current model step to each of the output file's
+  aggregation slots, according to the slot's AGG_TYPE.  Averages
+  over fixed intervals are accumulated as data/out_step_ratio;
+  averages over calendar intervals are accumulated as sums, and
+  divided by the number of steps by finish_output_record().
+**********************************************************************/
+{
+  int     j;
+  int     i;
+  int     nelem;
+  int     first;
+  double *data;
+  double *aggdata;
+
+  out_data_file->step_count++;
+  first = (out_data_file->step_count == 1);
+
+  for (j=0; j<out_data_file->naggvars; j++) {
+    data = out_data[out_data_file->aggvarid[j]].data;
+    nelem = out_data[out_data_file->aggvarid[j]].nelem;
+    aggdata = out_data_file->aggdata[j];
+    switch (out_data_file->aggtype[j]) {
+      case AGG_TYPE_AVG:
+        if (out_data_file->out_step_ratio > 0) {
+          for (i=0; i<nelem; i++)
+            aggdata[i] += data[i]/out_data_file->out_step_ratio;
+        }
+        else {
+          for (i=0; i<nelem; i++)
+            aggdata[i] += data[i];
+        }
+        break;
+      case AGG_TYPE_BEG:
+        if (first) {
+          for (i=0; i<nelem; i++)
+            aggdata[i] = data[i];
+        }
+        break;
+      case AGG_TYPE_END:
+        for (i=0; i<nelem; i++)
+          aggdata[i] = data[i];
+        break;
+      case AGG_TYPE_MAX:
+        for (i=0; i<nelem; i++) {
+          if (first || data[i] > aggdata[i])
+            aggdata[i] = data[i];
+        }
+        break;
+      case AGG_TYPE_MIN:
+        for (i=0; i<nelem; i++) {
+          if (first || data[i] < aggdata[i])
+            aggdata[i] = data[i];
+        }
+        break;
+      case AGG_TYPE_SUM:
+        for (i=0; i<nelem; i++)
+          aggdata[i] += data[i];
+        break;
     }
   }
-  out_data[OUT_AERO_RESIST].aggdata[0] = 1/out_data[OUT_AERO_COND].aggdata[0];
-  out_data[OUT_AERO_RESIST1].aggdata[0] = 1/out_data[OUT_AERO_COND1].aggdata[0];
-  out_data[OUT_AERO_RESIST2].aggdata[0] = 1/out_data[OUT_AERO_COND2].aggdata[0];
 
-  /********************
-    Output procedure
-    (only execute when we've completed an output interval)
-    ********************/
-  if (step_count == out_step_ratio) {
+}
+
+static int end_of_output_interval(out_data_file_struct *out_data_file,
+                                  dmy_struct           *dmy,
+                                  int                   rec)
+/**********************************************************************
+  end_of_output_interval
+
+  Returns TRUE if the model step of record rec, whose date is dmy,
+  completes the output file's current output interval.  An interval
+  of calendar months ends with the last step of each month that is a
+  multiple of the number of months (the last step of each month, or
+  of December for ANNUAL), and with the last step of the simulation,
+  so that the first and last records may cover only part of their
+  interval.
+**********************************************************************/
+{
+  extern global_param_struct global_param;
+  static const int month_days[12] = {31,28,31,30,31,30,31,31,30,31,30,31};
+  int ndays;
+
+  if (out_data_file->out_step_ratio > 0)
+    return (out_data_file->step_count == out_data_file->out_step_ratio);
+
+  if (rec == global_param.nrecs-1)
+    return TRUE;
+  if (dmy->hour + global_param.dt < 24)
+    return FALSE;
+  ndays = month_days[dmy->month-1];
+  if (dmy->month == 2 && LEAPYR(dmy->year))
+    ndays++;
+  if (dmy->day != ndays)
+    return FALSE;
+  return (dmy->month % (-out_data_file->out_dt) == 0);
+
+}
+
+static void finish_output_record(out_data_file_struct *out_data_file,
+                                 out_data_struct      *out_data)
+/**********************************************************************
+  finish_output_record
+
+  Turns the output file's aggregation slots into the values of the
+  record to be written: completes averages over calendar intervals,
+  inverts aggregated aerodynamic conductances, converts to ALMA units
+  if ALMA_OUTPUT is TRUE, and applies the binary multipliers if
+  BINARY_OUTPUT is TRUE.  Rates (ALMA) are per second of the interval
+  for AGG_TYPE_SUM, and per second of the model step otherwise.
+**********************************************************************/
+{
+  extern option_struct       options;
+  extern global_param_struct global_param;
+  int     j;
+  int     k;
+  int     i;
+  int     v;
+  int     nelem;
+  int     aggtype;
+  int     dt_sec;
+  int     out_dt_sec;
+  double *aggdata;
+
+  dt_sec = global_param.dt*SECPHOUR;
+  if (out_data_file->out_step_ratio > 0)
+    out_dt_sec = out_data_file->out_dt*SECPHOUR;
+  else
+    out_dt_sec = out_data_file->step_count*dt_sec;
+
+  for (j=0; j<out_data_file->naggvars; j++) {
+    // The variable written from this slot
+    v = (j < out_data_file->nvars) ? out_data_file->varid[j] : out_data_file->aggvarid[j];
+    nelem = out_data[out_data_file->aggvarid[j]].nelem;
+    aggtype = out_data_file->aggtype[j];
+    aggdata = out_data_file->aggdata[j];
+
+    if (aggtype == AGG_TYPE_AVG && out_data_file->out_step_ratio == 0) {
+      for (i=0; i<nelem; i++)
+        aggdata[i] /= out_data_file->step_count;
+    }
+
+    // Aerodynamic resistance from the average conductance
+    if (out_data_file->aggvarid[j] != v)
+      aggdata[0] = 1/aggdata[0];
 
     /***********************************************
       Change of units for ALMA-compliant output
     ***********************************************/
     if (options.ALMA_OUTPUT) {
-      out_data[OUT_BASEFLOW].aggdata[0] /= out_dt_sec;
-      out_data[OUT_EVAP].aggdata[0] /= out_dt_sec;
-      out_data[OUT_EVAP_BARE].aggdata[0] /= out_dt_sec;
-      out_data[OUT_EVAP_CANOP].aggdata[0] /= out_dt_sec;
-      out_data[OUT_INFLOW].aggdata[0] /= out_dt_sec;
-      out_data[OUT_LAKE_BF_IN].aggdata[0] /= out_dt_sec;
-      out_data[OUT_LAKE_BF_IN_V].aggdata[0] /= out_dt_sec;
-      out_data[OUT_LAKE_BF_OUT].aggdata[0] /= out_dt_sec;
-      out_data[OUT_LAKE_BF_OUT_V].aggdata[0] /= out_dt_sec;
-      out_data[OUT_LAKE_CHAN_IN].aggdata[0] /= out_dt_sec;
-      out_data[OUT_LAKE_CHAN_IN_V].aggdata[0] /= out_dt_sec;
-      out_data[OUT_LAKE_CHAN_OUT].aggdata[0] /= out_dt_sec;
-      out_data[OUT_LAKE_CHAN_OUT_V].aggdata[0] /= out_dt_sec;
-      out_data[OUT_LAKE_DSTOR].aggdata[0] /= out_dt_sec;
-      out_data[OUT_LAKE_DSTOR_V].aggdata[0] /= out_dt_sec;
-      out_data[OUT_LAKE_DSWE].aggdata[0] /= out_dt_sec;
-      out_data[OUT_LAKE_DSWE_V].aggdata[0] /= out_dt_sec;
-      out_data[OUT_LAKE_EVAP].aggdata[0] /= out_dt_sec;
-      out_data[OUT_LAKE_EVAP_V].aggdata[0] /= out_dt_sec;
-      out_data[OUT_LAKE_ICE_TEMP].aggdata[0] += KELVIN;
-      out_data[OUT_LAKE_PREC_V].aggdata[0] /= out_dt_sec;
-      out_data[OUT_LAKE_RCHRG].aggdata[0] /= out_dt_sec;
-      out_data[OUT_LAKE_RCHRG_V].aggdata[0] /= out_dt_sec;
-      out_data[OUT_LAKE_RO_IN].aggdata[0] /= out_dt_sec;
-      out_data[OUT_LAKE_RO_IN_V].aggdata[0] /= out_dt_sec;
-      out_data[OUT_LAKE_VAPFLX].aggdata[0] /= out_dt_sec;
-      out_data[OUT_LAKE_VAPFLX_V].aggdata[0] /= out_dt_sec;
-      out_data[OUT_LAKE_SURF_TEMP].aggdata[0] += KELVIN;
-      out_data[OUT_PREC].aggdata[0] /= out_dt_sec;
-      out_data[OUT_RAINF].aggdata[0] /= out_dt_sec;
-      out_data[OUT_REFREEZE].aggdata[0] /= out_dt_sec;
-      out_data[OUT_RUNOFF].aggdata[0] /= out_dt_sec;
-      out_data[OUT_SNOW_MELT].aggdata[0] /= out_dt_sec;
-      out_data[OUT_SNOWF].aggdata[0] /= out_dt_sec;
-      out_data[OUT_SUB_BLOWING].aggdata[0] /= out_dt_sec;
-      out_data[OUT_SUB_CANOP].aggdata[0] /= out_dt_sec;
-      out_data[OUT_SUB_SNOW].aggdata[0] /= out_dt_sec;
-      out_data[OUT_SUB_SNOW].aggdata[0] += out_data[OUT_SUB_CANOP].aggdata[0];
-      out_data[OUT_SUB_SURFACE].aggdata[0] /= out_dt_sec;
-      out_data[OUT_TRANSP_VEG].aggdata[0] /= out_dt_sec;
-      out_data[OUT_BARESOILT].aggdata[0] += KELVIN;
-      out_data[OUT_SNOW_PACK_TEMP].aggdata[0] += KELVIN;
-      out_data[OUT_SNOW_SURF_TEMP].aggdata[0] += KELVIN;
-      for (index=0; index<options.Nlayer; index++) {
-        out_data[OUT_SOIL_TEMP].aggdata[index] += KELVIN;
-      }
-      for (index=0; index<options.Nnode; index++) {
-        out_data[OUT_SOIL_TNODE].aggdata[index] += KELVIN;
-        out_data[OUT_SOIL_TNODE_WL].aggdata[index] += KELVIN;
+      if (in_var_list(v, alma_rate_vars, N_ALMA_RATE_VARS))
+        aggdata[0] /= (aggtype == AGG_TYPE_SUM) ? out_dt_sec : dt_sec;
+      if (in_var_list(v, alma_temp_vars, N_ALMA_TEMP_VARS)) {
+        for (i=0; i<nelem; i++)
+          aggdata[i] += KELVIN;
       }
-      out_data[OUT_SURF_TEMP].aggdata[0] += KELVIN;
-      out_data[OUT_VEGT].aggdata[0] += KELVIN;
-      out_data[OUT_FDEPTH].aggdata[0] /= 100;
-      out_data[OUT_TDEPTH].aggdata[0] /= 100;
-      out_data[OUT_DELTACC].aggdata[0] *= out_dt_sec;
-      out_data[OUT_DELTAH].aggdata[0] *= out_dt_sec;
-      out_data[OUT_AIR_TEMP].aggdata[0] += KELVIN;
-      out_data[OUT_PRESSURE].aggdata[0] *= 1000;
-      out_data[OUT_VP].aggdata[0] *= 1000;
-      out_data[OUT_VPD].aggdata[0] *= 1000;
+      if (v == OUT_FDEPTH || v == OUT_TDEPTH)
+        aggdata[0] /= 100;
+      if (v == OUT_DELTACC || v == OUT_DELTAH)
+        aggdata[0] *= (aggtype == AGG_TYPE_AVG) ? out_dt_sec : dt_sec;
+      if (v == OUT_PRESSURE || v == OUT_VP || v == OUT_VPD)
+        aggdata[0] *= 1000;
     }
+  }
 
-    /*************
-      Write Data
-    *************/
-    if(rec >= skipyear) {
-      if (options.BINARY_OUTPUT) {
-        for (v=0; v<N_OUTVAR_TYPES; v++) {
-          for (i=0; i<out_data[v].nelem; i++) {
-            out_data[v].aggdata[i] *= out_data[v].mult;
-          }
+  // ALMA OUT_SUB_SNOW includes canopy sublimation
+  if (options.ALMA_OUTPUT) {
+    for (j=0; j<out_data_file->nvars; j++) {
+      if (out_data_file->varid[j] != OUT_SUB_SNOW) continue;
+      for (k=out_data_file->nvars; k<out_data_file->naggvars; k++) {
+        if (out_data_file->aggvarid[k] == OUT_SUB_CANOP) {
+          out_data_file->aggdata[j][0] += out_data_file->aggdata[k][0];
+          break;
         }
       }
-      write_data(out_data_files, out_data, dmy, global_param.out_dt);
     }
+  }
 
-    // Reset the step count
-    step_count = 0;
-
-    // Reset the agg data
-    for (v=0; v<N_OUTVAR_TYPES; v++) {
-      for (i=0; i<out_data[v].nelem; i++) {
-        out_data[v].aggdata[i] = 0;
-      }
+  if (options.BINARY_OUTPUT) {
+    for (j=0; j<out_data_file->nvars; j++) {
+      v = out_data_file->varid[j];
+      for (i=0; i<out_data[v].nelem; i++)
+        out_data_file->aggdata[j][i] *= out_data[v].mult;
     }
+  }
 
-  } // End of output procedure
+}
 
-  return (0);
+static void reset_output_aggregation(out_data_file_struct *out_data_file,
+                                     out_data_struct      *out_data)
+/**********************************************************************
+  reset_output_aggregation
+
+  Starts a new output interval of the output file.
+**********************************************************************/
+{
+  int j;
+  int i;
+
+  out_data_file->step_count = 0;
+  for (j=0; j<out_data_file->naggvars; j++) {
+    for (i=0; i<out_data[out_data_file->aggvarid[j]].nelem; i++)
+      out_data_file->aggdata[j][i] = 0;
+  }
+
+}
+
+static int in_var_list(int        v,
+                       const int *list,
+                       int        n)
+{
+  int i;
+
+  for (i=0; i<n; i++) {
+    if (list[i] == v) return TRUE;
+  }
+  return FALSE;
 
 }
 
@@ -814,6 +990,7 @@ void collect_wb_terms(cell_data_struct  cell,
   double tmp_ice;
   int index;
   int frost_area;
+  int p;
 
   AreaFactor = Cv * AreaFract * TreeAdjustFactor * lakefactor;
 
@@ -822,36 +999,44 @@ void collect_wb_terms(cell_data_struct  cell,
   for(index=0;index<options.Nlayer;index++) {
     tmp_evap += cell.layer[index].evap;
     if (HasVeg) {
-      out_data[OUT_EVAP_BARE].data[0] += cell.layer[index].evap * cell.layer[index].bare_evap_frac * AreaFactor;
-      out_data[OUT_TRANSP_VEG].data[0] += cell.layer[index].evap * (1-cell.layer[index].bare_evap_frac) * AreaFactor;
+      if (out_data[OUT_EVAP_BARE].active)
+        out_data[OUT_EVAP_BARE].data[0] += cell.layer[index].evap * cell.layer[index].bare_evap_frac * AreaFactor;
+      if (out_data[OUT_TRANSP_VEG].active)
+        out_data[OUT_TRANSP_VEG].data[0] += cell.layer[index].evap * (1-cell.layer[index].bare_evap_frac) * AreaFactor;
     }
-    else 
+    else if (out_data[OUT_EVAP_BARE].active)
       out_data[OUT_EVAP_BARE].data[0] += cell.layer[index].evap * AreaFactor;
   }
   tmp_evap += snow.vapor_flux * 1000.;
-  out_data[OUT_SUB_SNOW].data[0] += snow.vapor_flux * 1000. * AreaFactor; 
-  out_data[OUT_SUB_SURFACE].data[0] += snow.surface_flux * 1000. * AreaFactor; 
-  out_data[OUT_SUB_BLOWING].data[0] += snow.blowing_flux * 1000. * AreaFactor; 
+  if (out_data[OUT_SUB_SNOW].active)
+    out_data[OUT_SUB_SNOW].data[0] += snow.vapor_flux * 1000. * AreaFactor; 
+  if (out_data[OUT_SUB_SURFACE].active)
+    out_data[OUT_SUB_SURFACE].data[0] += snow.surface_flux * 1000. * AreaFactor; 
+  if (out_data[OUT_SUB_BLOWING].active)
+    out_data[OUT_SUB_BLOWING].data[0] += snow.blowing_flux * 1000. * AreaFactor; 
   if (HasVeg) {
     tmp_evap += snow.canopy_vapor_flux * 1000.;
-    out_data[OUT_SUB_CANOP].data[0] += snow.canopy_vapor_flux * 1000. * AreaFactor; 
+    if (out_data[OUT_SUB_CANOP].active)
+      out_data[OUT_SUB_CANOP].data[0] += snow.canopy_vapor_flux * 1000. * AreaFactor; 
   }
   if (HasVeg) {
     tmp_evap += veg_var.canopyevap;
-    out_data[OUT_EVAP_CANOP].data[0] += veg_var.canopyevap * AreaFactor; 
+    if (out_data[OUT_EVAP_CANOP].active)
+      out_data[OUT_EVAP_CANOP].data[0] += veg_var.canopyevap * AreaFactor; 
   }
   out_data[OUT_EVAP].data[0] += tmp_evap * AreaFactor; // mm over gridcell
 
   /** record potential evap **/
-  out_data[OUT_PET_SATSOIL].data[0] += cell.pot_evap[0] * AreaFactor;
-  out_data[OUT_PET_H2OSURF].data[0] += cell.pot_evap[1] * AreaFactor;
-  out_data[OUT_PET_SHORT].data[0] += cell.pot_evap[2] * AreaFactor;
-  out_data[OUT_PET_TALL].data[0] += cell.pot_evap[3] * AreaFactor;
-  out_data[OUT_PET_NATVEG].data[0] += cell.pot_evap[4] * AreaFactor;
-  out_data[OUT_PET_VEGNOCR].data[0] += cell.pot_evap[5] * AreaFactor;
+  if (options.OUTPUT_PET) {
+    for (p=0; p<N_PET_TYPES; p++) {
+      if (out_data[OUT_PET_SATSOIL+p].active)
+        out_data[OUT_PET_SATSOIL+p].data[0] += cell.pot_evap[p] * AreaFactor;
+    }
+  }
 
   /** record saturated area fraction **/
-  out_data[OUT_ASAT].data[0] += cell.asat * AreaFactor; 
+  if (out_data[OUT_ASAT].active)
+    out_data[OUT_ASAT].data[0] += cell.asat * AreaFactor; 
 
   /** record runoff **/
   out_data[OUT_RUNOFF].data[0]   += cell.runoff * AreaFactor;
@@ -860,17 +1045,20 @@ void collect_wb_terms(cell_data_struct  cell,
   out_data[OUT_BASEFLOW].data[0] += cell.baseflow * AreaFactor; 
 
   /** record inflow **/
-  out_data[OUT_INFLOW].data[0] += (cell.inflow) * AreaFactor;
+  if (out_data[OUT_INFLOW].active)
+    out_data[OUT_INFLOW].data[0] += (cell.inflow) * AreaFactor;
  
   /** record canopy interception **/
   if (HasVeg) 
     out_data[OUT_WDEW].data[0] += veg_var.Wdew * AreaFactor;
 
   /** record LAI **/
-  out_data[OUT_LAI].data[0] += veg_var.LAI * AreaFactor;
+  if (out_data[OUT_LAI].active)
+    out_data[OUT_LAI].data[0] += veg_var.LAI * AreaFactor;
 
   /** record vegcover **/
-  out_data[OUT_VEGCOVER].data[0] += veg_var.vegcover * AreaFactor;
+  if (out_data[OUT_VEGCOVER].active)
+    out_data[OUT_VEGCOVER].data[0] += veg_var.vegcover * AreaFactor;
 
   /** record aerodynamic conductance and resistance **/
   if (cell.aero_resist[0] > SMALL) {
@@ -879,7 +1067,8 @@ void collect_wb_terms(cell_data_struct  cell,
   else {
     tmp_cond1 = HUGE_RESIST;
   }
-  out_data[OUT_AERO_COND1].data[0] += tmp_cond1;
+  if (out_data[OUT_AERO_COND1].active)
+    out_data[OUT_AERO_COND1].data[0] += tmp_cond1;
   if (overstory) {
     if (cell.aero_resist[1] > SMALL) {
       tmp_cond2 = (1/cell.aero_resist[1]) * AreaFactor;
@@ -887,13 +1076,16 @@ void collect_wb_terms(cell_data_struct  cell,
     else {
       tmp_cond2 = HUGE_RESIST;
     }
-    out_data[OUT_AERO_COND2].data[0] += tmp_cond2;
-  }
-  if (overstory) {
-    out_data[OUT_AERO_COND].data[0] += tmp_cond2;
+    if (out_data[OUT_AERO_COND2].active)
+      out_data[OUT_AERO_COND2].data[0] += tmp_cond2;
   }
-  else {
-    out_data[OUT_AERO_COND].data[0] += tmp_cond1;
+  if (out_data[OUT_AERO_COND].active) {
+    if (overstory) {
+      out_data[OUT_AERO_COND].data[0] += tmp_cond2;
+    }
+    else {
+      out_data[OUT_AERO_COND].data[0] += tmp_cond1;
+    }
   }
 
   /** record layer moistures **/
@@ -910,16 +1102,22 @@ void collect_wb_terms(cell_data_struct  cell,
     out_data[OUT_SOIL_LIQ].data[index] += tmp_moist * AreaFactor;
     out_data[OUT_SOIL_ICE].data[index] += tmp_ice * AreaFactor;
   }
-  out_data[OUT_SOIL_WET].data[0] += cell.wetness * AreaFactor;
-  out_data[OUT_ROOTMOIST].data[0] += cell.rootmoist * AreaFactor;
+  if (out_data[OUT_SOIL_WET].active)
+    out_data[OUT_SOIL_WET].data[0] += cell.wetness * AreaFactor;
+  if (out_data[OUT_ROOTMOIST].active)
+    out_data[OUT_ROOTMOIST].data[0] += cell.rootmoist * AreaFactor;
 
   /** record water table position **/
-  out_data[OUT_ZWT].data[0] += cell.zwt * AreaFactor;
-  out_data[OUT_ZWT_LUMPED].data[0] += cell.zwt_lumped * AreaFactor;
+  if (out_data[OUT_ZWT].active)
+    out_data[OUT_ZWT].data[0] += cell.zwt * AreaFactor;
+  if (out_data[OUT_ZWT_LUMPED].active)
+    out_data[OUT_ZWT_LUMPED].data[0] += cell.zwt_lumped * AreaFactor;
 
   /** record layer temperatures **/
-  for(index=0;index<options.Nlayer;index++) {
-    out_data[OUT_SOIL_TEMP].data[index] += cell.layer[index].T * AreaFactor;
+  if (out_data[OUT_SOIL_TEMP].active) {
+    for(index=0;index<options.Nlayer;index++) {
+      out_data[OUT_SOIL_TEMP].data[index] += cell.layer[index].T * AreaFactor;
+    }
   }
 
   /*****************************
@@ -930,13 +1128,17 @@ void collect_wb_terms(cell_data_struct  cell,
   out_data[OUT_SWE].data[0] += snow.swq * AreaFactor * 1000.;
   
   /** record snowpack depth **/
-  out_data[OUT_SNOW_DEPTH].data[0] += snow.depth * AreaFactor * 100.;
+  if (out_data[OUT_SNOW_DEPTH].active)
+    out_data[OUT_SNOW_DEPTH].data[0] += snow.depth * AreaFactor * 100.;
   
   /** record snowpack albedo, temperature **/
   if (snow.swq> 0.0) {
-    out_data[OUT_SALBEDO].data[0] += snow.albedo * AreaFactor;
-    out_data[OUT_SNOW_SURF_TEMP].data[0] += snow.surf_temp * AreaFactor;
-    out_data[OUT_SNOW_PACK_TEMP].data[0] += snow.pack_temp * AreaFactor;
+    if (out_data[OUT_SALBEDO].active)
+      out_data[OUT_SALBEDO].data[0] += snow.albedo * AreaFactor;
+    if (out_data[OUT_SNOW_SURF_TEMP].active)
+      out_data[OUT_SNOW_SURF_TEMP].data[0] += snow.surf_temp * AreaFactor;
+    if (out_data[OUT_SNOW_PACK_TEMP].active)
+      out_data[OUT_SNOW_PACK_TEMP].data[0] += snow.pack_temp * AreaFactor;
   }
 
   /** record canopy intercepted snow **/
@@ -944,25 +1146,36 @@ void collect_wb_terms(cell_data_struct  cell,
     out_data[OUT_SNOW_CANOPY].data[0] += (snow.snow_canopy) * AreaFactor * 1000.;
 
   /** record snowpack melt **/
-  out_data[OUT_SNOW_MELT].data[0] += snow.melt * AreaFactor;
+  if (out_data[OUT_SNOW_MELT].active)
+    out_data[OUT_SNOW_MELT].data[0] += snow.melt * AreaFactor;
 
   /** record snow cover fraction **/
-  out_data[OUT_SNOW_COVER].data[0] += snow.coverage * AreaFactor;
+  if (out_data[OUT_SNOW_COVER].active)
+    out_data[OUT_SNOW_COVER].data[0] += snow.coverage * AreaFactor;
 
   /*****************************
     Record Carbon Cycling Variables 
   *****************************/
   if (options.CARBON) {
 
-    out_data[OUT_APAR].data[0] += veg_var.aPAR * AreaFactor;
-    out_data[OUT_GPP].data[0] += veg_var.GPP * MCg * SEC_PER_DAY * AreaFactor;
-    out_data[OUT_RAUT].data[0] += veg_var.Raut * MCg * SEC_PER_DAY * AreaFactor;
-    out_data[OUT_NPP].data[0] += veg_var.NPP * MCg * SEC_PER_DAY * AreaFactor;
-    out_data[OUT_LITTERFALL].data[0] += veg_var.Litterfall * AreaFactor;
-    out_data[OUT_RHET].data[0] += cell.RhTot * AreaFactor;
-    out_data[OUT_CLITTER].data[0] += cell.CLitter * AreaFactor;
-    out_data[OUT_CINTER].data[0] += cell.CInter * AreaFactor;
-    out_data[OUT_CSLOW].data[0] += cell.CSlow * AreaFactor;
+    if (out_data[OUT_APAR].active)
+      out_data[OUT_APAR].data[0] += veg_var.aPAR * AreaFactor;
+    if (out_data[OUT_GPP].active)
+      out_data[OUT_GPP].data[0] += veg_var.GPP * MCg * SEC_PER_DAY * AreaFactor;
+    if (out_data[OUT_RAUT].active)
+      out_data[OUT_RAUT].data[0] += veg_var.Raut * MCg * SEC_PER_DAY * AreaFactor;
+    if (out_data[OUT_NPP].active)
+      out_data[OUT_NPP].data[0] += veg_var.NPP * MCg * SEC_PER_DAY * AreaFactor;
+    if (out_data[OUT_LITTERFALL].active)
+      out_data[OUT_LITTERFALL].data[0] += veg_var.Litterfall * AreaFactor;
+    if (out_data[OUT_RHET].active)
+      out_data[OUT_RHET].data[0] += cell.RhTot * AreaFactor;
+    if (out_data[OUT_CLITTER].active)
+      out_data[OUT_CLITTER].data[0] += cell.CLitter * AreaFactor;
+    if (out_data[OUT_CINTER].active)
+      out_data[OUT_CINTER].data[0] += cell.CInter * AreaFactor;
+    if (out_data[OUT_CSLOW].active)
+      out_data[OUT_CSLOW].data[0] += cell.CSlow * AreaFactor;
 
   }
 
@@ -1008,18 +1221,20 @@ void collect_eb_terms(energy_bal_struct energy,
   /** record freezing and thawing front depths **/
   if(options.FROZEN_SOIL) {
     for(index = 0; index < MAX_FRONTS; index++) {
-      if(energy.fdepth[index] != MISSING)
+      if(energy.fdepth[index] != MISSING && out_data[OUT_FDEPTH].active)
         out_data[OUT_FDEPTH].data[index] += energy.fdepth[index] * AreaFactor * 100.;
-      if(energy.tdepth[index] != MISSING)
+      if(energy.tdepth[index] != MISSING && out_data[OUT_TDEPTH].active)
         out_data[OUT_TDEPTH].data[index] += energy.tdepth[index] * AreaFactor * 100.;
     }
   }
 
-  tmp_fract = 0;
-  for ( frost_area = 0; frost_area < options.Nfrost; frost_area++ )
-    if ( cell_wet.layer[0].ice[frost_area] )
-      tmp_fract  += frost_fract[frost_area];
-  out_data[OUT_SURF_FROST_FRAC].data[0] += tmp_fract * AreaFactor;
+  if (out_data[OUT_SURF_FROST_FRAC].active) {
+    tmp_fract = 0;
+    for ( frost_area = 0; frost_area < options.Nfrost; frost_area++ )
+      if ( cell_wet.layer[0].ice[frost_area] )
+        tmp_fract  += frost_fract[frost_area];
+    out_data[OUT_SURF_FROST_FRAC].data[0] += tmp_fract * AreaFactor;
+  }
 
   tmp_fract = 0;
   if ( (energy.T[0] + frost_slope / 2.) > 0 ) {
@@ -1046,9 +1261,10 @@ void collect_eb_terms(energy_bal_struct energy,
   /** record landcover temperature **/
   if(!HasVeg) {
     // landcover is bare soil
-    out_data[OUT_BARESOILT].data[0] += (rad_temp-KELVIN) * AreaFactor;
+    if (out_data[OUT_BARESOILT].active)
+      out_data[OUT_BARESOILT].data[0] += (rad_temp-KELVIN) * AreaFactor;
   }
-  else {
+  else if (out_data[OUT_VEGT].active) {
     // landcover is vegetation
     if ( overstory && !snow.snow )
       // here, rad_temp will be wrong since it will pick the understory temperature
@@ -1058,96 +1274,127 @@ void collect_eb_terms(energy_bal_struct energy,
   }
 
   /** record mean surface temperature [C]  **/
-  out_data[OUT_SURF_TEMP].data[0] += surf_temp * AreaFactor;
+  if (out_data[OUT_SURF_TEMP].active)
+    out_data[OUT_SURF_TEMP].data[0] += surf_temp * AreaFactor;
   
   /** record thermal node temperatures **/
-  for(index=0;index<options.Nnode;index++) {
-    out_data[OUT_SOIL_TNODE].data[index] += energy.T[index] * AreaFactor;
+  if (out_data[OUT_SOIL_TNODE].active) {
+    for(index=0;index<options.Nnode;index++) {
+      out_data[OUT_SOIL_TNODE].data[index] += energy.T[index] * AreaFactor;
+    }
   }
-  if (IsWet) {
+  if (IsWet && out_data[OUT_SOIL_TNODE_WL].active) {
     for(index=0;index<options.Nnode;index++) {
       out_data[OUT_SOIL_TNODE_WL].data[index] = energy.T[index];
     }
   }
 
   /** record temperature flags  **/
-  out_data[OUT_SURFT_FBFLAG].data[0] += energy.Tsurf_fbflag * AreaFactor;
+  if (out_data[OUT_SURFT_FBFLAG].active)
+    out_data[OUT_SURFT_FBFLAG].data[0] += energy.Tsurf_fbflag * AreaFactor;
   *Tsurf_fbcount_total += energy.Tsurf_fbcount;
   for (index=0; index<options.Nnode; index++) {
-    out_data[OUT_SOILT_FBFLAG].data[index] += energy.T_fbflag[index] * AreaFactor;
     *Tsoil_fbcount_total += energy.T_fbcount[index];
   }
-  out_data[OUT_SNOWT_FBFLAG].data[0] += snow.surf_temp_fbflag * AreaFactor;
+  if (out_data[OUT_SOILT_FBFLAG].active) {
+    for (index=0; index<options.Nnode; index++) {
+      out_data[OUT_SOILT_FBFLAG].data[index] += energy.T_fbflag[index] * AreaFactor;
+    }
+  }
+  if (out_data[OUT_SNOWT_FBFLAG].active)
+    out_data[OUT_SNOWT_FBFLAG].data[0] += snow.surf_temp_fbflag * AreaFactor;
   *Tsnowsurf_fbcount_total += snow.surf_temp_fbcount;
-  out_data[OUT_TFOL_FBFLAG].data[0] += energy.Tfoliage_fbflag * AreaFactor;
+  if (out_data[OUT_TFOL_FBFLAG].active)
+    out_data[OUT_TFOL_FBFLAG].data[0] += energy.Tfoliage_fbflag * AreaFactor;
   *Tfoliage_fbcount_total += energy.Tfoliage_fbcount;
-  out_data[OUT_TCAN_FBFLAG].data[0] += energy.Tcanopy_fbflag * AreaFactor;
+  if (out_data[OUT_TCAN_FBFLAG].active)
+    out_data[OUT_TCAN_FBFLAG].data[0] += energy.Tcanopy_fbflag * AreaFactor;
   *Tcanopy_fbcount_total += energy.Tcanopy_fbcount;
 
   /** record net shortwave radiation **/
-  out_data[OUT_NET_SHORT].data[0] += energy.NetShortAtmos * AreaFactor;
+  if (out_data[OUT_NET_SHORT].active)
+    out_data[OUT_NET_SHORT].data[0] += energy.NetShortAtmos * AreaFactor;
 
   /** record net longwave radiation **/
-  out_data[OUT_NET_LONG].data[0]  += energy.NetLongAtmos * AreaFactor;
+  if (out_data[OUT_NET_LONG].active)
+    out_data[OUT_NET_LONG].data[0]  += energy.NetLongAtmos * AreaFactor;
 
   /** record incoming longwave radiation at ground surface (under veg) **/
-  if ( snow.snow && overstory )
-    out_data[OUT_IN_LONG].data[0] += energy.LongOverIn * AreaFactor;
-  else
-    out_data[OUT_IN_LONG].data[0] += energy.LongUnderIn * AreaFactor;
+  if (out_data[OUT_IN_LONG].active) {
+    if ( snow.snow && overstory )
+      out_data[OUT_IN_LONG].data[0] += energy.LongOverIn * AreaFactor;
+    else
+      out_data[OUT_IN_LONG].data[0] += energy.LongUnderIn * AreaFactor;
+  }
 
   /** record albedo **/
-  if ( snow.snow && overstory )
-    out_data[OUT_ALBEDO].data[0]    += energy.AlbedoOver * AreaFactor;
-  else
-    out_data[OUT_ALBEDO].data[0]    += energy.AlbedoUnder * AreaFactor;
+  if (out_data[OUT_ALBEDO].active) {
+    if ( snow.snow && overstory )
+      out_data[OUT_ALBEDO].data[0]    += energy.AlbedoOver * AreaFactor;
+    else
+      out_data[OUT_ALBEDO].data[0]    += energy.AlbedoUnder * AreaFactor;
+  }
 
   /** record latent heat flux **/
-  out_data[OUT_LATENT].data[0]    -= energy.AtmosLatent * AreaFactor;
+  if (out_data[OUT_LATENT].active)
+    out_data[OUT_LATENT].data[0]    -= energy.AtmosLatent * AreaFactor;
 
   /** record latent heat flux from sublimation **/
-  out_data[OUT_LATENT_SUB].data[0] -= energy.AtmosLatentSub * AreaFactor;
+  if (out_data[OUT_LATENT_SUB].active)
+    out_data[OUT_LATENT_SUB].data[0] -= energy.AtmosLatentSub * AreaFactor;
 
   /** record sensible heat flux **/
-  out_data[OUT_SENSIBLE].data[0]  -= energy.AtmosSensible * AreaFactor;
+  if (out_data[OUT_SENSIBLE].active)
+    out_data[OUT_SENSIBLE].data[0]  -= energy.AtmosSensible * AreaFactor;
 
   /** record ground heat flux (+ heat storage) **/
-  out_data[OUT_GRND_FLUX].data[0] -= energy.grnd_flux * AreaFactor;
+  if (out_data[OUT_GRND_FLUX].active)
+    out_data[OUT_GRND_FLUX].data[0] -= energy.grnd_flux * AreaFactor;
 
   /** record heat storage **/
-  out_data[OUT_DELTAH].data[0]    -= energy.deltaH * AreaFactor;
+  if (out_data[OUT_DELTAH].active)
+    out_data[OUT_DELTAH].data[0]    -= energy.deltaH * AreaFactor;
 
   /** record heat of fusion **/
-  out_data[OUT_FUSION].data[0]    -= energy.fusion * AreaFactor;
+  if (out_data[OUT_FUSION].active)
+    out_data[OUT_FUSION].data[0]    -= energy.fusion * AreaFactor;
 
 //  /** record energy balance error **/
 //  out_data[OUT_ENERGY_ERROR].data[0] += energy.error * AreaFactor;
 
   /** record radiative effective temperature [K], 
       emissivities set = 1.0  **/
-  out_data[OUT_RAD_TEMP].data[0] += ((rad_temp) * (rad_temp) * (rad_temp) * (rad_temp)) * AreaFactor;
+  if (out_data[OUT_RAD_TEMP].active)
+    out_data[OUT_RAD_TEMP].data[0] += ((rad_temp) * (rad_temp) * (rad_temp) * (rad_temp)) * AreaFactor;
   
   /** record snowpack cold content **/
-  out_data[OUT_DELTACC].data[0] += energy.deltaCC * AreaFactor;
+  if (out_data[OUT_DELTACC].active)
+    out_data[OUT_DELTACC].data[0] += energy.deltaCC * AreaFactor;
   
   /** record snowpack advection **/
-  if (snow.snow && overstory)
-    out_data[OUT_ADVECTION].data[0] += energy.canopy_advection * AreaFactor;
-  out_data[OUT_ADVECTION].data[0] += energy.advection * AreaFactor;
+  if (out_data[OUT_ADVECTION].active) {
+    if (snow.snow && overstory)
+      out_data[OUT_ADVECTION].data[0] += energy.canopy_advection * AreaFactor;
+    out_data[OUT_ADVECTION].data[0] += energy.advection * AreaFactor;
+  }
   
   /** record snow energy flux **/
-  out_data[OUT_SNOW_FLUX].data[0] += energy.snow_flux * AreaFactor;
+  if (out_data[OUT_SNOW_FLUX].active)
+    out_data[OUT_SNOW_FLUX].data[0] += energy.snow_flux * AreaFactor;
   
   /** record refreeze energy **/
-  if (snow.snow && overstory)
-    out_data[OUT_RFRZ_ENERGY].data[0] += energy.canopy_refreeze * AreaFactor;
-  out_data[OUT_RFRZ_ENERGY].data[0] += energy.refreeze_energy * AreaFactor;
+  if (out_data[OUT_RFRZ_ENERGY].active) {
+    if (snow.snow && overstory)
+      out_data[OUT_RFRZ_ENERGY].data[0] += energy.canopy_refreeze * AreaFactor;
+    out_data[OUT_RFRZ_ENERGY].data[0] += energy.refreeze_energy * AreaFactor;
+  }
 
   /** record melt energy **/
-  out_data[OUT_MELT_ENERGY].data[0] += energy.melt_energy * AreaFactor;
+  if (out_data[OUT_MELT_ENERGY].active)
+    out_data[OUT_MELT_ENERGY].data[0] += energy.melt_energy * AreaFactor;
 
   /** record advected sensible heat energy **/
-  if ( !overstory )
+  if ( !overstory && out_data[OUT_ADV_SENS].active )
     out_data[OUT_ADV_SENS].data[0] -= energy.advected_sensible * AreaFactor;
  
   /**********************************
@@ -1155,67 +1402,87 @@ void collect_eb_terms(energy_bal_struct energy,
   **********************************/
 
   /** record band snow water equivalent **/
-  out_data[OUT_SWE_BAND].data[band] += snow.swq * Cv * lakefactor * 1000.;
+  if (out_data[OUT_SWE_BAND].active)
+    out_data[OUT_SWE_BAND].data[band] += snow.swq * Cv * lakefactor * 1000.;
 
   /** record band snowpack depth **/
-  out_data[OUT_SNOW_DEPTH_BAND].data[band] += snow.depth * Cv * lakefactor * 100.;
+  if (out_data[OUT_SNOW_DEPTH_BAND].active)
+    out_data[OUT_SNOW_DEPTH_BAND].data[band] += snow.depth * Cv * lakefactor * 100.;
 
   /** record band canopy intercepted snow **/
-  if (HasVeg)
+  if (HasVeg && out_data[OUT_SNOW_CANOPY_BAND].active)
     out_data[OUT_SNOW_CANOPY_BAND].data[band] += (snow.snow_canopy) * Cv * lakefactor * 1000.;
 
   /** record band snow melt **/
-  out_data[OUT_SNOW_MELT_BAND].data[band] += snow.melt * Cv * lakefactor;
+  if (out_data[OUT_SNOW_MELT_BAND].active)
+    out_data[OUT_SNOW_MELT_BAND].data[band] += snow.melt * Cv * lakefactor;
 
   /** record band snow coverage **/
-  out_data[OUT_SNOW_COVER_BAND].data[band] += snow.coverage * Cv * lakefactor;
+  if (out_data[OUT_SNOW_COVER_BAND].active)
+    out_data[OUT_SNOW_COVER_BAND].data[band] += snow.coverage * Cv * lakefactor;
 
   /** record band cold content **/
-  out_data[OUT_DELTACC_BAND].data[band] += energy.deltaCC * Cv * lakefactor;
+  if (out_data[OUT_DELTACC_BAND].active)
+    out_data[OUT_DELTACC_BAND].data[band] += energy.deltaCC * Cv * lakefactor;
     
   /** record band advection **/
-  out_data[OUT_ADVECTION_BAND].data[band] += energy.advection * Cv * lakefactor;
+  if (out_data[OUT_ADVECTION_BAND].active)
+    out_data[OUT_ADVECTION_BAND].data[band] += energy.advection * Cv * lakefactor;
     
   /** record band snow flux **/
-  out_data[OUT_SNOW_FLUX_BAND].data[band] += energy.snow_flux * Cv * lakefactor;
+  if (out_data[OUT_SNOW_FLUX_BAND].active)
+    out_data[OUT_SNOW_FLUX_BAND].data[band] += energy.snow_flux * Cv * lakefactor;
     
   /** record band refreeze energy **/
-  out_data[OUT_RFRZ_ENERGY_BAND].data[band] += energy.refreeze_energy * Cv * lakefactor;
+  if (out_data[OUT_RFRZ_ENERGY_BAND].active)
+    out_data[OUT_RFRZ_ENERGY_BAND].data[band] += energy.refreeze_energy * Cv * lakefactor;
     
   /** record band melt energy **/
-  out_data[OUT_MELT_ENERGY_BAND].data[band] += energy.melt_energy * Cv * lakefactor;
+  if (out_data[OUT_MELT_ENERGY_BAND].active)
+    out_data[OUT_MELT_ENERGY_BAND].data[band] += energy.melt_energy * Cv * lakefactor;
 
   /** record band advected sensble heat **/
-  out_data[OUT_ADV_SENS_BAND].data[band] -= energy.advected_sensible * Cv * lakefactor;
+  if (out_data[OUT_ADV_SENS_BAND].active)
+    out_data[OUT_ADV_SENS_BAND].data[band] -= energy.advected_sensible * Cv * lakefactor;
 
   /** record surface layer temperature **/
-  out_data[OUT_SNOW_SURFT_BAND].data[band] += snow.surf_temp * Cv * lakefactor;
+  if (out_data[OUT_SNOW_SURFT_BAND].active)
+    out_data[OUT_SNOW_SURFT_BAND].data[band] += snow.surf_temp * Cv * lakefactor;
 
   /** record pack layer temperature **/
-  out_data[OUT_SNOW_PACKT_BAND].data[band] += snow.pack_temp * Cv * lakefactor;
+  if (out_data[OUT_SNOW_PACKT_BAND].active)
+    out_data[OUT_SNOW_PACKT_BAND].data[band] += snow.pack_temp * Cv * lakefactor;
 
   /** record latent heat of sublimation **/
-  out_data[OUT_LATENT_SUB_BAND].data[band] += energy.latent_sub * Cv * lakefactor;
+  if (out_data[OUT_LATENT_SUB_BAND].active)
+    out_data[OUT_LATENT_SUB_BAND].data[band] += energy.latent_sub * Cv * lakefactor;
 
   /** record band net downwards shortwave radiation **/
-  out_data[OUT_NET_SHORT_BAND].data[band] += energy.NetShortAtmos * Cv * lakefactor;
+  if (out_data[OUT_NET_SHORT_BAND].active)
+    out_data[OUT_NET_SHORT_BAND].data[band] += energy.NetShortAtmos * Cv * lakefactor;
 
   /** record band net downwards longwave radiation **/
-  out_data[OUT_NET_LONG_BAND].data[band] += energy.NetLongAtmos * Cv * lakefactor;
+  if (out_data[OUT_NET_LONG_BAND].active)
+    out_data[OUT_NET_LONG_BAND].data[band] += energy.NetLongAtmos * Cv * lakefactor;
 
   /** record band albedo **/
-  if (snow.snow && overstory)
-    out_data[OUT_ALBEDO_BAND].data[band] += energy.AlbedoOver * Cv * lakefactor;
-  else
-    out_data[OUT_ALBEDO_BAND].data[band] += energy.AlbedoUnder * Cv * lakefactor;
+  if (out_data[OUT_ALBEDO_BAND].active) {
+    if (snow.snow && overstory)
+      out_data[OUT_ALBEDO_BAND].data[band] += energy.AlbedoOver * Cv * lakefactor;
+    else
+      out_data[OUT_ALBEDO_BAND].data[band] += energy.AlbedoUnder * Cv * lakefactor;
+  }
 
   /** record band net latent heat flux **/
-  out_data[OUT_LATENT_BAND].data[band] -= energy.latent * Cv * lakefactor;
+  if (out_data[OUT_LATENT_BAND].active)
+    out_data[OUT_LATENT_BAND].data[band] -= energy.latent * Cv * lakefactor;
 
   /** record band net sensible heat flux **/
-  out_data[OUT_SENSIBLE_BAND].data[band] -= energy.sensible * Cv * lakefactor;
+  if (out_data[OUT_SENSIBLE_BAND].active)
+    out_data[OUT_SENSIBLE_BAND].data[band] -= energy.sensible * Cv * lakefactor;
 
   /** record band net ground heat flux **/
-  out_data[OUT_GRND_FLUX_BAND].data[band] -= energy.grnd_flux * Cv * lakefactor;
+  if (out_data[OUT_GRND_FLUX_BAND].active)
+    out_data[OUT_GRND_FLUX_BAND].data[band] -= energy.grnd_flux * Cv * lakefactor;
 
 }
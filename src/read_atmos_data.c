@@ -1,10 +1,28 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#include <float.h>
 #include <vicNl.h>
 
 static char vcid[] = "$Id$";
 
+#define READ_BLOCK_SIZE 65536
+
+/* ASCII forcing file being read in blocks: the unparsed text is
+   buf[ptr - buf, end - buf), followed by a NUL */
+typedef struct {
+  FILE   *fh;
+  char   *buf;
+  size_t  size;   /* allocated size of buf, without the NUL */
+  char   *ptr;    /* next character to be parsed */
+  char   *end;    /* end of the text read so far */
+  int     eof;    /* TRUE once the end of the file has been read */
+} text_block_struct;
+
+static void fill_text_block(text_block_struct *);
+static int  parse_double(char **, double *);
+
 void read_atmos_data(FILE                 *infile,
 		     global_param_struct   global_param,
 		     int                   file_num,
@@ -60,23 +78,46 @@ void read_atmos_data(FILE                 *infile,
   2014-Apr-25 Added non-climatological veg parameters (as forcing
 	      variables).						TJB
   2014-Apr-25 Added partial vegcover fraction.				TJB
+  2015-Feb-02 BINARY forcings are now read with a single fread() of
+	      all required records, byte-swapped in one pass over the
+	      whole block if necessary, and converted to doubles one
+	      field (column) at a time.  Only complete records are
+	      counted when checking that the file is long enough.	GT
+  2015-Feb-02 ASCII forcings are now read into memory in large blocks
+	      and parsed with parse_double() instead of fscanf(); header
+	      records are skipped by scanning for newlines.  Results are
+	      identical to strtod().					GT
+  2015-Feb-02 ASCII blocks are read only as far as needed: reading
+	      stops once the records of the simulation period have been
+	      parsed, instead of loading the rest of the file.		GT
 
   **********************************************************************/
 {
   
   extern option_struct options;
-  extern param_set_struct param_set;
+  extern THREAD_LOCAL param_set_struct param_set;
   
   int             rec;
+  int             Nrecs;
   int             skip_recs;
   int             i,j;
+  int             r;
   int             endian;
   int             fields;
   int             Nfields;
   int             day=0;
   int            *field_index;
+  int             reclen;
+  int             nelem[N_FORCING_TYPES];
+  int             offset;
+  unsigned short *block;
+  unsigned short *column;
+  double         *data;
+  double          multiplier;
+  text_block_struct text;
+  char           *eol;
+  int             ok;
   unsigned short  ustmp;
-  signed short    stmp;
   char            str[MAXSTRING+1];
   char            ErrStr[MAXSTRING+1];
   unsigned short  Identifier[4];
@@ -155,55 +196,57 @@ void read_atmos_data(FILE                 *infile,
       nrerror("No data for the specified time period in the forcing file.  Model stopping...");
 	  
     /** Read BINARY forcing data **/
-    rec = 0;
-	  
-    while ( !feof(infile) && (rec * param_set.FORCE_DT[file_num] 
-			      < global_param.nrecs * global_param.dt) ) {
 
-      for(i=0;i<Nfields;i++) {
-        if (field_index[i] != ALBEDO && field_index[i] != LAI_IN && field_index[i] != VEGCOVER) {
-	  if(param_set.TYPE[field_index[i]].SIGNED) {
-	    fread(&stmp,sizeof(short int),1,infile);
-	    if (endian != param_set.FORCE_ENDIAN[file_num]) {
-	      stmp = ((stmp & 0xFF) << 8) | ((stmp >> 8) & 0xFF);
-	    }
-	    forcing_data[field_index[i]][rec] 
-	      = (double)stmp / param_set.TYPE[field_index[i]].multiplier;
-	  }
-	  else {
-	    fread(&ustmp,sizeof(unsigned short int),1,infile);
-	    if (endian != param_set.FORCE_ENDIAN[file_num]) {
-	      ustmp = ((ustmp & 0xFF) << 8) | ((ustmp >> 8) & 0xFF);
-	    }
-	    forcing_data[field_index[i]][rec] 
-	      = (double)ustmp / param_set.TYPE[field_index[i]].multiplier;
-	  }
-	}
-	else {
-          for(j=0;j<param_set.TYPE[field_index[i]].N_ELEM;j++) {
-	    if(param_set.TYPE[field_index[i]].SIGNED) {
-	      fread(&stmp,sizeof(short int),1,infile);
-	      if (endian != param_set.FORCE_ENDIAN[file_num]) {
-	        stmp = ((stmp & 0xFF) << 8) | ((stmp >> 8) & 0xFF);
-	      }
-	      veg_hist_data[field_index[i]][j][rec] 
-	        = (double)stmp / param_set.TYPE[field_index[i]].multiplier;
-	    }
-	    else {
-	      fread(&ustmp,sizeof(unsigned short int),1,infile);
-	      if (endian != param_set.FORCE_ENDIAN[file_num]) {
-	        ustmp = ((ustmp & 0xFF) << 8) | ((ustmp >> 8) & 0xFF);
-	      }
-	      veg_hist_data[field_index[i]][j][rec] 
-	        = (double)ustmp / param_set.TYPE[field_index[i]].multiplier;
-	    }
-          }
-	}
+    /* number of values per record; veg-dependent fields have one
+       value per veg tile */
+    reclen = 0;
+    for(i=0;i<Nfields;i++) {
+      if (field_index[i] != ALBEDO && field_index[i] != LAI_IN && field_index[i] != VEGCOVER)
+        nelem[i] = 1;
+      else
+        nelem[i] = param_set.TYPE[field_index[i]].N_ELEM;
+      reclen += nelem[i];
+    }
+
+    /* number of records needed to cover the simulation period */
+    Nrecs = (global_param.nrecs * global_param.dt + param_set.FORCE_DT[file_num] - 1)
+      / param_set.FORCE_DT[file_num];
+
+    /* read them all at once */
+    block = (unsigned short *)malloc((size_t)Nrecs*reclen*sizeof(unsigned short));
+    if (block == NULL)
+      nrerror("Memory allocation error in read_atmos_data().");
+    rec = (int)fread(block, reclen*sizeof(unsigned short), Nrecs, infile);
+
+    /* swap bytes of the whole block in one pass */
+    if (endian != param_set.FORCE_ENDIAN[file_num]) {
+      for (r=0; r<rec*reclen; r++)
+        block[r] = (unsigned short)((block[r] << 8) | (block[r] >> 8));
+    }
+
+    /* convert to model values, one field at a time */
+    offset = 0;
+    for(i=0;i<Nfields;i++) {
+      multiplier = param_set.TYPE[field_index[i]].multiplier;
+      for(j=0;j<nelem[i];j++) {
+        if (field_index[i] != ALBEDO && field_index[i] != LAI_IN && field_index[i] != VEGCOVER)
+          data = forcing_data[field_index[i]];
+        else
+          data = veg_hist_data[field_index[i]][j];
+        column = block + offset;
+        if(param_set.TYPE[field_index[i]].SIGNED) {
+          for (r=0; r<rec; r++)
+            data[r] = (double)(signed short)column[r*reclen] / multiplier;
+        }
+        else {
+          for (r=0; r<rec; r++)
+            data[r] = (double)column[r*reclen] / multiplier;
+        }
+        offset++;
       }
-			
-      rec++;
-			
     }
+
+    free((char *)block);
   }
 
   /**************************
@@ -219,30 +262,50 @@ void read_atmos_data(FILE                 *infile,
     // and to any other functions that read the files, so that those functions could
     // also read the headers if necessary).
 
+    text.fh   = infile;
+    text.size = READ_BLOCK_SIZE;
+    text.buf  = (char *)malloc(text.size + 1);
+    if (text.buf == NULL)
+      nrerror("Memory allocation error in read_atmos_data().");
+    text.ptr  = text.end = text.buf;
+    *text.end = '\0';
+    text.eof  = FALSE;
+
     /* skip to the beginning of the required met data */
     for(i=0;i<skip_recs;i++){
-      if( fgets(str, MAXSTRING, infile) == NULL )
+      fill_text_block(&text);
+      if( text.ptr >= text.end )
 	nrerror("No data for the specified time period in the forcing file.  Model stopping...");
+      eol = (char *)memchr(text.ptr, '\n', text.end - text.ptr);
+      text.ptr = (eol == NULL) ? text.end : eol + 1;
     }
 	  
     /* read forcing data */
     rec=0;
 
-    while( !feof(infile) && (rec * param_set.FORCE_DT[file_num] 
-			      < global_param.nrecs * global_param.dt ) ) {
-      for(i=0;i<Nfields;i++) {
+    while( rec * param_set.FORCE_DT[file_num] 
+	   < global_param.nrecs * global_param.dt ) {
+      fill_text_block(&text);
+      while( text.ptr < text.end && isspace((unsigned char)*text.ptr) ) text.ptr++;
+      if( text.ptr >= text.end ) break;
+      ok = TRUE;
+      for(i=0;i<Nfields && ok;i++) {
         if (field_index[i] != ALBEDO && field_index[i] != LAI_IN && field_index[i] != VEGCOVER) {
-	  fscanf(infile,"%lf", &forcing_data[field_index[i]][rec]);
+	  ok = parse_double(&text.ptr, &forcing_data[field_index[i]][rec]);
         }
         else {
-          for(j=0;j<param_set.TYPE[field_index[i]].N_ELEM;j++) {
-	    fscanf(infile,"%lf", &veg_hist_data[field_index[i]][j][rec]);
+          for(j=0;j<param_set.TYPE[field_index[i]].N_ELEM && ok;j++) {
+	    ok = parse_double(&text.ptr, &veg_hist_data[field_index[i]][j][rec]);
           }
         }
       }
-      fgets(str, MAXSTRING, infile);
+      /* skip the rest of the line */
+      eol = (char *)memchr(text.ptr, '\n', text.end - text.ptr);
+      text.ptr = (eol == NULL) ? text.end : eol + 1;
       rec++;
     }
+
+    free((char *)text.buf);
   }
   
   if(rec * param_set.FORCE_DT[file_num] 
@@ -254,3 +317,149 @@ void read_atmos_data(FILE                 *infile,
   }
   
 }
+
+static void fill_text_block(text_block_struct *text)
+/**********************************************************************
+  fill_text_block
+
+  Makes sure that the unparsed text of an ASCII forcing file holds at
+  least one complete line and READ_BLOCK_SIZE/2 bytes, or the rest of
+  the file if that is shorter, so that a record (even one that spans
+  lines) can be parsed from it.  The unparsed text is moved to the
+  start of the buffer and the buffer is refilled from the file in
+  blocks; it grows only if a single line does not fit.
+**********************************************************************/
+{
+  size_t  len;
+  size_t  n;
+
+  while (!text->eof
+         && ((size_t)(text->end - text->ptr) < READ_BLOCK_SIZE/2
+             || memchr(text->ptr, '\n', text->end - text->ptr) == NULL)) {
+    len = text->end - text->ptr;
+    if (text->ptr > text->buf)
+      memmove(text->buf, text->ptr, len);
+    if (len == text->size) {
+      text->size *= 2;
+      text->buf = (char *)realloc(text->buf, text->size + 1);
+      if (text->buf == NULL)
+        nrerror("Memory allocation error in fill_text_block().");
+    }
+    n = fread(text->buf + len, 1, text->size - len, text->fh);
+    if (n == 0)
+      text->eof = TRUE;
+    text->ptr = text->buf;
+    text->end = text->buf + len + n;
+    *text->end = '\0';
+  }
+
+}
+
+static int parse_double(char **ptr, double *value)
+/**********************************************************************
+  parse_double
+
+  Parses a floating point number at *ptr, skipping leading white space,
+  and advances *ptr past it; returns FALSE, leaving *value unchanged,
+  if there is no number.  The result is always the same as strtod()'s.
+
+  Plain decimal numbers with at most 15 significant digits and a
+  decimal exponent of at most 22 in magnitude (the vast majority of
+  forcing values) are converted directly: the digits are then exactly
+  representable, as is the power of ten, so a single multiplication or
+  division gives the correctly rounded result, as strtod() does.
+  Anything else is passed to strtod().  The direct conversion relies on
+  double arithmetic being evaluated in double precision, and is
+  disabled where it is not (FLT_EVAL_METHOD != 0, e.g. x87).
+**********************************************************************/
+{
+  static const double pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+  char               *p;
+  char               *start;
+  char               *q;
+  unsigned long long  m;
+  int                 ndigits;
+  int                 e10;
+  int                 exp;
+  int                 neg;
+  int                 expneg;
+  int                 any;
+  double              tmp;
+
+  p = *ptr;
+  while (isspace((unsigned char)*p)) p++;
+  start = p;
+
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+  neg = FALSE;
+  if (*p == '-' || *p == '+') {
+    neg = (*p == '-');
+    p++;
+  }
+  m = 0;
+  ndigits = 0;
+  e10 = 0;
+  any = FALSE;
+  while (*p >= '0' && *p <= '9') {
+    any = TRUE;
+    if (m != 0 || *p != '0') {
+      if (++ndigits > 15) goto slow;
+      m = m*10 + (*p - '0');
+    }
+    p++;
+  }
+  if (*p == '.') {
+    p++;
+    while (*p >= '0' && *p <= '9') {
+      any = TRUE;
+      if (m != 0 || *p != '0') {
+        if (++ndigits > 15) goto slow;
+        m = m*10 + (*p - '0');
+      }
+      e10--;
+      p++;
+    }
+  }
+  if (!any || *p == 'x' || *p == 'X') goto slow;
+  if (*p == 'e' || *p == 'E') {
+    q = p + 1;
+    expneg = FALSE;
+    if (*q == '-' || *q == '+') {
+      expneg = (*q == '-');
+      q++;
+    }
+    if (*q < '0' || *q > '9') goto slow;
+    exp = 0;
+    while (*q >= '0' && *q <= '9') {
+      if (exp < 10000) exp = exp*10 + (*q - '0');
+      q++;
+    }
+    e10 += expneg ? -exp : exp;
+    p = q;
+  }
+
+  if (m == 0)
+    tmp = 0.0;
+  else if (e10 >= 0 && e10 <= 22)
+    tmp = (double)m * pow10[e10];
+  else if (e10 < 0 && e10 >= -22)
+    tmp = (double)m / pow10[-e10];
+  else
+    goto slow;
+  *value = neg ? -tmp : tmp;
+  *ptr = p;
+  return(TRUE);
+
+ slow:
+#endif /* FLT_EVAL_METHOD == 0 */
+  tmp = strtod(start, &q);
+  if (q == start)
+    return(FALSE);
+  *value = tmp;
+  *ptr = q;
+  return(TRUE);
+
+}
@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vicNl.h>
+
+static char vcid[] = "$Id$";
+
+double **read_cell_forcing(filep_struct      *filep,
+                           filenames_struct  *filenames,
+                           soil_con_struct   *soil,
+                           veg_con_struct    *veg_con,
+                           double         ****veg_hist_data)
+/**********************************************************************
+  read_cell_forcing
+
+  This routine builds the names of the grid cell's forcing files,
+  opens them, reads all forcing records (via read_forcing_data()),
+  and closes them again.  The forcing arrays are returned to the
+  caller, which passes them to initialize_atmos().
+
+  Since it touches nothing but the forcing files and the forcing
+  arrays, it can be called for the next cell while another thread is
+  still simulating the current one (PREFETCH = TRUE).
+
+  Modifications:
+  2015-Feb-02 Moved the opening of the forcing files here from
+	      make_in_and_outfiles() and their closing here from
+	      close_files().						GT
+**********************************************************************/
+{
+  extern option_struct    options;
+  extern global_param_struct global_param;
+  extern THREAD_LOCAL param_set_struct param_set;
+  extern FILE *open_file(char string[], char type[]);
+
+  char     latchar[20], lngchar[20], junk[6];
+  int      i;
+  double **forcing_data;
+
+  sprintf(junk, "%%.%if", options.GRID_DECIMAL);
+  sprintf(latchar, junk, soil->lat);
+  sprintf(lngchar, junk, soil->lng);
+
+  /********************************
+  Open Input Forcing Files
+  ********************************/
+
+  strcpy(filenames->forcing[0], filenames->f_path_pfx[0]);
+  strcat(filenames->forcing[0], latchar);
+  strcat(filenames->forcing[0], "_");
+  strcat(filenames->forcing[0], lngchar);
+  if(param_set.FORCE_FORMAT[0] == BINARY)
+    filep->forcing[0] = open_file(filenames->forcing[0], "rb");
+  else
+    filep->forcing[0] = open_file(filenames->forcing[0], "r");
+
+  filep->forcing[1] = NULL;
+  if(strcasecmp(filenames->f_path_pfx[1],"MISSING")!=0) {
+    strcpy(filenames->forcing[1], filenames->f_path_pfx[1]);
+    strcat(filenames->forcing[1], latchar);
+    strcat(filenames->forcing[1], "_");
+    strcat(filenames->forcing[1], lngchar);
+    if(param_set.FORCE_FORMAT[0] == BINARY)
+      filep->forcing[1] = open_file(filenames->forcing[1], "rb");
+    else
+      filep->forcing[1] = open_file(filenames->forcing[1], "r");
+  }
+
+  /********************************
+  Read Forcing Data
+  ********************************/
+
+  /* Number of elements of veg-dependent forcings */
+  set_veg_forcing_nelem(veg_con);
+
+  forcing_data = read_forcing_data(filep->forcing, global_param, veg_hist_data);
+
+  fprintf(stderr,"\nRead meteorological forcing file\n");
+
+  /********************************
+  Close Input Forcing Files
+  ********************************/
+
+  for (i=0; i<2; i++) {
+    if (filep->forcing[i] != NULL) {
+      fclose(filep->forcing[i]);
+      if(options.COMPRESS) compress_files(filenames->forcing[i]);
+      filep->forcing[i] = NULL;
+    }
+  }
+
+  return(forcing_data);
+
+}
+
+void set_veg_forcing_nelem(veg_con_struct *veg_con)
+/**********************************************************************
+  set_veg_forcing_nelem
+
+  This routine sets the number of elements of the veg-dependent
+  forcings (LAI_IN, VEGCOVER, ALBEDO) to the number of vegetation
+  tiles of the grid cell.  The veg_hist_data arrays of a cell have one
+  row per tile, and param_set is thread-local, so this must be called
+  by every thread that reads, hashes or frees a cell's forcing arrays
+  before it does so; the value left by another cell, or by the thread
+  that prefetched this one, is not valid.
+
+  Modifications:
+  2015-Feb-02 Split out of read_cell_forcing().			GT
+**********************************************************************/
+{
+  extern option_struct    options;
+  extern THREAD_LOCAL param_set_struct param_set;
+
+  if (!options.OUTPUT_FORCE) {
+    param_set.TYPE[LAI_IN].N_ELEM = veg_con[0].vegetat_type_num;
+    param_set.TYPE[VEGCOVER].N_ELEM = veg_con[0].vegetat_type_num;
+    param_set.TYPE[ALBEDO].N_ELEM = veg_con[0].vegetat_type_num;
+  }
+
+}
+
+void free_cell_forcing(double   **forcing_data,
+                       double  ***veg_hist_data)
+/**********************************************************************
+  free_cell_forcing
+
+  This routine frees the forcing arrays returned by
+  read_cell_forcing().  The caller must have set the number of
+  elements of the veg-dependent forcings for the cell the arrays
+  belong to (set_veg_forcing_nelem()).
+
+  Modifications:
+  2015-Feb-02 Moved here from initialize_atmos(), so that the arrays
+	      can also be freed when the prepared forcings are loaded
+	      from the forcing cache.					GT
+**********************************************************************/
+{
+  extern THREAD_LOCAL param_set_struct param_set;
+
+  int i, j;
+
+  for(i=0;i<N_FORCING_TYPES;i++)  {
+    if (param_set.TYPE[i].SUPPLIED) {
+      if (i != ALBEDO && i != LAI_IN && i != VEGCOVER) {
+        free(forcing_data[i]);
+      }
+      else {
+        for (j=0;j<param_set.TYPE[i].N_ELEM;j++) free(veg_hist_data[i][j]);
+        free(veg_hist_data[i]);
+      }
+    }
+  }
+  free(forcing_data);
+  free(veg_hist_data);
+
+}
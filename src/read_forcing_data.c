@@ -23,7 +23,7 @@ double **read_forcing_data(FILE                **infile,
 **********************************************************************/
 {
   extern option_struct    options;
-  extern param_set_struct param_set;
+  extern THREAD_LOCAL param_set_struct param_set;
   extern int              NR, NF;
 
   char                 errorstr[MAXSTRING];
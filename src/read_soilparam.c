@@ -125,12 +125,16 @@ soil_con_struct read_soilparam(FILE *soilparam,
   2013-Dec-27 Moved OUTPUT_FORCE to options_struct.			TJB
   2014-Mar-24 Removed ARC_SOIL option                               BN
   2014-Mar-28 Removed DIST_PRCP option.								TJB
+  2015-Feb-02 Snow band arrays are allocated from param_arena.		GT
+  2015-Feb-02 Allocates the thermal node arrays, options.Nnode entries
+	      each, from param_arena.					GT
 **********************************************************************/
 {
   void ttrim( char *string );
   extern option_struct options;
   extern global_param_struct global_param;
-  extern veg_lib_struct *veg_lib;
+  extern THREAD_LOCAL veg_lib_struct *veg_lib;
+  extern THREAD_LOCAL arena_struct param_arena;
   char            ErrStr[MAXSTRING];
   char            line[MAXSTRING];
   char            tmpline[MAXSTRING];
@@ -164,6 +168,7 @@ soil_con_struct read_soilparam(FILE *soilparam,
   double          w_avg;
   char   latchar[20], lngchar[20], junk[6];
   soil_con_struct temp;
+  double         *node_data;
 
     /** Read plain ASCII soil parameter file **/
   if ((fscanf(soilparam, "%d", &flag)) != EOF) {
@@ -756,15 +761,28 @@ soil_con_struct read_soilparam(FILE *soilparam,
 
         }
 
+        /*************************************************
+          Allocate Thermal Node Parameters
+        *************************************************/
+        node_data = (double *)arena_calloc(&param_arena,8*options.Nnode,sizeof(double));
+        temp.alpha          = &node_data[0*options.Nnode];
+        temp.beta           = &node_data[1*options.Nnode];
+        temp.bubble_node    = &node_data[2*options.Nnode];
+        temp.dz_node        = &node_data[3*options.Nnode];
+        temp.Zsum_node      = &node_data[4*options.Nnode];
+        temp.expt_node      = &node_data[5*options.Nnode];
+        temp.gamma          = &node_data[6*options.Nnode];
+        temp.max_moist_node = &node_data[7*options.Nnode];
+
         /*************************************************
           Allocate and Initialize Snow Band Parameters
         *************************************************/
         Nbands         = options.SNOW_BAND;
-        temp.AreaFract     = (double *)calloc(Nbands,sizeof(double));
-        temp.BandElev      = (float *)calloc(Nbands,sizeof(float));
-        temp.Tfactor       = (double *)calloc(Nbands,sizeof(double));
-        temp.Pfactor       = (double *)calloc(Nbands,sizeof(double));
-        temp.AboveTreeLine = (char *)calloc(Nbands,sizeof(char));
+        temp.AreaFract     = (double *)arena_calloc(&param_arena,Nbands,sizeof(double));
+        temp.BandElev      = (float *)arena_calloc(&param_arena,Nbands,sizeof(float));
+        temp.Tfactor       = (double *)arena_calloc(&param_arena,Nbands,sizeof(double));
+        temp.Pfactor       = (double *)arena_calloc(&param_arena,Nbands,sizeof(double));
+        temp.AboveTreeLine = (char *)arena_calloc(&param_arena,Nbands,sizeof(char));
 
         if (temp.Tfactor == NULL || temp.Pfactor == NULL || temp.AreaFract == NULL)
           nrerror("Memory allocation failure in read_snowband");
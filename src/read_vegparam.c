@@ -51,12 +51,16 @@ veg_con_struct *read_vegparam(FILE *vegparam,
 	      ALB_SRC.							TJB
   2014-Apr-25 Added optional vegcover values; added VEGPARAM_VEGCOVER
 	      and VEGCOVER_SRC.						TJB
+  2015-Feb-02 The veg_con array and its arrays are allocated from
+	      param_arena, and are released by resetting it.  The fields
+	      of each line are no longer copied to allocated strings.	GT
 **********************************************************************/
 {
 
   void ttrim( char *string );
-  extern veg_lib_struct *veg_lib;
+  extern THREAD_LOCAL veg_lib_struct *veg_lib;
   extern option_struct   options;
+  extern THREAD_LOCAL arena_struct param_arena;
   veg_con_struct *temp;
   int             vegcel, i, j, k, vegetat_type_num, skip, veg_class;
   int             MaxVeg;
@@ -112,17 +116,17 @@ veg_con_struct *read_vegparam(FILE *vegparam,
     MaxVeg++;
 
   /** Allocate memory for vegetation grid cell parameters **/
-  temp = (veg_con_struct*) calloc( MaxVeg, sizeof(veg_con_struct));
+  temp = (veg_con_struct*) arena_calloc( &param_arena, MaxVeg, sizeof(veg_con_struct));
   temp[0].Cv_sum = 0.0;
 
   for (i = 0; i < vegetat_type_num; i++) {
-    temp[i].zone_depth = calloc(options.ROOT_ZONES,sizeof(float));
-    temp[i].zone_fract = calloc(options.ROOT_ZONES,sizeof(float));
+    temp[i].zone_depth = arena_calloc(&param_arena,options.ROOT_ZONES,sizeof(float));
+    temp[i].zone_fract = arena_calloc(&param_arena,options.ROOT_ZONES,sizeof(float));
     temp[i].vegetat_type_num = vegetat_type_num;
 
     /* Upper boundaries of canopy layers, expressed in terms of fraction of total LAI  */
     if (options.CARBON) {
-      temp[i].CanopLayerBnd = calloc(options.Ncanopy,sizeof(double));
+      temp[i].CanopLayerBnd = arena_calloc(&param_arena,options.Ncanopy,sizeof(double));
       for (cidx=0; cidx<options.Ncanopy; cidx++) {
         /* apportion LAI equally among layers */
         temp[i].CanopLayerBnd[cidx] = (double)((cidx+1))/(double)(options.Ncanopy);
@@ -138,15 +142,13 @@ veg_con_struct *read_vegparam(FILE *vegparam,
     ttrim( tmpline );
     token = strtok (tmpline, delimiters);    /*  token => veg_class, move 'line' pointer to next field */  
     Nfields = 0;
-    vegarr[Nfields] = calloc( 500, sizeof(char));
-    strcpy(vegarr[Nfields],token);
+    vegarr[Nfields] = token;
     Nfields++;
 
     token = strtok (NULL, delimiters);
     while (token != NULL && (length=strlen(token))==0) token = strtok (NULL, delimiters);
     while ( token != NULL ) {
-      vegarr[Nfields] = calloc( 500, sizeof(char));      
-      strcpy(vegarr[Nfields],token);
+      vegarr[Nfields] = token;
       Nfields++;
       token = strtok (NULL, delimiters);
       while (token != NULL && (length=strlen(token))==0) token = strtok (NULL, delimiters);
@@ -211,9 +213,6 @@ veg_con_struct *read_vegparam(FILE *vegparam,
 
     temp[0].Cv_sum += temp[i].Cv;
 
-    for(k=0; k<Nfields; k++)
-      free(vegarr[k]);
-
     if ( options.VEGPARAM_LAI ) {
       // Read the LAI line
       if ( fgets( line, MAXSTRING, vegparam ) == NULL ){
@@ -221,16 +220,14 @@ veg_con_struct *read_vegparam(FILE *vegparam,
         nrerror(ErrStr);
       }      
       Nfields = 0;
-      vegarr[Nfields] = calloc( 500, sizeof(char));      
       strcpy(tmpline, line);
       ttrim( tmpline );
       token = strtok (tmpline, delimiters); 
-      strcpy(vegarr[Nfields],token);
+      vegarr[Nfields] = token;
       Nfields++;
  
       while( ( token = strtok (NULL, delimiters)) != NULL ){
-        vegarr[Nfields] = calloc( 500, sizeof(char));      
-        strcpy(vegarr[Nfields],token);
+        vegarr[Nfields] = token;
         Nfields++;
       }
       NfieldsMax = 12; /* For LAI */
@@ -251,8 +248,6 @@ veg_con_struct *read_vegparam(FILE *vegparam,
           veg_lib[temp[i].veg_class].Wdmax[j] = LAI_WATER_FACTOR * veg_lib[temp[i].veg_class].LAI[j];
         }
       }
-      for(k=0; k<Nfields; k++)
-        free(vegarr[k]);
     }
 
     if ( options.VEGPARAM_VEGCOVER ) {
@@ -262,16 +257,14 @@ veg_con_struct *read_vegparam(FILE *vegparam,
         nrerror(ErrStr);
       }      
       Nfields = 0;
-      vegarr[Nfields] = calloc( 500, sizeof(char));      
       strcpy(tmpline, line);
       ttrim( tmpline );
       token = strtok (tmpline, delimiters); 
-      strcpy(vegarr[Nfields],token);
+      vegarr[Nfields] = token;
       Nfields++;
  
       while( ( token = strtok (NULL, delimiters)) != NULL ){
-        vegarr[Nfields] = calloc( 500, sizeof(char));      
-        strcpy(vegarr[Nfields],token);
+        vegarr[Nfields] = token;
         Nfields++;
       }
       NfieldsMax = 12; /* For vegcover */
@@ -287,8 +280,6 @@ veg_con_struct *read_vegparam(FILE *vegparam,
             veg_lib[temp[i].veg_class].vegcover[j] = tmp;
         }
       }
-      for(k=0; k<Nfields; k++)
-        free(vegarr[k]);
     }
 
     if ( options.VEGPARAM_ALB ) {
@@ -298,16 +289,14 @@ veg_con_struct *read_vegparam(FILE *vegparam,
         nrerror(ErrStr);
       }      
       Nfields = 0;
-      vegarr[Nfields] = calloc( 500, sizeof(char));      
       strcpy(tmpline, line);
       ttrim( tmpline );
       token = strtok (tmpline, delimiters); 
-      strcpy(vegarr[Nfields],token);
+      vegarr[Nfields] = token;
       Nfields++;
  
       while( ( token = strtok (NULL, delimiters)) != NULL ){
-        vegarr[Nfields] = calloc( 500, sizeof(char));      
-        strcpy(vegarr[Nfields],token);
+        vegarr[Nfields] = token;
         Nfields++;
       }
       NfieldsMax = 12; /* For albedo */
@@ -323,8 +312,6 @@ veg_con_struct *read_vegparam(FILE *vegparam,
             veg_lib[temp[i].veg_class].albedo[j] = tmp;
         }
       }
-      for(k=0; k<Nfields; k++)
-        free(vegarr[k]);
     }
 
     // Determine if cell contains non-overstory vegetation
@@ -378,9 +365,9 @@ veg_con_struct *read_vegparam(FILE *vegparam,
         temp[vegetat_type_num].Cv         = 0.001;
         temp[vegetat_type_num].veg_class  = options.AboveTreelineVeg;
         temp[vegetat_type_num].Cv_sum     = temp[vegetat_type_num-1].Cv_sum;
-        temp[vegetat_type_num].zone_depth = calloc( options.ROOT_ZONES,
+        temp[vegetat_type_num].zone_depth = arena_calloc( &param_arena, options.ROOT_ZONES,
                                                   sizeof(float));
-        temp[vegetat_type_num].zone_fract = calloc( options.ROOT_ZONES,
+        temp[vegetat_type_num].zone_fract = arena_calloc( &param_arena, options.ROOT_ZONES,
                                                   sizeof(float));
         temp[vegetat_type_num].vegetat_type_num = vegetat_type_num+1;
 
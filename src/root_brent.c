@@ -11,6 +11,7 @@
  *               method.  
  * DESCRIP-END.
  * FUNCTIONS:    RootBrent()
+ *               root_solve()
  * COMMENTS:     
  */
 
@@ -34,6 +35,28 @@ static char vcid[] = "$Id$";
 #define MACHEPS 3e-8
 #define TSTEP   10
 #define T       1e-7   
+#define MAXNEWTON 8
+#define NEWTON_DX 0.1
+
+typedef struct {
+  double (*Function)(double Estimate, void *ctx);
+  void   *ctx;
+  int     nevals;   /* number of evaluations of Function */
+} counted_function_struct;
+
+typedef struct {
+  long ncalls;      /* number of calls to root_solve() */
+  long nevals;      /* total number of evaluations of Function */
+  int  maxevals;    /* largest number of evaluations in one call */
+  long nfallback;   /* number of ROOT_NEWTON calls finished by Brent */
+} root_stats_struct;
+
+static const char *root_site_names[N_ROOT_SITES] = { "surface", "canopy",
+                                                      "snow pack", "lake ice" };
+
+static THREAD_LOCAL root_stats_struct root_stats[N_ROOT_SITES];
+
+static double counted_function(double Estimate, void *ctx);
 
 /*****************************************************************************
   GENERAL DOCUMENTATION FOR THIS MODULE
@@ -63,8 +86,141 @@ static char vcid[] = "$Id$";
   If this is not the case the program will abort.  In addition the program
   will perform not more than a certain number of iterations, as specified
   in brent.h, and will abort if more iterations are needed.
+
+  root_solve() is the entry point used by the energy balance routines.
+  With options.ROOT_SOLVER = ROOT_NEWTON it calls root_newton(), which
+  starts from the previous time step's solution and switches to the Brent
+  search only when a secant step leaves the bracket.
 ******************************************************************************/
   
+/*****************************************************************************
+  Function name: brent_search()
+
+  Purpose      : Find the root of Function in the interval [a, b], which
+                 must bracket the root, using the Brent method.  This is
+                 the search that follows the bracketing step in
+                 root_brent(); it is also used by root_newton() once the
+                 root has been bracketed.
+
+  Required     :
+    double a, fa          - First bound, and Function at a
+    double b, fb          - Second bound, and Function at b; fa and fb
+                            must have opposite signs
+    char *ErrorString     - For storing description of errors (if any)
+    double (*Function)(double Estimate, void *ctx)
+    void *ctx             - Context structure passed on to Function
+
+  Returns      :
+    double b              - Root of Function
+
+  Modifies     : 
+    char *ErrorString     - Stores description of errors
+*****************************************************************************/
+static double brent_search(double a, double fa, double b, double fb,
+                           char *ErrorString,
+                           double (*Function)(double Estimate, void *ctx),
+                           void *ctx)
+{
+  const char *Routine = "RootBrent";
+  double c;
+  double d;
+  double e;
+  double fc;
+  double m;
+  double p;
+  double q;
+  double r;
+  double s;
+  double tol;
+  int i;
+
+  c = a;
+  fc = fb;
+  e = d = b - a;
+
+  for (i = 0; i < MAXITER; i++) {
+
+    if (fb*fc > 0) {
+      c = a;
+      fc = fa;
+      d = b - a;
+      e = d;
+    }
+    
+    if (fabs(fc) < fabs(fb)) {
+      a = b;
+      b = c;
+      c = a;
+      fa = fb;
+      fb = fc;
+      fc = fa;
+    }
+    
+    tol = 2 * MACHEPS * fabs(b) + T;
+    m = 0.5 * (c - b);
+    
+    if (fabs(m) <= tol || fb == 0) {
+      return b;
+    }
+    
+    else {
+      if (fabs(e) < tol || fabs(fa) <= fabs(fb)) {
+	d = m;
+	e = d;
+      }
+      else {
+	s = fb/fa;
+	
+	if (a == c) {
+	  
+	  /* linear interpolation */
+          
+	  p = 2 * m * s;
+	  q = 1 - s;
+	}
+	
+	else {
+	  
+	  /* inverse quadratic interpolation */
+	  
+	  q = fa/fc;
+	  r = fb/fc;
+	  p = s * (2 * m * q * (q - r) - (b - a) * (r - 1));
+	  q = (q - 1) * (r - 1) * (s - 1);
+	}
+	
+	if (p > 0)
+	  q = -q;
+	else
+	  p = -p;
+	s = e;
+	e = d;
+	if ((2 * p) < ( 3 * m * q - fabs(tol * q)) && p < fabs(0.5 * s * q))
+	  d = p/q;
+	else {
+	  d = m;
+	  e = d;
+	}
+      }
+      a = b;
+      fa = fb;
+      b += (fabs(d) > tol) ? d : ((m > 0) ? tol : -tol);
+      fb = Function(b, ctx);
+
+      // Catch ERROR values returned from Function
+      if(fb == ERROR){
+	sprintf(ErrorString,"ERROR returned to root_brent on iteration %d: temperature = %.4f\n",i+1,b);
+	return( ERROR );
+      }      
+
+    }
+  }
+  /* If we get here, there were too many iterations */
+  sprintf(ErrorString,"WARNING: %s: too many iterations.\n",Routine);
+  return(ERROR);
+
+}
+
 /*****************************************************************************
   Function name: RootBrent()
 
@@ -74,14 +230,11 @@ static char vcid[] = "$Id$";
     double LowerBound     - Lower bound for root
     double UpperBound     - Upper bound for root
     char *ErrorString     - For storing description of errors (if any)
-    double (*Function)(double Estimate, va_list ap)
-    ...                   - Variable arguments 
-                            The number and order of arguments has to be
-                            appropriate for the Function pointed to, since
-                            the list of arguments after Nargs will be passed
-                            on to Function.
-                            See the appropriate Function for the correct
-                            arguments. 
+    double (*Function)(double Estimate, void *ctx)
+    void *ctx             - Context structure holding the remaining
+                            arguments of Function, passed on to Function
+                            unchanged.  See the appropriate Function for
+                            the type of structure it expects.
 
   Returns      :
     double b              - Effective surface temperature (C)
@@ -101,46 +254,40 @@ static char vcid[] = "$Id$";
   2007-Sep-01 Removed the integer "eval" since it is never used for anything.	JCA
   2009-May-22 Modified root-bracketing scheme to handle case when one bound
 	      yields garbage output from the target function.			TJB
+  2015-Feb-02 Function now takes a pointer to a context structure
+	      instead of a va_list, so its arguments are no longer
+	      unpacked from a variable argument list on every
+	      evaluation.							GT
+  2015-Feb-02 Moved the search for the bracketed root into brent_search(),
+	      which root_newton() also uses.				GT
 *****************************************************************************/
 double root_brent(double LowerBound, double UpperBound, char *ErrorString,
-                double (*Function)(double Estimate, va_list ap), ...)
+                  double (*Function)(double Estimate, void *ctx), void *ctx)
 {
   const char *Routine = "RootBrent";
-  va_list ap;                   /* Used in traversing variable argument list */ 
   double a;
   double b;
   double c;
-  double d;
-  double e;
   double fa;
   double fb;
   double fc;
-  double m;
-  double p;
-  double q;
-  double r;
-  double s;
-  double tol;
   double last_bad;
   double last_good;
   int which_err;
   int i;
   int j;
 
-  /* initialize variable argument list */
   a = LowerBound;
   b = UpperBound;
-  va_start(ap, Function);
-  fa = Function(a, ap);
-  va_start(ap, Function);
-  fb = Function(b, ap);
+  last_bad = a;
+  fa = Function(a, ctx);
+  fb = Function(b, ctx);
  
   which_err = 0;
 
   // If Function returns values of ERROR for both bounds, give up
   if (fa == ERROR && fb == ERROR) {
     sprintf(ErrorString,"ERROR: %s: lower and upper bounds %f and %f failed to bracket the root because the given function was not defined at either point.\n",Routine,a,b);
-    va_end(ap);
     return(ERROR);
   }      
 
@@ -160,23 +307,20 @@ double root_brent(double LowerBound, double UpperBound, char *ErrorString,
     }
 
     c = 0.5*(last_bad+last_good);
-    va_start(ap, Function);
-    fc = Function(c, ap);
+    fc = Function(c, ctx);
 
     /* search for valid point via bisection */
     j = 0;
     while (fc == ERROR && j < MAXITER) {
       last_bad = c;
       c = 0.5*(last_bad+last_good);
-      va_start(ap, Function);
-      fc = Function(c, ap);
+      fc = Function(c, ctx);
       j++;
     }
 
     if (fc == ERROR) {
       /* if we get here, we could not find a bound for which the function returns a valid value */
       sprintf(ErrorString,"ERROR: %s: the given function produced undefined values while attempting to bracket the root between %f and %f.\n",Routine,LowerBound,UpperBound);
-      va_end(ap);
       return(ERROR);
     }
     else {
@@ -201,32 +345,26 @@ double root_brent(double LowerBound, double UpperBound, char *ErrorString,
     if (which_err == 0) { // No undefined values were encountered
       a -= TSTEP;
       b += TSTEP;
-      va_start(ap, Function);
-      fa = Function(a, ap);
-      va_start(ap, Function);
-      fb = Function(b, ap);
+      fa = Function(a, ctx);
+      fb = Function(b, ctx);
     }
     else { // Undefined values were encountered
       if (which_err == -1) { // Undefined values encountered in the lower direction
         b += TSTEP;
-        va_start(ap, Function);
-        fb = Function(b, ap);
+        fb = Function(b, ctx);
         if (fb == ERROR) {
           /* Undefined function values in both directions - give up */
           sprintf(ErrorString,"ERROR: %s: the given function produced undefined values while attempting to bracket the root between %f and %f.\n",Routine,LowerBound,UpperBound);
-          va_end(ap);
           return(ERROR);
         }
         last_good = a;
       }
       else { // Undefined values encountered in the upper direction
         a -= TSTEP;
-        va_start(ap, Function);
-        fa = Function(a, ap);
+        fa = Function(a, ctx);
         if (fa == ERROR) {
           /* Undefined function values in both directions - give up */
           sprintf(ErrorString,"ERROR: %s: the given function produced undefined values while attempting to bracket the root between %f and %f.\n",Routine,LowerBound,UpperBound);
-          va_end(ap);
           return(ERROR);
         }
         last_good = b;
@@ -234,21 +372,18 @@ double root_brent(double LowerBound, double UpperBound, char *ErrorString,
 
       /* search for valid point via bisection */
       c = 0.5*(last_good+last_bad);
-      va_start(ap, Function);
-      fc = Function(c, ap);
+      fc = Function(c, ctx);
       i = 0;
       while (fc == ERROR && i < MAXITER) {
         last_bad = c;
         c = 0.5*(last_bad+last_good);
-        va_start(ap, Function);
-        fc = Function(c, ap);
+        fc = Function(c, ctx);
         i++;
       }
 
       if (fc == ERROR) {
         /* if we get here, we could not find a bound for which the function returns a valid value */
         sprintf(ErrorString,"ERROR: %s: the given function produced undefined values while attempting to bracket the root between %f and %f.\n",Routine,LowerBound,UpperBound);
-        va_end(ap);
         return(ERROR);
       }
       else {
@@ -269,7 +404,6 @@ double root_brent(double LowerBound, double UpperBound, char *ErrorString,
   if ((fa * fb) >= 0) {
     /* if we get here, the lower and upper bounds did not bracket the root */
     sprintf(ErrorString,"WARNING: %s: lower and upper bounds %f and %f failed to bracket the root.\n",Routine,a,b);
-    va_end(ap);
     return(ERROR);
   }
 
@@ -277,92 +411,287 @@ double root_brent(double LowerBound, double UpperBound, char *ErrorString,
  
   // Now search for the root
 
-  fc = fb;
+  return brent_search(a, fa, b, fb, ErrorString, Function, ctx);
 
-  for (i = 0; i < MAXITER; i++) {
+}
+/*****************************************************************************
+  Function name: root_newton()
 
-    if (fb*fc > 0) {
-      c = a;
-      fc = fa;
-      d = b - a;
-      e = d;
+  Purpose      : Calculate the root of Function with a safeguarded secant
+                 (quasi-Newton) iteration started from a first guess
+
+  Required     :
+    double Guess          - First guess of the root, normally the solution
+                            of the previous time step
+    double LowerBound     - Lower bound for root
+    double UpperBound     - Upper bound for root
+    char *ErrorString     - For storing description of errors (if any)
+    double (*Function)(double Estimate, void *ctx)
+    void *ctx             - Context structure passed on to Function
+
+  Returns      :
+    double x              - Root of Function
+
+  Modifies     : 
+    char *ErrorString     - Stores description of errors
+    int *Fallback         - TRUE if the Brent method had to take over
+
+  Comments     :
+    The derivative of Function is estimated by a finite difference over
+    NEWTON_DX times the half width of [LowerBound, UpperBound] for the
+    first step, and by the secant through the last two iterates after
+    that.  Iterates on either side of the root are kept as a bracket.
+    The iteration stops on the criterion of brent_search(): once the
+    bracket is no wider than twice its tolerance, 2 * MACHEPS * |x| + T,
+    it is handed to brent_search(), which returns the end with the
+    smaller |Function| without evaluating Function again (or finishes
+    the search if its own test, taken at that end, is not yet met).  As
+    in brent_search(), a step is never shorter than the tolerance, so
+    that a converging iteration steps across the root and brackets it.
+
+    Until the root has been bracketed, steps are limited to TSTEP and
+    may not leave [LowerBound - MAXTRIES * TSTEP, UpperBound + MAXTRIES *
+    TSTEP], the interval searched by the bracketing step of
+    root_brent().  If a step leaves
+    the bracket or that interval, if a secant step inside the bracket
+    does not halve |Function| (which happens where Function is not
+    smooth), if
+    Function returns ERROR, or if the iteration has not converged after
+    MAXNEWTON steps, the Brent method takes over: brent_search() on the
+    bracket found so far, or root_brent() if there is none.  So does a
+    first guess at one of the bounds where Function is exactly 0, which
+    root_brent() does not accept as a root either.
+
+    The root therefore satisfies the same tolerance as that of root_brent(),
+    but the two are not identical: they stop at different points within
+    it, and where Function has more than one root in the bracket they
+    may find different roots.
+*****************************************************************************/
+static double root_newton(double Guess, double LowerBound, double UpperBound,
+                          char *ErrorString,
+                          double (*Function)(double Estimate, void *ctx),
+                          void *ctx, int *Fallback)
+{
+  double x0;
+  double x1;
+  double x2;
+  double f0;
+  double f1;
+  double xlo;
+  double xhi;
+  double flo;
+  double fhi;
+  double tol;
+  char   BRACKETED;
+  char   TOLSTEP;
+  int    i;
+
+  *Fallback = FALSE;
+  BRACKETED = FALSE;
+  TOLSTEP = FALSE;
+  xlo = xhi = flo = fhi = 0;
+
+  x0 = Guess;
+  if (x0 < LowerBound) x0 = LowerBound;
+  if (x0 > UpperBound) x0 = UpperBound;
+  f0 = Function(x0, ctx);
+  if (f0 == ERROR) goto fallback;
+  if (f0 == 0) {
+    /* root_brent() does not take a zero at a bound as the root (it
+       widens the bracket instead), so neither does root_newton() */
+    if (x0 == LowerBound || x0 == UpperBound) goto fallback;
+    return x0;
+  }
+
+  /* finite difference step for the first derivative estimate, taken
+     towards the middle of [LowerBound, UpperBound] */
+  x1 = NEWTON_DX * 0.5 * (UpperBound - LowerBound);
+  if (x0 > 0.5 * (LowerBound + UpperBound)) x1 = -x1;
+  x1 += x0;
+
+  for (i = 0; i < MAXNEWTON; i++) {
+
+    f1 = Function(x1, ctx);
+    if (f1 == ERROR) goto fallback;
+    if (f1 == 0) return x1;
+
+    /* keep track of the bracket */
+    if (f0 * f1 < 0) {
+      BRACKETED = TRUE;
+      if (x0 < x1) { xlo = x0; flo = f0; xhi = x1; fhi = f1; }
+      else         { xlo = x1; flo = f1; xhi = x0; fhi = f0; }
     }
-    
-    if (fabs(fc) < fabs(fb)) {
-      a = b;
-      b = c;
-      c = a;
-      fa = fb;
-      fb = fc;
-      fc = fa;
+    else if (BRACKETED) {
+      if (flo * f1 > 0) { xlo = x1; flo = f1; }
+      else              { xhi = x1; fhi = f1; }
     }
-    
-    tol = 2 * MACHEPS * fabs(b) + T;
-    m = 0.5 * (c - b);
-    
-    if (fabs(m) <= tol || fb == 0) {
-      va_end(ap);
-      return b;
+
+    /* converged: the root is bracketed to within brent_search()'s
+       tolerance, so brent_search() makes the final choice */
+    if (BRACKETED) {
+      tol = 2 * MACHEPS * ((fabs(xlo) > fabs(xhi)) ? fabs(xlo) : fabs(xhi)) + T;
+      if (xhi - xlo <= 2 * tol)
+        return brent_search(xlo, flo, xhi, fhi, ErrorString, Function, ctx);
+    }
+
+    /* secant steps that do not reduce |Function| enough mean that
+       Function is not smooth near the root; Brent does better there */
+    if (f1 == f0 || (BRACKETED && i > 0 && !TOLSTEP && fabs(f1) > 0.5 * fabs(f0)))
+      goto fallback;
+    x2 = x1 - f1 * (x1 - x0) / (f1 - f0);
+
+    /* step at least the tolerance, to get across the root */
+    tol = 2 * MACHEPS * fabs(x1) + T;
+    TOLSTEP = (fabs(x2 - x1) < tol);
+    if (TOLSTEP)
+      x2 = (x2 > x1) ? x1 + tol : x1 - tol;
+
+    /* safeguard - the step must stay inside the bracket */
+    if (BRACKETED) {
+      if (x2 <= xlo || x2 >= xhi) goto fallback;
     }
-    
     else {
-      if (fabs(e) < tol || fabs(fa) <= fabs(fb)) {
-	d = m;
-	e = d;
-      }
-      else {
-	s = fb/fa;
-	
-	if (a == c) {
-	  
-	  /* linear interpolation */
-          
-	  p = 2 * m * s;
-	  q = 1 - s;
-	}
-	
-	else {
-	  
-	  /* inverse quadratic interpolation */
-	  
-	  q = fa/fc;
-	  r = fb/fc;
-	  p = s * (2 * m * q * (q - r) - (b - a) * (r - 1));
-	  q = (q - 1) * (r - 1) * (s - 1);
-	}
-	
-	if (p > 0)
-	  q = -q;
-	else
-	  p = -p;
-	s = e;
-	e = d;
-	if ((2 * p) < ( 3 * m * q - fabs(tol * q)) && p < fabs(0.5 * s * q))
-	  d = p/q;
-	else {
-	  d = m;
-	  e = d;
-	}
-      }
-      a = b;
-      fa = fb;
-      b += (fabs(d) > tol) ? d : ((m > 0) ? tol : -tol);
-      va_start(ap, Function);
-      fb = Function(b, ap);
+      if (x2 > x1 + TSTEP) x2 = x1 + TSTEP;
+      if (x2 < x1 - TSTEP) x2 = x1 - TSTEP;
+      if (x2 < LowerBound - MAXTRIES * TSTEP
+          || x2 > UpperBound + MAXTRIES * TSTEP) goto fallback;
+    }
 
-      // Catch ERROR values returned from Function
-      if(fb == ERROR){
-	sprintf(ErrorString,"ERROR returned to root_brent on iteration %d: temperature = %.4f\n",i+1,b);
-	va_end(ap);
-	return( ERROR );
-      }      
+    x0 = x1;
+    f0 = f1;
+    x1 = x2;
 
-    }
   }
-  /* If we get here, there were too many iterations */
-  sprintf(ErrorString,"WARNING: %s: too many iterations.\n",Routine);
-  va_end(ap);
-  return(ERROR);
+
+ fallback:
+  *Fallback = TRUE;
+  if (BRACKETED)
+    return brent_search(xlo, flo, xhi, fhi, ErrorString, Function, ctx);
+  return root_brent(LowerBound, UpperBound, ErrorString, Function, ctx);
+
+}
+
+/*****************************************************************************
+  Function name: root_solve()
+
+  Purpose      : Calculate the root of Function with the solver selected by
+                 options.ROOT_SOLVER, and count the evaluations of Function
+
+  Required     :
+    int Site              - Which energy balance is being solved (ROOT_SURF,
+                            ROOT_CANOPY, ROOT_SNOW or ROOT_ICE); used to
+                            keep separate evaluation counts
+    double Guess          - First guess of the root, normally the solution
+                            of the previous time step; not used by
+                            ROOT_BRENT
+    double LowerBound     - Lower bound for root
+    double UpperBound     - Upper bound for root
+    char *ErrorString     - For storing description of errors (if any)
+    double (*Function)(double Estimate, void *ctx)
+    void *ctx             - Context structure passed on to Function
+
+  Returns      :
+    double                - Root of Function, or ERROR
+
+  Modifies     : 
+    char *ErrorString     - Stores description of errors
+
+  Comments     :
+    With ROOT_BRENT (the default) the result is that of root_brent().
+    The evaluation counts of the calling thread are reported for each
+    cell by print_root_stats().
+*****************************************************************************/
+double root_solve(int Site, double Guess, double LowerBound, double UpperBound,
+                  char *ErrorString,
+                  double (*Function)(double Estimate, void *ctx), void *ctx)
+{
+  extern option_struct options;
+
+  counted_function_struct counted;
+  root_stats_struct *stats;
+  double root;
+  int    Fallback;
+
+  counted.Function = Function;
+  counted.ctx      = ctx;
+  counted.nevals   = 0;
+  Fallback         = FALSE;
+
+  if (options.ROOT_SOLVER == ROOT_NEWTON)
+    root = root_newton(Guess, LowerBound, UpperBound, ErrorString,
+                       counted_function, &counted, &Fallback);
+  else
+    root = root_brent(LowerBound, UpperBound, ErrorString,
+                      counted_function, &counted);
+
+  stats = &root_stats[Site];
+  stats->ncalls++;
+  stats->nevals += counted.nevals;
+  if (counted.nevals > stats->maxevals) stats->maxevals = counted.nevals;
+  if (Fallback) stats->nfallback++;
+
+  return root;
+
+}
+
+static double counted_function(double Estimate, void *ctx)
+/*****************************************************************************
+  counted_function
+
+  Evaluates the Function held in a counted_function_struct, counting the
+  evaluations.
+*****************************************************************************/
+{
+  counted_function_struct *counted = (counted_function_struct *)ctx;
+
+  counted->nevals++;
+  return counted->Function(Estimate, counted->ctx);
+
+}
+
+void reset_root_stats()
+/*****************************************************************************
+  reset_root_stats
+
+  Clears the calling thread's root_solve() evaluation counts.
+*****************************************************************************/
+{
+  int i;
+
+  for (i = 0; i < N_ROOT_SITES; i++) {
+    root_stats[i].ncalls    = 0;
+    root_stats[i].nevals    = 0;
+    root_stats[i].maxevals  = 0;
+    root_stats[i].nfallback = 0;
+  }
+
+}
+
+void print_root_stats(int gridcel)
+/*****************************************************************************
+  print_root_stats
+
+  Prints the calling thread's root_solve() evaluation counts, i.e. those
+  of grid cell gridcel if they were reset at the start of the cell.
+*****************************************************************************/
+{
+  extern option_struct options;
+
+  root_stats_struct *stats;
+  int i;
+
+  for (i = 0; i < N_ROOT_SITES; i++) {
+    stats = &root_stats[i];
+    if (stats->ncalls == 0) continue;
+    fprintf(stderr,"Cell %d %s energy balance (%s): %ld solutions, %ld evaluations, %.2f per solution (max %d)",
+            gridcel, root_site_names[i],
+            (options.ROOT_SOLVER == ROOT_NEWTON) ? "NEWTON" : "BRENT",
+            stats->ncalls, stats->nevals,
+            (double)stats->nevals / (double)stats->ncalls, stats->maxevals);
+    if (options.ROOT_SOLVER == ROOT_NEWTON)
+      fprintf(stderr,", %ld Brent fallbacks", stats->nfallback);
+    fprintf(stderr,"\n");
+  }
 
 }
 
@@ -371,3 +700,5 @@ double root_brent(double LowerBound, double UpperBound, char *ErrorString,
 #undef MACHEPS
 #undef TSTEP
 #undef T
+#undef MAXNEWTON
+#undef NEWTON_DX
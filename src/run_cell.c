@@ -0,0 +1,289 @@
+/*
+ * Purpose: run_cell() - simulate one grid cell
+ * Usage  : Part of VIC
+ * Created: 2015-Feb-02
+ * Notes  : The body of the grid cell loop of vicNl.c, moved here so
+ *          that the serial driver (vicNl.c) and the threaded cell
+ *          driver (cell_threads.c) run a cell the same way.  The cell's
+ *          parameters are read by the caller; run_cell() opens the
+ *          cell's output files, prepares the forcings, initializes the
+ *          model state, runs all records, and closes the files.
+ *          Everything it allocates for the cell is either freed before
+ *          it returns or supplied by the caller, so that several cells
+ *          can be run at once by different threads.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vicNl.h>
+
+static char vcid[] = "$Id$";
+
+int run_cell(int                   cellnum,
+             soil_con_struct      *soil_con,
+             veg_con_struct       *veg_con,
+             lake_con_struct      *lake_con,
+             double              **forcing_data,
+             double             ***veg_hist_data,
+             dmy_struct           *dmy,
+             int                   startrec,
+             filep_struct         *filep,
+             filenames_struct     *filenames,
+             atmos_data_struct    *atmos,
+             veg_hist_struct    ***veg_hist,
+             int                  *Nveg_hist,
+             out_data_file_struct *out_data_files,
+             out_data_struct      *out_data)
+/**********************************************************************
+  run_cell
+
+  This routine runs the model for a single grid cell whose parameters
+  have already been read: it opens the cell's output files, reads
+  and initializes the forcings, initializes the model state, steps through
+  all records, writing output and (on the assigned date) the model
+  state, and closes the cell's files.
+
+  forcing_data and veg_hist_data are the cell's forcings as returned
+  by read_cell_forcing(), if they have already been read (PREFETCH =
+  TRUE); if forcing_data is NULL, they are read here.  Either way they
+  are freed by initialize_atmos().
+
+  The caller owns soil_con and veg_con.  atmos and veg_hist are
+  allocated once per run by the caller and reused for every cell;
+  *Nveg_hist is the number of veg tiles *veg_hist was allocated for
+  (0 if not allocated yet), and *veg_hist is reallocated here when a
+  cell has more tiles.  All other per-cell structures are allocated
+  and freed here, so run_cell() may be called concurrently for
+  different cells as long as each caller supplies its own filep,
+  filenames, atmos, veg_hist, out_data_files, and out_data.
+
+  Returns ERROR if the model state could not be initialized and
+  CONTINUEONERROR is TRUE, in which case no further cells should be
+  run; otherwise returns 0.  If CONTINUEONERROR is FALSE, an error in
+  the cell ends the simulation through cell_error(): when the cell is
+  run by the serial driver this exits through vicerror(); when it is
+  run by a worker thread the cell's files are closed and ERROR is
+  returned, and the threaded driver reports the error once the cells
+  before this one have finished.  A cell run by a worker thread also
+  stops early, without an error, if a cell before it has failed
+  (cell_cancelled()), since its output will be discarded.
+
+  Modifications:
+  2015-Feb-02 Moved the body of the grid cell loop from vicNl.c into
+	      this routine so that it can be shared by the serial
+	      driver and the threaded cell driver.			GT
+  2015-Feb-02 Added forcing_data and veg_hist_data to the argument list
+	      so that the forcings can be read ahead of time.		GT
+  2015-Feb-02 veg_hist is now allocated by the caller and reused
+	      across cells, like atmos.					GT
+  2015-Feb-02 With FORCING_CACHE, the prepared forcings are loaded
+	      from the forcing cache if possible, and are otherwise
+	      computed by initialize_atmos() and stored in the cache.	GT
+  2015-Feb-02 The energy balance solver evaluation counts of the cell
+	      are reported at the end of the cell.			GT
+  2015-Feb-02 Added out_data to the argument list of
+	      make_in_and_outfiles().					GT
+  2015-Feb-02 With OUTPUT_CONTAINER, the output file headers are not
+	      written here; each container holds one copy.		GT
+  2015-Feb-02 Errors that end the simulation go through cell_error(),
+	      so that in a worker thread they return ERROR instead of
+	      exiting while other cells are still running.  Cells after
+	      a failed cell stop early.					GT
+**********************************************************************/
+{
+  extern THREAD_LOCAL veg_lib_struct *veg_lib;
+  extern option_struct options;
+  extern THREAD_LOCAL Error_struct Error;
+  extern global_param_struct global_param;
+
+  char                     ErrStr[MAXSTRING];
+  int                      rec;
+  int                      ErrorFlag;
+  int                      InitError;
+  int                      FatalError;  /* a record failed and
+                                           CONTINUEONERROR is FALSE */
+  int                      UseCache;
+  int                      CacheHit;
+  unsigned long long       CacheKey;
+  all_vars_struct          all_vars;
+  save_data_struct         save_data;
+
+  InitError = FALSE;
+  FatalError = FALSE;
+
+  /** Build Gridded Filenames, and Open **/
+  make_in_and_outfiles(cellnum, filep, filenames, soil_con, out_data_files,
+                       out_data);
+
+  if (options.PRT_HEADER && !options.OUTPUT_CONTAINER) {
+    /** Write output file headers **/
+    write_header(out_data_files, out_data, dmy, global_param);
+  }
+
+  if (!options.OUTPUT_FORCE) {
+
+    /** Make Top-level Control Structure **/
+    all_vars     = make_all_vars(veg_con[0].vegetat_type_num);
+
+    /** (re)allocate the veg_hist_struct if it is too small for this cell **/
+    if (*veg_hist == NULL || veg_con[0].vegetat_type_num > *Nveg_hist) {
+      free_veg_hist(global_param.nrecs, *Nveg_hist, veg_hist);
+      *Nveg_hist = veg_con[0].vegetat_type_num;
+      alloc_veg_hist(global_param.nrecs, *Nveg_hist, veg_hist);
+    }
+
+  } /* !OUTPUT_FORCE */
+
+  /**************************************************
+     Initialize Meteological Forcing Values That
+     Have not Been Specifically Set
+   **************************************************/
+
+#if VERBOSE
+  fprintf(stderr,"Initializing Forcing Data\n");
+#endif /* VERBOSE */
+
+  if (forcing_data == NULL)
+    forcing_data = read_cell_forcing(filep, filenames, soil_con, veg_con,
+                                     &veg_hist_data);
+  else
+    /* prefetched by another thread: size the veg-dependent forcings for
+       this cell before they are hashed or freed */
+    set_veg_forcing_nelem(veg_con);
+
+  /** Load the prepared forcings from the forcing cache if possible **/
+  UseCache = (!options.OUTPUT_FORCE
+              && strcmp(filenames->forcing_cache, "MISSING") != 0);
+  CacheHit = FALSE;
+  if (UseCache) {
+    CacheKey = forcing_cache_key(forcing_data, veg_hist_data, soil_con,
+                                 veg_con, veg_lib);
+    CacheHit = read_forcing_cache(filenames->forcing_cache, CacheKey, soil_con,
+                                  veg_con[0].vegetat_type_num, atmos, *veg_hist);
+  }
+
+  if (CacheHit)
+    free_cell_forcing(forcing_data, veg_hist_data);
+  else {
+    initialize_atmos(atmos, dmy, forcing_data, veg_hist_data, veg_lib, veg_con,
+                     *veg_hist, soil_con, out_data_files, out_data);
+    if (UseCache)
+      write_forcing_cache(filenames->forcing_cache, CacheKey, soil_con,
+                          veg_con[0].vegetat_type_num, atmos, *veg_hist);
+  }
+
+  if (!options.OUTPUT_FORCE) {
+
+    /**************************************************
+      Initialize Energy Balance and Snow Variables
+    **************************************************/
+
+#if VERBOSE
+    fprintf(stderr,"Model State Initialization\n");
+#endif /* VERBOSE */
+    rec = startrec;
+    wait_cell_turn(INIT_STATE_TURN);
+    ErrorFlag = initialize_model_state(&all_vars, dmy[0], &global_param, *filep,
+                                       soil_con->gridcel, veg_con[0].vegetat_type_num,
+                                       options.Nnode,
+                                       atmos[0].air_temp[NR],
+                                       soil_con, veg_con, *lake_con);
+    end_cell_turn(INIT_STATE_TURN);
+    if ( ErrorFlag == ERROR ) {
+      if ( options.CONTINUEONERROR == TRUE ) {
+        // Handle grid cell solution error
+        fprintf(stderr, "ERROR: Grid cell %i failed in record %i so the simulation has not finished.  An incomplete output file has been generated, check your inputs before rerunning the simulation.\n", soil_con->gridcel, rec);
+        InitError = TRUE;
+      } else {
+        // Else exit program on cell solution error as in previous versions
+        sprintf(ErrStr, "ERROR: Grid cell %i failed in record %i so the simulation has ended. Check your inputs before rerunning the simulation.\n", soil_con->gridcel, rec);
+        cell_error(ErrStr);
+        InitError = TRUE;
+      }
+    }
+
+    if (!InitError) {
+
+#if VERBOSE
+      fprintf(stderr,"Running Model\n");
+#endif /* VERBOSE */
+      reset_root_stats();
+
+      /** Update Error Handling Structure **/
+      Error.filep = *filep;
+      Error.out_data_files = out_data_files;
+
+      /** Initialize the storage terms in the water and energy balances **/
+      /** Sending a negative record number (-global_param.nrecs) to put_data() will accomplish this **/
+      ErrorFlag = put_data(&all_vars, &atmos[0], soil_con, veg_con, lake_con, out_data_files, out_data, &save_data, &dmy[0], -global_param.nrecs);
+
+      /******************************************
+        Run Model in Grid Cell for all Time Steps
+      ******************************************/
+
+      for ( rec = startrec ; rec < global_param.nrecs; rec++ ) {
+
+        /**************************************************
+          Compute cell physics for 1 timestep
+        **************************************************/
+        ErrorFlag = full_energy(cellnum, rec, &atmos[rec], &all_vars, dmy, &global_param, lake_con, soil_con, veg_con, *veg_hist);
+
+        /**************************************************
+          Write cell average values for current time step
+        **************************************************/
+        ErrorFlag = put_data(&all_vars, &atmos[rec], soil_con, veg_con, lake_con, out_data_files, out_data, &save_data, &dmy[rec], rec);
+
+        /************************************
+          Save model state at assigned date
+          (after the final time step of the assigned date)
+        ************************************/
+        if ( filep->statefile != NULL
+             &&  ( dmy[rec].year == global_param.stateyear
+                   && dmy[rec].month == global_param.statemonth
+                   && dmy[rec].day == global_param.stateday
+                   && ( rec+1 == global_param.nrecs
+                        || dmy[rec+1].day != global_param.stateday ) ) )
+          write_model_state(&all_vars, &global_param, veg_con->vegetat_type_num, soil_con->gridcel, filep, soil_con, *lake_con);
+
+
+        if ( ErrorFlag == ERROR ) {
+          if ( options.CONTINUEONERROR == TRUE ) {
+            // Handle grid cell solution error
+            fprintf(stderr, "ERROR: Grid cell %i failed in record %i so the simulation has not finished.  An incomplete output file has been generated, check your inputs before rerunning the simulation.\n", soil_con->gridcel, rec);
+            break;
+          } else {
+            // Else exit program on cell solution error as in previous versions
+            sprintf(ErrStr, "ERROR: Grid cell %i failed in record %i so the simulation has ended. Check your inputs before rerunning the simulation.\n", soil_con->gridcel, rec);
+            cell_error(ErrStr);
+            FatalError = TRUE;
+            break;
+          }
+        }
+
+        /** Stop if a cell before this one has failed **/
+        if ( cell_cancelled() ) break;
+
+      } /* End Rec Loop */
+
+#if VERBOSE
+      print_root_stats(soil_con->gridcel);
+#endif /* VERBOSE */
+
+    } /* !InitError */
+
+  } /* !OUTPUT_FORCE */
+
+  close_files(filep,out_data_files,filenames);
+
+  if (!options.OUTPUT_FORCE) {
+
+    free_all_vars(&all_vars,veg_con[0].vegetat_type_num);
+
+  } /* !OUTPUT_FORCE */
+
+  if (InitError || FatalError) return(ERROR);
+
+  return(0);
+
+}
@@ -30,6 +30,7 @@ out_data_file_struct *set_output_defaults(out_data_struct *out_data) {
 	      to set of output variables.  Added volumetric versions
 	      of these too.						TJB
   2013-Dec-27 Moved OUTPUT_FORCE to options_struct.			TJB
+  2015-Feb-02 Allocates each file's aggtype array.			GT
 *************************************************************/
 
   extern option_struct options;
@@ -46,6 +47,7 @@ if(options.OUTPUT_FORCE) {
   strcpy(out_data_files[0].prefix,"full_data");
   out_data_files[0].nvars = 8;
   out_data_files[0].varid = (int *)calloc(out_data_files[0].nvars, sizeof(int));
+  out_data_files[0].aggtype = (int *)calloc(out_data_files[0].nvars, sizeof(int));
 
   // Variables in first file
   filenum = 0;
@@ -115,6 +117,7 @@ else {
   }
   for (filenum=0; filenum<options.Noutfiles; filenum++) {
     out_data_files[filenum].varid = (int *)calloc(out_data_files[filenum].nvars, sizeof(int));
+    out_data_files[filenum].aggtype = (int *)calloc(out_data_files[filenum].nvars, sizeof(int));
   }
 
   // Variables in first file
@@ -81,6 +81,13 @@ static char vcid[] = "$Id$";
   2013-Dec-27 Moved SPATIAL_FROST to options_struct.			TJB
   2014-Mar-28 Removed DIST_PRCP option.					TJB
   2014-May-05 Added logic to handle LAI = 0.				TJB
+  2015-Feb-02 The arguments of func_canopy_energy_bal() are now stored
+	      in a canopy_energy_bal_struct that is passed to
+	      root_brent(), func_canopy_energy_bal() and
+	      error_print_canopy_energy_bal(), replacing the va_list
+	      argument lists.						GT
+  2015-Feb-02 The foliage temperature is found by root_solve(), with
+	      the previous foliage temperature as first guess.		GT
 *****************************************************************************/
 int snow_intercept(double  Dt,
 		   double  F,  
@@ -189,6 +196,7 @@ int snow_intercept(double  Dt,
   double  Catm; //
 
   char ErrorString[MAXSTRING];
+  canopy_energy_bal_struct canopy_args;
 
   AirDens   = atmos->density[hidx];
   EactAir   = atmos->vp[hidx];
@@ -340,39 +348,71 @@ int snow_intercept(double  Dt,
     *Tfoliage = Tcanopy;
   }
 
+  /* Store the arguments of the canopy energy balance; NetShortOver
+     is stored once the canopy albedo is known */
+  canopy_args.band           = band;
+  canopy_args.month          = month;
+  canopy_args.rec            = rec;
+  canopy_args.delta_t        = Dt;
+  canopy_args.elevation      = soil_con->elevation;
+  canopy_args.Wmax           = soil_con->max_moist;
+  canopy_args.Wcr            = soil_con->Wcr;
+  canopy_args.Wpwp           = soil_con->Wpwp;
+  canopy_args.depth          = soil_con->depth;
+  canopy_args.frost_fract    = soil_con->frost_fract;
+  canopy_args.AirDens        = AirDens;
+  canopy_args.EactAir        = EactAir;
+  canopy_args.Press          = Press;
+  canopy_args.Le             = Le;
+  canopy_args.Tcanopy        = Tcanopy;
+  canopy_args.Vpd            = Vpd;
+  canopy_args.shortwave      = shortwave;
+  canopy_args.Catm           = Catm;
+  canopy_args.dryFrac        = dryFrac;
+  canopy_args.Evap           = &Evap;
+  canopy_args.Ra             = Ra;
+  canopy_args.Ra_used        = Ra_used;
+  canopy_args.Rainfall       = *RainFall;
+  canopy_args.Wind           = Wind;
+  canopy_args.UnderStory     = UnderStory;
+  canopy_args.iveg           = iveg;
+  canopy_args.veg_class      = veg_class;
+  canopy_args.displacement   = displacement;
+  canopy_args.ref_height     = ref_height;
+  canopy_args.roughness      = roughness;
+  canopy_args.root           = root;
+  canopy_args.CanopLayerBnd  = CanopLayerBnd;
+  canopy_args.IntRain        = IntRainOrg;
+  canopy_args.IntSnow        = *IntSnow;
+  canopy_args.Wdew           = IntRain;
+  canopy_args.layer          = layer;
+  canopy_args.veg_var        = veg_var;
+  canopy_args.LongOverIn     = LongOverIn;
+  canopy_args.LongUnderOut   = LongUnderOut;
+  canopy_args.AdvectedEnergy = AdvectedEnergy;
+  canopy_args.LatentHeat     = LatentHeat;
+  canopy_args.LatentHeatSub  = LatentHeatSub;
+  canopy_args.LongOverOut    = LongOverOut;
+  canopy_args.NetLongOver    = NetLongOver;
+  canopy_args.NetRadiation   = &NetRadiation;
+  canopy_args.RefreezeEnergy = &RefreezeEnergy;
+  canopy_args.SensibleHeat   = SensibleHeat;
+  canopy_args.VaporMassFlux  = VaporMassFlux;
+
+  Tupper = Tlower = MISSING;
+
   /* Calculate the net radiation at the canopy surface, using the canopy 
      temperature.  The outgoing longwave is subtracted twice, because the 
      canopy radiates in two directions */
 
-  Tupper = Tlower = MISSING;
-
   if ( *IntSnow > 0 || *SnowFall > 0 ) {
     /* Snow present or accumulating in the canopy */
 
     *AlbedoOver = NEW_SNOW_ALB; // albedo of intercepted snow in canopy
     *NetShortOver = (1. - *AlbedoOver) * ShortOverIn; // net SW in canopy
 
-    Qnet = solve_canopy_energy_bal(0., band, month, rec, Dt, 
-				   soil_con->elevation, soil_con->max_moist,
-				   soil_con->Wcr, soil_con->Wpwp, 
-				   soil_con->depth, 
-				   soil_con->frost_fract, 
-				   AirDens, EactAir, Press, Le, 
-				   Tcanopy, Vpd,
-				   shortwave, Catm, dryFrac,
-				   &Evap, Ra, Ra_used,
-				   *RainFall, Wind, UnderStory, iveg, 
-				   veg_class, displacement, ref_height, 
-				   roughness, root, CanopLayerBnd, 
-				   IntRainOrg, *IntSnow, 
-				   IntRain, layer, veg_var, 
-				   LongOverIn, LongUnderOut, 
-				   *NetShortOver, 
-				   AdvectedEnergy, 
-				   LatentHeat, LatentHeatSub, 
-				   LongOverOut, NetLongOver, &NetRadiation, 
-				   &RefreezeEnergy, SensibleHeat, 
-				   VaporMassFlux);
+    canopy_args.NetShortOver = *NetShortOver;
+    Qnet = func_canopy_energy_bal(0., &canopy_args);
 
     if ( Qnet != 0 ) {
       /* Intercepted snow not melting - need to find temperature */
@@ -396,24 +436,9 @@ int snow_intercept(double  Dt,
 
   if ( Tupper != MISSING && Tlower != MISSING ) {
 
-    *Tfoliage = root_brent(Tlower, Tupper, ErrorString, func_canopy_energy_bal,  band, 
-			   month, rec, Dt, soil_con->elevation, soil_con->max_moist, 
-			   soil_con->Wcr, soil_con->Wpwp, soil_con->depth, 
-			   soil_con->frost_fract, 
-			   AirDens, EactAir, Press, Le, 
-			   Tcanopy, Vpd, shortwave, Catm, dryFrac,
-			   &Evap, Ra, Ra_used,
-			   *RainFall, Wind, UnderStory, iveg, 
-			   veg_class, displacement, ref_height, 
-			   roughness, root, CanopLayerBnd, IntRainOrg, *IntSnow, 
-			   IntRain, layer, veg_var, 
-			   LongOverIn, LongUnderOut, 
-			   *NetShortOver, 
-			   AdvectedEnergy, 
-			   LatentHeat, LatentHeatSub, 
-			   LongOverOut, NetLongOver, &NetRadiation, 
-			   &RefreezeEnergy, SensibleHeat, 
-			   VaporMassFlux);
+    canopy_args.NetShortOver   = *NetShortOver;
+    *Tfoliage = root_solve(ROOT_CANOPY, *Tfoliage, Tlower, Tupper, ErrorString,
+			   func_canopy_energy_bal, &canopy_args);
     
     if ( *Tfoliage <= -998 ) {
       if (options.TFALLBACK) {
@@ -422,47 +447,12 @@ int snow_intercept(double  Dt,
         (*Tfoliage_fbcount)++;
       }
       else { 
-        Qnet = error_calc_canopy_energy_bal(*Tfoliage, band, month, rec, Dt, 
-					    soil_con->elevation, soil_con->max_moist, 
-					    soil_con->Wcr, soil_con->Wpwp, 
-					    soil_con->depth, 
-					    soil_con->frost_fract, 
-					    AirDens, EactAir, Press, Le, 
-					    Tcanopy, Vpd, shortwave, Catm, dryFrac,
-					    &Evap, Ra, Ra_used,
-					    *RainFall, Wind, UnderStory, iveg, 
-					    veg_class, displacement, ref_height, 
-					    roughness, root, CanopLayerBnd, IntRainOrg, *IntSnow, 
-					    IntRain, layer, veg_var, 
-					    LongOverIn, LongUnderOut, *NetShortOver, 
-					    AdvectedEnergy, 
-					    LatentHeat, LatentHeatSub, 
-					    LongOverOut, NetLongOver, &NetRadiation, 
-					    &RefreezeEnergy, SensibleHeat, 
-					    VaporMassFlux, ErrorString);
+        Qnet = error_print_canopy_energy_bal(*Tfoliage, &canopy_args, ErrorString);
         return( ERROR );
       }
     }
     
-    Qnet = solve_canopy_energy_bal(*Tfoliage, band, month, rec, Dt, 
-				   soil_con->elevation, soil_con->max_moist, soil_con->Wcr, 
-				   soil_con->Wpwp, soil_con->depth, 
-				   soil_con->frost_fract, 
-				   AirDens, EactAir, Press, Le, 
-				   Tcanopy, Vpd, shortwave, Catm, dryFrac,
-				   &Evap, Ra, Ra_used,
-				   *RainFall, Wind, UnderStory, iveg, 
-				   veg_class, displacement, ref_height, 
-				   roughness, root, CanopLayerBnd,
-				   IntRainOrg, *IntSnow, 
-				   IntRain, layer, veg_var, 
-				   LongOverIn, LongUnderOut, 
-				   *NetShortOver, 
-				   AdvectedEnergy, 
-				   LatentHeat, LatentHeatSub, 
-				   LongOverOut, NetLongOver, &NetRadiation, 
-				   &RefreezeEnergy, SensibleHeat, 
-				   VaporMassFlux);
+    Qnet = func_canopy_energy_bal(*Tfoliage, &canopy_args);
 
   }
 
@@ -629,31 +619,9 @@ int snow_intercept(double  Dt,
 
 }
 
-double solve_canopy_energy_bal(double Tfoliage, ...)
-{
-  va_list  ap;
-  double   Qnet;
-
-  va_start(ap, Tfoliage);
-  Qnet = func_canopy_energy_bal(Tfoliage, ap);
-  va_end(ap);
-
-  return Qnet;
-}
-
-double error_calc_canopy_energy_bal(double Tfoliage, ...)
-{
-  va_list  ap;
-  double   Qnet;
-
-  va_start(ap, Tfoliage);
-  Qnet = error_print_canopy_energy_bal(Tfoliage, ap);
-  va_end(ap);
-
-  return Qnet;
-}
-
-double error_print_canopy_energy_bal(double Tfoliage, va_list ap)
+double error_print_canopy_energy_bal(double Tfoliage,
+				     canopy_energy_bal_struct *args,
+				     char *ErrorString)
 {  
 
   extern option_struct options;
@@ -725,78 +693,76 @@ double error_print_canopy_energy_bal(double Tfoliage, va_list ap)
   double *SensibleHeat;
   double *VaporMassFlux;
 
-  char *ErrorString;
   int   cidx;
 
-  /** Read variables from variable length argument list **/
+  /** Read variables from argument struct **/
 
   /* General Model Parameters */
-  band    = (int) va_arg(ap, int);
-  month   = (int) va_arg(ap, int);
-  rec     = (int) va_arg(ap, int);
+  band    = args->band;
+  month   = args->month;
+  rec     = args->rec;
 
-  delta_t   = (double) va_arg(ap, double);
-  elevation = (double) va_arg(ap, double);
+  delta_t   = args->delta_t;
+  elevation = args->elevation;
 
-  Wmax  = (double *) va_arg(ap, double *);
-  Wcr   = (double *) va_arg(ap, double *);
-  Wpwp  = (double *) va_arg(ap, double *);
-  depth = (double *) va_arg(ap, double *);
-  frost_fract = (double *) va_arg(ap, double *);
+  Wmax  = args->Wmax;
+  Wcr   = args->Wcr;
+  Wpwp  = args->Wpwp;
+  depth = args->depth;
+  frost_fract = args->frost_fract;
 
   /* Atmopheric Condition and Forcings */
-  AirDens = (double) va_arg(ap, double);
-  EactAir = (double) va_arg(ap, double);
-  Press   = (double) va_arg(ap, double);
-  Le      = (double) va_arg(ap, double);
-  Tcanopy = (double) va_arg(ap, double);
-  Vpd     = (double) va_arg(ap, double);
-  shortwave=(double) va_arg(ap, double);
-  Catm    = (double) va_arg(ap, double);
-  dryFrac = (double *) va_arg(ap, double *);
-
-  Evap     = (double *) va_arg(ap, double *);
-  Ra       = (double *) va_arg(ap, double *);
-  Ra_used  = (double *) va_arg(ap, double *);
-  Rainfall = (double) va_arg(ap, double);
-  Wind     = (double *) va_arg(ap, double *);
+  AirDens = args->AirDens;
+  EactAir = args->EactAir;
+  Press   = args->Press;
+  Le      = args->Le;
+  Tcanopy = args->Tcanopy;
+  Vpd     = args->Vpd;
+  shortwave= args->shortwave;
+  Catm    = args->Catm;
+  dryFrac = args->dryFrac;
+
+  Evap     = args->Evap;
+  Ra       = args->Ra;
+  Ra_used  = args->Ra_used;
+  Rainfall = args->Rainfall;
+  Wind     = args->Wind;
 
   /* Vegetation Terms */
-  UnderStory = (int) va_arg(ap, int);
-  iveg       = (int) va_arg(ap, int);
-  veg_class  = (int) va_arg(ap, int);
+  UnderStory = args->UnderStory;
+  iveg       = args->iveg;
+  veg_class  = args->veg_class;
 
-  displacement = (double *) va_arg(ap, double *);
-  ref_height   = (double *) va_arg(ap, double *);
-  roughness    = (double *) va_arg(ap, double *);
+  displacement = args->displacement;
+  ref_height   = args->ref_height;
+  roughness    = args->roughness;
 
-  root = (float *) va_arg(ap, float *);
-  CanopLayerBnd = (double *) va_arg(ap, double *);
+  root = args->root;
+  CanopLayerBnd = args->CanopLayerBnd;
 
   /* Water Flux Terms */
-  IntRain = (double) va_arg(ap, double);
-  IntSnow = (double) va_arg(ap, double);
+  IntRain = args->IntRain;
+  IntSnow = args->IntSnow;
 
-  Wdew    = (double *) va_arg(ap, double *);
+  Wdew    = args->Wdew;
 
-  layer   = (layer_data_struct *) va_arg(ap, layer_data_struct *);
-  veg_var = (veg_var_struct *) va_arg(ap, veg_var_struct *);
+  layer   = args->layer;
+  veg_var = args->veg_var;
 
   /* Energy Flux Terms */
-  LongOverIn       = (double) va_arg(ap, double);
-  LongUnderOut     = (double) va_arg(ap, double);
-  NetShortOver     = (double) va_arg(ap, double);
-
-  AdvectedEnergy     = (double *) va_arg(ap, double *);
-  LatentHeat         = (double *) va_arg(ap, double *);
-  LatentHeatSub      = (double *) va_arg(ap, double *);
-  LongOverOut        = (double *) va_arg(ap, double *);
-  NetLongOver        = (double *) va_arg(ap, double *);
-  NetRadiation       = (double *) va_arg(ap, double *);
-  RefreezeEnergy     = (double *) va_arg(ap, double *);
-  SensibleHeat       = (double *) va_arg(ap, double *);
-  VaporMassFlux      = (double *) va_arg(ap, double *);
-  ErrorString        = (char *) va_arg(ap, char *);
+  LongOverIn       = args->LongOverIn;
+  LongUnderOut     = args->LongUnderOut;
+  NetShortOver     = args->NetShortOver;
+
+  AdvectedEnergy     = args->AdvectedEnergy;
+  LatentHeat         = args->LatentHeat;
+  LatentHeatSub      = args->LatentHeatSub;
+  LongOverOut        = args->LongOverOut;
+  NetLongOver        = args->NetLongOver;
+  NetRadiation       = args->NetRadiation;
+  RefreezeEnergy     = args->RefreezeEnergy;
+  SensibleHeat       = args->SensibleHeat;
+  VaporMassFlux      = args->VaporMassFlux;
 
   /** Print variable info */
   fprintf(stderr, "%s", ErrorString);
@@ -14,7 +14,6 @@
  * COMMENTS:     
  */
 
-#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <vicNl.h>
@@ -115,6 +114,14 @@ static char vcid[] = "$Id$";
   2007-Aug-31 Checked root_brent return value against -998 rather than -9998.    JCA
   2009-Sep-19 Added T fbcount to count TFALLBACK occurrences.		TJB
   2009-Oct-08 Extended T fallback scheme to snow and ice T.		TJB
+  2015-Feb-02 The arguments of SnowPackEnergyBalance() are now stored
+	      in a snow_pack_energy_bal_struct that is passed to
+	      root_brent(), SnowPackEnergyBalance() and
+	      ErrorPrintSnowPackEnergyBalance(), replacing the va_list
+	      argument lists and the CalcSnowPackEnergyBalance() and
+	      ErrorSnowPackEnergyBalance() wrappers.			GT
+  2015-Feb-02 The surface layer temperature is found by root_solve(),
+	      with the previous surface temperature as first guess.	GT
 *****************************************************************************/
 int  snow_melt(double            Le, 
                double            NetShortSnow,  // net SW at absorbed by snow
@@ -188,6 +195,7 @@ int  snow_melt(double            Le,
   double melt_energy = 0.;
 
   char ErrorString[MAXSTRING];
+  snow_pack_energy_bal_struct snow_args;
 
   SnowFall = snowfall / 1000.; /* convet to m */
   RainFall = rainfall / 1000.; /* convet to m */
@@ -243,23 +251,49 @@ int  snow_melt(double            Le,
   Ice += SnowFall;
   snow->surf_water += RainFall;
   
+  /* Store the arguments of the snowpack energy balance */
+  snow_args.rec                 = rec;
+  snow_args.iveg                = iveg;
+  snow_args.band                = band;
+  snow_args.Dt                  = delta_t;
+  snow_args.Ra                  = aero_resist;
+  snow_args.Ra_used             = aero_resist_used;
+  snow_args.Displacement        = displacement;
+  snow_args.Z                   = z2;
+  snow_args.Z0                  = Z0;
+  snow_args.AirDens             = density;
+  snow_args.EactAir             = vp;
+  snow_args.LongSnowIn          = LongSnowIn;
+  snow_args.Lv                  = Le;
+  snow_args.Press               = pressure;
+  snow_args.Rain                = RainFall;
+  snow_args.NetShortUnder       = NetShortSnow;
+  snow_args.Vpd                 = vpd;
+  snow_args.Wind                = wind;
+  snow_args.OldTSurf            = (*OldTSurf);
+  snow_args.SnowCoverFract      = coverage;
+  snow_args.SnowDepth           = snow->depth;
+  snow_args.SnowDensity         = snow->density;
+  snow_args.SurfaceLiquidWater  = snow->surf_water;
+  snow_args.SweSurfaceLayer     = SurfaceSwq;
+  snow_args.Tair                = Tcanopy;
+  snow_args.TGrnd               = Tgrnd;
+  snow_args.AdvectedEnergy      = &advection;
+  snow_args.AdvectedSensibleHeat= &advected_sensible_heat;
+  snow_args.DeltaColdContent    = &deltaCC;
+  snow_args.GroundFlux          = &grnd_flux;
+  snow_args.LatentHeat          = &latent_heat;
+  snow_args.LatentHeatSub       = &latent_heat_sub;
+  snow_args.NetLongUnder        = NetLongSnow;
+  snow_args.RefreezeEnergy      = &RefreezeEnergy;
+  snow_args.SensibleHeat        = &sensible_heat;
+  snow_args.vapor_flux          = &snow->vapor_flux;
+  snow_args.blowing_flux        = &snow->blowing_flux;
+  snow_args.surface_flux        = &snow->surface_flux;
+
   /* Calculate the surface energy balance for snow_temp = 0.0 */
   
-  Qnet = CalcSnowPackEnergyBalance((double)0.0, delta_t, aero_resist, aero_resist_used,
-				   displacement, z2, Z0, 
-				   density, vp, LongSnowIn, Le, pressure,
-				   RainFall, NetShortSnow, vpd, 
-				   wind, (*OldTSurf), coverage, 
-				   snow->depth, snow->density,
-				   snow->surf_water, SurfaceSwq, 
-				   Tcanopy, Tgrnd, 
-				   &advection, &advected_sensible_heat, 
-				   &deltaCC, 
-				   &grnd_flux, &latent_heat, 
-				   &latent_heat_sub, NetLongSnow, 
-				   &RefreezeEnergy, &sensible_heat, 
-				   &snow->vapor_flux, &snow->blowing_flux,
-				   &snow->surface_flux);
+  Qnet = SnowPackEnergyBalance((double)0.0, &snow_args);
 
   /* Check that snow swq exceeds minimum value for model stability */
 //  if ( SurfaceSwq > MIN_SWQ_EB_THRES && !UNSTABLE_SNOW ) {
@@ -339,24 +373,11 @@ int  snow_melt(double            Le,
     else  {
       /* Calculate surface layer temperature using "Brent method" */
       if (SurfaceSwq > MIN_SWQ_EB_THRES) {
-	snow->surf_temp = root_brent((double)(snow->surf_temp-SNOW_DT), 
+	snow->surf_temp = root_solve(ROOT_SNOW, snow->surf_temp,
+				     (double)(snow->surf_temp-SNOW_DT), 
 				     (double)(snow->surf_temp+SNOW_DT),
 				     ErrorString, SnowPackEnergyBalance, 
-				     delta_t, aero_resist, aero_resist_used,
-				     displacement, z2, Z0, 
-				     density, vp, LongSnowIn, Le, pressure,
-				     RainFall, NetShortSnow, vpd, 
-				     wind, (*OldTSurf), coverage, 
-				     snow->depth, snow->density, 
-				     snow->surf_water, SurfaceSwq, 
-				     Tcanopy, Tgrnd, 
-				     &advection, &advected_sensible_heat, 
-				     &deltaCC, 
-				     &grnd_flux, &latent_heat, 
-				     &latent_heat_sub, NetLongSnow, 
-				     &RefreezeEnergy, &sensible_heat, 
-				     &snow->vapor_flux, &snow->blowing_flux,
-				     &snow->surface_flux);
+				     &snow_args);
       
         if (snow->surf_temp <= -998) {
           if (options.TFALLBACK) {
@@ -365,22 +386,8 @@ int  snow_melt(double            Le,
             snow->surf_temp_fbcount++;
           }
           else {
-	    error = ErrorSnowPackEnergyBalance(snow->surf_temp, rec, iveg, band,
-					 delta_t, aero_resist, aero_resist_used,
-					 displacement, z2, Z0, 
-					 density, vp, LongSnowIn, Le, pressure,
-					 RainFall, NetShortSnow, vpd, 
-					 wind, (*OldTSurf), coverage, 
-					 snow->depth, snow->density,
-					 snow->surf_water, SurfaceSwq, 
-					 Tcanopy, Tgrnd, 
-					 &advection, &advected_sensible_heat, 
-					 &deltaCC, 
-					 &grnd_flux, &latent_heat, 
-					 &latent_heat_sub, 
-					 NetLongSnow, &RefreezeEnergy, 
-					 &sensible_heat, &snow->vapor_flux,
-					 &snow->blowing_flux, &snow->surface_flux);
+	    error = ErrorPrintSnowPackEnergyBalance(snow->surf_temp, &snow_args,
+						    ErrorString);
             return(ERROR);
           }
         }
@@ -391,22 +398,7 @@ int  snow_melt(double            Le,
 	snow->surf_temp = 999;
       }
       if (snow->surf_temp > -998 && snow->surf_temp < 999) {
-	Qnet = CalcSnowPackEnergyBalance(snow->surf_temp, 
-					 delta_t, aero_resist, aero_resist_used,
-					 displacement, z2, Z0, 
-					 density, vp, LongSnowIn, Le, pressure,
-					 RainFall, NetShortSnow, vpd, 
-					 wind, (*OldTSurf), coverage, 
-					 snow->depth, snow->density,
-					 snow->surf_water, SurfaceSwq, 
-					 Tcanopy, Tgrnd, 
-					 &advection, &advected_sensible_heat, 
-					 &deltaCC, 
-					 &grnd_flux, &latent_heat, 
-					 &latent_heat_sub, 
-					 NetLongSnow, &RefreezeEnergy, 
-					 &sensible_heat, &snow->vapor_flux,
-					 &snow->blowing_flux, &snow->surface_flux);
+	Qnet = SnowPackEnergyBalance(snow->surf_temp, &snow_args);
 	
 	/* since we iterated, the surface layer is below freezing and no snowmelt */ 
 	
@@ -578,57 +570,12 @@ int  snow_melt(double            Le,
   return ( 0 );
 }
 
-/*****************************************************************************
-  Function name: CalcSnowPackEnergyBalance()
-
-  Purpose      : Dummy function to make a direct call to
-                 SnowEnergyBalance() possible.
-
-  Required     : 
-    double TSurf - SnowPack surface temperature (C)
-    other arguments required by SnowPackEnergyBalance()
-
-  Returns      :
-    double Qnet - Net energy exchange at the SnowPack snow surface (W/m^2)
-
-  Modifies     : none
-
-  Comments     : function is local to this module
-*****************************************************************************/
-double CalcSnowPackEnergyBalance(double Tsurf, ...)
+double ErrorPrintSnowPackEnergyBalance(double TSurf,
+				       snow_pack_energy_bal_struct *args,
+				       char *ErrorString)
 {
 
-  va_list ap;                   /* Used in traversing variable argument list
-                                 */ 
-  double Qnet;                   /* Net energy exchange at the SnowPack snow
-                                   surface (W/m^2) */
-
-  va_start(ap, Tsurf);
-  Qnet = SnowPackEnergyBalance(Tsurf, ap);
-  va_end(ap);
-  
-  return Qnet;
-}
-
-double ErrorSnowPackEnergyBalance(double Tsurf, ...)
-{
-
-  va_list ap;                   /* Used in traversing variable argument list
-                                 */ 
-  double Qnet;                   /* Net energy exchange at the SnowPack snow
-                                   surface (W/m^2) */
-
-  va_start(ap, Tsurf);
-  Qnet = ErrorPrintSnowPackEnergyBalance(Tsurf, ap);
-  va_end(ap);
-  
-  return Qnet;
-}
-
-double ErrorPrintSnowPackEnergyBalance(double TSurf, va_list ap)
-{
-
-  /* Define Variable Argument List */
+  /* Define Variables */
 
   /* General Model Parameters */
   int rec, iveg, band;
@@ -670,8 +617,6 @@ double ErrorPrintSnowPackEnergyBalance(double TSurf, va_list ap)
 				     area into snow covered area (W/m^2) */
   double *DeltaColdContent;       /* Change in cold content of surface 
 				     layer (W/m2) */
-  double *DeltaPackColdContent;   /* Change in sold content of pack 
-				     layer (W/m^2) */
   double *GroundFlux;		  /* Ground Heat Flux (W/m2) */
   double *LatentHeat;		  /* Latent heat exchange at surface (W/m2) */
   double *LatentHeatSub;          /* Latent heat of sub exchange at 
@@ -688,58 +633,54 @@ double ErrorPrintSnowPackEnergyBalance(double TSurf, va_list ap)
   double *SurfaceMassFlux;          /* Mass flux of water vapor to or from the
 					 intercepted snow */
 
-  char *ErrorString;
-
-  /* Read Variable Argument List */
+  /* Read Variables from Struct */
 
   /* General Model Parameters */
-  rec       = (int) va_arg(ap, int);
-  iveg      = (int) va_arg(ap, int);
-  band      = (int) va_arg(ap, int);
-  Dt        = (double) va_arg(ap, double);
+  rec       = args->rec;
+  iveg      = args->iveg;
+  band      = args->band;
+  Dt        = args->Dt;
 
   /* Vegetation Parameters */
-  Ra           = (double) va_arg(ap, double);
-  Displacement = (double) va_arg(ap, double);
-  Z            = (double) va_arg(ap, double);
-  Z0           = (double) va_arg(ap, double);
+  Ra           = args->Ra;
+  Displacement = args->Displacement;
+  Z            = args->Z;
+  Z0           = *args->Z0;
 
   /* Atmospheric Forcing Variables */
-  AirDens    = (double) va_arg(ap, double);
-  EactAir    = (double) va_arg(ap, double);
-  LongSnowIn = (double) va_arg(ap, double);
-  Lv         = (double) va_arg(ap, double);
-  Press      = (double) va_arg(ap, double);
-  Rain       = (double) va_arg(ap, double);
-  ShortRad   = (double) va_arg(ap, double);
-  Vpd        = (double) va_arg(ap, double);
-  Wind       = (double) va_arg(ap, double);
+  AirDens    = args->AirDens;
+  EactAir    = args->EactAir;
+  LongSnowIn = args->LongSnowIn;
+  Lv         = args->Lv;
+  Press      = args->Press;
+  Rain       = args->Rain;
+  ShortRad   = args->NetShortUnder;
+  Vpd        = args->Vpd;
+  Wind       = args->Wind;
 
   /* Snowpack Variables */
-  OldTSurf           = (double) va_arg(ap, double);
-  SnowCoverFract     = (double) va_arg(ap, double);
-  SnowDensity        = (double) va_arg(ap, double);
-  SurfaceLiquidWater = (double) va_arg(ap, double);
-  SweSurfaceLayer    = (double) va_arg(ap, double);
+  OldTSurf           = args->OldTSurf;
+  SnowCoverFract     = args->SnowCoverFract;
+  SnowDensity        = args->SnowDensity;
+  SurfaceLiquidWater = args->SurfaceLiquidWater;
+  SweSurfaceLayer    = args->SweSurfaceLayer;
 
   /* Energy Balance Components */
-  Tair         = (double) va_arg(ap, double);
-  TGrnd           = (double) va_arg(ap, double);
-
-  AdvectedEnergy        = (double *) va_arg(ap, double *);
-  AdvectedSensibleHeat  = (double *)va_arg(ap, double *);
-  DeltaColdContent      = (double *) va_arg(ap, double *);
-  DeltaPackColdContent  = (double *) va_arg(ap, double *);
-  GroundFlux            = (double *) va_arg(ap, double *);
-  LatentHeat            = (double *) va_arg(ap, double *);
-  LatentHeatSub         = (double *) va_arg(ap, double *);
-  NetLongSnow           = (double *) va_arg(ap, double *);
-  RefreezeEnergy        = (double *) va_arg(ap, double *);
-  SensibleHeat          = (double *) va_arg(ap, double *);
-  VaporMassFlux         = (double *) va_arg(ap, double *);
-  BlowingMassFlux       = (double *) va_arg(ap, double *);
-  SurfaceMassFlux       = (double *) va_arg(ap, double *);
-  ErrorString           = (char *) va_arg(ap, char *);
+  Tair         = args->Tair;
+  TGrnd           = args->TGrnd;
+
+  AdvectedEnergy        = args->AdvectedEnergy;
+  AdvectedSensibleHeat  = args->AdvectedSensibleHeat;
+  DeltaColdContent      = args->DeltaColdContent;
+  GroundFlux            = args->GroundFlux;
+  LatentHeat            = args->LatentHeat;
+  LatentHeatSub         = args->LatentHeatSub;
+  NetLongSnow           = args->NetLongUnder;
+  RefreezeEnergy        = args->RefreezeEnergy;
+  SensibleHeat          = args->SensibleHeat;
+  VaporMassFlux         = args->vapor_flux;
+  BlowingMassFlux       = args->blowing_flux;
+  SurfaceMassFlux       = args->surface_flux;
 
   /* print variables */
   fprintf(stderr, "%s", ErrorString);
@@ -779,7 +720,6 @@ double ErrorPrintSnowPackEnergyBalance(double TSurf, va_list ap)
   fprintf(stderr,"AdvectedEnergy = %f\n",AdvectedEnergy[0]);
   fprintf(stderr,"AdvectedSensibleHeat = %f\n",AdvectedSensibleHeat[0]);
   fprintf(stderr,"DeltaColdContent = %f\n",DeltaColdContent[0]);
-  fprintf(stderr,"DeltaPackColdContent = %f\n",DeltaPackColdContent[0]);
   fprintf(stderr,"GroundFlux = %f\n",GroundFlux[0]);
   fprintf(stderr,"LatentHeat = %f\n",LatentHeat[0]);
   fprintf(stderr,"LatentHeatSub = %f\n",LatentHeatSub[0]);
@@ -37,7 +37,9 @@
 
   programmer: Ted Bohn
   date      : July 25, 2013
-  changes   :
+  changes   : 2015-Feb-02 dZ, dZCum and w are taken from the thread's
+              scratch arrays instead of being allocated on every call;
+              node temperatures are passed directly from energy->T.	GT
   references: 
 ********************************************************************************/
 
@@ -55,6 +57,7 @@ void soil_carbon_balance(soil_con_struct *soil_con,
 {
   extern option_struct options;
   extern global_param_struct global_param;
+  extern THREAD_LOCAL scratch_struct scratch;
   int i;
   int lidx;
   int Nnodes;
@@ -82,10 +85,10 @@ void soil_carbon_balance(soil_con_struct *soil_con,
   if (soil_con->Zsum_node[i] > dZTot) {
     Nnodes--;
   }
-  dZ = (double*)calloc(Nnodes,sizeof(double));
-  dZCum = (double*)calloc(Nnodes,sizeof(double));
-  T = (double*)calloc(Nnodes,sizeof(double));
-  w = (double*)calloc(Nnodes,sizeof(double));
+  dZ = scratch.dZ;
+  dZCum = scratch.dZCum;
+  T = energy->T;
+  w = scratch.w;
 
   // Assign node thicknesses and temperatures for subset
   dZTot = 0;
@@ -93,7 +96,6 @@ void soil_carbon_balance(soil_con_struct *soil_con,
     dZ[i] = soil_con->dz_node[i]*1000; // mm
     dZTot += dZ[i];
     dZCum[i] = dZTot;
-    T[i] = energy->T[i];
   }
 
   // Compute node relative moistures based on lumped water table depth
@@ -138,11 +140,5 @@ void soil_carbon_balance(soil_con_struct *soil_con,
   cell->CInter += (1-fAir)*cell->RhLitter*fInter - cell->RhInter;
   cell->CSlow += (1-fAir)*cell->RhLitter*(1-fInter) - cell->RhSlow;
 
-  // Free temporary dynamic arrays
-  free((char *)dZ);
-  free((char *)dZCum);
-  free((char *)T);
-  free((char *)w);
-
 }
 
@@ -105,6 +105,60 @@ double soil_conductivity(double moist,
   return (K);
 }
 
+double soil_conductivity_slope(double moist, 
+			       double Wu, 
+			       double soil_dens_min, 
+			       double bulk_dens_min,
+			       double quartz,
+			       double soil_density, 
+			       double bulk_density,
+			       double organic) {
+/**********************************************************************
+  Derivative of soil_conductivity() with respect to the liquid water
+  content Wu (W/mK per unit volume fraction), for the same arguments.
+  Used to build the analytic Jacobian of the implicit soil temperature
+  equation (fda_heat_eqn).
+
+  In the frozen case K = (Ksat-Kdry)*Sr+Kdry with
+  Ksat = Ks^(1-n) * Ki^(n-Wu) * Kw^Wu, so dK/dWu = Sr*Ksat*ln(Kw/Ki).
+  Unfrozen soil, dry soil and soil held at Kdry return 0.
+
+  Modifications:
+  2015-Feb-02 Created.							GT
+**********************************************************************/
+
+  double Ki = 2.2;      /* thermal conductivity of ice (W/mK) */
+  double Kw = 0.57;     /* thermal conductivity of water (W/mK) */
+  double Ksat;
+  double Kdry;
+  double Kdry_org = 0.05;
+  double Kdry_min;
+  double Ks;
+  double Ks_org = 0.25;
+  double Ks_min;
+  double Sr;
+  double porosity;
+
+  if(moist<=0. || Wu==moist) return (0.);
+
+  Kdry_min = (0.135*bulk_dens_min+64.7)/(soil_dens_min-0.947*bulk_dens_min);
+  Kdry = (1-organic)*Kdry_min + organic*Kdry_org;
+
+  porosity = 1.0 - bulk_density / soil_density;
+  Sr = moist/porosity;
+
+  if(quartz < .2)
+    Ks_min = pow(7.7,quartz) * pow(3.0,1.0-quartz);
+  else
+    Ks_min = pow(7.7,quartz) * pow(2.2,1.0-quartz);
+  Ks = (1-organic)*Ks_min + organic*Ks_org;
+
+  Ksat = pow(Ks,1.0-porosity) * pow(Ki,porosity-Wu) * pow(Kw,Wu);
+  if((Ksat-Kdry)*Sr < 0.) return (0.);
+
+  return (Sr * Ksat * log(Kw/Ki));
+}
+
 
 double volumetric_heat_capacity(double soil_fract,
                                 double water_fract,
@@ -809,3 +863,29 @@ double maximum_unfrozen_water(double T,
   
 }
 
+double maximum_unfrozen_water_slope(double T,
+                                    double max_moist,
+                                    double bubble,
+                                    double expt) {
+/**********************************************************************
+  Derivative of maximum_unfrozen_water() with respect to T (1/C), for
+  the same arguments.  Zero wherever maximum_unfrozen_water() is
+  limited to max_moist or 0.
+
+  Modifications:
+  2015-Feb-02 Created.							GT
+**********************************************************************/
+
+  double unfrozen;
+  double power;
+
+  if ( T < 0. ) {
+    power = -(2.0 / (expt - 3.0));
+    unfrozen = max_moist * pow((-Lf * T) / 273.16 / (9.81 * bubble / 100.), power);
+    if(unfrozen > max_moist || unfrozen < 0.) return (0.);
+    return (power * unfrozen / T);
+  }
+
+  return (0.);
+
+}
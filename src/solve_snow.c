@@ -139,7 +139,7 @@ double solve_snow(char                 overstory,
 *********************************************************************/
 
   extern option_struct   options;
-  extern veg_lib_struct *veg_lib;
+  extern THREAD_LOCAL veg_lib_struct *veg_lib;
 
   char                ErrStr[MAXSTRING];
   char                FIRST_SOLN[1];
@@ -145,9 +145,23 @@ int surface_fluxes(char                 overstory,
   2014-Mar-28 Removed DIST_PRCP option.					TJB
   2014-Apr-25 Added non-climatological veg parameters.			TJB
   2014-Apr-25 Added partial vegcover fraction.				TJB
+  2015-Feb-02 step_aero_resist is now an array on the stack, and the
+	      canopy layer arrays are taken from the thread's scratch
+	      arrays, instead of being allocated on every call.  Fixes
+	      a leak of store_gsLayer for the bare soil tile.		GT
+  2015-Feb-02 The soil thermal nodes of snow_energy, soil_energy, and
+	      their iteration copies live in the thread's scratch
+	      energy records; records are copied with copy_energy_bal().	GT
+  2015-Feb-02 Removed the iter_* copies of the step records.  The
+	      iteration now works on the step records directly, and
+	      each repeated pass resets only the fields that a pass
+	      modifies, via save_iter_state() and restore_iter_state().	GT
+  2015-Feb-02 Potential evap is only computed when options.OUTPUT_PET
+	      is TRUE; otherwise pot_evap is left at 0.			GT
 **********************************************************************/
 {
-  extern veg_lib_struct *veg_lib;
+  extern THREAD_LOCAL veg_lib_struct *veg_lib;
+  extern THREAD_LOCAL scratch_struct scratch;
   extern option_struct   options;
   double                 total_store_moist[3];
   double                 step_store_moist[3];
@@ -219,7 +233,8 @@ int surface_fluxes(char                 overstory,
   double                 step_out_snow;
   double                 step_ppt;
   double                 step_prec;
-  double               **step_aero_resist;
+  double                 step_aero_resist_data[N_PET_TYPES][2];
+  double                *step_aero_resist[N_PET_TYPES];
 
   // Quantities that need to be summed or averaged over multiple snow steps
   // energy structure
@@ -280,13 +295,8 @@ int surface_fluxes(char                 overstory,
   snow_data_struct       step_snow;
   layer_data_struct      step_layer[MAX_LAYERS];
 
-  // Structures holding values for current iteration
-  energy_bal_struct      iter_snow_energy; // energy fluxes at snowpack surface
-  energy_bal_struct      iter_soil_energy; // energy fluxes at soil surface
-  veg_var_struct         iter_snow_veg_var; // veg fluxes/storages in presence of snow
-  veg_var_struct         iter_soil_veg_var; // veg fluxes/storages in soil energy balance
-  snow_data_struct       iter_snow;
-  layer_data_struct      iter_layer[MAX_LAYERS];
+  // Values for current iteration
+  iter_state_struct     *iter_state; // state each pass starts from
   double                 iter_aero_resist[3];
   double                 iter_aero_resist_used[2];
   double                 stability_factor[2];
@@ -327,9 +337,13 @@ int surface_fluxes(char                 overstory,
   else
     MAX_ITER_GRND_CANOPY = 0;
 
-  if (options.CARBON) {
-    store_gsLayer = (double*)calloc(options.Ncanopy,sizeof(double));
-  }
+  LAIlayer      = scratch.LAIlayer;
+  faPAR         = scratch.faPAR;
+  store_gsLayer = scratch.store_gsLayer;
+
+  snow_energy   = scratch.energy[0];
+  soil_energy   = scratch.energy[1];
+  iter_state    = &scratch.iter_state;
 
   /***********************************************************************
     Set temporary variables for convenience
@@ -341,9 +355,8 @@ int surface_fluxes(char                 overstory,
   inflow = &(cell->inflow);
   layer = cell->layer;
 
-  step_aero_resist = (double**)calloc(N_PET_TYPES,sizeof(double*));
   for (p=0; p<N_PET_TYPES; p++) {
-    step_aero_resist[p] = (double*)calloc(2,sizeof(double));
+    step_aero_resist[p] = step_aero_resist_data[p];
   }
 
   /***********************************************************************
@@ -360,8 +373,8 @@ int surface_fluxes(char                 overstory,
     snow_flux = -(energy->grnd_flux + energy->deltaH + energy->fusion);
   energy->refreeze_energy = 0; 
   coverage                = snow->coverage;
-  snow_energy             = (*energy);
-  soil_energy             = (*energy);
+  copy_energy_bal(&snow_energy, energy);
+  copy_energy_bal(&soil_energy, energy);
   snow_veg_var       = (*veg_var);
   soil_veg_var       = (*veg_var);
   step_snow               = (*snow);
@@ -502,8 +515,6 @@ int surface_fluxes(char                 overstory,
 
     // compute LAI and absorbed PAR per canopy layer
     if (options.CARBON && iveg < Nveg) {
-      LAIlayer = (double *)calloc(options.Ncanopy,sizeof(double));
-      faPAR = (double *)calloc(options.Ncanopy,sizeof(double));
       /* Compute absorbed PAR per ground area per canopy layer (W/m2)
          normalized to PAR = 1 W, i.e. the canopy albedo in the PAR
          range (alb_total ~ 0.45*alb_par + 0.55*alb_other) */
@@ -527,8 +538,6 @@ int surface_fluxes(char                 overstory,
           veg_var->aPAR += atmos->par[hidx] * faPAR[cidx] / 1e-10;
         }
       }
-      free((char*)LAIlayer);
-      free((char*)faPAR);
     }
 
     // initialize bisection startup
@@ -557,6 +566,10 @@ int surface_fluxes(char                 overstory,
     else
       step_snow.blowing_flux = 0.0;
 
+    // store the state that each pass of the iteration starts from
+    save_iter_state(iter_state, &snow_energy, &soil_energy, &snow_veg_var,
+                    &soil_veg_var, &step_snow, step_layer, Nlayers);
+
     do {
 
       /** Iterate for overstory solution **/
@@ -603,7 +616,7 @@ int surface_fluxes(char                 overstory,
 	      UNSTABLE_SNOW = TRUE;
 	  }
 	  else if ( !INCLUDE_SNOW ) { // stepped the wrong way
-	    snow_flux = (last_snow_flux + iter_soil_energy.snow_flux) / 2.;
+	    snow_flux = (last_snow_flux + soil_energy.snow_flux) / 2.;
 	  } 
 	}
 	last_snow_flux = snow_flux;
@@ -613,30 +626,26 @@ int surface_fluxes(char                 overstory,
 	snow_grnd_flux = -snow_flux;
 	
 	// Initialize structures for new iteration
-	iter_snow_energy    = snow_energy;
-	iter_soil_energy    = soil_energy;
-	iter_snow_veg_var = snow_veg_var;
-	iter_soil_veg_var = soil_veg_var;
-	iter_snow           = step_snow;
-	for ( lidx = 0; lidx < Nlayers; lidx++ ) {
-	  iter_layer[lidx] = step_layer[lidx];
-	}
-	iter_snow_veg_var.Wdew = step_Wdew;
-	iter_soil_veg_var.Wdew = step_Wdew;
-	iter_snow_veg_var.canopyevap = 0;
-	iter_soil_veg_var.canopyevap = 0;
+	if ( over_iter > 1 || under_iter > 1 )
+	  restore_iter_state(iter_state, &snow_energy, &soil_energy,
+			     &snow_veg_var, &soil_veg_var, &step_snow,
+			     step_layer, Nlayers);
+	snow_veg_var.Wdew = step_Wdew;
+	soil_veg_var.Wdew = step_Wdew;
+	snow_veg_var.canopyevap = 0;
+	soil_veg_var.canopyevap = 0;
 	for ( lidx = 0; lidx < Nlayers; lidx ++ ) 
-	  iter_layer[lidx].evap = 0;
+	  step_layer[lidx].evap = 0;
 	for (q=0; q<3; q++) {
 	  iter_aero_resist[q] = aero_resist[N_PET_TYPES][q];
 	}
         iter_aero_resist_used[0] = aero_resist_used[0];
         iter_aero_resist_used[1] = aero_resist_used[1];
-	iter_snow.canopy_vapor_flux = 0;
-	iter_snow.vapor_flux = 0;
-	iter_snow.surface_flux = 0;
-        /* iter_snow.blowing_flux has already been reset to step_snow.blowing_flux */
-	LongUnderOut       = iter_soil_energy.LongUnderOut;
+	step_snow.canopy_vapor_flux = 0;
+	step_snow.vapor_flux = 0;
+	step_snow.surface_flux = 0;
+        /* step_snow.blowing_flux is reset with the rest of the snow state */
+	LongUnderOut       = soil_energy.LongUnderOut;
         dryFrac = -1;
 
 	/** Solve snow accumulation, ablation and interception **/
@@ -657,22 +666,22 @@ int surface_fluxes(char                 overstory,
 			       wind, root, UNSTABLE_SNOW, options.Nnode, 
 			       Nveg, iveg, band, step_dt, rec, hidx, veg_class,
 			       &UnderStory, CanopLayerBnd, &dryFrac, 
-			       dmy, atmos, &(iter_snow_energy), 
-			       iter_layer, &(iter_snow), 
+			       dmy, atmos, &(snow_energy), 
+			       step_layer, &(step_snow), 
 			       soil_con, 
-			       &(iter_snow_veg_var));
+			       &(snow_veg_var));
       
-// iter_snow_energy.sensible + iter_snow_energy.latent + iter_snow_energy.latent_sub + NetShortSnow + NetLongSnow + ( snow_grnd_flux + iter_snow_energy.advection - iter_snow_energy.deltaCC + iter_snow_energy.refreeze_energy + iter_snow_energy.advected_sensible ) * step_snow.coverage
+// snow_energy.sensible + snow_energy.latent + snow_energy.latent_sub + NetShortSnow + NetLongSnow + ( snow_grnd_flux + snow_energy.advection - snow_energy.deltaCC + snow_energy.refreeze_energy + snow_energy.advected_sensible ) * step_snow.coverage
         if ( step_melt == ERROR ) return (ERROR);
 
 	/* Check that the snow surface temperature was estimated, if not
 	   prepare to include thin snowpack in the estimation of the
 	   snow-free surface energy balance */
-	if ( ( iter_snow.surf_temp == 999 || UNSTABLE_SNOW ) 
-	     && iter_snow.swq > 0 ) {
+	if ( ( step_snow.surf_temp == 999 || UNSTABLE_SNOW ) 
+	     && step_snow.swq > 0 ) {
 	  INCLUDE_SNOW = UnderStory + 1;
-	  iter_soil_energy.advection = iter_snow_energy.advection;
-	  iter_snow.surf_temp = step_snow.surf_temp;
+	  soil_energy.advection = snow_energy.advection;
+	  step_snow.surf_temp = iter_state->snow.surf_temp;
 	  step_melt_energy = 0;
 	}
 	else {
@@ -685,18 +694,18 @@ int surface_fluxes(char                 overstory,
 	      
 	Tsurf = calc_surf_energy_bal((*Le), LongUnderIn, NetLongSnow, 
 				     NetShortGrnd, NetShortSnow, OldTSurf, 
-				     ShortUnderIn, iter_snow.albedo, 
-				     iter_snow_energy.latent, 
-				     iter_snow_energy.latent_sub, 
-				     iter_snow_energy.sensible, 
+				     ShortUnderIn, step_snow.albedo, 
+				     snow_energy.latent, 
+				     snow_energy.latent_sub, 
+				     snow_energy.sensible, 
 				     Tcanopy, VPDcanopy, 
-				     VPcanopy, iter_snow_energy.advection, 
-				     step_snow.coldcontent, delta_coverage, dp, 
+				     VPcanopy, snow_energy.advection, 
+				     iter_state->snow.coldcontent, delta_coverage, dp, 
 				     ice0, step_melt_energy, moist0,
-				     iter_snow.coverage, 
-				     (step_snow.depth + iter_snow.depth) / 2., 
+				     step_snow.coverage, 
+				     (iter_state->snow.depth + step_snow.depth) / 2., 
 				     BareAlbedo, surf_atten, 
-				     iter_snow.vapor_flux,
+				     step_snow.vapor_flux,
 				     iter_aero_resist, iter_aero_resist_used,
 				     displacement, &step_melt, &step_ppt, 
 				     rainfall, ref_height, roughness, 
@@ -705,10 +714,10 @@ int surface_fluxes(char                 overstory,
 				     step_dt, hidx, iveg, options.Nlayer, 
 				     (int)overstory, rec, veg_class, 
 				     CanopLayerBnd, &dryFrac, atmos, 
-				     &(dmy[rec]), &iter_soil_energy, 
-				     iter_layer, 
-				     &(iter_snow), soil_con, 
-				     &iter_soil_veg_var, gp->nrecs); 
+				     &(dmy[rec]), &soil_energy, 
+				     step_layer, 
+				     &(step_snow), soil_con, 
+				     &soil_veg_var, gp->nrecs); 
 
         if ( (int)Tsurf == ERROR ) {
           // Return error flag to skip rest of grid cell
@@ -723,31 +732,31 @@ int surface_fluxes(char                 overstory,
 	/*****************************************
           Compute energy balance with atmosphere
         *****************************************/
-	if ( iter_snow.snow && overstory ) {
+	if ( step_snow.snow && overstory ) {
 	  // do this if overstory is active and energy balance is closed
-	  Tcanopy = calc_atmos_energy_bal(iter_snow_energy.canopy_sensible,
-					  iter_soil_energy.sensible, 
-					  iter_snow_energy.canopy_latent, 
-					  iter_soil_energy.latent, 
-					  iter_snow_energy.canopy_latent_sub, 
-					  iter_soil_energy.latent_sub, 
+	  Tcanopy = calc_atmos_energy_bal(snow_energy.canopy_sensible,
+					  soil_energy.sensible, 
+					  snow_energy.canopy_latent, 
+					  soil_energy.latent, 
+					  snow_energy.canopy_latent_sub, 
+					  soil_energy.latent_sub, 
 					  (*Le),
-					  iter_snow_energy.NetLongOver, 
-					  iter_soil_energy.NetLongUnder, 
-					  iter_snow_energy.NetShortOver, 
-					  iter_soil_energy.NetShortUnder, 
+					  snow_energy.NetLongOver, 
+					  soil_energy.NetLongUnder, 
+					  snow_energy.NetShortOver, 
+					  soil_energy.NetShortUnder, 
 					  iter_aero_resist_used[1], Tair, 
 					  atmos->density[hidx], 
 					  atmos->vp[hidx], atmos->vpd[hidx], 
-					  &iter_soil_energy.AtmosError, 
-					  &iter_soil_energy.AtmosLatent,
-					  &iter_soil_energy.AtmosLatentSub,
-					  &iter_soil_energy.NetLongAtmos, 
-					  &iter_soil_energy.NetShortAtmos, 
-					  &iter_soil_energy.AtmosSensible, 
+					  &soil_energy.AtmosError, 
+					  &soil_energy.AtmosLatent,
+					  &soil_energy.AtmosLatentSub,
+					  &soil_energy.NetLongAtmos, 
+					  &soil_energy.NetShortAtmos, 
+					  &soil_energy.AtmosSensible, 
 					  &VPcanopy, &VPDcanopy,
-					  &iter_soil_energy.Tcanopy_fbflag,
-					  &iter_soil_energy.Tcanopy_fbcount);
+					  &soil_energy.Tcanopy_fbflag,
+					  &soil_energy.Tcanopy_fbcount);
 	  /* iterate to find Tcanopy which will solve the atmospheric energy
 	     balance.  Since I do not know vp in the canopy, use the
 	     sum of latent heats from the ground and foliage, and iterate
@@ -761,33 +770,33 @@ int surface_fluxes(char                 overstory,
 	else {
 	  // else put surface fluxes into atmospheric flux storage so that 
 	  // the model will continue to function
-	  iter_soil_energy.AtmosLatent    = iter_soil_energy.latent;
-	  iter_soil_energy.AtmosLatentSub = iter_soil_energy.latent_sub;
-	  iter_soil_energy.AtmosSensible  = iter_soil_energy.sensible;
-	  iter_soil_energy.NetLongAtmos   = iter_soil_energy.NetLongUnder;
-	  iter_soil_energy.NetShortAtmos  = iter_soil_energy.NetShortUnder;
+	  soil_energy.AtmosLatent    = soil_energy.latent;
+	  soil_energy.AtmosLatentSub = soil_energy.latent_sub;
+	  soil_energy.AtmosSensible  = soil_energy.sensible;
+	  soil_energy.NetLongAtmos   = soil_energy.NetLongUnder;
+	  soil_energy.NetShortAtmos  = soil_energy.NetShortUnder;
 	}
-	iter_soil_energy.Tcanopy = Tcanopy;
-	iter_snow_energy.Tcanopy = Tcanopy;
+	soil_energy.Tcanopy = Tcanopy;
+	snow_energy.Tcanopy = Tcanopy;
 
 	/*****************************************
           Compute iteration tolerance statistics 
         *****************************************/
 
 	// compute understory tolerance
-	if ( INCLUDE_SNOW || ( iter_snow.swq == 0 && delta_coverage == 0 ) ) {
+	if ( INCLUDE_SNOW || ( step_snow.swq == 0 && delta_coverage == 0 ) ) {
 	  store_tol_under = 0;
 	  tol_under       = 0;
 	}
 	else {
-	  store_tol_under = snow_flux - iter_soil_energy.snow_flux;
+	  store_tol_under = snow_flux - soil_energy.snow_flux;
 	  tol_under       = fabs(store_tol_under);
 	}
 	if ( fabs( tol_under - last_tol_under ) < GRND_TOL && tol_under > 1. )
 	  tol_under = -999;
 
 	// compute overstory tolerance
-	if ( overstory && iter_snow.snow ) {
+	if ( overstory && step_snow.snow ) {
 	  store_tol_over = Tcanopy - last_Tcanopy;
 	  tol_over       = fabs( store_tol_over );
 	}
@@ -807,108 +816,101 @@ int surface_fluxes(char                 overstory,
       Compute GPP, Raut, and NPP
     **************************************/
     if (options.CARBON) {
-      if (iveg < Nveg && !step_snow.snow && dryFrac > 0) {
+      if (iveg < Nveg && !iter_state->snow.snow && dryFrac > 0) {
         canopy_assimilation(veg_lib[veg_class].Ctype,
                             veg_lib[veg_class].MaxCarboxRate,
                             veg_lib[veg_class].MaxETransport,
                             veg_lib[veg_class].CO2Specificity,
-                            iter_soil_veg_var.NscaleFactor,
+                            soil_veg_var.NscaleFactor,
                             Tair,
                             atmos->shortwave[hidx],
-                            iter_soil_veg_var.aPARLayer,
+                            soil_veg_var.aPARLayer,
                             soil_con->elevation,
                             atmos->Catm[hidx],
                             CanopLayerBnd,
                             veg_var->LAI,
                             "rs",
-                            iter_soil_veg_var.rsLayer,
-                            &(iter_soil_veg_var.rc),
-                            &(iter_soil_veg_var.Ci),
-                            &(iter_soil_veg_var.GPP),
-                            &(iter_soil_veg_var.Rdark),
-                            &(iter_soil_veg_var.Rphoto),
-                            &(iter_soil_veg_var.Rmaint),
-                            &(iter_soil_veg_var.Rgrowth),
-                            &(iter_soil_veg_var.Raut),
-                            &(iter_soil_veg_var.NPP));
+                            soil_veg_var.rsLayer,
+                            &(soil_veg_var.rc),
+                            &(soil_veg_var.Ci),
+                            &(soil_veg_var.GPP),
+                            &(soil_veg_var.Rdark),
+                            &(soil_veg_var.Rphoto),
+                            &(soil_veg_var.Rmaint),
+                            &(soil_veg_var.Rgrowth),
+                            &(soil_veg_var.Raut),
+                            &(soil_veg_var.NPP));
         /* Adjust by fraction of canopy that was dry and account for any other inhibition`*/
-        dryFrac *= iter_soil_veg_var.NPPfactor;
-        iter_soil_veg_var.GPP *= dryFrac;
-        iter_soil_veg_var.Rdark *= dryFrac;
-        iter_soil_veg_var.Rphoto *= dryFrac;
-        iter_soil_veg_var.Rmaint *= dryFrac;
-        iter_soil_veg_var.Rgrowth *= dryFrac;
-        iter_soil_veg_var.Raut *= dryFrac;
-        iter_soil_veg_var.NPP *= dryFrac;
+        dryFrac *= soil_veg_var.NPPfactor;
+        soil_veg_var.GPP *= dryFrac;
+        soil_veg_var.Rdark *= dryFrac;
+        soil_veg_var.Rphoto *= dryFrac;
+        soil_veg_var.Rmaint *= dryFrac;
+        soil_veg_var.Rgrowth *= dryFrac;
+        soil_veg_var.Raut *= dryFrac;
+        soil_veg_var.NPP *= dryFrac;
         /* Adjust by veg cover fraction */
-        iter_soil_veg_var.GPP *= iter_soil_veg_var.vegcover;
-        iter_soil_veg_var.Rdark *= iter_soil_veg_var.vegcover;
-        iter_soil_veg_var.Rphoto *= iter_soil_veg_var.vegcover;
-        iter_soil_veg_var.Rmaint *= iter_soil_veg_var.vegcover;
-        iter_soil_veg_var.Rgrowth *= iter_soil_veg_var.vegcover;
-        iter_soil_veg_var.Raut *= iter_soil_veg_var.vegcover;
-        iter_soil_veg_var.NPP *= iter_soil_veg_var.vegcover;
+        soil_veg_var.GPP *= soil_veg_var.vegcover;
+        soil_veg_var.Rdark *= soil_veg_var.vegcover;
+        soil_veg_var.Rphoto *= soil_veg_var.vegcover;
+        soil_veg_var.Rmaint *= soil_veg_var.vegcover;
+        soil_veg_var.Rgrowth *= soil_veg_var.vegcover;
+        soil_veg_var.Raut *= soil_veg_var.vegcover;
+        soil_veg_var.NPP *= soil_veg_var.vegcover;
       }
       else {
-        iter_soil_veg_var.rc = HUGE_RESIST;
+        soil_veg_var.rc = HUGE_RESIST;
         for (cidx=0; cidx<options.Ncanopy; cidx++)
-          iter_soil_veg_var.rsLayer[cidx] = HUGE_RESIST;
-        iter_soil_veg_var.Ci = 0;
-        iter_soil_veg_var.GPP = 0;
-        iter_soil_veg_var.Rdark = 0;
-        iter_soil_veg_var.Rphoto = 0;
-        iter_soil_veg_var.Rmaint = 0;
-        iter_soil_veg_var.Rgrowth = 0;
-        iter_soil_veg_var.Raut = 0;
-        iter_soil_veg_var.NPP = 0;
+          soil_veg_var.rsLayer[cidx] = HUGE_RESIST;
+        soil_veg_var.Ci = 0;
+        soil_veg_var.GPP = 0;
+        soil_veg_var.Rdark = 0;
+        soil_veg_var.Rphoto = 0;
+        soil_veg_var.Rmaint = 0;
+        soil_veg_var.Rgrowth = 0;
+        soil_veg_var.Raut = 0;
+        soil_veg_var.NPP = 0;
       }
     }
 
     /**************************************
       Compute Potential Evap
     **************************************/
-    // First, determine the stability correction used in the iteration
-    if (iter_aero_resist_used[0] == HUGE_RESIST)
-      stability_factor[0] = HUGE_RESIST;
-    else
-      stability_factor[0] = iter_aero_resist_used[0]/aero_resist[N_PET_TYPES][UnderStory];
-    if (iter_aero_resist_used[1] == iter_aero_resist_used[0])
-      stability_factor[1] = stability_factor[0];
-    else {
-      if (iter_aero_resist_used[1] == HUGE_RESIST)
-        stability_factor[1] = HUGE_RESIST;
+    if (options.OUTPUT_PET) {
+      // First, determine the stability correction used in the iteration
+      if (iter_aero_resist_used[0] == HUGE_RESIST)
+        stability_factor[0] = HUGE_RESIST;
       else
-        stability_factor[1] = iter_aero_resist_used[1]/aero_resist[N_PET_TYPES][1];
-    }
+        stability_factor[0] = iter_aero_resist_used[0]/aero_resist[N_PET_TYPES][UnderStory];
+      if (iter_aero_resist_used[1] == iter_aero_resist_used[0])
+        stability_factor[1] = stability_factor[0];
+      else {
+        if (iter_aero_resist_used[1] == HUGE_RESIST)
+          stability_factor[1] = HUGE_RESIST;
+        else
+          stability_factor[1] = iter_aero_resist_used[1]/aero_resist[N_PET_TYPES][1];
+      }
 
-    // Next, loop over pot_evap types and apply the correction to the relevant aerodynamic resistance
-    for (p=0; p<N_PET_TYPES; p++) {
-      if (stability_factor[0] == HUGE_RESIST)
-        step_aero_resist[p][0] = HUGE_RESIST;
-      else
-        step_aero_resist[p][0] = aero_resist[p][UnderStory]*stability_factor[0];
-      if (stability_factor[1] == HUGE_RESIST)
-        step_aero_resist[p][1] = HUGE_RESIST;
-      else
-        step_aero_resist[p][1] = aero_resist[p][1]*stability_factor[1];
-    }
+      // Next, loop over pot_evap types and apply the correction to the relevant aerodynamic resistance
+      for (p=0; p<N_PET_TYPES; p++) {
+        if (stability_factor[0] == HUGE_RESIST)
+          step_aero_resist[p][0] = HUGE_RESIST;
+        else
+          step_aero_resist[p][0] = aero_resist[p][UnderStory]*stability_factor[0];
+        if (stability_factor[1] == HUGE_RESIST)
+          step_aero_resist[p][1] = HUGE_RESIST;
+        else
+          step_aero_resist[p][1] = aero_resist[p][1]*stability_factor[1];
+      }
 
-    // Finally, compute pot_evap
-    compute_pot_evap(veg_class, dmy, rec, gp->dt, atmos->shortwave[hidx], iter_soil_energy.NetLongAtmos, Tair, VPDcanopy, soil_con->elevation, step_aero_resist, iter_pot_evap);
+      // Finally, compute pot_evap
+      compute_pot_evap(veg_class, dmy, rec, gp->dt, atmos->shortwave[hidx], soil_energy.NetLongAtmos, Tair, VPDcanopy, soil_con->elevation, step_aero_resist, iter_pot_evap);
+    }
 
     /**************************************
       Store sub-model time step variables 
     **************************************/
 
-    snow_energy = iter_snow_energy;
-    soil_energy = iter_soil_energy;
-    snow_veg_var = iter_snow_veg_var;
-    soil_veg_var = iter_soil_veg_var;
-    step_snow = iter_snow;
-    for(lidx = 0; lidx < options.Nlayer; lidx++) {
-      step_layer[lidx] = iter_layer[lidx];
-    }
-
     if(iveg != Nveg) {
       if(step_snow.snow) {
         store_throughfall += snow_veg_var.throughfall;
@@ -1015,8 +1017,10 @@ int surface_fluxes(char                 overstory,
       store_snow_flux         += soil_energy.snow_flux * (step_snow.coverage + delta_coverage); 
       store_refreeze_energy   += snow_energy.refreeze_energy * (step_snow.coverage + delta_coverage); 
     }
-    for (p=0; p<N_PET_TYPES; p++)
-      store_pot_evap[p] += iter_pot_evap[p];
+    if (options.OUTPUT_PET) {
+      for (p=0; p<N_PET_TYPES; p++)
+        store_pot_evap[p] += iter_pot_evap[p];
+    }
 
     /* increment time step */
     N_steps ++;
@@ -1041,7 +1045,7 @@ int surface_fluxes(char                 overstory,
     Store energy flux averages for sub-model time steps 
   ******************************************************/
 
-  (*energy) = soil_energy;
+  copy_energy_bal(energy, &soil_energy);
   energy->AlbedoOver        = store_AlbedoOver / (double)N_steps; 
   energy->AlbedoUnder       = store_AlbedoUnder / (double)N_steps;
   energy->AtmosLatent       = store_AtmosLatent / (double)N_steps; 
@@ -1122,11 +1126,6 @@ int surface_fluxes(char                 overstory,
   for (p=0; p<N_PET_TYPES; p++)
     pot_evap[p] = store_pot_evap[p]/(double)N_steps;
 
-  for (p=0; p<N_PET_TYPES; p++) {
-    free((char *)step_aero_resist[p]);
-  }
-  free((char *)step_aero_resist);
-
   /**********************************************************
     Store carbon cycle variable sums for sub-model time steps
   **********************************************************/
@@ -1145,8 +1144,6 @@ int surface_fluxes(char                 overstory,
     veg_var->Raut     = store_Raut/(double)N_steps;
     veg_var->NPP      = store_NPP/(double)N_steps;
 
-    free((char *)(store_gsLayer));
-
     soil_carbon_balance(soil_con,energy,cell,veg_var);
 
     // Update running total annual NPP
@@ -98,46 +98,61 @@ int main(int argc, char *argv[])
 	      OUTPUT_FORCE condition to avoid memory leak.		TJB
   2014-Mar-28 Removed DIST_PRCP option.					TJB
   2014-Apr-25 Added non-climatological veg parameters.			TJB
+  2015-Feb-02 Moved the per-cell simulation into run_cell().  Added
+	      the threaded cell driver: when options.NTHREADS > 1, cell
+	      parameters are still read here, in order, but the cells
+	      are run by worker threads.  read_snowband() is now called
+	      before the cell's files are opened.			GT
+  2015-Feb-02 Added sharding: when options.NSHARDS > 1, parameters are
+	      read for all active cells, but only the cells in this
+	      shard are run.						GT
+  2015-Feb-02 With PREFETCH = TRUE, cells are always run by worker
+	      threads, so that this thread can read the next cell's
+	      parameters and forcings while the current one runs.	GT
+  2015-Feb-02 Start the asynchronous output writer (ASYNC_OUTPUT) when
+	      cells are run by this thread.				GT
+  2015-Feb-02 veg_hist is allocated once per run, like atmos.	GT
+  2015-Feb-02 Added call to free_radgeom_cache().			GT
+  2015-Feb-02 Cell parameters are allocated from param_arena, which
+	      is reset before each cell is read, instead of being freed
+	      one array at a time.					GT
+  2015-Feb-02 Added call to set_output_active().			GT
+  2015-Feb-02 With OUTPUT_CONTAINER, the output containers are opened
+	      before the first cell is run and closed after the last.	GT
+  2015-Feb-02 Added call to set_output_aggregation().		GT
+  2015-Feb-02 A grid cell error that ends the simulation in a worker
+	      thread is reported here with vicerror() once
+	      finish_cell_threads() has returned.			GT
 **********************************************************************/
 {
 
-  extern veg_lib_struct *veg_lib;
+  extern THREAD_LOCAL veg_lib_struct *veg_lib;
   extern option_struct options;
-  extern Error_struct Error;
   extern global_param_struct global_param;
+  extern THREAD_LOCAL arena_struct param_arena;
+  extern THREAD_LOCAL arena_struct cell_arena;
 
   /** Variable Declarations **/
 
-  char                     NEWCELL;
-  char                     LASTREC;
   char                     MODEL_DONE;
   char                     RUN_MODEL;
-  char                     ErrStr[MAXSTRING];
-  int                      rec, i, j;
-  int                      veg;
-  int                      band;
+  char                     THREADED;
   int                      Nveg_type;
+  int                      Nveg_hist;
   int                      cellnum;
-  int                      index;
-  int                      Ncells;
   int                      startrec;
   int                      ErrorFlag;
-  double                   storage;
-  double                   veg_fract;
-  double                   band_fract;
-  double                   Clake;
+  char                     ErrStr[MAXSTRING];
   dmy_struct              *dmy;
   atmos_data_struct       *atmos;
   veg_hist_struct        **veg_hist;
   veg_con_struct          *veg_con;
   soil_con_struct          soil_con;
-  all_vars_struct          all_vars;
   filenames_struct         filenames;
   filep_struct             filep;
   lake_con_struct          lake_con;
   out_data_file_struct     *out_data_files;
   out_data_struct          *out_data;
-  save_data_struct         save_data;
   
   /** Read Model Options **/
   initialize_global();
@@ -157,6 +172,8 @@ int main(int argc, char *argv[])
   fclose(filep.globalparam);
   filep.globalparam = open_file(filenames.global,"r");
   parse_output_info(&filenames, filep.globalparam, &out_data_files, out_data);
+  set_output_active(out_data_files, out_data);
+  set_output_aggregation(out_data_files, out_data);
 
   /** Check and Open Files **/
   check_files(&filep, &filenames);
@@ -168,12 +185,30 @@ int main(int argc, char *argv[])
 
   /** Initialize Parameters **/
   cellnum = -1;
+  veg_con = NULL;
 
   /** Make Date Data Structure **/
   dmy      = make_dmy(&global_param);
 
+  /** Open the output containers (all cells go into one file per prefix) **/
+  if (options.OUTPUT_CONTAINER)
+    open_output_containers(out_data_files, out_data, dmy, &global_param,
+                           &filenames);
+
+  /** Cells are run by worker threads if more than one thread was requested,
+      or if input is to be read ahead of the simulation **/
+  THREADED = (options.NTHREADS > 1 || options.PREFETCH);
+
   /** allocate memory for the atmos_data_struct **/
-  alloc_atmos(global_param.nrecs, &atmos);
+  /** (worker threads allocate their own) **/
+  /** veg_hist is allocated by run_cell() when the first cell is run **/
+  veg_hist  = NULL;
+  Nveg_hist = 0;
+  if (!THREADED) {
+    alloc_atmos(global_param.nrecs, &atmos);
+    if (options.ASYNC_OUTPUT)
+      start_output_writer(options.OUTPUT_QUEUE_LEN);
+  }
 
   /** Initial state **/
   startrec = 0;
@@ -195,14 +230,20 @@ int main(int argc, char *argv[])
   /************************************
     Run Model for all Active Grid Cells
     ************************************/
+  if (THREADED)
+    start_cell_threads(options.NTHREADS, dmy, startrec, &filep, &filenames,
+                       out_data_files, out_data);
+
   MODEL_DONE = FALSE;
   while(!MODEL_DONE) {
 
+    /** Release the previous cell's parameters **/
+    reset_arena(&param_arena);
+
     soil_con = read_soilparam(filep.soilparam, &RUN_MODEL, &MODEL_DONE);
 
     if(RUN_MODEL) {
 
-      NEWCELL=TRUE;
       cellnum++;
 
       if (!options.OUTPUT_FORCE) {
@@ -215,152 +256,64 @@ int main(int argc, char *argv[])
         if ( options.LAKES ) 
 	  lake_con = read_lakeparam(filep.lakeparam, soil_con, veg_con);
 
-      } /* !OUTPUT_FORCE */
-
-      /** Build Gridded Filenames, and Open **/
-      make_in_and_outfiles(&filep, &filenames, &soil_con, out_data_files);
-
-      if (options.PRT_HEADER) {
-        /** Write output file headers **/
-        write_header(out_data_files, out_data, dmy, global_param);
-      }
-
-      if (!options.OUTPUT_FORCE) {
-
         /** Read Elevation Band Data if Used **/
         read_snowband(filep.snowband, &soil_con);
 
-        /** Make Top-level Control Structure **/
-        all_vars     = make_all_vars(veg_con[0].vegetat_type_num);
-
-        /** allocate memory for the veg_hist_struct **/
-        alloc_veg_hist(global_param.nrecs, veg_con[0].vegetat_type_num, &veg_hist);
-
       } /* !OUTPUT_FORCE */
 
-      /**************************************************
-         Initialize Meteological Forcing Values That
-         Have not Been Specifically Set
-       **************************************************/
+      if (cellnum % options.NSHARDS != options.SHARD) {
 
-#if VERBOSE
-      fprintf(stderr,"Initializing Forcing Data\n");
-#endif /* VERBOSE */
-
-      initialize_atmos(atmos, dmy, filep.forcing, veg_lib, veg_con, veg_hist,
-		       &soil_con, out_data_files, out_data); 
-
-      if (!options.OUTPUT_FORCE) {
+        /** Cell belongs to another shard **/
+        ErrorFlag = 0;
 
-        /**************************************************
-          Initialize Energy Balance and Snow Variables 
-        **************************************************/
-
-#if VERBOSE
-        fprintf(stderr,"Model State Initialization\n");
-#endif /* VERBOSE */
-        ErrorFlag = initialize_model_state(&all_vars, dmy[0], &global_param, filep, 
-			       soil_con.gridcel, veg_con[0].vegetat_type_num,
-			       options.Nnode, 
-			       atmos[0].air_temp[NR],
-			       &soil_con, veg_con, lake_con);
-        if ( ErrorFlag == ERROR ) {
-	  if ( options.CONTINUEONERROR == TRUE ) {
-	    // Handle grid cell solution error
-	    fprintf(stderr, "ERROR: Grid cell %i failed in record %i so the simulation has not finished.  An incomplete output file has been generated, check your inputs before rerunning the simulation.\n", soil_con.gridcel, rec);
-	    break;
-	  } else {
-	    // Else exit program on cell solution error as in previous versions
-	    sprintf(ErrStr, "ERROR: Grid cell %i failed in record %i so the simulation has ended. Check your inputs before rerunning the simulation.\n", soil_con.gridcel, rec);
-	    vicerror(ErrStr);
-	  }
-        }
-      
-#if VERBOSE
-        fprintf(stderr,"Running Model\n");
-#endif /* VERBOSE */
-
-        /** Update Error Handling Structure **/
-        Error.filep = filep;
-        Error.out_data_files = out_data_files;
-
-        /** Initialize the storage terms in the water and energy balances **/
-        /** Sending a negative record number (-global_param.nrecs) to put_data() will accomplish this **/
-	ErrorFlag = put_data(&all_vars, &atmos[0], &soil_con, veg_con, &lake_con, out_data_files, out_data, &save_data, &dmy[0], -global_param.nrecs);
-
-        /******************************************
-	  Run Model in Grid Cell for all Time Steps
-	******************************************/
-
-        for ( rec = startrec ; rec < global_param.nrecs; rec++ ) {
-
-          if ( rec == global_param.nrecs - 1 ) LASTREC = TRUE;
-          else LASTREC = FALSE;
-
-	  /**************************************************
-	    Compute cell physics for 1 timestep
-	  **************************************************/
-	  ErrorFlag = full_energy(cellnum, rec, &atmos[rec], &all_vars, dmy, &global_param, &lake_con, &soil_con, veg_con, veg_hist);
-
-	  /**************************************************
-	    Write cell average values for current time step
-	  **************************************************/
-	  ErrorFlag = put_data(&all_vars, &atmos[rec], &soil_con, veg_con, &lake_con, out_data_files, out_data, &save_data, &dmy[rec], rec);
-
-	  /************************************
-	    Save model state at assigned date
-	    (after the final time step of the assigned date)
-	  ************************************/
-	  if ( filep.statefile != NULL
-	       &&  ( dmy[rec].year == global_param.stateyear
-		     && dmy[rec].month == global_param.statemonth 
-		     && dmy[rec].day == global_param.stateday
-		     && ( rec+1 == global_param.nrecs
-			  || dmy[rec+1].day != global_param.stateday ) ) )
-	    write_model_state(&all_vars, &global_param, veg_con->vegetat_type_num, soil_con.gridcel, &filep, &soil_con, lake_con);
-
-
-          if ( ErrorFlag == ERROR ) {
-            if ( options.CONTINUEONERROR == TRUE ) {
-              // Handle grid cell solution error
-              fprintf(stderr, "ERROR: Grid cell %i failed in record %i so the simulation has not finished.  An incomplete output file has been generated, check your inputs before rerunning the simulation.\n", soil_con.gridcel, rec);
-              break;
-            } else {
-	      // Else exit program on cell solution error as in previous versions
-              sprintf(ErrStr, "ERROR: Grid cell %i failed in record %i so the simulation has ended. Check your inputs before rerunning the simulation.\n", soil_con.gridcel, rec);
-              vicerror(ErrStr);
-	    }
-          }
-
-          NEWCELL=FALSE;
-
-        } /* End Rec Loop */
+      }
+      else if (THREADED) {
 
-      } /* !OUTPUT_FORCE */
+        /** Hand the cell to the worker threads **/
+        if (queue_cell(cellnum, &soil_con, veg_con, &lake_con) == ERROR)
+          break;
+        continue;
 
-      close_files(&filep,out_data_files,&filenames); 
+      }
+      else {
 
-      if (!options.OUTPUT_FORCE) {
+        /** Run the cell **/
+        ErrorFlag = run_cell(cellnum, &soil_con, veg_con, &lake_con, NULL,
+                             NULL, dmy,
+                             startrec, &filep, &filenames, atmos,
+                             &veg_hist, &Nveg_hist, out_data_files, out_data);
 
-        free_veg_hist(global_param.nrecs, veg_con[0].vegetat_type_num, &veg_hist);
-        free_all_vars(&all_vars,veg_con[0].vegetat_type_num);
-        free_vegcon(&veg_con);
-        free((char *)soil_con.AreaFract);
-        free((char *)soil_con.BandElev);
-        free((char *)soil_con.Tfactor);
-        free((char *)soil_con.Pfactor);
-        free((char *)soil_con.AboveTreeLine);
+      }
 
-      } /* !OUTPUT_FORCE */
+      if ( ErrorFlag == ERROR ) break;
 
     }	/* End Run Model Condition */
   } 	/* End Grid Loop */
 
+  if (THREADED) {
+    /** Cells before a cell whose error ends the simulation have now
+        finished, so the error can be reported **/
+    if (finish_cell_threads(ErrStr) == ERROR)
+      vicerror(ErrStr);
+  }
+
   /** cleanup **/
-  free_atmos(global_param.nrecs, &atmos);
+  if (!THREADED) {
+    finish_output_writer();
+    free_atmos(global_param.nrecs, &atmos);
+    free_veg_hist(global_param.nrecs, Nveg_hist, &veg_hist);
+  }
+  if (options.OUTPUT_CONTAINER) {
+    close_output_containers();
+    free_output_containers();
+  }
   free_dmy(&dmy);
   free_out_data_files(&out_data_files);
   free_out_data(&out_data);
+  free_radgeom_cache();
+  free_arena(&param_arena);
+  if (!THREADED)
+    free_arena(&cell_arena);
   fclose(filep.soilparam);
   if (!options.OUTPUT_FORCE) {
     free_veglib(&veg_lib);
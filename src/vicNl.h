@@ -124,6 +124,69 @@
   2014-Apr-25 Added non-climatological veg parameter functions.		TJB
   2014-Apr-25 Resurrected calc_veg_displacement() and
 	      calc_veg_roughness().					TJB
+  2015-Feb-02 Added the threaded cell driver functions:		GT
+	      copy_out_data_files
+	      copy_output_list
+	      end_cell_turn
+	      finish_cell_threads
+	      queue_cell
+	      run_cell
+	      start_cell_threads
+	      wait_cell_turn
+  2015-Feb-02 Added read_cell_forcing(); added forcing arrays to the
+	      argument lists of initialize_atmos() and run_cell().	GT
+  2015-Feb-02 Added the asynchronous output writer functions:	GT
+	      end_output_record
+	      finish_output_writer
+	      flush_output_writer
+	      output_fwrite
+	      start_output_writer
+  2015-Feb-02 Added open_compressed_file().				GT
+  2015-Feb-02 Added veg_hist to the argument list of run_cell().	GT
+  2015-Feb-02 Added the forcing cache functions:			GT
+	      forcing_cache_key
+	      read_forcing_cache
+	      write_forcing_cache
+	      and free_cell_forcing().
+  2015-Feb-02 Added set_veg_forcing_nelem().			GT
+  2015-Feb-02 root_brent() and the functions it solves now take their
+	      arguments in a struct (void *) instead of a va_list.
+	      Removed the following wrapper functions:			GT
+		CalcSnowPackEnergyBalance
+		error_calc_atmos_energy_bal
+		error_calc_canopy_energy_bal
+		error_calc_surf_energy_bal
+		error_solve_T_profile
+		ErrorSnowPackEnergyBalance
+		solve_atmos_energy_bal
+		solve_canopy_energy_bal
+		solve_surf_energy_bal
+  2015-Feb-02 Added root_solve(), print_root_stats() and
+	      reset_root_stats().					GT
+  2015-Feb-02 Added maximum_unfrozen_water_slope() and
+	      soil_conductivity_slope().			GT
+  2015-Feb-02 Added free_radgeom_cache().				GT
+  2015-Feb-02 Added arena_calloc(), reset_arena() and free_arena().
+	      Removed free_vegcon().					GT
+  2015-Feb-02 Added make_energy_nodes() and copy_energy_bal().	GT
+  2015-Feb-02 Added save_iter_state() and restore_iter_state().	GT
+  2015-Feb-02 Added set_output_active().				GT
+  2015-Feb-02 Added out_data to the argument list of
+	      make_in_and_outfiles().  Added flush_out_data_file().	GT
+  2015-Feb-02 Added the output container functions:		GT
+	      close_output_containers
+	      finish_container_cell
+	      free_output_containers
+	      open_output_containers
+	      start_container_cell
+	      write_container_chunk
+	      and cellnum to the argument list of make_in_and_outfiles().
+  2015-Feb-02 Added set_output_aggregation().  write_data() now
+	      writes one output file; removed its dt argument.  Added
+	      out_data to the argument list of copy_out_data_files().	GT
+  2015-Feb-02 Added cell_cancelled(), cell_error() and
+	      discard_container_cell().  finish_cell_threads() now
+	      returns the error that ended the simulation.		GT
 ************************************************************************/
 
 #include <math.h>
@@ -135,6 +198,7 @@
 double advected_sensible_heat(double, double, double, double, double);
 void alloc_atmos(int, atmos_data_struct **);
 void alloc_veg_hist(int, int, veg_hist_struct ***);
+void  *arena_calloc(arena_struct *, size_t, size_t);
 double arno_evap(layer_data_struct *, double, double, 
 		 double, double, double, double, double, double, double, 
 		 double, double *);
@@ -163,7 +227,6 @@ int    calc_soil_thermal_fluxes(int, double *, double *, char *, int *, double *
 				double *, double *, double *, 
 				double *, double *, double *, 
 				int, int, int, int);
-double CalcSnowPackEnergyBalance(double Tsurf, ...);
 double CalcBlowingSnow(double, double, int, double, double, double, double, 
                        double, double, double, double, double, float, 
                        float, double, int, int, float, double, double, double *); 
@@ -206,10 +269,13 @@ double canopy_evap(layer_data_struct *,
 		   double, double, double, double, double, 
 		   double *, double *, double *, double *, double *,
                    float *, double *, double, double, double *);
+int    cell_cancelled();
+int    cell_error(char *);
 void   check_files(filep_struct *, filenames_struct *);
 FILE  *check_state_file(char *, dmy_struct *, global_param_struct *, int, int, 
                         int *);
 void   close_files(filep_struct *, out_data_file_struct *, filenames_struct *);
+void   close_output_containers();
 filenames_struct cmd_proc(int argc, char *argv[]);
 void   collect_eb_terms(energy_bal_struct, snow_data_struct, cell_data_struct,
                         int *, int *, int *, int *, int *, double, double, double,
@@ -231,9 +297,13 @@ void   compute_soil_layer_thermal_properties(layer_data_struct *, double *,
                                              double *, int);
 void   compute_treeline(atmos_data_struct *, dmy_struct *, double, double *, char *);
 double compute_zwt(soil_con_struct *, int, double);
+void   copy_energy_bal(energy_bal_struct *, energy_bal_struct *);
+out_data_file_struct *copy_out_data_files(out_data_file_struct *, out_data_struct *);
+out_data_struct *copy_output_list(out_data_struct *);
 out_data_struct *create_output_list();
 
 double darkinhib(double);
+void   discard_container_cell(out_data_file_struct *);
 void   display_current_settings(int, filenames_struct *, global_param_struct *);
 int  distribute_node_moisture_properties(double *, double *, double *, 
 					 double *, double *, double *,
@@ -244,18 +314,15 @@ void   distribute_soil_property(double *,double,double,
 				double **l_param,
 				int, int, double *, double *);
 
-double error_calc_atmos_energy_bal(double Tcanopy, ...);
 double error_calc_atmos_moist_bal(double , ...);
-double error_calc_canopy_energy_bal(double Tsurf, ...);
-double error_calc_surf_energy_bal(double Tsurf, ...);
-double ErrorSnowPackEnergyBalance(double Tsurf, ...);
-double error_print_atmos_energy_bal(double, va_list);
+double error_print_atmos_energy_bal(double, atmos_energy_bal_struct *, char *);
 double error_print_atmos_moist_bal(double, va_list);
-double error_print_canopy_energy_bal(double, va_list);
-double ErrorPrintSnowPackEnergyBalance(double, va_list);
-double error_print_solve_T_profile(double, va_list);
-double error_print_surf_energy_bal(double, va_list);
-double error_solve_T_profile(double Tsurf, ...);
+double error_print_canopy_energy_bal(double, canopy_energy_bal_struct *, char *);
+void   end_cell_turn(int);
+void   end_output_record();
+double ErrorPrintSnowPackEnergyBalance(double, snow_pack_energy_bal_struct *, char *);
+double error_print_solve_T_profile(double, soil_node_struct *, char *);
+double error_print_surf_energy_bal(double, surf_energy_bal_struct *, char *);
 double estimate_dew_point(double, double, double, double, double);
 int estimate_layer_ice_content(layer_data_struct *, double *, double *,
 			       double *, double *, double *, double *,
@@ -277,24 +344,34 @@ void   fda_heat_eqn(double *, double *, int, int, ...);
 void   fdjac3(double *, double *, double *, double *, double *,
             void (*vecfunc)(double *, double *, int, int, ...), 
             int);
+int    finish_cell_threads(char *);
+void   finish_container_cell(out_data_file_struct *);
+void   finish_output_writer();
+void   flush_out_data_file(out_data_file_struct *);
+void   flush_output_writer();
 void   find_0_degree_fronts(energy_bal_struct *, double *, double *, int);
+unsigned long long forcing_cache_key(double **, double ***, soil_con_struct *,
+                                     veg_con_struct *, veg_lib_struct *);
 layer_data_struct find_average_layer(layer_data_struct *, layer_data_struct *,
 				     double, double);
 void   free_atmos(int nrecs, atmos_data_struct **atmos);
 void   free_all_vars(all_vars_struct *, int);
+void   free_arena(arena_struct *);
+void   free_cell_forcing(double **, double ***);
 void   free_dmy(dmy_struct **dmy);
 void   free_veg_hist(int nrecs, int nveg, veg_hist_struct ***veg_hist);
-void   free_vegcon(veg_con_struct **);
 void   free_veglib(veg_lib_struct **);
 void   free_out_data_files(out_data_file_struct **);
 void   free_out_data(out_data_struct **);
+void   free_output_containers();
+void   free_radgeom_cache();
 int    full_energy(int, int, atmos_data_struct *, all_vars_struct *,
 		   dmy_struct *, global_param_struct *, lake_con_struct *,
                    soil_con_struct *, veg_con_struct *, veg_hist_struct **);
-double func_atmos_energy_bal(double, va_list);
+double func_atmos_energy_bal(double, void *);
 double func_atmos_moist_bal(double, va_list);
-double func_canopy_energy_bal(double, va_list);
-double func_surf_energy_bal(double, va_list);
+double func_canopy_energy_bal(double, void *);
+double func_surf_energy_bal(double, void *);
 double get_dist(double, double, double, double);
 void   get_force_type(char *, int, int *);
 global_param_struct get_global_param(filenames_struct *, FILE *);
@@ -306,7 +383,7 @@ double hiTinhib(double);
 void   HourlyT(int, int, int *, double *, int *, double *, double *);
 
 void   init_output_list(out_data_struct *, int, char *, int, float);
-void   initialize_atmos(atmos_data_struct *, dmy_struct *, FILE **,
+void   initialize_atmos(atmos_data_struct *, dmy_struct *, double **, double ***,
 			veg_lib_struct *, veg_con_struct *, veg_hist_struct **,
 			soil_con_struct *, out_data_file_struct *, out_data_struct *);
 void   initialize_global();
@@ -329,12 +406,15 @@ cell_data_struct **make_cell_data(int, int);
 all_vars_struct make_all_vars(int);
 dmy_struct *make_dmy(global_param_struct *);
 energy_bal_struct **make_energy_bal(int);
-void make_in_and_outfiles(filep_struct *, filenames_struct *, 
-			  soil_con_struct *, out_data_file_struct *);
+void   make_energy_nodes(energy_bal_struct *);
+void make_in_and_outfiles(int, filep_struct *, filenames_struct *, 
+			  soil_con_struct *, out_data_file_struct *,
+			  out_data_struct *);
 snow_data_struct **make_snow_data(int);
 veg_var_struct **make_veg_var(int);
 void   MassRelease(double *,double *,double *,double *);
 double maximum_unfrozen_water(double, double, double, double);
+double maximum_unfrozen_water_slope(double, double, double, double);
 double modify_Ksat(double);
 void mtclim_wrapper(int, int, double, double, double, double,
                       double, double, double, double,
@@ -346,8 +426,13 @@ int    newt_raph(void (*vecfunc)(double *, double *, int, int, ...),
                double *, int);
 void   nrerror(char *);
 
+FILE  *open_compressed_file(char string[], char type[]);
 FILE  *open_file(char string[], char type[]);
+void   open_output_containers(out_data_file_struct *, out_data_struct *,
+                              dmy_struct *, global_param_struct *,
+                              filenames_struct *);
 FILE  *open_state_file(global_param_struct *, filenames_struct, int, int);
+void   output_fwrite(const void *, size_t, size_t, FILE *);
 
 void parse_output_info(filenames_struct *, FILE *, out_data_file_struct **, out_data_struct *);
 double penman(double, double, double, double, double, double, double);
@@ -380,6 +465,7 @@ void print_option(option_struct *option);
 void print_out_data(out_data_struct *out, size_t nelem);
 void print_out_data_file(out_data_file_struct *outf);
 void print_param_set(param_set_struct *param_set);
+void print_root_stats(int);
 void print_save_data(save_data_struct *save);
 void print_snow_data(snow_data_struct *snow);
 void print_soil_con(soil_con_struct *scon, size_t nlayers, size_t nnodes,
@@ -389,24 +475,47 @@ void print_veg_con(veg_con_struct *vcon, size_t nroots, char blowing, char lake,
 void print_veg_lib(veg_lib_struct *vlib, char carbon);
 void print_veg_var(veg_var_struct *vvar, size_t ncanopy);
 void   read_atmos_data(FILE *, global_param_struct, int, int, double **, double ***);
+double **read_cell_forcing(filep_struct *, filenames_struct *, soil_con_struct *,
+                           veg_con_struct *, double ****);
+int    read_forcing_cache(char *, unsigned long long, soil_con_struct *, int,
+                          atmos_data_struct *, veg_hist_struct **);
 double **read_forcing_data(FILE **, global_param_struct, double ****);
 void   read_initial_model_state(FILE *, all_vars_struct *, 
 				global_param_struct *, int, int, int, 
 				soil_con_struct *, lake_con_struct);
 void   read_snowband(FILE *, soil_con_struct *);
 soil_con_struct read_soilparam(FILE *, char *, char *);
+int    queue_cell(int, soil_con_struct *, veg_con_struct *, lake_con_struct *);
 veg_lib_struct *read_veglib(FILE *, int *);
 veg_con_struct *read_vegparam(FILE *, int, int);
+void   reset_arena(arena_struct *);
+void   reset_root_stats();
 void   redistribute_moisture(layer_data_struct *, double *, double *,
 			     double *, double *, double *, int);
-double root_brent(double, double, char *, double (*Function)(double, va_list), ...);
+void   restore_iter_state(iter_state_struct *, energy_bal_struct *,
+                          energy_bal_struct *, veg_var_struct *,
+                          veg_var_struct *, snow_data_struct *,
+                          layer_data_struct *, int);
+double root_brent(double, double, char *, double (*Function)(double, void *), void *);
+double root_solve(int, double, double, double, char *, double (*Function)(double, void *), void *);
 int    runoff(cell_data_struct *, energy_bal_struct *, soil_con_struct *,
               double, double *, int, int, int, int, int);
+int    run_cell(int, soil_con_struct *, veg_con_struct *, lake_con_struct *,
+                double **, double ***, dmy_struct *, int, filep_struct *, filenames_struct *,
+                atmos_data_struct *, veg_hist_struct ***, int *,
+                out_data_file_struct *, out_data_struct *);
 
+void   save_iter_state(iter_state_struct *, energy_bal_struct *,
+                       energy_bal_struct *, veg_var_struct *,
+                       veg_var_struct *, snow_data_struct *,
+                       layer_data_struct *, int);
 void set_max_min_hour(double *, int, int *, int *);
 void set_node_parameters(double *, double *, double *, double *, double *, double *,
 			 double *, double *, double *, double *, double *,
 			 double *, double *, int, int, char);
+void   set_output_active(out_data_file_struct *, out_data_struct *);
+void   set_output_aggregation(out_data_file_struct *, out_data_struct *);
+void   set_veg_forcing_nelem(veg_con_struct *);
 out_data_file_struct *set_output_defaults(out_data_struct *);
 int set_output_var(out_data_file_struct *, int, int, out_data_struct *, char *, int, char *, int, float);
 double snow_albedo(double, double, double, double, double, double, int, char);
@@ -429,11 +538,12 @@ int    snow_melt(double, double, double, double, double *, double, double *, dou
                  double *, double *, double *, double *, double *, double *, 
                  double *, double *, double *, double *, double *, double *, 
                  int, int, int, int, snow_data_struct *, soil_con_struct *);
-double SnowPackEnergyBalance(double, va_list);
+double SnowPackEnergyBalance(double, void *);
 void   soil_carbon_balance(soil_con_struct *, energy_bal_struct *,
                            cell_data_struct *, veg_var_struct *);
 double soil_conductivity(double, double, double, double, double, double, double, double);
-double soil_thermal_eqn(double, va_list);
+double soil_conductivity_slope(double, double, double, double, double, double, double, double);
+double soil_thermal_eqn(double, void *);
 double solve_snow(char, double, double, double, double, double,
                   double, double, double, double, double, double,
                   double *, double *, double *, double *, double *,
@@ -447,10 +557,7 @@ double solve_snow(char, double, double, double, double, double,
                   layer_data_struct *,
                   snow_data_struct *, soil_con_struct *,
                   veg_var_struct *);
-double solve_atmos_energy_bal(double Tcanopy, ...);
 double solve_atmos_moist_bal(double , ...);
-double solve_canopy_energy_bal(double Tfoliage, ...);
-double solve_surf_energy_bal(double Tsurf, ...);
 int    solve_T_profile(double *, double *, char *, int *, double *, double *,double *, 
 		       double *, double, double *, double *, double *,
 		       double *, double *, double *, double *, double, double *,
@@ -472,6 +579,11 @@ int    surface_fluxes(char, double, double, double, double,
                       cell_data_struct *, 
                       snow_data_struct *, soil_con_struct *, 
                       veg_var_struct *, float, float, float, double *);
+void   start_cell_threads(int, dmy_struct *, int, filep_struct *,
+                          filenames_struct *, out_data_file_struct *,
+                          out_data_struct *);
+void   start_container_cell(out_data_file_struct *, int, soil_con_struct *);
+void   start_output_writer(int);
 double svp(double);
 double svp_slope(double);
 
@@ -488,8 +600,12 @@ void usage(char *);
 void   vicerror(char *);
 double volumetric_heat_capacity(double,double,double,double);
 
+void   wait_cell_turn(int);
 void wrap_compute_zwt(soil_con_struct *, cell_data_struct *);
-void write_data(out_data_file_struct *, out_data_struct *, dmy_struct *, int);
+void   write_container_chunk(out_data_file_struct *);
+void write_data(out_data_file_struct *, out_data_struct *, dmy_struct *);
+void write_forcing_cache(char *, unsigned long long, soil_con_struct *, int,
+                         atmos_data_struct *, veg_hist_struct **);
 void write_forcing_file(atmos_data_struct *, int, out_data_file_struct *, out_data_struct *);
 void write_header(out_data_file_struct *, out_data_struct *, dmy_struct *, global_param_struct);
 void write_layer(layer_data_struct *, int, int, 
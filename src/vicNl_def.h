@@ -148,12 +148,58 @@
   2014-Apr-25 Added partial vegcover fraction.				TJB
   2014-May-05 Moved constants CLOSURE, RSMAX, and VPDMINFACTOR from
 	      penman.c to here.						TJB
+  2015-Feb-02 Added THREAD_LOCAL storage qualifier and options.NTHREADS
+	      for the threaded cell driver; moved put_data's step count
+	      and fallback totals into save_data_struct.		GT
+  2015-Feb-02 Added options.SHARD and options.NSHARDS.			GT
+  2015-Feb-02 Added options.PREFETCH.					GT
+  2015-Feb-02 Added options.ASYNC_OUTPUT and options.OUTPUT_QUEUE_LEN.	GT
+  2015-Feb-02 Added options.COMPRESS_LEVEL.				GT
+  2015-Feb-02 Added filenames->forcing_cache.				GT
+  2015-Feb-02 Added argument structs for the functions solved by
+	      root_brent().						GT
+  2015-Feb-02 Added options.ROOT_SOLVER.				GT
+  2015-Feb-02 Added options.IMPLICIT_JACOBIAN.			GT
+  2015-Feb-02 Added arena_struct.					GT
+  2015-Feb-02 Added scratch_struct.					GT
+  2015-Feb-02 The thermal node arrays of soil_con_struct and
+	      energy_bal_struct now point to options.Nnode entries
+	      instead of being embedded with MAX_NODES entries.		GT
+  2015-Feb-02 Added iter_state_struct.					GT
+  2015-Feb-02 Added the active field of out_data_struct and
+	      options.OUTPUT_PET.					GT
+  2015-Feb-02 Added the binary record buffer of out_data_file_struct
+	      and OUT_BUF_SIZE.						GT
+  2015-Feb-02 Added the compiled ASCII format (fmt_width, fmt_prec)
+	      to out_data_struct; ASCII output files also use the
+	      out_data_file_struct buffer.				GT
+  2015-Feb-02 Added options.OUTPUT_CONTAINER and the output container
+	      fields of out_data_file_struct.				GT
+  2015-Feb-02 Output variables are now aggregated per output file:
+	      added out_dt, step_count and the aggregation slots to
+	      out_data_file_struct, and OUT_STEP_MONTH, OUT_STEP_YEAR
+	      and AGG_TYPE_DEFAULT;
+	      removed aggdata from out_data_struct and step_count from
+	      save_data_struct.						GT
 *********************************************************************/
 #include <snow.h>
 
 /***** If TRUE include all model messages to stdout, and stderr *****/
 #define VERBOSE TRUE
 
+/***** Storage qualifier for file-scope and static variables that hold
+       per-cell state; each worker thread of the threaded cell driver
+       (options.NTHREADS > 1) gets its own copy *****/
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define THREAD_LOCAL _Thread_local
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+/***** Ordered sections of the threaded cell driver (see wait_cell_turn()) *****/
+#define INIT_STATE_TURN 0  /* reading the initial state file */
+#define SAVE_STATE_TURN 1  /* writing the output state file */
+
 /***** Model Constants *****/
 #define MAXSTRING    2048
 #define MINSTRING    20
@@ -190,6 +236,21 @@
 #define DENS_BRAS   0
 #define DENS_SNTHRM 1
 
+/***** Root solvers for the energy balance temperatures *****/
+#define ROOT_BRENT  0
+#define ROOT_NEWTON 1
+
+/***** Energy balances solved by root_solve() *****/
+#define ROOT_SURF    0
+#define ROOT_CANOPY  1
+#define ROOT_SNOW    2
+#define ROOT_ICE     3
+#define N_ROOT_SITES 4
+
+/***** Jacobians of the implicit soil thermal solver *****/
+#define JACOBIAN_FD       0
+#define JACOBIAN_ANALYTIC 1
+
 /***** Baseflow parametrizations *****/
 #define ARNO        0
 #define NIJSSEN2001 1
@@ -659,7 +720,18 @@ extern char ref_veg_ref_crop[];
 #define OUT_TYPE_FLOAT   5 /* single-precision floating point */
 #define OUT_TYPE_DOUBLE  6 /* double-precision floating point */
 
+/***** Size of the buffer of each output file [bytes];
+       output is written in blocks of about this size *****/
+#define OUT_BUF_SIZE     65536
+
+/***** Largest precision and field width of the %[width][.prec]f ASCII
+       formats that write_data() formats itself; other formats are
+       written with snprintf() *****/
+#define MAX_FMT_PREC     15
+#define MAX_FMT_WIDTH    64
+
 /***** Output aggregation method types *****/
+#define AGG_TYPE_DEFAULT -1 /* default aggregation type of the variable */
 #define AGG_TYPE_AVG     0 /* average over agg interval */
 #define AGG_TYPE_BEG     1 /* value at beginning of agg interval */
 #define AGG_TYPE_END     2 /* value at end of agg interval */
@@ -667,6 +739,11 @@ extern char ref_veg_ref_crop[];
 #define AGG_TYPE_MIN     4 /* minimum value over agg interval */
 #define AGG_TYPE_SUM     5 /* sum over agg interval */
 
+/***** Output intervals of whole calendar months, stored as minus the
+       number of months in out_data_file_struct.out_dt *****/
+#define OUT_STEP_MONTH  -1
+#define OUT_STEP_YEAR  -12
+
 /***** Codes for displaying version information *****/
 #define DISP_VERSION 1
 #define DISP_COMPILE_TIME 2
@@ -700,6 +777,7 @@ typedef struct {
 typedef struct {
   char  forcing[2][MAXSTRING];  /* atmospheric forcing data file names */
   char  f_path_pfx[2][MAXSTRING];  /* path and prefix for atmospheric forcing data file names */
+  char  forcing_cache[MAXSTRING]; /* directory of cached prepared forcings */
   char  global[MAXSTRING];      /* global control file name */
   char  init_state[MAXSTRING];  /* initial model state file name */
   char  lakeparam[MAXSTRING];   /* lake model constants file */
@@ -765,6 +843,9 @@ typedef struct {
                             "GF_410"  = use formulas from VIC 4.1.0 */
   char   IMPLICIT;       /* TRUE = Use implicit solution when computing 
 			    soil thermal fluxes */
+  char   IMPLICIT_JACOBIAN; /* JACOBIAN_FD = finite-difference Jacobian in
+                            the implicit soil thermal solver (default);
+                            JACOBIAN_ANALYTIC = analytic Jacobian */
   char   JULY_TAVG_SUPPLIED; /* If TRUE and COMPUTE_TREELINE is also true,
 			        then average July air temperature will be read
 			        from soil file and used in calculating treeline */
@@ -792,6 +873,11 @@ typedef struct {
 			    FALSE = air pressure set to constant 95.5 kPa */
   char   RC_MODE;        /* RC_JARVIS = compute canopy resistance via Jarvis formulation (default)
                             RC_PHOTO = compute canopy resistance based on photosynthetic activity */
+  char   ROOT_SOLVER;    /* ROOT_BRENT = find the surface, canopy, snow pack
+                            and lake ice temperatures with the Brent method
+                            (default); ROOT_NEWTON = secant iteration from
+                            the previous time step's temperature, falling
+                            back to the Brent method */
   int    ROOT_ZONES;     /* Number of root zones used in simulation */
   char   QUICK_FLUX;     /* TRUE = Use Liang et al., 1999 formulation for
 			    ground heat flux, if FALSE use explicit finite
@@ -855,16 +941,48 @@ typedef struct {
   char   ALMA_OUTPUT;    /* TRUE = output variables are in ALMA-compliant units; FALSE = standard VIC units */
   char   BINARY_OUTPUT;  /* TRUE = output files are in binary, not ASCII */
   char   COMPRESS;       /* TRUE = Compress all output files */
+  int    COMPRESS_LEVEL; /* gzip compression level (1 = fastest,
+                            9 = smallest) used when COMPRESS is TRUE */
   char   MOISTFRACT;     /* TRUE = output soil moisture as fractional moisture content */
   int    Noutfiles;      /* Number of output files (not including state files) */
+  char   OUTPUT_CONTAINER; /* TRUE = the output of all cells is written to
+			    one container file per output file prefix
+			    (see output_container.c); FALSE = one file per
+			    prefix per cell (default) */
   char   OUTPUT_FORCE;   /* TRUE = perform disaggregation of forcings, skip
                             the simulation, and output the disaggregated
                             forcings. */
+  char   OUTPUT_PET;     /* TRUE = an OUT_PET_* variable is written, so
+                            potential evap must be computed; set by
+                            set_output_active() */
   char   PRT_HEADER;     /* TRUE = insert header at beginning of output file; FALSE = no header */
   char   PRT_SNOW_BAND;  /* TRUE = print snow parameters for each snow band. This is only used when default
 				   output files are used (for backwards-compatibility); if outfiles and
 				   variables are explicitly mentioned in global parameter file, this option
 				   is ignored. */
+
+  // execution options
+  char   ASYNC_OUTPUT;   /* TRUE = output records are written to the output
+			    files by a separate writer thread; FALSE =
+			    output records are written as soon as they are
+			    computed (default) */
+  int    NSHARDS;        /* Number of shards (independent processes) the
+			    active cells are divided among; 1 = no
+			    sharding (default) */
+  int    NTHREADS;       /* Number of worker threads used to simulate grid
+			    cells in parallel; 1 = serial (default) */
+  char   PREFETCH;       /* TRUE = the main thread reads the parameters and
+			    forcings of the next cells while the current
+			    cell is being simulated by a worker thread;
+			    FALSE = each cell's forcings are read by the
+			    thread that simulates it (default) */
+  int    OUTPUT_QUEUE_LEN; /* Number of output blocks (each up to
+			    OUT_BUF_SIZE bytes of records of one output
+			    file) that can be waiting for the writer thread
+			    when ASYNC_OUTPUT is TRUE (default = 8) */
+  int    SHARD;          /* Shard run by this process; only active cells
+			    whose index (counted from 0 in soil file
+			    order) modulo NSHARDS equals SHARD are run */
 } option_struct;
 
 /*******************************************************
@@ -924,7 +1042,9 @@ typedef struct {
 } global_param_struct;
 
 /***********************************************************
-  This structure stores the soil parameters for a grid cell.
+  This structure stores the soil parameters for a grid cell.  The
+  thermal node arrays hold options.Nnode entries; they are allocated
+  by read_soilparam() and shared by copies of the structure.
   ***********************************************************/
 typedef struct {
   int      FS_ACTIVE;                 /* if TRUE frozen soil algorithm is 
@@ -943,31 +1063,31 @@ typedef struct {
 					 wilting point (mm) */
   double   Ws;                        /* fraction of maximum soil moisture */
   float    AlbedoPar;                 /* soil albedo in PAR range (400-700nm) */
-  double   alpha[MAX_NODES];          /* thermal solution constant */
+  double  *alpha;                     /* thermal solution constant */
   double   annual_prec;               /* annual average precipitation (mm) */
   double   avg_temp;                  /* average soil temperature (C) */
   double   avgJulyAirTemp;            /* Average July air temperature (C) */
   double   b_infilt;                  /* infiltration parameter */
-  double   beta[MAX_NODES];           /* thermal solution constant */
+  double  *beta;                      /* thermal solution constant */
   double   bubble[MAX_LAYERS];        /* bubbling pressure, HBH 5.15 (cm) */
-  double   bubble_node[MAX_NODES];    /* bubbling pressure (cm) */
+  double  *bubble_node;               /* bubbling pressure (cm) */
   double   bulk_density[MAX_LAYERS];  /* soil bulk density (kg/m^3) */
   double   bulk_dens_min[MAX_LAYERS]; /* bulk density of mineral soil (kg/m^3) */
   double   bulk_dens_org[MAX_LAYERS]; /* bulk density of organic soil (kg/m^3) */
   double   c;                         /* exponent in ARNO baseflow scheme */
   double   depth[MAX_LAYERS];         /* thickness of each soil moisture layer (m) */
   double   dp;                        /* soil thermal damping depth (m) */
-  double   dz_node[MAX_NODES];        /* thermal node thickness (m) */
-  double   Zsum_node[MAX_NODES];      /* thermal node depth (m) */
+  double  *dz_node;                   /* thermal node thickness (m) */
+  double  *Zsum_node;                 /* thermal node depth (m) */
   double   expt[MAX_LAYERS];          /* layer-specific exponent n (=3+2/lambda) in Campbell's eqn for hydraulic conductivity, HBH 5.6 */
-  double   expt_node[MAX_NODES];      /* node-specific exponent n (=3+2/lambda) in Campbell's eqn for hydraulic conductivity, HBH 5.6 */
+  double  *expt_node;                 /* node-specific exponent n (=3+2/lambda) in Campbell's eqn for hydraulic conductivity, HBH 5.6 */
   double   frost_fract[MAX_FROST_AREAS]; /* spatially distributed frost coverage fractions */
   double   frost_slope;               /* slope of frost distribution */
-  double   gamma[MAX_NODES];          /* thermal solution constant */
+  double  *gamma;                     /* thermal solution constant */
   double   init_moist[MAX_LAYERS];    /* initial layer moisture level (mm) */
   double   max_infil;                 /* maximum infiltration rate */
   double   max_moist[MAX_LAYERS];     /* maximum moisture content (mm) per layer */
-  double   max_moist_node[MAX_NODES]; /* maximum moisture content (mm/mm) per node */
+  double  *max_moist_node;            /* maximum moisture content (mm/mm) per node */
   double   max_snow_distrib_slope;    /* Maximum slope of snow depth distribution [m].  This should equal 2*depth_min, where depth_min = minimum snow pack depth below which coverage < 1.  Comment, ported from user_def.h, with questionable units: SiB uses 0.076; Rosemount data imply 0.155cm depth ~ 0.028mm swq. */
   double   phi_s[MAX_LAYERS];         /* soil moisture diffusion parameter (mm/mm) */
   double   porosity[MAX_LAYERS];      /* porosity (fraction) */
@@ -1168,7 +1288,10 @@ typedef struct {
 
 /***********************************************************************
   This structure stores energy balance components, and variables used to
-  solve the thermal fluxes through the soil column.
+  solve the thermal fluxes through the soil column.  The thermal node
+  arrays hold options.Nnode entries and are allocated by
+  make_energy_nodes(); use copy_energy_bal() to copy the contents of
+  one structure to another.
   ***********************************************************************/
 typedef struct {
   // State variables
@@ -1176,18 +1299,18 @@ typedef struct {
   double  AlbedoOver;            /* albedo of intercepted snow (fract) */
   double  AlbedoUnder;           /* surface albedo (fraction) */
   double  Cs[2];                 /* heat capacity for top two layers (J/m^3/K) */
-  double  Cs_node[MAX_NODES];    /* heat capacity of the soil thermal nodes (J/m^3/K) */
+  double *Cs_node;              /* heat capacity of the soil thermal nodes (J/m^3/K) */
   double  fdepth[MAX_FRONTS];    /* all simulated freezing front depths */
   char    frozen;                /* TRUE = frozen soil present */
-  double  ice[MAX_NODES];        /* thermal node ice content */
+  double *ice;                  /* thermal node ice content */
   double  kappa[2];              /* soil thermal conductivity for top two layers (W/m/K) */
-  double  kappa_node[MAX_NODES]; /* thermal conductivity of the soil thermal nodes (W/m/K) */
-  double  moist[MAX_NODES];      /* thermal node moisture content */
+  double *kappa_node;           /* thermal conductivity of the soil thermal nodes (W/m/K) */
+  double *moist;                /* thermal node moisture content */
   int     Nfrost;                /* number of simulated freezing fronts */
   int     Nthaw;                 /* number of simulated thawing fronts */
-  double  T[MAX_NODES];          /* thermal node temperatures (C) */
-  char    T_fbflag[MAX_NODES];   /* flag indicating if previous step's temperature was used */
-  int     T_fbcount[MAX_NODES];  /* running total number of times that previous step's temperature was used */
+  double *T;                    /* thermal node temperatures (C) */
+  char   *T_fbflag;              /* flag indicating if previous step's temperature was used */
+  int    *T_fbcount;             /* running total number of times that previous step's temperature was used */
   int     T1_index;              /* soil node at the bottom of the top layer */
   double  Tcanopy;               /* temperature of the canopy air */
   char    Tcanopy_fbflag;        /* flag indicating if previous step's temperature was used */
@@ -1407,6 +1530,129 @@ typedef struct {
   snow_data_struct  **snow;       /* Stores snow variables */
 } all_vars_struct;
 
+/*****************************************************************
+  Arena from which structures that live as long as one grid cell
+  are allocated; see arena.c.
+*****************************************************************/
+typedef struct {
+  char   *base;       /* block the allocations are carved from */
+  size_t  size;       /* size of the block (bytes) */
+  size_t  used;       /* bytes of the block in use */
+  size_t  need;       /* bytes requested since the last reset */
+  void   *overflow;   /* allocations that did not fit in the block */
+} arena_struct;
+
+/*****************************************************************
+  Fields of the energy balance, vegetation and soil layer records
+  that one pass of the over/understory iteration in surface_fluxes()
+  can modify; no other field of these records is changed by a pass.
+  save_iter_state() stores them before the first pass, and
+  restore_iter_state() resets the records from them before each
+  repeated pass.  The snow record is kept whole, since a pass can
+  modify nearly all of it.  Field descriptions are those of the
+  records.
+*****************************************************************/
+typedef struct {
+  // State variables
+  double  AlbedoOver;
+  double  AlbedoUnder;
+  double  fdepth[MAX_FRONTS];
+  char    frozen;
+  int     Nfrost;
+  int     Nthaw;
+  double *T;                    /* options.Nnode entries */
+  char   *T_fbflag;             /* options.Nnode entries */
+  int    *T_fbcount;            /* options.Nnode entries */
+  double  Tcanopy;
+  char    Tcanopy_fbflag;
+  int     Tcanopy_fbcount;
+  double  tdepth[MAX_FRONTS];
+  double  Tfoliage;
+  char    Tfoliage_fbflag;
+  int     Tfoliage_fbcount;
+  double  Tsurf;
+  char    Tsurf_fbflag;
+  int     Tsurf_fbcount;
+  // Fluxes
+  double  advected_sensible;
+  double  advection;
+  double  AtmosError;
+  double  AtmosLatent;
+  double  AtmosLatentSub;
+  double  AtmosSensible;
+  double  canopy_advection;
+  double  canopy_latent;
+  double  canopy_latent_sub;
+  double  canopy_refreeze;
+  double  canopy_sensible;
+  double  deltaCC;
+  double  deltaH;
+  double  error;
+  double  fusion;
+  double  grnd_flux;
+  double  latent;
+  double  latent_sub;
+  double  LongOverIn;
+  double  LongUnderOut;
+  double  melt_energy;
+  double  NetLongAtmos;
+  double  NetLongOver;
+  double  NetLongUnder;
+  double  NetShortAtmos;
+  double  NetShortGrnd;
+  double  NetShortOver;
+  double  NetShortUnder;
+  double  refreeze_energy;
+  double  sensible;
+  double  ShortOverIn;
+  double  snow_flux;
+} energy_iter_state_struct;
+
+typedef struct {
+  double NPPfactor;
+  double rc;
+  double throughfall;
+} veg_iter_state_struct;
+
+typedef struct {
+  double bare_evap_frac;
+  double ice[MAX_FROST_AREAS];
+  double T;
+} layer_iter_state_struct;
+
+typedef struct {
+  energy_iter_state_struct snow_energy;
+  energy_iter_state_struct soil_energy;
+  veg_iter_state_struct    snow_veg_var;
+  veg_iter_state_struct    soil_veg_var;
+  snow_data_struct         snow;
+  layer_iter_state_struct  layer[MAX_LAYERS];
+} iter_state_struct;
+
+/*****************************************************************
+  Work arrays of the routines that are called every time step,
+  sized from options.Ncanopy and options.Nnode.  Allocated once per
+  cell by make_all_vars(); each array belongs to one routine.
+*****************************************************************/
+typedef struct {
+  double *CiLayer;        /* canopy_assimilation(): leaf-internal CO2 per
+                             canopy layer */
+  double *gsLayer;        /* canopy_evap(): stomatal conductance per canopy
+                             layer */
+  double *LAIlayer;       /* surface_fluxes(): LAI per canopy layer */
+  double *faPAR;          /* surface_fluxes(): absorbed PAR per canopy layer */
+  double *store_gsLayer;  /* surface_fluxes(): gsLayer summed over the
+                             sub-steps */
+  double *dZ;             /* soil_carbon_balance(): node thicknesses (mm) */
+  double *dZCum;          /* soil_carbon_balance(): depths of node bottoms
+                             (mm) */
+  double *w;              /* soil_carbon_balance(): node relative moistures */
+  energy_bal_struct energy[2]; /* surface_fluxes(): node arrays of snow_energy
+                             and soil_energy */
+  iter_state_struct iter_state; /* surface_fluxes(): state that repeated
+                             passes of the iteration start from */
+} scratch_struct;
+
 /*******************************************************
   This structure stores moisture state information for
   differencing with next time step.
@@ -1416,6 +1662,11 @@ typedef struct {
   double	surfstor;         /* surface water storage [mm] */
   double	swe;              /* snow water equivalent [mm] */
   double	wdew;             /* canopy interception [mm] */
+  int		Tfoliage_fbcount_total;  /* cell totals of T fallback occurrences */
+  int		Tcanopy_fbcount_total;
+  int		Tsnowsurf_fbcount_total;
+  int		Tsurf_fbcount_total;
+  int		Tsoil_fbcount_total;
 } save_data_struct;
 
 /*******************************************************
@@ -1424,8 +1675,15 @@ typedef struct {
 typedef struct {
   char		varname[20]; /* name of variable */
   int		write;       /* FALSE = don't write; TRUE = write */
+  int		active;      /* TRUE = computed by put_data(), because the
+		                variable is written or is needed by another
+		                active variable or by the balance checks */
   char		format[10];  /* format, when written to an ascii file;
 		                should match the desired fprintf format specifier, e.g. %.4f */
+  int		fmt_width;   /* field width of format */
+  int		fmt_prec;    /* precision of format, if format is of the form
+		                %[width][.prec]f; -1 = any other format, which
+		                is written with snprintf() */
   int		type;        /* type, when written to a binary file;
 		                OUT_TYPE_USINT  = unsigned short int
 		                OUT_TYPE_SINT   = short int
@@ -1441,9 +1699,14 @@ typedef struct {
 				AGG_TYPE_SUM    = take sum over agg interval */
   int		nelem;       /* number of data values */
   double	*data;       /* array of data values */
-  double	*aggdata;    /* array of aggregated data values */
 } out_data_struct;
 
+/*******************************************************
+  Output container of one output file prefix; defined in
+  output_container.c.
+  *******************************************************/
+struct out_container;
+
 /*******************************************************
   This structure stores output information for one output file.
   *******************************************************/
@@ -1456,6 +1719,34 @@ typedef struct {
 		                (a variable's id number is its index in the out_data array).
 		                The order of the id numbers in the varid array
 		                is the order in which the variables will be written. */
+  char		*buf;        /* output buffer; with BINARY_OUTPUT, holds a
+		                whole number of records; otherwise holds
+		                lines of text */
+  size_t	reclen;      /* size of one record [bytes] (BINARY_OUTPUT only) */
+  size_t	buflen;      /* number of bytes in buf not yet written */
+  size_t	bufsize;     /* allocated size of buf [bytes] */
+  int		bufrecs;     /* number of records in buf */
+  struct out_container *container; /* with OUTPUT_CONTAINER, the container
+		                the records are written to; NULL otherwise */
+  int		cell;        /* index of the current cell in the container */
+  int		nrecs;       /* number of records of the current cell
+		                written to the container */
+  long long	last_chunk;  /* offset of the current cell's last chunk in
+		                the container; 0 if none */
+  int		out_dt;      /* output interval of this file [hours]; if
+		                negative, minus the number of calendar months
+		                (OUT_STEP_MONTH, OUT_STEP_YEAR); 0 = OUT_STEP */
+  int		out_step_ratio; /* number of model steps per output interval;
+		                0 for calendar intervals */
+  int		step_count;  /* number of model steps in the current output
+		                interval */
+  int		naggvars;    /* number of aggregated variables: the nvars
+		                variables written, then those that they are
+		                derived from */
+  int		*aggvarid;   /* id of the variable aggregated into each slot */
+  int		*aggtype;    /* aggregation method of each slot (AGG_TYPE_*) */
+  double	**aggdata;   /* aggregated values of each slot, nelem values
+		                of the slot's output variable */
 } out_data_file_struct;
 
 /********************************************************
@@ -1476,3 +1767,346 @@ typedef struct {
   veg_var_struct    *veg_var;
 } Error_struct;
 
+
+/***********************************************************************
+  The following structures hold the arguments of the residual functions
+  solved by root_brent().  The caller fills one structure and passes its
+  address to root_brent(), to the residual function for the final
+  solution, and to the matching error print routine.
+***********************************************************************/
+
+/*******************************************************
+  func_surf_energy_bal() - surface energy balance
+  *******************************************************/
+typedef struct {
+  /* general model terms */
+  int                rec;
+  int                nrecs;
+  dmy_struct        *dmy;
+  int                VEG;
+  int                veg_class;
+  int                iveg;
+  double             delta_t;
+
+  /* soil layer terms */
+  double             Cs1;
+  double             Cs2;
+  double             D1;
+  double             D2;
+  double             T1_old;
+  double             T2;
+  double             Ts_old;
+  double            *Told_node;
+  double             bubble;
+  double             dp;
+  double             expt;
+  double             ice0;
+  double             kappa1;
+  double             kappa2;
+  double             max_moist;
+  double             moist;
+
+  float             *root;
+  double            *CanopLayerBnd;
+
+  /* meteorological forcing terms */
+  int                UnderStory;
+  int                overstory;
+
+  double             NetShortBare;  /* net SW that reaches bare ground */
+  double             NetShortGrnd;  /* net SW that penetrates snowpack */
+  double             NetShortSnow;  /* net SW that reaches snow surface */
+  double             Tair;          /* temperature of canopy air or atmosphere */
+  double             atmos_density;
+  double             atmos_pressure;
+  double             emissivity;
+  double             LongBareIn;    /* incoming LW to snow-free surface */
+  double             LongSnowIn;    /* incoming LW to snow surface */
+  double             surf_atten;
+  double             vp;
+  double             vpd;
+  double             shortwave;
+  double             Catm;
+  double            *dryFrac;
+
+  double            *Wdew;
+  double            *displacement;
+  double            *ra;
+  double            *Ra_used;
+  double             rainfall;
+  double            *ref_height;
+  double            *roughness;
+  double            *wind;
+
+  /* latent heat terms */
+  double             Le;
+
+  /* snowpack terms */
+  double             Advection;
+  double             OldTSurf;
+  double             TPack;
+  double             Tsnow_surf;
+  double             kappa_snow;    /* snow conductance / depth */
+  double             melt_energy;   /* energy consumed in reducing the snowpack coverage */
+  double             snow_coverage; /* snowpack coverage fraction */
+  double             snow_density;
+  double             snow_swq;
+  double             snow_water;
+
+  double            *deltaCC;
+  double            *refreeze_energy;
+  double            *vapor_flux;
+  double            *blowing_flux;
+  double            *surface_flux;
+
+  /* soil node terms */
+  int                Nnodes;
+
+  double            *Cs_node;
+  double            *T_node;
+  double            *Tnew_node;
+  char              *Tnew_fbflag;
+  int               *Tnew_fbcount;
+  double            *alpha;
+  double            *beta;
+  double            *bubble_node;
+  double            *Zsum_node;
+  double            *expt_node;
+  double            *gamma;
+  double            *ice_node;
+  double            *kappa_node;
+  double            *max_moist_node;
+  double            *moist_node;
+
+  /* model structures */
+  soil_con_struct   *soil_con;
+  layer_data_struct *layer;
+  veg_var_struct    *veg_var;
+
+  /* control flags */
+  int                INCLUDE_SNOW;
+  int                NOFLUX;
+  int                EXP_TRANS;
+  int                SNOWING;
+
+  int               *FIRST_SOLN;
+
+  /* returned energy balance terms */
+  double            *NetLongBare;   /* net LW from snow-free ground */
+  double            *NetLongSnow;   /* net longwave from snow surface */
+  double            *T1;
+  double            *deltaH;
+  double            *fusion;
+  double            *grnd_flux;
+  double            *latent_heat;
+  double            *latent_heat_sub;
+  double            *sensible_heat;
+  double            *snow_flux;
+  double            *store_error;
+} surf_energy_bal_struct;
+
+/*******************************************************
+  func_canopy_energy_bal() - canopy (foliage) energy balance
+  *******************************************************/
+typedef struct {
+  /* General Model Parameters */
+  int                band;
+  int                month;
+  int                rec;
+
+  double             delta_t;
+  double             elevation;
+
+  double            *Wmax;
+  double            *Wcr;
+  double            *Wpwp;
+  double            *depth;
+  double            *frost_fract;
+
+  /* Atmopheric Condition and Forcings */
+  double             AirDens;
+  double             EactAir;
+  double             Press;
+  double             Le;
+  double             Tcanopy;
+  double             Vpd;
+  double             shortwave;
+  double             Catm;
+  double            *dryFrac;
+
+  double            *Evap;
+  double            *Ra;
+  double            *Ra_used;
+  double             Rainfall;
+  double            *Wind;
+
+  /* Vegetation Terms */
+  int                UnderStory;
+  int                iveg;
+  int                veg_class;
+
+  double            *displacement;
+  double            *ref_height;
+  double            *roughness;
+
+  float             *root;
+  double            *CanopLayerBnd;
+
+  /* Water Flux Terms */
+  double             IntRain;
+  double             IntSnow;
+
+  double            *Wdew;
+
+  layer_data_struct *layer;
+  veg_var_struct    *veg_var;
+
+  /* Energy Flux Terms */
+  double             LongOverIn;
+  double             LongUnderOut;
+  double             NetShortOver;
+
+  double            *AdvectedEnergy;
+  double            *LatentHeat;
+  double            *LatentHeatSub;
+  double            *LongOverOut;
+  double            *NetLongOver;
+  double            *NetRadiation;
+  double            *RefreezeEnergy;
+  double            *SensibleHeat;
+  double            *VaporMassFlux;
+} canopy_energy_bal_struct;
+
+/*******************************************************
+  func_atmos_energy_bal() - canopy air energy balance
+  *******************************************************/
+typedef struct {
+  double             LatentHeat;
+  double             NetRadiation;
+  double             Ra;
+  double             Tair;
+  double             atmos_density;
+  double             InSensible;
+
+  double            *SensibleHeat;
+} atmos_energy_bal_struct;
+
+/*******************************************************
+  SnowPackEnergyBalance() - snowpack surface energy balance
+  *******************************************************/
+typedef struct {
+  /* General Model Parameters */
+  int                rec;
+  int                iveg;
+  int                band;
+  double             Dt;            /* Model time step (sec) */
+  double             Ra;            /* Aerodynamic resistance (s/m) */
+  double            *Ra_used;       /* Aerodynamic resistance (s/m) after stability correction */
+
+  /* Vegetation Parameters */
+  double             Displacement;  /* Displacement height (m) */
+  double             Z;             /* Reference height (m) */
+  double            *Z0;            /* surface roughness height (m) */
+
+  /* Atmospheric Forcing Variables */
+  double             AirDens;       /* Density of air (kg/m3) */
+  double             EactAir;       /* Actual vapor pressure of air (Pa) */
+  double             LongSnowIn;    /* Incoming longwave radiation (W/m2) */
+  double             Lv;            /* Latent heat of vaporization (J/kg3) */
+  double             Press;         /* Air pressure (Pa) */
+  double             Rain;          /* Rain fall (m/timestep) */
+  double             NetShortUnder; /* Net incident shortwave radiation (W/m2) */
+  double             Vpd;           /* Vapor pressure deficit (Pa) */
+  double             Wind;          /* Wind speed (m/s) */
+
+  /* Snowpack Variables */
+  double             OldTSurf;      /* Surface temperature during previous time step */
+  double             SnowCoverFract; /* Fraction of area covered by snow */
+  double             SnowDepth;     /* Depth of snowpack (m) */
+  double             SnowDensity;   /* Density of snowpack (kg/m^3) */
+  double             SurfaceLiquidWater; /* Liquid water in the surface layer (m) */
+  double             SweSurfaceLayer; /* Snow water equivalent in surface layer (m) */
+
+  /* Energy Balance Components */
+  double             Tair;          /* Canopy air / Air temperature (C) */
+  double             TGrnd;         /* Ground surface temperature (C) */
+
+  double            *AdvectedEnergy; /* Energy advected by precipitation (W/m2) */
+  double            *AdvectedSensibleHeat; /* Sensible heat advected from snow-free
+				       area into snow covered area (W/m^2) */
+  double            *DeltaColdContent; /* Change in cold content of surface layer (W/m2) */
+  double            *GroundFlux;    /* Ground Heat Flux (W/m2) */
+  double            *LatentHeat;    /* Latent heat exchange at surface (W/m2) */
+  double            *LatentHeatSub; /* Latent heat of sublimation exchange at surface (W/m2) */
+  double            *NetLongUnder;  /* Net longwave radiation at snowpack surface (W/m^2) */
+  double            *RefreezeEnergy; /* Refreeze energy (W/m2) */
+  double            *SensibleHeat;  /* Sensible heat exchange at surface (W/m2) */
+  double            *vapor_flux;    /* Mass flux of water vapor to or from the
+				       intercepted snow (m/timestep) */
+  double            *blowing_flux;  /* Mass flux of water vapor from blowing snow (m/timestep) */
+  double            *surface_flux;  /* Mass flux of water vapor from pack snow (m/timestep) */
+} snow_pack_energy_bal_struct;
+
+/*******************************************************
+  IceEnergyBalance() - lake ice pack surface energy balance
+  *******************************************************/
+typedef struct {
+  double             Dt;            /* Model time step (hours) */
+  double             Ra;            /* Aerodynamic resistance (s/m) */
+  double            *Ra_used;       /* Aerodynamic resistance (s/m) after stability correction */
+  double             Z;             /* Reference height (m) */
+  double             Displacement;  /* Displacement height (m) */
+  double             Z0;            /* surface roughness height (m) */
+  double             Wind;          /* Wind speed (m/s) */
+  double             ShortRad;      /* Net incident shortwave radiation (W/m2) */
+  double             LongRadIn;     /* Incoming longwave radiation (W/m2) */
+  double             AirDens;       /* Density of air (kg/m3) */
+  double             Lv;            /* Latent heat of vaporization (J/kg3) */
+  double             Tair;          /* Air temperature (C) */
+  double             Press;         /* Air pressure (Pa) */
+  double             Vpd;           /* Vapor pressure deficit (Pa) */
+  double             EactAir;       /* Actual vapor pressure of air (Pa) */
+  double             Rain;          /* Rain fall (m/timestep) */
+  double             SweSurfaceLayer; /* Snow water equivalent in surface layer (m) */
+  double             SurfaceLiquidWater; /* Liquid water in the surface layer (m) */
+  double             OldTSurf;      /* Surface temperature during previous time step */
+  double            *RefreezeEnergy; /* Refreeze energy (W/m2) */
+  double            *vapor_flux;    /* Total mass flux of water vapor to or from snow (m/timestep) */
+  double            *blowing_flux;  /* Mass flux of water vapor to or from blowing snow (m/timestep) */
+  double            *surface_flux;  /* Mass flux of water vapor to or from snow pack (m/timestep) */
+  double            *AdvectedEnergy; /* Energy advected by precipitation (W/m2) */
+  double             DeltaColdContent; /* Change in cold content (W/m2) */
+  double             Tfreeze;
+  double             AvgCond;
+  double             SWconducted;
+  double             SnowDepth;
+  double             SnowDensity;
+  double             SurfAttenuation;
+  double            *qf;            /* Ground Heat Flux (W/m2) */
+  double            *LatentHeat;    /* Latent heat exchange at surface (W/m2) */
+  double            *LatentHeatSub; /* Latent heat exchange at surface (W/m2) due to sublimation */
+  double            *SensibleHeat;  /* Sensible heat exchange at surface (W/m2) */
+  double            *LongRadOut;
+} ice_energy_bal_struct;
+
+/*******************************************************
+  soil_thermal_eqn() - heat equation at one soil node
+  *******************************************************/
+typedef struct {
+  double             TL;            /* temperature of the node below */
+  double             TU;            /* temperature of the node above */
+  double             T0;            /* temperature of the node at the previous time step */
+  double             moist;
+  double             max_moist;
+  double             bubble;
+  double             expt;
+  double             ice0;
+  double             gamma;
+  double             A;
+  double             B;
+  double             C;
+  double             D;
+  double             E;
+  int                EXP_TRANS;
+  int                node;
+} soil_node_struct;
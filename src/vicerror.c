@@ -18,21 +18,31 @@ void vicerror(char error_text[])
               out_data and out_data_files structures.xi			TJB
   2006-Oct-16 Merged infiles and outfiles structs into filep_struct.	TJB
   2012-Jan-16 Removed LINK_DEBUG code					BN
+  2015-Feb-02 Closes the output containers (OUTPUT_CONTAINER), so
+	      that the records written so far can be extracted.		GT
+  2015-Feb-02 No longer sets options.COMPRESS, which close_files() no
+	      longer uses and which other cell threads may be reading.
+	      Only the calling thread's output files are closed.	GT
+  2015-Feb-02 Closes no output files if the calling thread has none
+	      (the main thread of the threaded cell driver, whose worker
+	      threads have already closed theirs).			GT
+  2015-Feb-02 Flushes all open streams before _exit(), which does not,
+	      so that the state file written so far is not lost.	GT
 **********************************************************************/
 {
         extern option_struct options;
-	extern Error_struct Error;
+	extern THREAD_LOCAL Error_struct Error;
         filenames_struct fnames;
 	void _exit();
 
-        options.COMPRESS=FALSE;	/* turn off compression of last set of files */
-
 	fprintf(stderr,"VIC model run-time error...\n");
 	fprintf(stderr,"%s\n",error_text);
 	fprintf(stderr,"...now writing output files...\n");
-        close_files(&(Error.filep), Error.out_data_files, &fnames);
+        if (Error.out_data_files != NULL)
+          close_files(&(Error.filep), Error.out_data_files, &fnames);
+        if (options.OUTPUT_CONTAINER)
+          close_output_containers();
 	fprintf(stderr,"...now exiting to system...\n");
-        fflush(stdout);
-        fflush(stderr);
+        fflush(NULL);
 	_exit(1);
 }
@@ -1,13 +1,18 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <float.h>
 #include <vicNl.h>
 
 static char vcid[] = "$Id$";
 
-void write_data(out_data_file_struct *out_data_files,
+static void  write_ascii_value(out_data_file_struct *, out_data_struct *, double, int);
+static int   format_fixed(char *, double, int, int);
+static char *reserve_out_data_file(out_data_file_struct *, size_t);
+
+void write_data(out_data_file_struct *out_data_file,
 		out_data_struct *out_data,
-		dmy_struct      *dmy,
-		int              dt)
+		dmy_struct      *dmy)
 /**********************************************************************
 	write_data	Dag Lohmann		Janurary 1996
 
@@ -78,19 +83,43 @@ void write_data(out_data_file_struct *out_data_files,
 	      aggregation of output variables.				TJB
   2012-Jan-16 Removed LINK_DEBUG code					BN
   2013-Dec-27 Moved OUTPUT_FORCE to options_struct.			TJB
+  2015-Feb-02 Records are now written via output_fwrite(), so that
+	      they can be handed to the asynchronous output writer
+	      (ASYNC_OUTPUT = TRUE).					GT
+  2015-Feb-02 Binary records are now packed into the file's record
+	      buffer, allocated by make_in_and_outfiles(), instead of
+	      temporary arrays allocated on every call; the buffer is
+	      written by flush_out_data_file() when it is full and when
+	      the file is closed.					GT
+  2015-Feb-02 ASCII lines are now formatted into the file's buffer
+	      too, and written in blocks.  Formats of the form
+	      %[width][.prec]f are compiled once, when the output
+	      variables are set up, and are written by format_fixed()
+	      instead of fprintf(); output is unchanged.		GT
+  2015-Feb-02 Output buffers now always hold whole records, and count
+	      them, so that they can be written to an output container
+	      (OUTPUT_CONTAINER) as chunks.				GT
+  2015-Feb-02 Writes one record of one output file, since each file
+	      has its own output interval: the values are taken from
+	      the file's aggregation slots, and the date columns
+	      depend on the file's out_dt.				GT
 **********************************************************************/
 {
   extern option_struct options;
-  int                 file_idx;
   int                 var_idx;
   int                 elem_idx;
-  int                 ptr_idx;
-  char               *tmp_cptr;
-  short int          *tmp_siptr;
-  unsigned short int *tmp_usiptr;
-  int                *tmp_iptr;
-  float              *tmp_fptr;
-  double             *tmp_dptr;
+  int                 date[4];
+  int                 ndate;
+  int                 hourly;
+  size_t              line_start;
+  char               *ptr;
+  double             *aggdata;
+  int                 nelem;
+  char                tmp_c;
+  short int           tmp_si;
+  unsigned short int  tmp_usi;
+  int                 tmp_i;
+  float               tmp_f;
 
   /***************************************************************
     Write output files using default VIC ASCII or BINARY formats
@@ -100,129 +129,291 @@ void write_data(out_data_file_struct *out_data_files,
       www.hydro.washington.edu/Lettenmaier/Models/VIC/VIChome.html
   ***************************************************************/
 
-  if(options.BINARY_OUTPUT) {  // BINARY
+  // The hour is written if the output interval is less than a day
+  hourly = (out_data_file->out_dt > 0 && out_data_file->out_dt < 24);
 
-    // Initialize pointers
-    tmp_cptr = (char *)calloc(N_OUTVAR_TYPES*options.Nlayer*options.SNOW_BAND,sizeof(char));
-    tmp_siptr = (short int *)calloc(N_OUTVAR_TYPES*options.Nlayer*options.SNOW_BAND,sizeof(short int));
-    tmp_usiptr = (unsigned short int *)calloc(N_OUTVAR_TYPES*options.Nlayer*options.SNOW_BAND,sizeof(unsigned short int));
-    tmp_iptr = (int *)calloc(N_OUTVAR_TYPES*options.Nlayer*options.SNOW_BAND,sizeof(int));
-    tmp_fptr = (float *)calloc(N_OUTVAR_TYPES*options.Nlayer*options.SNOW_BAND,sizeof(float));
-    tmp_dptr = (double *)calloc(N_OUTVAR_TYPES*options.Nlayer*options.SNOW_BAND,sizeof(double));
+  if(options.BINARY_OUTPUT) {  // BINARY
 
     // Time
-    tmp_iptr[0] = dmy->year;
-    tmp_iptr[1] = dmy->month;
-    tmp_iptr[2] = dmy->day;
-    tmp_iptr[3] = dmy->hour;
-
-    // Loop over output files
-    for (file_idx = 0; file_idx < options.Noutfiles; file_idx++) {
-
-      if (!options.OUTPUT_FORCE) {
-
-        // Write the date
-        if (dt < 24) {
-          // Write year, month, day, and hour
-          fwrite(tmp_iptr, sizeof(int), 4, out_data_files[file_idx].fh);
-        }
-        else {
-          // Only write year, month, and day
-          fwrite(tmp_iptr, sizeof(int), 3, out_data_files[file_idx].fh);
-        }
+    if (options.OUTPUT_FORCE)
+      ndate = 0;
+    else {
+      date[0] = dmy->year;
+      date[1] = dmy->month;
+      date[2] = dmy->day;
+      date[3] = dmy->hour;
+      if (hourly)
+        ndate = 4; // Write year, month, day, and hour
+      else
+        ndate = 3; // Only write year, month, and day
+    }
 
-      }
+    // Make room for the record in the file's record buffer
+    if (out_data_file->buflen + out_data_file->reclen > out_data_file->bufsize)
+      flush_out_data_file(out_data_file);
+    ptr = out_data_file->buf + out_data_file->buflen;
 
-      // Loop over this output file's data variables
-      for (var_idx = 0; var_idx < out_data_files[file_idx].nvars; var_idx++) {
-        // Loop over this variable's elements
-        ptr_idx = 0;
-        if (out_data[out_data_files[file_idx].varid[var_idx]].type == OUT_TYPE_CHAR) {
-          for (elem_idx = 0; elem_idx < out_data[out_data_files[file_idx].varid[var_idx]].nelem; elem_idx++) {
-            tmp_cptr[ptr_idx++] = (char)out_data[out_data_files[file_idx].varid[var_idx]].aggdata[elem_idx];
-          }
-          fwrite(tmp_cptr, sizeof(char), ptr_idx, out_data_files[file_idx].fh);
-        }
-        else if (out_data[out_data_files[file_idx].varid[var_idx]].type == OUT_TYPE_SINT) {
-          for (elem_idx = 0; elem_idx < out_data[out_data_files[file_idx].varid[var_idx]].nelem; elem_idx++) {
-            tmp_siptr[ptr_idx++] = (short int)out_data[out_data_files[file_idx].varid[var_idx]].aggdata[elem_idx];
+    // Write the date
+    memcpy(ptr, date, ndate*sizeof(int));
+    ptr += ndate*sizeof(int);
+
+    // Loop over this output file's data variables, packing each
+    // variable's elements as its binary type
+    for (var_idx = 0; var_idx < out_data_file->nvars; var_idx++) {
+      aggdata = out_data_file->aggdata[var_idx];
+      nelem = out_data[out_data_file->varid[var_idx]].nelem;
+      switch (out_data[out_data_file->varid[var_idx]].type) {
+        case OUT_TYPE_CHAR:
+          for (elem_idx = 0; elem_idx < nelem; elem_idx++) {
+            tmp_c = (char)aggdata[elem_idx];
+            memcpy(ptr, &tmp_c, sizeof(char));
+            ptr += sizeof(char);
           }
-          fwrite(tmp_siptr, sizeof(short int), ptr_idx, out_data_files[file_idx].fh);
-        }
-        else if (out_data[out_data_files[file_idx].varid[var_idx]].type == OUT_TYPE_USINT) {
-          for (elem_idx = 0; elem_idx < out_data[out_data_files[file_idx].varid[var_idx]].nelem; elem_idx++) {
-            tmp_usiptr[ptr_idx++] = (unsigned short int)out_data[out_data_files[file_idx].varid[var_idx]].aggdata[elem_idx];
+          break;
+        case OUT_TYPE_SINT:
+          for (elem_idx = 0; elem_idx < nelem; elem_idx++) {
+            tmp_si = (short int)aggdata[elem_idx];
+            memcpy(ptr, &tmp_si, sizeof(short int));
+            ptr += sizeof(short int);
           }
-          fwrite(tmp_usiptr, sizeof(unsigned short int), ptr_idx, out_data_files[file_idx].fh);
-        }
-        else if (out_data[out_data_files[file_idx].varid[var_idx]].type == OUT_TYPE_INT) {
-          for (elem_idx = 0; elem_idx < out_data[out_data_files[file_idx].varid[var_idx]].nelem; elem_idx++) {
-            tmp_iptr[ptr_idx++] = (int)out_data[out_data_files[file_idx].varid[var_idx]].aggdata[elem_idx];
+          break;
+        case OUT_TYPE_USINT:
+          for (elem_idx = 0; elem_idx < nelem; elem_idx++) {
+            tmp_usi = (unsigned short int)aggdata[elem_idx];
+            memcpy(ptr, &tmp_usi, sizeof(unsigned short int));
+            ptr += sizeof(unsigned short int);
           }
-          fwrite(tmp_iptr, sizeof(int), ptr_idx, out_data_files[file_idx].fh);
-        }
-        else if (out_data[out_data_files[file_idx].varid[var_idx]].type == OUT_TYPE_FLOAT) {
-          for (elem_idx = 0; elem_idx < out_data[out_data_files[file_idx].varid[var_idx]].nelem; elem_idx++) {
-            tmp_fptr[ptr_idx++] = (float)out_data[out_data_files[file_idx].varid[var_idx]].aggdata[elem_idx];
+          break;
+        case OUT_TYPE_INT:
+          for (elem_idx = 0; elem_idx < nelem; elem_idx++) {
+            tmp_i = (int)aggdata[elem_idx];
+            memcpy(ptr, &tmp_i, sizeof(int));
+            ptr += sizeof(int);
           }
-          fwrite(tmp_fptr, sizeof(float), ptr_idx, out_data_files[file_idx].fh);
-        }
-        else if (out_data[out_data_files[file_idx].varid[var_idx]].type == OUT_TYPE_DOUBLE) {
-          for (elem_idx = 0; elem_idx < out_data[out_data_files[file_idx].varid[var_idx]].nelem; elem_idx++) {
-            tmp_dptr[ptr_idx++] = (double)out_data[out_data_files[file_idx].varid[var_idx]].aggdata[elem_idx];
+          break;
+        case OUT_TYPE_FLOAT:
+          for (elem_idx = 0; elem_idx < nelem; elem_idx++) {
+            tmp_f = (float)aggdata[elem_idx];
+            memcpy(ptr, &tmp_f, sizeof(float));
+            ptr += sizeof(float);
           }
-          fwrite(tmp_dptr, sizeof(double), ptr_idx, out_data_files[file_idx].fh);
-        }
+          break;
+        case OUT_TYPE_DOUBLE:
+          memcpy(ptr, aggdata, nelem*sizeof(double));
+          ptr += nelem*sizeof(double);
+          break;
       }
-
     }
 
-    // Free the arrays
-    free((char *)tmp_cptr);
-    free((char *)tmp_siptr);
-    free((char *)tmp_usiptr);
-    free((char *)tmp_iptr);
-    free((char *)tmp_fptr);
-    free((char *)tmp_dptr);
+    out_data_file->buflen = ptr - out_data_file->buf;
+    out_data_file->bufrecs++;
 
   }
 
   else {  // ASCII
 
-    // Loop over output files
-    for (file_idx = 0; file_idx < options.Noutfiles; file_idx++) {
+    line_start = out_data_file->buflen;
 
-      if (!options.OUTPUT_FORCE) {
-
-        // Write the date
-        if (dt < 24) {
-          // Write year, month, day, and hour
-          fprintf(out_data_files[file_idx].fh, "%04i\t%02i\t%02i\t%02i\t",
-                  dmy->year, dmy->month, dmy->day, dmy->hour);
-        }
-        else {
-          // Only write year, month, and day
-          fprintf(out_data_files[file_idx].fh, "%04i\t%02i\t%02i\t",
-                  dmy->year, dmy->month, dmy->day);
-        }
+    if (!options.OUTPUT_FORCE) {
 
+      // Write the date
+      ptr = reserve_out_data_file(out_data_file, 64);
+      if (hourly) {
+        // Write year, month, day, and hour
+        out_data_file->buflen += sprintf(ptr, "%04i\t%02i\t%02i\t%02i\t",
+                dmy->year, dmy->month, dmy->day, dmy->hour);
+      }
+      else {
+        // Only write year, month, and day
+        out_data_file->buflen += sprintf(ptr, "%04i\t%02i\t%02i\t",
+                dmy->year, dmy->month, dmy->day);
       }
 
-      // Loop over this output file's data variables
-      for (var_idx = 0; var_idx < out_data_files[file_idx].nvars; var_idx++) {
-        // Loop over this variable's elements
-        for (elem_idx = 0; elem_idx < out_data[out_data_files[file_idx].varid[var_idx]].nelem; elem_idx++) {
-          if (!(var_idx == 0 && elem_idx == 0)) {
-            fprintf(out_data_files[file_idx].fh, "\t ");
-          }
-          fprintf(out_data_files[file_idx].fh, out_data[out_data_files[file_idx].varid[var_idx]].format, out_data[out_data_files[file_idx].varid[var_idx]].aggdata[elem_idx]);
-        }
+    }
+
+    // Loop over this output file's data variables
+    for (var_idx = 0; var_idx < out_data_file->nvars; var_idx++) {
+      // Loop over this variable's elements
+      for (elem_idx = 0; elem_idx < out_data[out_data_file->varid[var_idx]].nelem; elem_idx++) {
+        write_ascii_value(out_data_file, &out_data[out_data_file->varid[var_idx]],
+                          out_data_file->aggdata[var_idx][elem_idx],
+                          !(var_idx == 0 && elem_idx == 0));
       }
-      fprintf(out_data_files[file_idx].fh, "\n");
+    }
+    ptr = reserve_out_data_file(out_data_file, 1);
+    *ptr = '\n';
+    out_data_file->buflen++;
+    out_data_file->bufrecs++;
+
+    // Write the buffer if the next line, if as long as this one,
+    // would not fit, so that the buffer always holds whole lines
+    if (2*out_data_file->buflen - line_start > out_data_file->bufsize)
+      flush_out_data_file(out_data_file);
 
+  }
+
+}
+
+
+static void write_ascii_value(out_data_file_struct *out_data_file,
+                              out_data_struct      *out_data,
+                              double                value,
+                              int                   sep)
+/**********************************************************************
+  write_ascii_value
+
+  Appends one value of an ASCII output file's line to the file's
+  buffer, preceded by the column separator if sep is TRUE.  Formats
+  compiled to a width and precision (see compile_output_format()) are
+  written by format_fixed(); other formats, and values format_fixed()
+  cannot round with certainty, are written by snprintf().
+**********************************************************************/
+{
+  size_t  need;
+  size_t  len;
+  int     n;
+  char   *ptr;
+
+  need = 2 + MAX_FMT_WIDTH + MAX_FMT_PREC + 24;
+  while (TRUE) {
+    ptr = reserve_out_data_file(out_data_file, need);
+    len = 0;
+    if (sep) {
+      ptr[len++] = '\t';
+      ptr[len++] = ' ';
+    }
+    n = -1;
+    if (out_data->fmt_prec >= 0)
+      n = format_fixed(ptr + len, value, out_data->fmt_width, out_data->fmt_prec);
+    if (n < 0) {
+      n = snprintf(ptr + len, need - len, out_data->format, value);
+      if (n >= need - len) {
+        // Did not fit; make room and format again
+        need = len + n + 1;
+        continue;
+      }
     }
+    out_data_file->buflen += len + n;
+    return;
+  }
+
+}
 
+
+static int format_fixed(char   *str,
+                        double  value,
+                        int     width,
+                        int     prec)
+/**********************************************************************
+  format_fixed
+
+  Writes value to str as printf's %<width>.<prec>f would, without
+  parsing a format or consulting the locale.  Returns the number of
+  characters written (not including a terminating null, which is not
+  written), or -1 if the value must be formatted by printf instead:
+  when it is not finite, when value*10^prec does not fit in the 53-bit
+  mantissa of a double, or when value*10^prec is so close to halfway
+  between two integers that the rounding of the product could change
+  the result.  In all other cases the result is identical to printf's,
+  which rounds the exact binary value to the nearest decimal.
+**********************************************************************/
+{
+  static const double pow10[MAX_FMT_PREC+1] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+    1e13, 1e14, 1e15
+  };
+  char                digits[MAX_FMT_PREC+24];
+  unsigned long long  r;
+  double              y;
+  double              y_int;
+  double              d;
+  int                 neg;
+  int                 ndigits;
+  int                 len;
+  int                 i;
+
+  if (!(fabs(value) <= DBL_MAX)) return(-1);
+  neg = signbit(value) ? 1 : 0;
+
+  // Scale to an integer number of units of the last decimal place;
+  // the product is within half an ulp (2^-53 relative) of the exact one
+  y = fabs(value) * pow10[prec];
+  if (y >= 9007199254740992.) return(-1); // 2^53
+  y_int = floor(y);
+  d = (y - y_int) - 0.5;
+  if (fabs(d) <= 4.5e-16 * y) return(-1);
+  r = (unsigned long long)y_int + (d > 0 ? 1 : 0);
+
+  // Digits, least significant first, with at least one before the point
+  ndigits = 0;
+  do {
+    digits[ndigits++] = '0' + (char)(r % 10);
+    r /= 10;
+  } while (r > 0);
+  while (ndigits < prec + 1)
+    digits[ndigits++] = '0';
+
+  len = neg + ndigits + (prec > 0 ? 1 : 0);
+  i = 0;
+  while (len + i < width)
+    str[i++] = ' ';
+  if (neg)
+    str[i++] = '-';
+  while (ndigits > prec)
+    str[i++] = digits[--ndigits];
+  if (prec > 0) {
+    str[i++] = '.';
+    while (ndigits > 0)
+      str[i++] = digits[--ndigits];
   }
 
+  return(i);
+
 }
 
+
+static char *reserve_out_data_file(out_data_file_struct *out_data_file,
+                                   size_t                n)
+/**********************************************************************
+  reserve_out_data_file
+
+  Returns a pointer to the end of an output file's buffer, after making
+  sure that n more bytes fit in it.  The buffer is grown if they do
+  not, rather than written, since it must hold whole lines.
+**********************************************************************/
+{
+  if (out_data_file->buflen + n > out_data_file->bufsize) {
+    out_data_file->bufsize = 2*out_data_file->bufsize;
+    if (out_data_file->bufsize < out_data_file->buflen + n)
+      out_data_file->bufsize = out_data_file->buflen + n;
+    out_data_file->buf = (char *)realloc(out_data_file->buf, out_data_file->bufsize);
+    if (out_data_file->buf == NULL)
+      nrerror("Memory allocation error in reserve_out_data_file().");
+  }
+
+  return(out_data_file->buf + out_data_file->buflen);
+
+}
+
+
+void flush_out_data_file(out_data_file_struct *out_data_file)
+/**********************************************************************
+  flush_out_data_file
+
+  Writes the records in the buffer of an output file (see
+  write_data()) to the file as one block, or, with OUTPUT_CONTAINER,
+  to the file's container as one chunk.
+**********************************************************************/
+{
+  if (out_data_file->buflen == 0) return;
+
+  if (out_data_file->container != NULL)
+    write_container_chunk(out_data_file);
+  else {
+    output_fwrite(out_data_file->buf, sizeof(char), out_data_file->buflen, out_data_file->fh);
+    end_output_record();
+  }
+  out_data_file->buflen = 0;
+  out_data_file->bufrecs = 0;
+
+}
@@ -29,12 +29,18 @@ void write_forcing_file(atmos_data_struct *atmos,
   2013-Jul-25 Added OUT_CATM, OUT_COSZEN, OUT_FDIR, and OUT_PAR.	TJB
   2013-Dec-27 Moved OUTPUT_FORCE to options_struct.					TJB
   2014-Apr-02 Fixed uninitialized dummy variables.					TJB
+  2015-Feb-02 Only active output variables are aggregated.		GT
+  2015-Feb-02 Each record is copied into the aggregation slots of
+	      each output file, and written by write_data() one file
+	      at a time.						GT
 **********************************************************************/
 {
   extern global_param_struct global_param;
   extern option_struct options;
 
   int                 rec, i, j, v;
+  int                 filenum, k;
+  out_data_file_struct *file;
   short int          *tmp_siptr;
   unsigned short int *tmp_usiptr;
   dmy_struct         *dummy_dmy;
@@ -75,30 +81,33 @@ void write_forcing_file(atmos_data_struct *atmos,
         out_data[OUT_SNOWF].data[0] = out_data[OUT_PREC].data[0]-out_data[OUT_RAINF].data[0];
       }
 
-      for (v=0; v<N_OUTVAR_TYPES; v++) {
-        for (i=0; i<out_data[v].nelem; i++) {
-          out_data[v].aggdata[i] = out_data[v].data[i];
-        }
-      }
+      for (filenum = 0; filenum < options.Noutfiles; filenum++) {
+        file = &out_data_files[filenum];
 
-      if (options.ALMA_OUTPUT) {
-        out_data[OUT_PREC].aggdata[0] /= dt_sec;
-        out_data[OUT_RAINF].aggdata[0] /= dt_sec;
-        out_data[OUT_SNOWF].aggdata[0] /= dt_sec;
-        out_data[OUT_AIR_TEMP].aggdata[0] += KELVIN;
-        out_data[OUT_PRESSURE].aggdata[0] *= 1000;
-        out_data[OUT_VP].aggdata[0] *= 1000;
-        out_data[OUT_VPD].aggdata[0] *= 1000;
-      }
-
-      if (options.BINARY_OUTPUT) {
-        for (v=0; v<N_OUTVAR_TYPES; v++) {
+        for (k=0; k<file->nvars; k++) {
+          v = file->varid[k];
           for (i=0; i<out_data[v].nelem; i++) {
-            out_data[v].aggdata[i] *= out_data[v].mult;
+            file->aggdata[k][i] = out_data[v].data[i];
+          }
+
+          if (options.ALMA_OUTPUT) {
+            if (v == OUT_PREC || v == OUT_RAINF || v == OUT_SNOWF)
+              file->aggdata[k][0] /= dt_sec;
+            else if (v == OUT_AIR_TEMP)
+              file->aggdata[k][0] += KELVIN;
+            else if (v == OUT_PRESSURE || v == OUT_VP || v == OUT_VPD)
+              file->aggdata[k][0] *= 1000;
+          }
+
+          if (options.BINARY_OUTPUT) {
+            for (i=0; i<out_data[v].nelem; i++) {
+              file->aggdata[k][i] *= out_data[v].mult;
+            }
           }
         }
+
+        write_data(file, out_data, dummy_dmy);
       }
-      write_data(out_data_files, out_data, dummy_dmy, global_param.dt);
     }
   }
 
@@ -19,6 +19,9 @@ void write_header(out_data_file_struct *out_data_files,
 	      since out_dt is the time interval used in the output
 	      files.							TJB
   2013-Dec-27 Moved OUTPUT_FORCE to options_struct.			TJB
+  2015-Feb-02 DT and the date fields are those of each file's own
+	      output interval (out_data_file_struct.out_dt).		GT
+  2015-Feb-02 Documented the DT values of MONTHLY and ANNUAL files.	GT
 
 **********************************************************************/
 {
@@ -58,7 +61,9 @@ void write_header(out_data_file_struct *out_data_files,
     // Part 1: Global Attributes
     // Nbytes1     (unsigned short)*1  Number of bytes in part 1
     // nrecs       (int)*1             Number of records in the file
-    // dt          (int)*1             Output time step length in hours
+    // dt          (int)*1             Output time step length in hours; if negative,
+    //                                 minus the number of calendar months
+    //                                 (-1 = MONTHLY, -12 = ANNUAL)
     // startyear   (int)*1             Year of first record
     // startmonth  (int)*1             Month of first record
     // startday    (int)*1             Day of first record
@@ -111,7 +116,7 @@ void write_header(out_data_file_struct *out_data_files,
         Nbytes2 += sizeof(char) + 4*sizeof(char) + sizeof(char) + sizeof(float); // year
         Nbytes2 += sizeof(char) + 5*sizeof(char) + sizeof(char) + sizeof(float); // month
         Nbytes2 += sizeof(char) + 3*sizeof(char) + sizeof(char) + sizeof(float); // day
-        if (global.out_dt < 24)
+        if (out_data_files[file_idx].out_dt > 0 && out_data_files[file_idx].out_dt < 24)
           Nbytes2 += sizeof(char) + 4*sizeof(char) + sizeof(char) + sizeof(float); // hour
 
       }
@@ -149,7 +154,7 @@ void write_header(out_data_file_struct *out_data_files,
       fwrite(&(global.nrecs), sizeof(int), 1, out_data_files[file_idx].fh);
 
       // dt
-      fwrite(&(global.out_dt), sizeof(int), 1, out_data_files[file_idx].fh);
+      fwrite(&(out_data_files[file_idx].out_dt), sizeof(int), 1, out_data_files[file_idx].fh);
 
       // start date (year, month, day, hour)
       fwrite(&(dmy->year), sizeof(int), 1, out_data_files[file_idx].fh);
@@ -163,7 +168,7 @@ void write_header(out_data_file_struct *out_data_files,
       // Nvars
       Nvars = out_data_files[file_idx].nvars;
       if (!options.OUTPUT_FORCE) {
-        if (global.out_dt < 24)
+        if (out_data_files[file_idx].out_dt > 0 && out_data_files[file_idx].out_dt < 24)
           Nvars += 4;
         else
           Nvars += 3;
@@ -203,7 +208,7 @@ void write_header(out_data_file_struct *out_data_files,
         fwrite(&tmp_type, sizeof(char), 1, out_data_files[file_idx].fh);
         fwrite(&tmp_mult, sizeof(float), 1, out_data_files[file_idx].fh);
 
-        if (global.out_dt < 24) {
+        if (out_data_files[file_idx].out_dt > 0 && out_data_files[file_idx].out_dt < 24) {
           // hour
           strcpy(tmp_str,"HOUR");
           tmp_len = strlen(tmp_str);
@@ -250,7 +255,9 @@ void write_header(out_data_file_struct *out_data_files,
     //
     // where
     //    nrecs       = Number of records in the file
-    //    dt          = Output time step length in hours
+    //    dt          = Output time step length in hours; if negative,
+    //                  minus the number of calendar months
+    //                  (-1 = MONTHLY, -12 = ANNUAL)
     //    start date  = Date and time of first record of file
     //    ALMA_OUTPUT = Indicates units of the variables; 0 = standard VIC units; 1 = ALMA units
     //    Nvars       = Number of variables in the file, including date fields
@@ -261,13 +268,13 @@ void write_header(out_data_file_struct *out_data_files,
       // Header part 1: Global attributes
       Nvars = out_data_files[file_idx].nvars;
       if (!options.OUTPUT_FORCE) {
-        if (global.out_dt < 24)
+        if (out_data_files[file_idx].out_dt > 0 && out_data_files[file_idx].out_dt < 24)
           Nvars += 4;
         else
           Nvars += 3;
       }
       fprintf(out_data_files[file_idx].fh, "# NRECS: %d\n", global.nrecs);
-      fprintf(out_data_files[file_idx].fh, "# DT: %d\n", global.out_dt);
+      fprintf(out_data_files[file_idx].fh, "# DT: %d\n", out_data_files[file_idx].out_dt);
       fprintf(out_data_files[file_idx].fh, "# STARTDATE: %04d-%02d-%02d %02d:00:00\n",
         dmy->year, dmy->month, dmy->day, dmy->hour);
       fprintf(out_data_files[file_idx].fh, "# ALMA_OUTPUT: %d\n", tmp_ALMA_OUTPUT);
@@ -278,7 +285,7 @@ void write_header(out_data_file_struct *out_data_files,
 
       if (!options.OUTPUT_FORCE) {
         // Write the date
-        if (global.out_dt < 24) {
+        if (out_data_files[file_idx].out_dt > 0 && out_data_files[file_idx].out_dt < 24) {
           // Write year, month, day, and hour
           fprintf(out_data_files[file_idx].fh, "YEAR\tMONTH\tDAY\tHOUR\t");
         }
@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Benchmark of the MTCLIM window sums in src/mtclim_vic.c on a synthetic
+   daily record.  The 90-day effective annual precip window of
+   calc_srad_humidity_iterative() is compared with the original loop, for
+   speed and for bitwise identical results; effann_new() must match
+   src/mtclim_vic.c.  The dtr smoother pulled_boxcar() is unchanged and
+   only timed.  Returns non-zero if any value differs.
+
+   Running sums (O(n) instead of O(n*w)) were tried and dropped: they
+   cannot reproduce the rounding of each window's sequential sum, and
+   the energy balance amplifies last-bit forcing changes into different
+   solutions. */
+
+#define PRCP_WINDOW 90
+
+/* pulled_boxcar() (unchanged) */
+static void pulled_boxcar(double *input, double *output, int n, int w, int w_flag)
+{
+  int i, j;
+  double *wt;
+  double total, sum_wt;
+
+  wt = (double *) malloc(w * sizeof(double));
+  sum_wt = 0.0;
+  if (w_flag) {
+    for (i=0 ; i<w ; i++) {
+      wt[i] = (double)(i+1);
+      sum_wt += wt[i];
+    }
+  }
+  else {
+    for (i=0 ; i<w ; i++) {
+      wt[i] = 1.0;
+      sum_wt += wt[i];
+    }
+  }
+  for (i=w-1 ; i<n ; i++) {
+    total = 0.0;
+    for (j=0 ; j<w ; j++) {
+      total += input[i-w+j+1] * wt[j];
+    }
+    output[i] = total/sum_wt;
+  }
+  for (i=0 ; i<w-1 ; i++) {
+    output[i] = output[w-1];
+  }
+  free(wt);
+}
+
+/* original effective annual precip: a (ndays+90) window array and a
+   90-day sum for every day */
+static void effann_old(double *prcp, double *parray, int ndays, int isloop)
+{
+  int i, j;
+  double *window;
+  double sum_prcp;
+
+  window = (double *) malloc((ndays+90) * sizeof(double));
+  for (i=0 ; i<90 ; i++) {
+    if (isloop)
+      window[i] = prcp[ndays-90+i];
+    else
+      window[i] = prcp[i];
+  }
+  for (i=0 ; i<ndays ; i++) {
+    window[i+90] = prcp[i];
+  }
+  for (i=0 ; i<ndays ; i++) {
+    sum_prcp = 0.0;
+    for (j=0 ; j<90 ; j++) {
+      sum_prcp += window[i+j];
+    }
+    sum_prcp = (sum_prcp/90.0) * 365.25;
+    parray[i] = (sum_prcp < 8.0) ? 8.0 : sum_prcp;
+  }
+  free(window);
+}
+
+/* current effective annual precip */
+static void effann_new(double *prcp, double *parray, int ndays, int isloop)
+{
+  int i, j;
+  double *lead_in;
+  double sum_prcp;
+
+  lead_in = (isloop) ? &(prcp[ndays-PRCP_WINDOW]) : prcp;
+  for (i=0 ; i<ndays ; i++) {
+    sum_prcp = 0.0;
+    if (i < PRCP_WINDOW) {
+      for (j=i ; j<PRCP_WINDOW ; j++)
+	sum_prcp += lead_in[j];
+      for (j=0 ; j<i ; j++)
+	sum_prcp += prcp[j];
+    }
+    else {
+      for (j=i-PRCP_WINDOW ; j<i ; j++)
+	sum_prcp += prcp[j];
+    }
+    sum_prcp = (sum_prcp/90.0) * 365.25;
+    parray[i] = (sum_prcp < 8.0) ? 8.0 : sum_prcp;
+  }
+}
+
+static double seconds(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (ts.tv_sec + 1e-9 * ts.tv_nsec);
+}
+
+/* returns the number of elements that differ in any bit */
+static int ndiff(const double *a, const double *b, int n)
+{
+  int i, count = 0;
+
+  for (i=0 ; i<n ; i++)
+    if (memcmp(&a[i], &b[i], sizeof(double)))
+      count++;
+  return (count);
+}
+
+int main(int argc, char *argv[])
+{
+  int ndays, nreps, r, i, nd, total_diff;
+  double *dtr, *prcp, *out_old, *out_new;
+  double t0, t_old, t_new;
+  double tmax, tmin;
+
+  ndays = (argc > 1) ? atoi(argv[1]) : 36525;
+  nreps = (argc > 2) ? atoi(argv[2]) : 20;
+  if (ndays < PRCP_WINDOW || nreps < 1) {
+    fprintf(stderr, "usage: %s [ndays >= %d] [repetitions]\n", argv[0],
+	    PRCP_WINDOW);
+    return (1);
+  }
+
+  dtr = (double *) malloc(ndays * sizeof(double));
+  prcp = (double *) malloc(ndays * sizeof(double));
+  out_old = (double *) malloc(ndays * sizeof(double));
+  out_new = (double *) malloc(ndays * sizeof(double));
+  if (!dtr || !prcp || !out_old || !out_new) {
+    fprintf(stderr, "Memory allocation error\n");
+    return (1);
+  }
+
+  /* synthetic record with the precision of VIC's scaled binary forcings:
+     temperatures in 0.01 C, precip in 0.025 mm, dry on about 60% of days */
+  srand(12345);
+  for (i=0 ; i<ndays ; i++) {
+    tmin = (rand() % 4000 - 2000) / 100.0;
+    tmax = tmin + (rand() % 2500) / 100.0;
+    dtr[i] = tmax - tmin;
+    prcp[i] = (rand() % 10 < 6) ? 0.0 : (rand() % 2000) / 40.0;
+  }
+
+  printf("%d days, best of %d repetitions\n", ndays, nreps);
+  total_diff = 0;
+
+#define BENCH(label, call_old, call_new)				\
+  t_old = t_new = 1e30;							\
+  for (r=0 ; r<nreps ; r++) {						\
+    t0 = seconds(); call_old; t0 = seconds() - t0;			\
+    if (t0 < t_old) t_old = t0;						\
+    t0 = seconds(); call_new; t0 = seconds() - t0;			\
+    if (t0 < t_new) t_new = t0;						\
+  }									\
+  nd = ndiff(out_old, out_new, ndays);					\
+  total_diff += nd;							\
+  printf("%-22s old %8.3f ms  new %8.3f ms  %6.2fx  %d values differ\n", \
+	 label, 1e3*t_old, 1e3*t_new, t_old/t_new, nd);
+
+  BENCH("90-day precip", effann_old(prcp, out_old, ndays, 0),
+	effann_new(prcp, out_new, ndays, 0));
+  BENCH("90-day precip (loop)", effann_old(prcp, out_old, ndays, 1),
+	effann_new(prcp, out_new, ndays, 1));
+
+  t_old = 1e30;
+  for (r=0 ; r<nreps ; r++) {
+    t0 = seconds();
+    pulled_boxcar(dtr, out_old, ndays, 30, 0);
+    t0 = seconds() - t0;
+    if (t0 < t_old) t_old = t0;
+  }
+  printf("%-22s     %8.3f ms\n", "boxcar w=30", 1e3*t_old);
+
+  free(dtr);
+  free(prcp);
+  free(out_old);
+  free(out_new);
+
+  return (total_diff != 0);
+}
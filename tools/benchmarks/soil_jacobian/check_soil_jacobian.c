@@ -0,0 +1,311 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vicNl.h>
+#include <global.h>
+
+/* Check of the analytic Jacobian of the implicit soil temperature equation
+   (fda_heat_eqn() in src/frozen_soil.c, called with init==2) against a
+   central finite-difference Jacobian of its residuals (init==0).
+
+   Synthetic profiles are run on the plain and the EXP_TRANS grid, with and
+   without NOFLUX, for 5 and 10 nodes.  Every tridiagonal entry is compared
+   and the largest relative error is reported separately for each grid
+   (plain or EXP_TRANS), bottom boundary (fixed or NOFLUX), node type (top,
+   interior, bottom), entry (sub-, main, super-diagonal) and state of the
+   node whose temperature is varied (frozen, i.e. holding ice, or
+   unfrozen).  Entries are compared relative to the largest entry of their
+   row.  Columns whose finite-difference step would cross 0 C or the
+   temperature at which the node's ice content reaches 0 are skipped,
+   since the residual is not differentiable there.
+
+   Each case is then solved from T0 by newt_raph() with the finite-difference
+   (IMPLICIT_JACOBIAN FD) and with the analytic Jacobian, and both solutions
+   are compared with each other and with the exact solution, found by
+   continuing the Newton iteration from the analytic solution until the
+   residuals are below ROOT_TOLF.  Both solvers stop at their tolerances
+   (TOLX, TOLF in newt_raph_func_fast.c), so they are expected to stop at
+   different points near the exact solution, not at the same point.
+
+   Returns non-zero if any error exceeds the tolerance. */
+
+#define NLAYER   3
+#define NCASE    400
+#define FD_STEP  1e-6
+#define TOL      1e-5
+#define ROOT_TOLF 1e-9
+#define ROOT_MAXIT 50
+
+enum { TOP, INTERIOR, BOTTOM, NTYPE };
+enum { SUB, DIAG, SUPER, NENTRY };
+enum { UNFROZEN, FROZEN, NSTATE };
+
+static const char *type_name[NTYPE] = { "top", "interior", "bottom" };
+static const char *entry_name[NENTRY] = { "sub", "main", "super" };
+static const char *state_name[NSTATE] = { "unfrozen", "frozen" };
+static const char *grid_name[2] = { "plain", "EXP_TRANS" };
+static const char *bound_name[2] = { "fixed", "NOFLUX" };
+
+static double urand(double lo, double hi)
+{
+  return (lo + (hi - lo) * rand() / (double)RAND_MAX);
+}
+
+/* temperature below which the node holds ice, i.e. the unfrozen water
+   content is less than the total moisture */
+static double freeze_temperature(double moist, double max_moist,
+				 double bubble, double expt)
+{
+  double lo = -50., hi = 0., mid;
+  int k;
+
+  for (k=0; k<100; k++) {
+    mid = 0.5 * (lo + hi);
+    if (maximum_unfrozen_water(mid, max_moist, bubble, expt) < moist)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  return (lo);
+}
+
+/* continue the Newton iteration with the analytic Jacobian from T until
+   the residuals sum to less than ROOT_TOLF; returns 0 on success */
+static int exact_solution(double T[], int n)
+{
+  double res[MAX_NODES], a[MAX_NODES], b[MAX_NODES], c[MAX_NODES];
+  double errf;
+  int k, i;
+
+  for (k=0; k<ROOT_MAXIT; k++) {
+    fda_heat_eqn(T, res, n, 0, -1);
+    errf = 0.;
+    for (i=0; i<n; i++)
+      errf += fabs(res[i]);
+    if (errf < ROOT_TOLF)
+      return (0);
+    fda_heat_eqn(T, res, n, 2, a, b, c);
+    for (i=0; i<n; i++)
+      res[i] = -res[i];
+    tridiag(a, b, c, res, n);
+    for (i=0; i<n; i++)
+      T[i] += res[i];
+  }
+  return (1);
+}
+
+int main(int argc, char *argv[])
+{
+  double T0[MAX_NODES], T[MAX_NODES], Tp[MAX_NODES], res[MAX_NODES];
+  double resp[MAX_NODES], resm[MAX_NODES];
+  double moist[MAX_NODES], ice[MAX_NODES], kappa[MAX_NODES], Cs[MAX_NODES];
+  double max_moist[MAX_NODES], bubble[MAX_NODES], expt[MAX_NODES];
+  double alpha[MAX_NODES], beta[MAX_NODES], gamma[MAX_NODES];
+  double Zsum[MAX_NODES];
+  double bulk_dens_min[NLAYER], soil_dens_min[NLAYER], quartz[NLAYER];
+  double bulk_density[NLAYER], soil_density[NLAYER], organic[NLAYER];
+  double depth[NLAYER];
+  double a[MAX_NODES], b[MAX_NODES], c[MAX_NODES];
+  double T_fd[MAX_NODES], T_an[MAX_NODES], T_ex[MAX_NODES];
+  double fd, an, scale, err, Tf, Dp, deltat, Lsum;
+  double maxdiff, maxerr_fd, maxerr_an, d;
+  double maxerr[2][2][NTYPE][NENTRY][NSTATE];
+  int count[2][2][NTYPE][NENTRY][NSTATE];
+  int Nnodes, NOFLUX, EXP_TRANS, n, icase, i, j, k, g, m, type, state, lidx;
+  int nskip, nfail;
+  int nsolved, nfail_fd, nfail_an, nnoexact;
+
+  for (g=0; g<2; g++)
+    for (m=0; m<2; m++)
+      for (i=0; i<NTYPE; i++)
+	for (j=0; j<NENTRY; j++)
+	  for (k=0; k<NSTATE; k++) {
+	    maxerr[g][m][i][j][k] = 0.;
+	    count[g][m][i][j][k] = 0;
+	  }
+  nskip = 0;
+  nsolved = nfail_fd = nfail_an = nnoexact = 0;
+  maxdiff = maxerr_fd = maxerr_an = 0.;
+  srand(4242);
+
+  for (icase=0; icase<NCASE; icase++) {
+    Nnodes = (icase % 2) ? 10 : 5;
+    NOFLUX = (icase / 2) % 2;
+    EXP_TRANS = (icase / 4) % 2;
+    n = (NOFLUX) ? Nnodes-1 : Nnodes-2;
+    deltat = 3600. * ((icase % 3) + 1);
+    Dp = 4.;
+
+    /* soil layers */
+    for (lidx=0; lidx<NLAYER; lidx++) {
+      depth[lidx] = urand(0.1, 1.0);
+      soil_density[lidx] = urand(2600., 2700.);
+      bulk_density[lidx] = urand(1200., 1600.);
+      soil_dens_min[lidx] = soil_density[lidx];
+      bulk_dens_min[lidx] = bulk_density[lidx];
+      quartz[lidx] = urand(0.1, 0.7);
+      organic[lidx] = urand(0., 0.3);
+    }
+
+    /* nodes, from the surface to the damping depth */
+    for (i=0; i<Nnodes; i++) {
+      if (EXP_TRANS)
+	Zsum[i] = exp(log(Dp+1.) * i / (Nnodes-1)) - 1.;
+      else
+	Zsum[i] = Dp * pow((double)i / (Nnodes-1), 1.5);
+    }
+    for (i=0; i<Nnodes-2; i++) {
+      alpha[i] = Zsum[i+2] - Zsum[i];
+      beta[i] = Zsum[i+1] - Zsum[i];
+      gamma[i] = Zsum[i+2] - Zsum[i+1];
+    }
+    alpha[Nnodes-2] = 2. * (Zsum[Nnodes-1] - Zsum[Nnodes-2]);
+    beta[Nnodes-2] = gamma[Nnodes-2] = Zsum[Nnodes-1] - Zsum[Nnodes-2];
+
+    /* node states at the start of the step: a profile crossing 0 C,
+       with old ice contents that are not in equilibrium with T0 so that
+       kappa and Cs are recomputed in the residual */
+    Lsum = 0.;
+    lidx = 0;
+    for (i=0; i<Nnodes; i++) {
+      if (Zsum[i] > Lsum + depth[lidx] && lidx < NLAYER-1) {
+	Lsum += depth[lidx];
+	lidx++;
+      }
+      max_moist[i] = 1. - bulk_density[lidx] / soil_density[lidx];
+      moist[i] = urand(0.3, 1.0) * max_moist[i];
+      bubble[i] = urand(10., 40.);
+      expt[i] = urand(8., 20.);
+      T0[i] = urand(-8., 4.);
+      ice[i] = 0.;
+      if (T0[i] < 0.) {
+	ice[i] = moist[i] - maximum_unfrozen_water(T0[i], max_moist[i],
+						   bubble[i], expt[i]);
+	ice[i] *= urand(0.8, 1.2);
+	if (ice[i] < 0.) ice[i] = 0.;
+	if (ice[i] > moist[i]) ice[i] = moist[i];
+      }
+      kappa[i] = soil_conductivity(moist[i], moist[i] - ice[i],
+				   soil_dens_min[lidx], bulk_dens_min[lidx],
+				   quartz[lidx], soil_density[lidx],
+				   bulk_density[lidx], organic[lidx]);
+      Cs[i] = volumetric_heat_capacity(bulk_density[lidx]/soil_density[lidx],
+				       moist[i] - ice[i], ice[i],
+				       organic[lidx]);
+    }
+
+    fda_heat_eqn(T, res, n, 1, deltat, TRUE, NOFLUX, EXP_TRANS, T0, moist,
+		 ice, kappa, Cs, max_moist, bubble, expt, alpha, beta, gamma,
+		 Zsum, Dp, bulk_dens_min, soil_dens_min, quartz, bulk_density,
+		 soil_density, organic, depth, NLAYER);
+
+    /* a Newton iterate near T0 */
+    for (i=0; i<n; i++)
+      T[i] = T0[i+1] + urand(-2., 2.);
+
+    /* analytic Jacobian at T */
+    fda_heat_eqn(T, res, n, 0, -1);
+    fda_heat_eqn(T, res, n, 2, a, b, c);
+
+    /* finite-difference columns */
+    for (j=0; j<n; j++) {
+      Tf = freeze_temperature(moist[j+1], max_moist[j+1], bubble[j+1],
+			      expt[j+1]);
+      if (fabs(T[j]) < 2*FD_STEP || fabs(T[j] - Tf) < 2*FD_STEP) {
+	nskip++;
+	continue;
+      }
+      state = (T[j] < Tf) ? FROZEN : UNFROZEN;
+      for (i=0; i<n; i++)
+	Tp[i] = T[i];
+      Tp[j] = T[j] + FD_STEP;
+      fda_heat_eqn(Tp, resp, n, 0, -1);
+      Tp[j] = T[j] - FD_STEP;
+      fda_heat_eqn(Tp, resm, n, 0, -1);
+
+      /* rows j-1, j and j+1 depend on T[j] */
+      for (i=j-1; i<=j+1; i++) {
+	if (i < 0 || i >= n)
+	  continue;
+	fd = (resp[i] - resm[i]) / (2*FD_STEP);
+	if (i == j-1)
+	  an = c[i];
+	else if (i == j)
+	  an = b[i];
+	else
+	  an = a[i];
+	scale = fabs(b[i]);
+	if (i > 0 && fabs(a[i]) > scale) scale = fabs(a[i]);
+	if (i < n-1 && fabs(c[i]) > scale) scale = fabs(c[i]);
+	err = fabs(an - fd) / scale;
+	type = (i == 0) ? TOP : (i == n-1) ? BOTTOM : INTERIOR;
+	k = (i == j-1) ? SUPER : (i == j) ? DIAG : SUB;
+	count[EXP_TRANS][NOFLUX][type][k][state]++;
+	if (err > maxerr[EXP_TRANS][NOFLUX][type][k][state])
+	  maxerr[EXP_TRANS][NOFLUX][type][k][state] = err;
+	if (err > TOL)
+	  printf("case %d (Nnodes %d NOFLUX %d EXP_TRANS %d) row %d col %d "
+		 "T %.4f: analytic %.6g finite difference %.6g\n", icase,
+		 Nnodes, NOFLUX, EXP_TRANS, i, j, T[j], an, fd);
+      }
+    }
+
+    /* solutions from T0 with the finite-difference and the analytic
+       Jacobian */
+    for (i=0; i<n; i++)
+      T_fd[i] = T_an[i] = T0[i+1];
+    options.IMPLICIT_JACOBIAN = JACOBIAN_FD;
+    if (newt_raph(fda_heat_eqn, T_fd, n)) {
+      nfail_fd++;
+      continue;
+    }
+    options.IMPLICIT_JACOBIAN = JACOBIAN_ANALYTIC;
+    if (newt_raph(fda_heat_eqn, T_an, n)) {
+      nfail_an++;
+      continue;
+    }
+    for (i=0; i<n; i++)
+      T_ex[i] = T_an[i];
+    if (exact_solution(T_ex, n)) {
+      nnoexact++;
+      continue;
+    }
+    nsolved++;
+    for (i=0; i<n; i++) {
+      d = fabs(T_fd[i] - T_an[i]);
+      if (d > maxdiff) maxdiff = d;
+      d = fabs(T_fd[i] - T_ex[i]);
+      if (d > maxerr_fd) maxerr_fd = d;
+      d = fabs(T_an[i] - T_ex[i]);
+      if (d > maxerr_an) maxerr_an = d;
+    }
+  }
+
+  printf("%-9s %-6s %-9s %-6s %-9s %8s %12s\n", "grid", "bottom", "node",
+	 "entry", "column", "entries", "max rel err");
+  nfail = 0;
+  for (g=0; g<2; g++)
+    for (m=0; m<2; m++)
+      for (i=0; i<NTYPE; i++)
+	for (j=0; j<NENTRY; j++)
+	  for (k=0; k<NSTATE; k++) {
+	    if (!count[g][m][i][j][k])
+	      continue;
+	    printf("%-9s %-6s %-9s %-6s %-9s %8d %12.2e\n", grid_name[g],
+		   bound_name[m], type_name[i], entry_name[j], state_name[k],
+		   count[g][m][i][j][k], maxerr[g][m][i][j][k]);
+	    if (maxerr[g][m][i][j][k] > TOL)
+	      nfail++;
+	  }
+  printf("%d columns skipped at 0 C or where the ice content reaches 0\n",
+	 nskip);
+
+  printf("\nnewt_raph() from T0: %d cases solved, %d failed with FD, "
+	 "%d failed with ANALYTIC, %d without exact solution\n", nsolved,
+	 nfail_fd, nfail_an, nnoexact);
+  printf("max |T(FD) - T(ANALYTIC)|     %.2e C\n", maxdiff);
+  printf("max |T(FD) - T(exact)|        %.2e C\n", maxerr_fd);
+  printf("max |T(ANALYTIC) - T(exact)|  %.2e C\n", maxerr_an);
+
+  return (nfail != 0);
+}
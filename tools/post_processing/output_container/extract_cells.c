@@ -0,0 +1,239 @@
+#define _FILE_OFFSET_BITS 64
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Container layout; must match src/output_container.c */
+
+#define CONTAINER_MAGIC   "VICCELLS"
+#define CONTAINER_VERSION 1
+
+typedef struct {
+  char       magic[8];
+  char       prefix[24];
+  int        version;
+  int        binary;
+  int        out_dt;       /* [hours]; if negative, minus the number of
+                              calendar months */
+  int        grid_decimal;
+  int        header_len;
+  int        ncells;
+  long long  index_offset;
+} container_header_struct;
+
+typedef struct {
+  int        cell;
+  int        first;
+  int        nrecs;
+  int        nbytes;
+  long long  next;
+} container_chunk_struct;
+
+typedef struct {
+  int        gridcel;
+  int        nrecs;
+  float      lat;
+  float      lng;
+  long long  offset;
+} container_cell_struct;
+
+void usage(char *);
+int  extract_cell(FILE *, container_header_struct *, char *, int,
+                  container_cell_struct *, char *);
+
+int main(int argc, char *argv[])
+/**********************************************************************
+  extract_cells
+
+  Reads an output container written by VIC with OUTPUT_CONTAINER = TRUE
+  (RESULT_DIR/<prefix>.vicout) and rebuilds the per-cell output files,
+  <outdir>/<prefix>_<lat>_<lng>, exactly as VIC writes them when
+  OUTPUT_CONTAINER = FALSE.  Must be run on a machine with the same
+  byte order as the one that wrote the container.
+
+  Usage: extract_cells [-l] [-g gridcel]... container [outdir]
+
+    -l          list the cells in the container (gridcel, lat, lng,
+                number of records) instead of extracting them
+    -g gridcel  only extract the given cell; may be repeated
+    outdir      directory for the per-cell files (default: .)
+
+  Compile with: gcc -O2 -o extract_cells extract_cells.c
+**********************************************************************/
+{
+  FILE                   *fp;
+  container_header_struct header;
+  container_cell_struct  *cells;
+  char                   *filehdr;
+  char                   *container;
+  char                   *outdir;
+  int                    *gridcels;
+  int                     ngridcels;
+  int                     list;
+  int                     i, j;
+  int                     nextracted;
+
+  list      = 0;
+  ngridcels = 0;
+  gridcels  = (int *)calloc(argc, sizeof(int));
+  container = NULL;
+  outdir    = ".";
+  for (i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-l") == 0)
+      list = 1;
+    else if (strcmp(argv[i], "-g") == 0 && i+1 < argc)
+      gridcels[ngridcels++] = atoi(argv[++i]);
+    else if (argv[i][0] == '-')
+      usage(argv[0]);
+    else if (container == NULL)
+      container = argv[i];
+    else
+      outdir = argv[i];
+  }
+  if (container == NULL) usage(argv[0]);
+
+  if ((fp = fopen(container, "rb")) == NULL) {
+    fprintf(stderr, "Unable to open \"%s\".\n", container);
+    exit(1);
+  }
+  if (fread(&header, sizeof(header), 1, fp) != 1
+      || memcmp(header.magic, CONTAINER_MAGIC, sizeof(header.magic)) != 0) {
+    fprintf(stderr, "\"%s\" is not a VIC output container.\n", container);
+    exit(1);
+  }
+  if (header.version != CONTAINER_VERSION) {
+    fprintf(stderr, "\"%s\" has container version %d; this program reads version %d.\n",
+            container, header.version, CONTAINER_VERSION);
+    exit(1);
+  }
+  if (header.index_offset == 0) {
+    fprintf(stderr, "\"%s\" has no index; the run that wrote it did not finish.\n",
+            container);
+    exit(1);
+  }
+
+  /* Per-cell file header (PRT_HEADER) */
+  filehdr = (char *)malloc(header.header_len + 1);
+  if (header.header_len > 0
+      && fread(filehdr, 1, header.header_len, fp) != (size_t)header.header_len) {
+    fprintf(stderr, "Error reading the file header from \"%s\".\n", container);
+    exit(1);
+  }
+
+  /* Cell index */
+  cells = (container_cell_struct *)calloc(header.ncells + 1, sizeof(container_cell_struct));
+  if (fseeko(fp, (off_t)header.index_offset, SEEK_SET) != 0
+      || fread(cells, sizeof(container_cell_struct), header.ncells, fp) != (size_t)header.ncells) {
+    fprintf(stderr, "Error reading the cell index from \"%s\".\n", container);
+    exit(1);
+  }
+
+  if (list) {
+    printf("# %s: %d cells, %s, ", header.prefix, header.ncells,
+           header.binary ? "binary" : "ASCII");
+    if (header.out_dt > 0)
+      printf("output time step %d hours\n", header.out_dt);
+    else
+      printf("output time step %d month(s)\n", -header.out_dt);
+    printf("# GRIDCEL\tLAT\tLNG\tNRECS\n");
+  }
+
+  nextracted = 0;
+  for (i = 0; i < header.ncells; i++) {
+    if (cells[i].nrecs < 0) continue;  /* cell was not run */
+    if (ngridcels > 0) {
+      for (j = 0; j < ngridcels; j++)
+        if (gridcels[j] == cells[i].gridcel) break;
+      if (j == ngridcels) continue;
+    }
+    if (list)
+      printf("%d\t%.*f\t%.*f\t%d\n", cells[i].gridcel,
+             header.grid_decimal, cells[i].lat,
+             header.grid_decimal, cells[i].lng, cells[i].nrecs);
+    else if (extract_cell(fp, &header, filehdr, i, &cells[i], outdir) != 0)
+      exit(1);
+    nextracted++;
+  }
+  fclose(fp);
+
+  if (!list)
+    fprintf(stderr, "Extracted %d cells from \"%s\".\n", nextracted, container);
+
+  free(gridcels);
+  free(filehdr);
+  free(cells);
+
+  return(0);
+
+}
+
+int extract_cell(FILE                    *fp,
+                 container_header_struct *header,
+                 char                    *filehdr,
+                 int                      cell,
+                 container_cell_struct   *entry,
+                 char                    *outdir)
+/**********************************************************************
+  extract_cell
+
+  Writes one cell's per-cell file: the file header, then the records
+  of each of the cell's chunks, in order.  Returns 0, or -1 on error.
+**********************************************************************/
+{
+  FILE                  *out;
+  char                   filename[2048];
+  char                  *buf;
+  int                    bufsize;
+  long long              offset;
+  container_chunk_struct chunk;
+
+  sprintf(filename, "%s/%s_%.*f_%.*f", outdir, header->prefix,
+          header->grid_decimal, entry->lat, header->grid_decimal, entry->lng);
+  if ((out = fopen(filename, "wb")) == NULL) {
+    fprintf(stderr, "Unable to open \"%s\".\n", filename);
+    return(-1);
+  }
+  if (header->header_len > 0)
+    fwrite(filehdr, 1, header->header_len, out);
+
+  bufsize = 0;
+  buf     = NULL;
+  for (offset = entry->offset; offset != 0; offset = chunk.next) {
+    if (fseeko(fp, (off_t)offset, SEEK_SET) != 0
+        || fread(&chunk, sizeof(chunk), 1, fp) != 1
+        || chunk.cell != cell || chunk.nbytes < 0) {
+      fprintf(stderr, "Bad chunk at offset %lld for cell %d.\n", offset,
+              entry->gridcel);
+      return(-1);
+    }
+    if (chunk.nbytes > bufsize) {
+      bufsize = chunk.nbytes;
+      buf = (char *)realloc(buf, bufsize);
+    }
+    if (fread(buf, 1, chunk.nbytes, fp) != (size_t)chunk.nbytes) {
+      fprintf(stderr, "Error reading chunk at offset %lld for cell %d.\n",
+              offset, entry->gridcel);
+      return(-1);
+    }
+    fwrite(buf, 1, chunk.nbytes, out);
+  }
+  free(buf);
+
+  if (fclose(out) != 0) {
+    fprintf(stderr, "Error writing \"%s\".\n", filename);
+    return(-1);
+  }
+
+  return(0);
+
+}
+
+void usage(char *progname)
+{
+  fprintf(stderr, "Usage: %s [-l] [-g gridcel]... container [outdir]\n", progname);
+  fprintf(stderr, "  Rebuilds the per-cell output files from a VIC output container.\n");
+  fprintf(stderr, "  -l          list the cells in the container instead of extracting them\n");
+  fprintf(stderr, "  -g gridcel  only extract (or list) the given cell; may be repeated\n");
+  fprintf(stderr, "  outdir      directory for the per-cell files (default: .)\n");
+  exit(1);
+}
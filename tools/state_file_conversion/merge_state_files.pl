@@ -0,0 +1,214 @@
+#!/usr/bin/perl
+#
+# merge_state_files.pl - script to merge the state files written by the
+#                        shards of a sharded VIC run (NSHARDS > 1) into a
+#                        single state file, with the grid cells in soil
+#                        parameter file order
+#
+# usage: see usage() function below
+#
+# $Id: $
+#-------------------------------------------------------------------------------
+
+#-------------------------------------------------------------------------------
+# Preliminary Stuff
+#-------------------------------------------------------------------------------
+
+# This allows us to use sophisticated command-line argument parsing
+use Getopt::Long;
+
+# Default values
+$binary = 0;
+$lakes = 0;
+
+#-------------------------------------------------------------------------------
+# Parse the command line
+#-------------------------------------------------------------------------------
+
+# Hash used in GetOptions function
+# format: option => \$variable_to_set
+%options_hash = (
+  h   => \$help,
+  o   => \$outfile,
+  b   => \$binary,
+  lakes  => \$lakes,
+);
+
+# This parses the command-line arguments and sets values for the variables in %option_hash
+$status = &GetOptions(\%options_hash,"h","o=s","b","lakes");
+
+# Remaining arguments are the shard state files, in shard order
+@infiles = @ARGV;
+
+#-------------------------------------------------------------------------------
+# Validate the command-line arguments
+#-------------------------------------------------------------------------------
+
+# Help option
+if ($help) {
+  &usage("full");
+  exit(0);
+}
+
+if (!$status) {
+  &usage("short");
+  exit(1);
+}
+if (!$outfile) {
+  printf STDERR "$0: ERROR: no output file was specified\n";
+  &usage("short");
+  exit(1);
+}
+if (@infiles < 1) {
+  printf STDERR "$0: ERROR: no input state files were specified\n";
+  &usage("short");
+  exit(1);
+}
+
+#-------------------------------------------------------------------------------
+# Open the files and check that their headers agree
+#-------------------------------------------------------------------------------
+
+$nshards = @infiles;
+for ($shard=0; $shard<$nshards; $shard++) {
+  open($fh[$shard], "<$infiles[$shard]") or die "$0: ERROR: cannot open input state file $infiles[$shard] for reading\n";
+  binmode($fh[$shard]) if ($binary);
+  $header = &read_header($fh[$shard], $infiles[$shard]);
+  if ($shard == 0) {
+    $header0 = $header;
+  }
+  elsif ($header ne $header0) {
+    die "$0: ERROR: the header of $infiles[$shard] (date, number of soil layers, number of soil nodes) does not match that of $infiles[0]\n";
+  }
+}
+
+open(OUTFILE, ">$outfile") or die "$0: ERROR: cannot open output state file $outfile for writing\n";
+binmode(OUTFILE) if ($binary);
+print OUTFILE $header0;
+
+#-------------------------------------------------------------------------------
+# Write the cell records
+#-------------------------------------------------------------------------------
+
+# Shard k of N ran the active cells k, k+N, k+2N, ... and wrote their
+# records in that order, so taking one record from each shard in turn
+# restores the order of the soil parameter file.
+$ncells = 0;
+$nopen = $nshards;
+while ($nopen > 0) {
+  for ($shard=0; $shard<$nshards; $shard++) {
+    next if (!$fh[$shard]);
+    $record = &read_record($fh[$shard], $infiles[$shard]);
+    if (!defined($record)) {
+      close($fh[$shard]);
+      $fh[$shard] = undef;
+      $nopen--;
+      next;
+    }
+    if ($nopen < $nshards) {
+      print STDERR "$0: WARNING: $infiles[$shard] has more cells than a preceding shard; cell order in $outfile may not match the soil parameter file\n" if (!$warned++);
+    }
+    print OUTFILE $record;
+    $ncells++;
+  }
+}
+
+close(OUTFILE);
+print "$0: wrote $ncells cells to $outfile\n";
+
+exit(0);
+
+#-------------------------------------------------------------------------------
+# Subroutines
+#-------------------------------------------------------------------------------
+
+# Returns the header of the state file (see open_state_file.c) as a string
+sub read_header {
+  my ($fh, $file) = @_;
+  my ($buf, $line1, $line2);
+
+  if ($binary) {
+    # year, month, day, Nlayer, Nnode
+    if (read($fh, $buf, 5*4) != 5*4) {
+      die "$0: ERROR: cannot read the header of $file\n";
+    }
+    return $buf;
+  }
+  else {
+    # "year month day" and "Nlayer Nnode"
+    $line1 = <$fh>;
+    $line2 = <$fh>;
+    if (!defined($line2)) {
+      die "$0: ERROR: cannot read the header of $file\n";
+    }
+    return $line1 . $line2;
+  }
+}
+
+# Returns the next cell record (see write_model_state.c) as a string, or
+# undef at the end of the file
+sub read_record {
+  my ($fh, $file) = @_;
+  my ($buf, $data, $line, $nveg, $nbands, $nbytes, $nlines, $i);
+
+  if ($binary) {
+    # cellnum, Nveg, Nbands, Nbytes, followed by Nbytes bytes of data
+    $i = read($fh, $buf, 4*4);
+    return undef if ($i == 0);
+    if ($i != 4*4) {
+      die "$0: ERROR: truncated cell record in $file\n";
+    }
+    ($cellnum, $nveg, $nbands, $nbytes) = unpack("i4", $buf);
+    if (read($fh, $data, $nbytes) != $nbytes) {
+      die "$0: ERROR: truncated record for cell $cellnum in $file\n";
+    }
+    return $buf . $data;
+  }
+  else {
+    # "cellnum Nveg Nbands dz_node... Zsum_node...", followed by one line
+    # per veg tile (including bare soil) and snow band, and one line for
+    # the lake if LAKES is TRUE
+    $line = <$fh>;
+    return undef if (!defined($line));
+    $buf = $line;
+    ($cellnum, $nveg, $nbands) = split /\s+/, $line;
+    $nlines = ($nveg+1) * $nbands;
+    $nlines++ if ($lakes);
+    for ($i=0; $i<$nlines; $i++) {
+      $line = <$fh>;
+      if (!defined($line)) {
+        die "$0: ERROR: truncated record for cell $cellnum in $file\n";
+      }
+      $buf .= $line;
+    }
+    return $buf;
+  }
+}
+
+sub usage() {
+
+  print "\n";
+  print "$0: script to merge the state files written by the shards of a sharded VIC run into a single state file\n";
+  print "\n";
+  print "usage:\n";
+  print "  $0 [-h] [-b] [-lakes] -o <outfile> <shard_0_file> <shard_1_file> ... <shard_N-1_file>\n";
+  print "\n";
+  if ($_[0] eq "full") {
+    print "  -h\n";
+    print "    prints this usage message\n";
+    print "\n";
+    print "  -b\n";
+    print "    (optional) the state files are binary (BINARY_STATE_FILE = TRUE); default is ASCII.\n";
+    print "\n";
+    print "  -lakes\n";
+    print "    (optional) the state files were written with LAKES = TRUE.  Only needed for ASCII state files.\n";
+    print "\n";
+    print "  -o <outfile>\n";
+    print "    <outfile>  = filename of the merged VIC state file.\n";
+    print "\n";
+    print "  <shard_0_file> ... <shard_N-1_file>\n";
+    print "    The state files written by shards 0 through N-1 (named <STATENAME>_<date>.shard<k>of<N>), in shard order.\n";
+    print "    All N shards must be given.  Cells that failed (CONTINUEONERROR = TRUE) write no state, which breaks the\n";
+    print "    correspondence between shard and soil file order; the script warns if it detects this.\n";
+  }
+}